@@ -83,6 +83,7 @@ if (TFM_PARTITION_CRYPTO OR FORWARD_PROT_MSG)
                         ${INTERFACE_INC_DIR}/psa/crypto_values.h
             DESTINATION ${INSTALL_INTERFACE_INC_DIR}/psa)
     install(FILES       ${INTERFACE_INC_DIR}/tfm_crypto_defs.h
+                        ${INTERFACE_INC_DIR}/tfm_crypto_pack.h
             DESTINATION ${INSTALL_INTERFACE_INC_DIR})
 endif()
 
@@ -102,6 +102,10 @@ tfm_invalid_config(TFM_PARTITION_AUDIT_LOG AND NOT TFM_LIB_MODEL)
 
 tfm_invalid_config(CRYPTO_NV_SEED AND CRYPTO_HW_ACCELERATOR)
 tfm_invalid_config(NOT CRYPTO_NV_SEED AND NOT CRYPTO_HW_ACCELERATOR)
+tfm_invalid_config(CRYPTO_HW_ACCELERATOR AND CRYPTO_MAC_KEY_CACHE_SIZE GREATER 0)
+tfm_invalid_config(CRYPTO_ECP_WINDOW_SIZE EQUAL 1 OR CRYPTO_ECP_WINDOW_SIZE GREATER 7)
+tfm_invalid_config(CRYPTO_PERSISTENT_KEY_CACHE_SLOTS GREATER 0 AND NOT CRYPTO_PERSISTENT_KEY_CACHE_ENTRY_SIZE GREATER 0)
+tfm_invalid_config(CRYPTO_ENGINE_SIZE_CLASS_ALLOC AND NOT CRYPTO_ENGINE_FIRST_FIT_SIZE LESS CRYPTO_ENGINE_BUF_SIZE)
 
 ########################### Test check config ##################################
 
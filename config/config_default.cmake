@@ -101,22 +101,49 @@ set(PS_ENCRYPTION                       ON          CACHE BOOL      "Enable encr
 set(PS_RAM_FS                           OFF         CACHE BOOL      "Enable emulated RAM FS for platforms that don't have flash for Protected Storage partition")
 set(PS_ROLLBACK_PROTECTION              ON          CACHE BOOL      "Enable rollback protection for Protected Storage partition")
 set(PS_VALIDATE_METADATA_FROM_FLASH     ON          CACHE BOOL      "Validate filesystem metadata every time it is read from flash")
+set(PS_WRITE_BACK                       OFF         CACHE BOOL      "Batch several Protected Storage updates into one object table commit")
+set(PS_OBJECT_CACHE                     OFF         CACHE BOOL      "Cache the data of small Protected Storage objects in RAM after they are read")
 set(PS_MAX_ASSET_SIZE                   "2048"      CACHE STRING    "The maximum asset size to be stored in the Protected Storage area")
 set(PS_NUM_ASSETS                       "10"        CACHE STRING    "The maximum number of assets to be stored in the Protected Storage area")
 set(PS_CRYPTO_AEAD_ALG                  PSA_ALG_GCM CACHE STRING    "The AEAD algorithm to use for authenticated encryption in Protected Storage")
+set(PS_OBJ_TABLE_PAGE_ENTRIES           "8"         CACHE STRING    "The number of object table entries stored in each Protected Storage object table page")
+set(PS_CRYPTO_CHUNK_SIZE                "256"       CACHE STRING    "The size of the chunks that encrypted Protected Storage objects are split into")
+set(PS_WRITE_BACK_MAX_UPDATES           "8"         CACHE STRING    "The maximum number of Protected Storage updates batched into one object table commit when PS_WRITE_BACK is enabled")
+set(PS_CRYPTO_KEY_CACHE_SIZE            "4"         CACHE STRING    "The number of derived Protected Storage encryption keys kept in the key cache, 0 to disable the cache")
+set(PS_OBJECT_CACHE_ENTRIES             "4"         CACHE STRING    "The number of objects held in the Protected Storage object cache when PS_OBJECT_CACHE is enabled")
+set(PS_OBJECT_CACHE_MAX_OBJECT_SIZE     "256"       CACHE STRING    "The maximum size of the objects held in the Protected Storage object cache")
+set(PS_CLIENT_QUOTA                     "0"         CACHE STRING    "The maximum total size of the Protected Storage assets of each client (0 for no limit)")
 
 set(TFM_PARTITION_INTERNAL_TRUSTED_STORAGE ON       CACHE BOOL      "Enable Internal Trusted Storage partition")
 set(ITS_CREATE_FLASH_LAYOUT             ON          CACHE BOOL      "Create flash FS if it doesn't exist for Internal Trusted Storage partition")
 set(ITS_RAM_FS                          OFF         CACHE BOOL      "Enable emulated RAM FS for platforms that don't have flash for Internal Trusted Storage partition")
 set(ITS_VALIDATE_METADATA_FROM_FLASH    ON          CACHE BOOL      "Validate filesystem metadata every time it is read from flash")
+set(ITS_FLASH_NOR_IN_PLACE_WRITE        OFF         CACHE BOOL      "Append Internal Trusted Storage file data in place on NOR flash. Only for flash without ECC, on which programmed bytes can be programmed again")
 set(ITS_MAX_ASSET_SIZE                  "512"       CACHE STRING    "The maximum asset size to be stored in the Internal Trusted Storage area")
 set(ITS_NUM_ASSETS                      "10"        CACHE STRING    "The maximum number of assets to be stored in the Internal Trusted Storage area")
 set(ITS_BUF_SIZE                        ""          CACHE STRING    "Size of the ITS internal data transfer buffer (defaults to ITS_MAX_ASSET_SIZE if not set)")
+set(ITS_TRANSACTION_MAX_FILES           "4"         CACHE STRING    "The maximum number of files that can be modified by one Internal Trusted Storage transaction")
+set(ITS_METADATA_SHADOW_MAX_BLOCKS      "8"         CACHE STRING    "The maximum number of filesystem blocks for which validated metadata is cached in RAM (0 to disable)")
+set(ITS_CLIENT_QUOTA                    "0"         CACHE STRING    "The maximum storage space used by the Internal Trusted Storage assets of each client (0 for no limit)")
 
 set(TFM_PARTITION_CRYPTO                ON          CACHE BOOL      "Enable Crypto partition")
 # CRYPTO_ENGINE_BUF_SIZE needs to be >8KB for EC signing by attest module.
 set(CRYPTO_ENGINE_BUF_SIZE              0x2080      CACHE STRING    "Heap size for the crypto backend")
-set(CRYPTO_CONC_OPER_NUM                8           CACHE STRING    "The max number of concurrent operations that can be active (allocated) at any time in Crypto")
+set(CRYPTO_ENGINE_SIZE_CLASS_ALLOC      OFF         CACHE BOOL      "Serve the allocations of the crypto backend from size classes instead of the Mbed TLS first-fit heap")
+set(CRYPTO_ENGINE_FIRST_FIT_SIZE        0x1000      CACHE STRING    "The part of the crypto backend heap kept as a first-fit heap for the allocations the size classes cannot serve, with CRYPTO_ENGINE_SIZE_CLASS_ALLOC")
+set(CRYPTO_CONC_OPER_NUM                8           CACHE STRING    "The number of operation contexts of any type in the shared pool of Crypto, used when the pool of a type is full or not configured")
+set(CRYPTO_CIPHER_OPER_NUM              0           CACHE STRING    "The number of operation contexts in the dedicated pool of cipher operations in Crypto")
+set(CRYPTO_MAC_OPER_NUM                 0           CACHE STRING    "The number of operation contexts in the dedicated pool of MAC operations in Crypto")
+set(CRYPTO_HASH_OPER_NUM                0           CACHE STRING    "The number of operation contexts in the dedicated pool of hash operations in Crypto")
+set(CRYPTO_KEY_DERIVATION_OPER_NUM      0           CACHE STRING    "The number of operation contexts in the dedicated pool of key derivation operations in Crypto")
+set(CRYPTO_AEAD_OPER_NUM                0           CACHE STRING    "The number of operation contexts in the dedicated pool of AEAD operations in Crypto")
+set(CRYPTO_RNG_POOL_SIZE                0           CACHE STRING    "The size of the pool of DRBG output serving small random requests in Crypto (0 to disable, as required for prediction resistance)")
+set(CRYPTO_RNG_POOL_MAX_REQUEST         16          CACHE STRING    "The largest random request served from the pool of DRBG output in Crypto")
+set(CRYPTO_MAC_KEY_CACHE_SIZE           0           CACHE STRING    "The number of HMAC setup states kept for reuse with the same key in Crypto (0 to disable)")
+set(CRYPTO_PERSISTENT_KEY_CACHE_SLOTS   0           CACHE STRING    "The number of persistent keys read from ITS kept in RAM by Crypto (0 to disable)")
+set(CRYPTO_PERSISTENT_KEY_CACHE_ENTRY_SIZE 128      CACHE STRING    "The size in bytes of the largest stored persistent key kept in RAM by Crypto")
+set(CRYPTO_ECP_FIXED_POINT_OPTIM        OFF         CACHE BOOL      "Use the precomputed comb tables of the curve generators in Mbed Crypto, speeding up ECDSA signing and EC key generation at the cost of flash")
+set(CRYPTO_ECP_WINDOW_SIZE              0           CACHE STRING    "The maximum window size of the EC scalar multiplications in Mbed Crypto, from 2 to 7, bounding the RAM of their comb tables (0 for the Mbed Crypto default)")
 set(CRYPTO_RNG_MODULE_DISABLED          FALSE       CACHE BOOL      "Disable PSA Crypto random number generator module")
 set(CRYPTO_KEY_MODULE_DISABLED          FALSE       CACHE BOOL      "Disable PSA Crypto Key module")
 set(CRYPTO_AEAD_MODULE_DISABLED         FALSE       CACHE BOOL      "Disable PSA Crypto AEAD module")
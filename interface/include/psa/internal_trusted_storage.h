@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019, Arm Limited. All rights reserved.
+ * Copyright (c) 2019-2022, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -157,6 +157,228 @@ psa_status_t psa_its_get_info(psa_storage_uid_t uid,
  */
 psa_status_t psa_its_remove(psa_storage_uid_t uid);
 
+/**
+ * \brief Reserve storage for the provided uid without writing any data
+ *
+ * Creates an asset with the given capacity and no data. The data can then be
+ * written, in parts, with \ref psa_its_set_extended.
+ *
+ * \note This is a TF-M extension to the PSA ITS API. It is only available when
+ *       TF-M is built with the IPC model. \ref psa_its_get_info reports the
+ *       capacity given here until the asset is replaced by \ref psa_its_set.
+ *
+ * \param[in] uid           The identifier for the data
+ * \param[in] capacity      The maximum size in bytes of the data
+ * \param[in] create_flags  The flags that the data will be stored with.
+ *                          PSA_STORAGE_FLAG_WRITE_ONCE is not supported.
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS                     The operation completed successfully
+ * \retval PSA_ERROR_ALREADY_EXISTS        The operation failed because the
+ *                                         provided `uid` value already exists
+ * \retval PSA_ERROR_NOT_SUPPORTED         The operation failed because one or
+ *                                         more of the flags provided in
+ *                                         `create_flags` is not supported or is
+ *                                         not valid, or because this build
+ *                                         does not support the operation
+ * \retval PSA_ERROR_INSUFFICIENT_STORAGE  The operation failed because there
+ *                                         was insufficient space on the
+ *                                         storage medium
+ * \retval PSA_ERROR_INVALID_ARGUMENT      The operation failed because
+ *                                         `capacity` is larger than the
+ *                                         maximum asset size
+ */
+psa_status_t psa_its_create(psa_storage_uid_t uid,
+                            size_t capacity,
+                            psa_storage_create_flags_t create_flags);
+
+/**
+ * \brief Write part of the data associated with a provided uid
+ *
+ * Writes `data_length` bytes from `p_data` at `data_offset` bytes from the
+ * beginning of the data, leaving the rest of the data unchanged. The write can
+ * extend the data, up to the capacity of the asset, but must not leave a gap
+ * after the current end of the data. Appending to an asset is cheaper than
+ * rewriting it with \ref psa_its_set.
+ *
+ * \note This is a TF-M extension to the PSA ITS API. It is only available when
+ *       TF-M is built with the IPC model.
+ *
+ * \param[in] uid          The identifier for the data
+ * \param[in] data_offset  The offset within the data at which to write
+ * \param[in] data_length  The size in bytes of the data in `p_data`
+ * \param[in] p_data       A buffer containing the data
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS                 The operation completed successfully
+ * \retval PSA_ERROR_DOES_NOT_EXIST    The operation failed because the
+ *                                     provided `uid` value was not found in
+ *                                     the storage
+ * \retval PSA_ERROR_NOT_PERMITTED     The operation failed because the
+ *                                     provided `uid` value was created with
+ *                                     PSA_STORAGE_FLAG_WRITE_ONCE
+ * \retval PSA_ERROR_NOT_SUPPORTED     The operation failed because this build
+ *                                     does not support the operation
+ * \retval PSA_ERROR_INVALID_ARGUMENT  The operation failed because
+ *                                     `data_offset` is larger than the current
+ *                                     size of the data, the write would exceed
+ *                                     the capacity of the asset, or `p_data`
+ *                                     is invalid
+ * \retval PSA_ERROR_STORAGE_FAILURE   The operation failed because the
+ *                                     physical storage has failed (Fatal
+ *                                     error)
+ */
+psa_status_t psa_its_set_extended(psa_storage_uid_t uid,
+                                  size_t data_offset,
+                                  size_t data_length,
+                                  const void *p_data);
+
+/**
+ * \brief List the uids stored by the caller
+ *
+ * Retrieves the metadata of up to `num_entries` of the caller's uids which are
+ * greater than `after_uid`, in ascending order of uid. To list all the uids,
+ * start with `after_uid` set to 0 and pass the last uid returned to the next
+ * call, until fewer than `num_entries` entries are returned.
+ *
+ * \note This is a TF-M extension to the PSA ITS API. It is only available when
+ *       TF-M is built with the IPC model. While a transaction is open, the
+ *       committed uids are listed.
+ *
+ * \param[in]  after_uid      The uid after which to start listing
+ * \param[in]  num_entries    The number of entries that `p_entries` can hold
+ * \param[out] p_entries      A buffer that will be populated with the metadata
+ *                            of the listed uids
+ * \param[out] p_num_entries  A pointer that will be populated with the number
+ *                            of listed uids
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS                 The operation completed successfully
+ * \retval PSA_ERROR_NOT_SUPPORTED     The operation failed because this build
+ *                                     does not support the operation
+ * \retval PSA_ERROR_STORAGE_FAILURE   The operation failed because the
+ *                                     physical storage has failed (Fatal
+ *                                     error)
+ * \retval PSA_ERROR_INVALID_ARGUMENT  The operation failed because one of the
+ *                                     provided pointers (`p_entries`,
+ *                                     `p_num_entries`) is invalid, for example
+ *                                     is `NULL` or references memory the
+ *                                     caller cannot access
+ */
+psa_status_t psa_its_list(psa_storage_uid_t after_uid,
+                          size_t num_entries,
+                          struct psa_storage_uid_info_t *p_entries,
+                          size_t *p_num_entries);
+
+/**
+ * \brief Retrieve the storage usage of the caller and the free storage
+ *
+ * Retrieves the number of assets owned by the caller and the storage space
+ * they use, the caller's quota, and the number and size of the assets that can
+ * still be created. The values are maintained as the storage is modified, so
+ * no asset metadata has to be read to answer the query.
+ *
+ * The fields of `p_capacity` are populated as follows:
+ * - `num_assets`: the number of assets owned by the caller
+ * - `size`: the storage space used by the caller's assets, which is the sum
+ *   of their capacities aligned to the flash program unit, in bytes
+ * - `quota`: the storage space the caller is permitted to use, in bytes, or
+ *   0 if the caller's usage is not limited
+ * - `free_assets`: the number of assets that can still be created
+ * - `free_size`: the capacity of the largest asset the caller can currently
+ *   create, in bytes
+ *
+ * \note This is a TF-M extension to the PSA ITS API. It is only available when
+ *       TF-M is built with the IPC model. While a transaction is open, the
+ *       values do not include the changes staged by the transaction.
+ *
+ * \param[out] p_capacity  A pointer to a `psa_storage_capacity_t` struct that
+ *                         will be populated with the usage and free storage
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS                 The operation completed successfully
+ * \retval PSA_ERROR_NOT_SUPPORTED     The operation failed because this build
+ *                                     does not support the operation
+ * \retval PSA_ERROR_STORAGE_FAILURE   The operation failed because the
+ *                                     physical storage has failed (Fatal
+ *                                     error)
+ * \retval PSA_ERROR_INVALID_ARGUMENT  The operation failed because the
+ *                                     provided pointer (`p_capacity`) is
+ *                                     invalid, for example is `NULL` or
+ *                                     references memory the caller cannot
+ *                                     access
+ */
+psa_status_t psa_its_get_capacity(struct psa_storage_capacity_t *p_capacity);
+
+/**
+ * \brief Open a transaction on the internal trusted storage
+ *
+ * All subsequent calls to \ref psa_its_set and \ref psa_its_remove made by the
+ * caller are applied atomically by \ref psa_its_txn_commit, or discarded by
+ * \ref psa_its_txn_abort. While the transaction is open, \ref psa_its_get and
+ * \ref psa_its_get_info return the committed data, and other callers are not
+ * permitted to modify the internal trusted storage. If a change staged by the
+ * transaction fails, or the commit fails, the transaction stays open: the
+ * later changes and commits return PSA_ERROR_BAD_STATE until the caller
+ * discards it with \ref psa_its_txn_abort.
+ *
+ * \note This is a TF-M extension to the PSA ITS API. It is only available to
+ *       secure partitions, when TF-M is built with the IPC model.
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS              The operation completed successfully
+ * \retval PSA_ERROR_NOT_PERMITTED  The operation failed because the caller is
+ *                                  not a secure partition
+ * \retval PSA_ERROR_NOT_SUPPORTED  The operation failed because transactions
+ *                                  are not supported by this build
+ * \retval PSA_ERROR_BAD_STATE      The operation failed because a transaction
+ *                                  is already open
+ */
+psa_status_t psa_its_txn_begin(void);
+
+/**
+ * \brief Commit the caller's open internal trusted storage transaction
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS                     The operation completed successfully
+ * \retval PSA_ERROR_BAD_STATE             The operation failed because the
+ *                                         caller does not have an open
+ *                                         transaction, or because a change
+ *                                         staged by the transaction has
+ *                                         failed. The transaction must then
+ *                                         be aborted.
+ * \retval PSA_ERROR_NOT_SUPPORTED         The operation failed because
+ *                                         transactions are not supported by
+ *                                         this build
+ * \retval PSA_ERROR_STORAGE_FAILURE       The operation failed because the
+ *                                         physical storage has failed (Fatal
+ *                                         error)
+ * \retval PSA_ERROR_GENERIC_ERROR         The operation failed because of an
+ *                                         unspecified internal failure.
+ *                                         Nothing has been committed, and the
+ *                                         transaction must be aborted.
+ */
+psa_status_t psa_its_txn_commit(void);
+
+/**
+ * \brief Discard the caller's open internal trusted storage transaction
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS              The operation completed successfully
+ * \retval PSA_ERROR_BAD_STATE      The operation failed because the caller
+ *                                  does not have an open transaction
+ * \retval PSA_ERROR_NOT_SUPPORTED  The operation failed because transactions
+ *                                  are not supported by this build
+ */
+psa_status_t psa_its_txn_abort(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019-2020, Arm Limited. All rights reserved.
+ * Copyright (c) 2019-2022, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -275,6 +275,107 @@ psa_status_t psa_ps_set_extended(psa_storage_uid_t uid,
  */
 uint32_t psa_ps_get_support(void);
 
+/**
+ * \brief Make all the completed protected storage updates persistent
+ *
+ * When TF-M is built with PS_WRITE_BACK, the updates made by \ref psa_ps_set,
+ * \ref psa_ps_set_extended, \ref psa_ps_create and \ref psa_ps_remove are
+ * batched, and are only guaranteed to survive a reset or power failure once
+ * they are flushed. Otherwise, every update is persistent when it completes
+ * and this function has no effect.
+ *
+ * \note This is a TF-M extension to the PSA PS API. It is only available when
+ *       TF-M is built with the IPC model.
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS                The operation completed successfully
+ * \retval PSA_ERROR_NOT_SUPPORTED    The operation failed because it is not
+ *                                    supported by this build
+ * \retval PSA_ERROR_STORAGE_FAILURE  The operation failed because the
+ *                                    physical storage has failed (Fatal
+ *                                    error)
+ * \retval PSA_ERROR_GENERIC_ERROR    The operation failed because of an
+ *                                    unspecified internal failure. The updates
+ *                                    stay pending.
+ */
+psa_status_t psa_ps_flush(void);
+
+/**
+ * \brief List the uids stored by the caller
+ *
+ * Retrieves the metadata of up to `num_entries` of the caller's uids which are
+ * greater than `after_uid`, in ascending order of uid. To list all the uids,
+ * start with `after_uid` set to 0 and pass the last uid returned to the next
+ * call, until fewer than `num_entries` entries are returned.
+ *
+ * \note This is a TF-M extension to the PSA PS API. It is only available when
+ *       TF-M is built with the IPC model. The metadata is read from the
+ *       authenticated object table, without reading the objects.
+ *
+ * \param[in]  after_uid      The uid after which to start listing
+ * \param[in]  num_entries    The number of entries that `p_entries` can hold
+ * \param[out] p_entries      A buffer that will be populated with the metadata
+ *                            of the listed uids
+ * \param[out] p_num_entries  A pointer that will be populated with the number
+ *                            of listed uids
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS                 The operation completed successfully
+ * \retval PSA_ERROR_NOT_SUPPORTED     The operation failed because it is not
+ *                                     supported by this build
+ * \retval PSA_ERROR_INVALID_ARGUMENT  The operation failed because one of the
+ *                                     provided pointers (`p_entries`,
+ *                                     `p_num_entries`) is invalid, for example
+ *                                     is `NULL` or references memory the
+ *                                     caller cannot access
+ */
+psa_status_t psa_ps_list(psa_storage_uid_t after_uid,
+                         size_t num_entries,
+                         struct psa_storage_uid_info_t *p_entries,
+                         size_t *p_num_entries);
+
+/**
+ * \brief Retrieve the storage usage of the caller and the free storage
+ *
+ * Retrieves the number of assets owned by the caller and the storage space
+ * they use, the caller's quota, and the number and size of the assets that can
+ * still be created. The usage is maintained as the object table is updated, so
+ * no object has to be read to answer the query.
+ *
+ * The fields of `p_capacity` are populated as follows:
+ * - `num_assets`: the number of assets owned by the caller
+ * - `size`: the storage space used by the caller's assets, which is the sum
+ *   of their sizes, in bytes
+ * - `quota`: the storage space the caller is permitted to use, in bytes, or
+ *   0 if the caller's usage is not limited
+ * - `free_assets`: the number of assets that can still be created
+ * - `free_size`: an estimate of the size of the largest asset the caller can
+ *   currently create, in bytes
+ *
+ * \note This is a TF-M extension to the PSA PS API. It is only available when
+ *       TF-M is built with the IPC model.
+ *
+ * \param[out] p_capacity  A pointer to a `psa_storage_capacity_t` struct that
+ *                         will be populated with the usage and free storage
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS                 The operation completed successfully
+ * \retval PSA_ERROR_NOT_SUPPORTED     The operation failed because it is not
+ *                                     supported by this build
+ * \retval PSA_ERROR_STORAGE_FAILURE   The operation failed because the
+ *                                     physical storage has failed (Fatal
+ *                                     error)
+ * \retval PSA_ERROR_INVALID_ARGUMENT  The operation failed because the
+ *                                     provided pointer (`p_capacity`) is
+ *                                     invalid, for example is `NULL` or
+ *                                     references memory the caller cannot
+ *                                     access
+ */
+psa_status_t psa_ps_get_capacity(struct psa_storage_capacity_t *p_capacity);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019, Arm Limited. All rights reserved.
+ * Copyright (c) 2019-2022, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -37,6 +37,24 @@ struct psa_storage_info_t {
     psa_storage_create_flags_t flags;
 };
 
+/* A container for the metadata of one of the uids listed for a caller */
+
+struct psa_storage_uid_info_t {
+    psa_storage_uid_t uid;
+    size_t size;
+    psa_storage_create_flags_t flags;
+};
+
+/* A container for the storage usage of a caller and the free storage */
+
+struct psa_storage_capacity_t {
+    size_t num_assets;
+    size_t size;
+    size_t quota;
+    size_t free_assets;
+    size_t free_size;
+};
+
 #define PSA_STORAGE_SUPPORT_SET_EXTENDED (1u << 0)
 
 #define PSA_ERROR_INVALID_SIGNATURE     ((psa_status_t)-149)
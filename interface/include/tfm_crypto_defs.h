@@ -125,6 +125,7 @@ enum {
     TFM_CRYPTO_RAW_KEY_AGREEMENT_SID,
     TFM_CRYPTO_GENERATE_RANDOM_SID,
     TFM_CRYPTO_GENERATE_KEY_SID,
+    TFM_CRYPTO_BATCH_SID,
     TFM_CRYPTO_SID_MAX,
 };
 
@@ -153,6 +154,99 @@ enum {
  */
 #define TFM_CRYPTO_ALG_HUK_DERIVATION ((psa_algorithm_t)0xB0000F00)
 
+/**
+ * \brief Maximum number of steps in a batched request
+ *
+ */
+#define TFM_CRYPTO_BATCH_MAX_STEPS (8u)
+
+/**
+ * \brief Maximum number of input and output buffers of a step of a batched
+ *        request. They do not include the tfm_crypto_pack_iovec of the step
+ *        and the operation handle.
+ *
+ */
+#define TFM_CRYPTO_BATCH_MAX_IN  (3u)
+#define TFM_CRYPTO_BATCH_MAX_OUT (3u)
+
+/**
+ * \brief Flags of a step of a batched request
+ *
+ */
+#define TFM_CRYPTO_BATCH_USE_HANDLE (1u << 0) /*!< The op_handle of the step is
+                                               *   replaced by the handle of
+                                               *   the batch
+                                               */
+#define TFM_CRYPTO_BATCH_HANDLE_OUT (1u << 1) /*!< The handle of the batch is
+                                               *   passed as the first output
+                                               *   of the step, before its
+                                               *   output buffers
+                                               */
+
+/**
+ * \brief Structure describing a step of a batched request. The buffers of the
+ *        step are given as offsets in the input and output buffers of the
+ *        batch, which must be aligned to 4 bytes.
+ *
+ */
+struct tfm_crypto_batch_step_t {
+    struct tfm_crypto_pack_iovec iov; /*!< Parameters of the step, as passed to
+                                       *   the service in the first input
+                                       */
+    uint32_t flags;                   /*!< TFM_CRYPTO_BATCH_* flags */
+    uint32_t num_in;                  /*!< Number of input buffers */
+    uint32_t num_out;                 /*!< Number of output buffers */
+    uint32_t in_offset[TFM_CRYPTO_BATCH_MAX_IN];   /*!< Input offsets */
+    uint32_t in_len[TFM_CRYPTO_BATCH_MAX_IN];      /*!< Input lengths */
+    uint32_t out_offset[TFM_CRYPTO_BATCH_MAX_OUT]; /*!< Output offsets */
+    uint32_t out_size[TFM_CRYPTO_BATCH_MAX_OUT];   /*!< Output sizes */
+};
+
+/**
+ * \brief Structure holding the result of a step of a batched request
+ *
+ */
+struct tfm_crypto_batch_result_t {
+    psa_status_t status;                        /*!< Status of the step */
+    uint32_t out_len[TFM_CRYPTO_BATCH_MAX_OUT]; /*!< Lengths written to the
+                                                 *   output buffers
+                                                 */
+};
+
+/**
+ * \brief Runs a list of crypto operations in sequence in a single call to the
+ *        crypto service. The execution stops at the first step which fails.
+ *
+ * \param[in,out] op_handle    Handle of the multipart operation used by the
+ *                             steps with TFM_CRYPTO_BATCH_USE_HANDLE or
+ *                             TFM_CRYPTO_BATCH_HANDLE_OUT. It is updated with
+ *                             the handle after the last step run.
+ * \param[in]     steps        Steps to run
+ * \param[in]     num_steps    Number of steps, at most
+ *                             TFM_CRYPTO_BATCH_MAX_STEPS
+ * \param[in]     input        Buffer holding the inputs of the steps
+ * \param[in]     input_length Length of the input buffer
+ * \param[out]    output       Buffer receiving the outputs of the steps. The
+ *                             content of the parts not used as the output of
+ *                             a step is undefined.
+ * \param[in]     output_size  Size of the output buffer
+ * \param[out]    results      Results of the steps, num_steps entries
+ * \param[out]    num_results  Number of steps run, including the one which
+ *                             failed
+ *
+ * \return PSA_SUCCESS if all the steps succeeded, otherwise the status of the
+ *         step which failed or an error in the description of the batch
+ */
+psa_status_t tfm_crypto_batch_call(uint32_t *op_handle,
+                                   const struct tfm_crypto_batch_step_t *steps,
+                                   size_t num_steps,
+                                   const void *input,
+                                   size_t input_length,
+                                   void *output,
+                                   size_t output_size,
+                                   struct tfm_crypto_batch_result_t *results,
+                                   size_t *num_results);
+
 /**
  * \brief Define miscellaneous literal constants that are used in the service
  *
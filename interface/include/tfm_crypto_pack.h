@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2022, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/**
+ * \file  tfm_crypto_pack.h
+ *
+ * \brief Wire encoding of the struct tfm_crypto_pack_iovec passed in the first
+ *        input vector of the requests to the crypto service in IPC mode.
+ *        The encoding starts with a struct tfm_crypto_pack_hdr, followed only
+ *        by the fields used by the service identified in the header, in the
+ *        order of LIST_TFM_CRYPTO_PACK_FIELDS. Each field is padded to a
+ *        multiple of 4 bytes. The AEAD nonce, when used, comes last as its
+ *        length on 4 bytes followed by the nonce bytes.
+ */
+
+#ifndef __TFM_CRYPTO_PACK_H__
+#define __TFM_CRYPTO_PACK_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "tfm_crypto_defs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Version of the encoding, increased when the fields used by a service
+ *        or their encoding change
+ */
+#define TFM_CRYPTO_PACK_VERSION (1u)
+
+/**
+ * \brief Header of an encoded struct tfm_crypto_pack_iovec
+ */
+struct tfm_crypto_pack_hdr {
+    uint8_t version;  /*!< TFM_CRYPTO_PACK_VERSION */
+    uint8_t reserved; /*!< Must be 0 */
+    uint16_t srv_id;  /*!< Crypto service ID used to dispatch the request */
+};
+
+/**
+ * \brief Fields of the struct tfm_crypto_pack_iovec which can be encoded
+ */
+#define TFM_CRYPTO_PACK_STEP             (1u << 0)
+#define TFM_CRYPTO_PACK_KEY_ID           (1u << 1)
+#define TFM_CRYPTO_PACK_ALG              (1u << 2)
+#define TFM_CRYPTO_PACK_OP_HANDLE        (1u << 3)
+#define TFM_CRYPTO_PACK_CAPACITY         (1u << 4)
+#define TFM_CRYPTO_PACK_AD_LENGTH        (1u << 5)
+#define TFM_CRYPTO_PACK_PLAINTEXT_LENGTH (1u << 6)
+#define TFM_CRYPTO_PACK_AEAD_IN          (1u << 7)
+
+/**
+ * \brief Scalar fields in the order of the encoding. The AEAD nonce is
+ *        handled separately as it has a variable length.
+ */
+#define LIST_TFM_CRYPTO_PACK_FIELDS                              \
+    X(TFM_CRYPTO_PACK_STEP, step)                                \
+    X(TFM_CRYPTO_PACK_KEY_ID, key_id)                            \
+    X(TFM_CRYPTO_PACK_ALG, alg)                                  \
+    X(TFM_CRYPTO_PACK_OP_HANDLE, op_handle)                      \
+    X(TFM_CRYPTO_PACK_CAPACITY, capacity)                        \
+    X(TFM_CRYPTO_PACK_AD_LENGTH, ad_length)                      \
+    X(TFM_CRYPTO_PACK_PLAINTEXT_LENGTH, plaintext_length)
+
+/**
+ * \brief Rounds a field size up to the 4-byte granularity of the encoding
+ */
+#define TFM_CRYPTO_PACK_ALIGN(x) (((x) + 3u) & ~(size_t)3u)
+
+/**
+ * \brief Maximum size of an encoded struct tfm_crypto_pack_iovec in bytes. As
+ *        the srv_id field is not encoded, it is at most the size of the header
+ *        and of the structure.
+ */
+#define TFM_CRYPTO_PACK_MAX_SIZE (sizeof(struct tfm_crypto_pack_hdr) + \
+                                  sizeof(struct tfm_crypto_pack_iovec))
+
+/**
+ * \brief Gets the fields of the struct tfm_crypto_pack_iovec used by a service
+ *
+ * \param[in] srv_id  Crypto service ID
+ *
+ * \return TFM_CRYPTO_PACK_* fields of the service, 0 if srv_id is invalid
+ */
+static inline uint32_t tfm_crypto_pack_fields(uint32_t srv_id)
+{
+    static const uint8_t sid_fields[TFM_CRYPTO_SID_MAX] = {
+        [TFM_CRYPTO_GET_KEY_ATTRIBUTES_SID] = TFM_CRYPTO_PACK_KEY_ID,
+        [TFM_CRYPTO_RESET_KEY_ATTRIBUTES_SID] = 0,
+        [TFM_CRYPTO_OPEN_KEY_SID] = 0,
+        [TFM_CRYPTO_CLOSE_KEY_SID] = TFM_CRYPTO_PACK_KEY_ID,
+        [TFM_CRYPTO_IMPORT_KEY_SID] = 0,
+        [TFM_CRYPTO_DESTROY_KEY_SID] = TFM_CRYPTO_PACK_KEY_ID,
+        [TFM_CRYPTO_EXPORT_KEY_SID] = TFM_CRYPTO_PACK_KEY_ID,
+        [TFM_CRYPTO_EXPORT_PUBLIC_KEY_SID] = TFM_CRYPTO_PACK_KEY_ID,
+        [TFM_CRYPTO_PURGE_KEY_SID] = TFM_CRYPTO_PACK_KEY_ID,
+        [TFM_CRYPTO_COPY_KEY_SID] = TFM_CRYPTO_PACK_KEY_ID,
+        [TFM_CRYPTO_HASH_COMPUTE_SID] = TFM_CRYPTO_PACK_ALG,
+        [TFM_CRYPTO_HASH_COMPARE_SID] = TFM_CRYPTO_PACK_ALG,
+        [TFM_CRYPTO_HASH_SETUP_SID] =
+            TFM_CRYPTO_PACK_OP_HANDLE |
+            TFM_CRYPTO_PACK_ALG,
+        [TFM_CRYPTO_HASH_UPDATE_SID] = TFM_CRYPTO_PACK_OP_HANDLE,
+        [TFM_CRYPTO_HASH_FINISH_SID] = TFM_CRYPTO_PACK_OP_HANDLE,
+        [TFM_CRYPTO_HASH_VERIFY_SID] = TFM_CRYPTO_PACK_OP_HANDLE,
+        [TFM_CRYPTO_HASH_ABORT_SID] = TFM_CRYPTO_PACK_OP_HANDLE,
+        [TFM_CRYPTO_HASH_CLONE_SID] = TFM_CRYPTO_PACK_OP_HANDLE,
+        [TFM_CRYPTO_MAC_COMPUTE_SID] =
+            TFM_CRYPTO_PACK_KEY_ID |
+            TFM_CRYPTO_PACK_ALG,
+        [TFM_CRYPTO_MAC_VERIFY_SID] =
+            TFM_CRYPTO_PACK_KEY_ID |
+            TFM_CRYPTO_PACK_ALG,
+        [TFM_CRYPTO_MAC_SIGN_SETUP_SID] =
+            TFM_CRYPTO_PACK_OP_HANDLE |
+            TFM_CRYPTO_PACK_KEY_ID |
+            TFM_CRYPTO_PACK_ALG,
+        [TFM_CRYPTO_MAC_VERIFY_SETUP_SID] =
+            TFM_CRYPTO_PACK_OP_HANDLE |
+            TFM_CRYPTO_PACK_KEY_ID |
+            TFM_CRYPTO_PACK_ALG,
+        [TFM_CRYPTO_MAC_UPDATE_SID] = TFM_CRYPTO_PACK_OP_HANDLE,
+        [TFM_CRYPTO_MAC_SIGN_FINISH_SID] = TFM_CRYPTO_PACK_OP_HANDLE,
+        [TFM_CRYPTO_MAC_VERIFY_FINISH_SID] = TFM_CRYPTO_PACK_OP_HANDLE,
+        [TFM_CRYPTO_MAC_ABORT_SID] = TFM_CRYPTO_PACK_OP_HANDLE,
+        [TFM_CRYPTO_CIPHER_ENCRYPT_SID] =
+            TFM_CRYPTO_PACK_KEY_ID |
+            TFM_CRYPTO_PACK_ALG,
+        [TFM_CRYPTO_CIPHER_DECRYPT_SID] =
+            TFM_CRYPTO_PACK_KEY_ID |
+            TFM_CRYPTO_PACK_ALG,
+        [TFM_CRYPTO_CIPHER_ENCRYPT_SETUP_SID] =
+            TFM_CRYPTO_PACK_OP_HANDLE |
+            TFM_CRYPTO_PACK_KEY_ID |
+            TFM_CRYPTO_PACK_ALG,
+        [TFM_CRYPTO_CIPHER_DECRYPT_SETUP_SID] =
+            TFM_CRYPTO_PACK_OP_HANDLE |
+            TFM_CRYPTO_PACK_KEY_ID |
+            TFM_CRYPTO_PACK_ALG,
+        [TFM_CRYPTO_CIPHER_GENERATE_IV_SID] = TFM_CRYPTO_PACK_OP_HANDLE,
+        [TFM_CRYPTO_CIPHER_SET_IV_SID] = TFM_CRYPTO_PACK_OP_HANDLE,
+        [TFM_CRYPTO_CIPHER_UPDATE_SID] = TFM_CRYPTO_PACK_OP_HANDLE,
+        [TFM_CRYPTO_CIPHER_FINISH_SID] = TFM_CRYPTO_PACK_OP_HANDLE,
+        [TFM_CRYPTO_CIPHER_ABORT_SID] = TFM_CRYPTO_PACK_OP_HANDLE,
+        [TFM_CRYPTO_AEAD_ENCRYPT_SID] =
+            TFM_CRYPTO_PACK_KEY_ID |
+            TFM_CRYPTO_PACK_ALG |
+            TFM_CRYPTO_PACK_AEAD_IN,
+        [TFM_CRYPTO_AEAD_DECRYPT_SID] =
+            TFM_CRYPTO_PACK_KEY_ID |
+            TFM_CRYPTO_PACK_ALG |
+            TFM_CRYPTO_PACK_AEAD_IN,
+        [TFM_CRYPTO_AEAD_ENCRYPT_SETUP_SID] =
+            TFM_CRYPTO_PACK_OP_HANDLE |
+            TFM_CRYPTO_PACK_KEY_ID |
+            TFM_CRYPTO_PACK_ALG,
+        [TFM_CRYPTO_AEAD_DECRYPT_SETUP_SID] =
+            TFM_CRYPTO_PACK_OP_HANDLE |
+            TFM_CRYPTO_PACK_KEY_ID |
+            TFM_CRYPTO_PACK_ALG,
+        [TFM_CRYPTO_AEAD_GENERATE_NONCE_SID] = TFM_CRYPTO_PACK_OP_HANDLE,
+        [TFM_CRYPTO_AEAD_SET_NONCE_SID] = TFM_CRYPTO_PACK_OP_HANDLE,
+        [TFM_CRYPTO_AEAD_SET_LENGTHS_SID] =
+            TFM_CRYPTO_PACK_OP_HANDLE |
+            TFM_CRYPTO_PACK_AD_LENGTH |
+            TFM_CRYPTO_PACK_PLAINTEXT_LENGTH,
+        [TFM_CRYPTO_AEAD_UPDATE_AD_SID] = TFM_CRYPTO_PACK_OP_HANDLE,
+        [TFM_CRYPTO_AEAD_UPDATE_SID] = TFM_CRYPTO_PACK_OP_HANDLE,
+        [TFM_CRYPTO_AEAD_FINISH_SID] = TFM_CRYPTO_PACK_OP_HANDLE,
+        [TFM_CRYPTO_AEAD_VERIFY_SID] = TFM_CRYPTO_PACK_OP_HANDLE,
+        [TFM_CRYPTO_AEAD_ABORT_SID] = TFM_CRYPTO_PACK_OP_HANDLE,
+        [TFM_CRYPTO_SIGN_MESSAGE_SID] =
+            TFM_CRYPTO_PACK_KEY_ID |
+            TFM_CRYPTO_PACK_ALG,
+        [TFM_CRYPTO_VERIFY_MESSAGE_SID] =
+            TFM_CRYPTO_PACK_KEY_ID |
+            TFM_CRYPTO_PACK_ALG,
+        [TFM_CRYPTO_SIGN_HASH_SID] =
+            TFM_CRYPTO_PACK_KEY_ID |
+            TFM_CRYPTO_PACK_ALG,
+        [TFM_CRYPTO_VERIFY_HASH_SID] =
+            TFM_CRYPTO_PACK_KEY_ID |
+            TFM_CRYPTO_PACK_ALG,
+        [TFM_CRYPTO_ASYMMETRIC_ENCRYPT_SID] =
+            TFM_CRYPTO_PACK_KEY_ID |
+            TFM_CRYPTO_PACK_ALG,
+        [TFM_CRYPTO_ASYMMETRIC_DECRYPT_SID] =
+            TFM_CRYPTO_PACK_KEY_ID |
+            TFM_CRYPTO_PACK_ALG,
+        [TFM_CRYPTO_KEY_DERIVATION_SETUP_SID] =
+            TFM_CRYPTO_PACK_OP_HANDLE |
+            TFM_CRYPTO_PACK_ALG,
+        [TFM_CRYPTO_KEY_DERIVATION_GET_CAPACITY_SID] =
+            TFM_CRYPTO_PACK_OP_HANDLE,
+        [TFM_CRYPTO_KEY_DERIVATION_SET_CAPACITY_SID] =
+            TFM_CRYPTO_PACK_OP_HANDLE |
+            TFM_CRYPTO_PACK_CAPACITY,
+        [TFM_CRYPTO_KEY_DERIVATION_INPUT_BYTES_SID] =
+            TFM_CRYPTO_PACK_OP_HANDLE |
+            TFM_CRYPTO_PACK_STEP,
+        [TFM_CRYPTO_KEY_DERIVATION_INPUT_KEY_SID] =
+            TFM_CRYPTO_PACK_OP_HANDLE |
+            TFM_CRYPTO_PACK_STEP |
+            TFM_CRYPTO_PACK_KEY_ID,
+        [TFM_CRYPTO_KEY_DERIVATION_KEY_AGREEMENT_SID] =
+            TFM_CRYPTO_PACK_OP_HANDLE |
+            TFM_CRYPTO_PACK_STEP |
+            TFM_CRYPTO_PACK_KEY_ID,
+        [TFM_CRYPTO_KEY_DERIVATION_OUTPUT_BYTES_SID] =
+            TFM_CRYPTO_PACK_OP_HANDLE,
+        [TFM_CRYPTO_KEY_DERIVATION_OUTPUT_KEY_SID] = TFM_CRYPTO_PACK_OP_HANDLE,
+        [TFM_CRYPTO_KEY_DERIVATION_ABORT_SID] = TFM_CRYPTO_PACK_OP_HANDLE,
+        [TFM_CRYPTO_RAW_KEY_AGREEMENT_SID] =
+            TFM_CRYPTO_PACK_KEY_ID |
+            TFM_CRYPTO_PACK_ALG,
+        [TFM_CRYPTO_GENERATE_RANDOM_SID] = 0,
+        [TFM_CRYPTO_GENERATE_KEY_SID] = 0,
+        [TFM_CRYPTO_BATCH_SID] = TFM_CRYPTO_PACK_OP_HANDLE,
+    };
+
+    return (srv_id < TFM_CRYPTO_SID_MAX) ? sid_fields[srv_id] : 0;
+}
+
+/**
+ * \brief Encodes a struct tfm_crypto_pack_iovec with the fields used by its
+ *        service. The nonce length of an AEAD request must have been checked
+ *        against TFM_CRYPTO_MAX_NONCE_LENGTH.
+ *
+ * \param[in]  iov  Structure to encode
+ * \param[out] buf  Buffer of TFM_CRYPTO_PACK_MAX_SIZE bytes, 4-byte aligned
+ *
+ * \return Size of the encoding in bytes
+ */
+static inline size_t tfm_crypto_pack_encode(
+                                       const struct tfm_crypto_pack_iovec *iov,
+                                       void *buf)
+{
+    struct tfm_crypto_pack_hdr *hdr = buf;
+    uint8_t *p = (uint8_t *)buf + sizeof(*hdr);
+    uint32_t fields = tfm_crypto_pack_fields(iov->srv_id);
+    const uint8_t *src;
+    size_t i, n;
+
+    hdr->version = TFM_CRYPTO_PACK_VERSION;
+    hdr->reserved = 0;
+    hdr->srv_id = (uint16_t)iov->srv_id;
+
+#define X(flag, member)                                                \
+    if (fields & (flag)) {                                             \
+        src = (const uint8_t *)&iov->member;                           \
+        n = TFM_CRYPTO_PACK_ALIGN(sizeof(iov->member));                \
+        for (i = 0; i < n; i++) {                                      \
+            p[i] = (i < sizeof(iov->member)) ? src[i] : 0;             \
+        }                                                              \
+        p += n;                                                        \
+    }
+    LIST_TFM_CRYPTO_PACK_FIELDS
+#undef X
+
+    if (fields & TFM_CRYPTO_PACK_AEAD_IN) {
+        *(uint32_t *)p = iov->aead_in.nonce_length;
+        p += sizeof(uint32_t);
+        n = TFM_CRYPTO_PACK_ALIGN(iov->aead_in.nonce_length);
+        for (i = 0; i < n; i++) {
+            p[i] = (i < iov->aead_in.nonce_length) ? iov->aead_in.nonce[i] : 0;
+        }
+        p += n;
+    }
+
+    return (size_t)(p - (uint8_t *)buf);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TFM_CRYPTO_PACK_H__ */
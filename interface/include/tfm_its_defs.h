@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019-2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2019-2022, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -20,6 +20,13 @@ extern "C" {
 #define TFM_ITS_GET                1002
 #define TFM_ITS_GET_INFO           1003
 #define TFM_ITS_REMOVE             1004
+#define TFM_ITS_TXN_BEGIN          1005
+#define TFM_ITS_TXN_COMMIT         1006
+#define TFM_ITS_TXN_ABORT          1007
+#define TFM_ITS_CREATE             1008
+#define TFM_ITS_SET_EXTENDED       1009
+#define TFM_ITS_LIST               1010
+#define TFM_ITS_GET_CAPACITY       1011
 
 #ifdef __cplusplus
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2017-2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2017-2022, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -21,6 +21,11 @@ extern "C" {
 #define TFM_PS_GET_INFO           1003
 #define TFM_PS_REMOVE             1004
 #define TFM_PS_GET_SUPPORT        1005
+#define TFM_PS_CREATE             1006
+#define TFM_PS_SET_EXTENDED       1007
+#define TFM_PS_FLUSH              1008
+#define TFM_PS_LIST               1009
+#define TFM_PS_GET_CAPACITY       1010
 
 #ifdef __cplusplus
 }
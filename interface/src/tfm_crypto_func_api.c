@@ -1719,3 +1719,27 @@ psa_status_t psa_key_derivation_output_key(
                           TFM_CRYPTO_KEY_DERIVATION_OUTPUT_KEY);
     return status;
 }
+
+psa_status_t tfm_crypto_batch_call(uint32_t *op_handle,
+                                   const struct tfm_crypto_batch_step_t *steps,
+                                   size_t num_steps,
+                                   const void *input,
+                                   size_t input_length,
+                                   void *output,
+                                   size_t output_size,
+                                   struct tfm_crypto_batch_result_t *results,
+                                   size_t *num_results)
+{
+    (void)op_handle;
+    (void)steps;
+    (void)num_steps;
+    (void)input;
+    (void)input_length;
+    (void)output;
+    (void)output_size;
+    (void)results;
+    (void)num_results;
+
+    /* Batched requests are only supported by the IPC model */
+    return PSA_ERROR_NOT_SUPPORTED;
+}
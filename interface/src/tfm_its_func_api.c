@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019-2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2019-2022, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -103,3 +103,51 @@ psa_status_t psa_its_remove(psa_storage_uid_t uid)
                                      (uint32_t)in_vec, IOVEC_LEN(in_vec),
                                      (uint32_t)NULL, 0);
 }
+
+psa_status_t psa_its_create(psa_storage_uid_t uid,
+                            size_t capacity,
+                            psa_storage_create_flags_t create_flags)
+{
+    (void)uid;
+    (void)capacity;
+    (void)create_flags;
+
+    /* Not supported in the library model */
+    return PSA_ERROR_NOT_SUPPORTED;
+}
+
+psa_status_t psa_its_set_extended(psa_storage_uid_t uid,
+                                  size_t data_offset,
+                                  size_t data_length,
+                                  const void *p_data)
+{
+    (void)uid;
+    (void)data_offset;
+    (void)data_length;
+    (void)p_data;
+
+    /* Not supported in the library model */
+    return PSA_ERROR_NOT_SUPPORTED;
+}
+
+psa_status_t psa_its_list(psa_storage_uid_t after_uid,
+                          size_t num_entries,
+                          struct psa_storage_uid_info_t *p_entries,
+                          size_t *p_num_entries)
+{
+    (void)after_uid;
+    (void)num_entries;
+    (void)p_entries;
+    (void)p_num_entries;
+
+    /* Not supported in the library model */
+    return PSA_ERROR_NOT_SUPPORTED;
+}
+
+psa_status_t psa_its_get_capacity(struct psa_storage_capacity_t *p_capacity)
+{
+    (void)p_capacity;
+
+    /* Not supported in the library model */
+    return PSA_ERROR_NOT_SUPPORTED;
+}
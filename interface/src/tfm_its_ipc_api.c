@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019-2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2019-2022, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -92,3 +92,70 @@ psa_status_t psa_its_remove(psa_storage_uid_t uid)
 
     return status;
 }
+
+psa_status_t psa_its_create(psa_storage_uid_t uid,
+                            size_t capacity,
+                            psa_storage_create_flags_t create_flags)
+{
+    psa_invec in_vec[] = {
+        { .base = &uid, .len = sizeof(uid) },
+        { .base = &capacity, .len = sizeof(capacity) },
+        { .base = &create_flags, .len = sizeof(create_flags) }
+    };
+
+    return psa_call(TFM_INTERNAL_TRUSTED_STORAGE_SERVICE_HANDLE, TFM_ITS_CREATE,
+                    in_vec, IOVEC_LEN(in_vec), NULL, 0);
+}
+
+psa_status_t psa_its_set_extended(psa_storage_uid_t uid,
+                                  size_t data_offset,
+                                  size_t data_length,
+                                  const void *p_data)
+{
+    psa_invec in_vec[] = {
+        { .base = &uid, .len = sizeof(uid) },
+        { .base = p_data, .len = data_length },
+        { .base = &data_offset, .len = sizeof(data_offset) }
+    };
+
+    return psa_call(TFM_INTERNAL_TRUSTED_STORAGE_SERVICE_HANDLE,
+                    TFM_ITS_SET_EXTENDED, in_vec, IOVEC_LEN(in_vec), NULL, 0);
+}
+
+psa_status_t psa_its_list(psa_storage_uid_t after_uid,
+                          size_t num_entries,
+                          struct psa_storage_uid_info_t *p_entries,
+                          size_t *p_num_entries)
+{
+    psa_status_t status;
+
+    psa_invec in_vec[] = {
+        { .base = &after_uid, .len = sizeof(after_uid) }
+    };
+
+    psa_outvec out_vec[] = {
+        { .base = p_entries, .len = num_entries * sizeof(*p_entries) }
+    };
+
+    if (p_num_entries == NULL) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    status = psa_call(TFM_INTERNAL_TRUSTED_STORAGE_SERVICE_HANDLE,
+                      TFM_ITS_LIST, in_vec, IOVEC_LEN(in_vec),
+                      out_vec, IOVEC_LEN(out_vec));
+
+    *p_num_entries = out_vec[0].len / sizeof(*p_entries);
+
+    return status;
+}
+
+psa_status_t psa_its_get_capacity(struct psa_storage_capacity_t *p_capacity)
+{
+    psa_outvec out_vec[] = {
+        { .base = p_capacity, .len = sizeof(*p_capacity) }
+    };
+
+    return psa_call(TFM_INTERNAL_TRUSTED_STORAGE_SERVICE_HANDLE,
+                    TFM_ITS_GET_CAPACITY, NULL, 0, out_vec, IOVEC_LEN(out_vec));
+}
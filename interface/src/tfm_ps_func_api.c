@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2017-2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2017-2022, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -106,6 +106,7 @@ psa_status_t psa_ps_create(psa_storage_uid_t uid,
     (void)capacity;
     (void)create_flags;
 
+    /* Not supported in the library model */
     return PSA_ERROR_NOT_SUPPORTED;
 }
 
@@ -117,6 +118,13 @@ psa_status_t psa_ps_set_extended(psa_storage_uid_t uid, size_t data_offset,
     (void)data_length;
     (void)p_data;
 
+    /* Not supported in the library model */
+    return PSA_ERROR_NOT_SUPPORTED;
+}
+
+psa_status_t psa_ps_flush(void)
+{
+    /* Not supported in the library model */
     return PSA_ERROR_NOT_SUPPORTED;
 }
 
@@ -137,3 +145,25 @@ uint32_t psa_ps_get_support(void)
 
     return support_flags;
 }
+
+psa_status_t psa_ps_list(psa_storage_uid_t after_uid,
+                         size_t num_entries,
+                         struct psa_storage_uid_info_t *p_entries,
+                         size_t *p_num_entries)
+{
+    (void)after_uid;
+    (void)num_entries;
+    (void)p_entries;
+    (void)p_num_entries;
+
+    /* Not supported in the library model */
+    return PSA_ERROR_NOT_SUPPORTED;
+}
+
+psa_status_t psa_ps_get_capacity(struct psa_storage_capacity_t *p_capacity)
+{
+    (void)p_capacity;
+
+    /* Not supported in the library model */
+    return PSA_ERROR_NOT_SUPPORTED;
+}
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2017-2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2017-2022, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -95,22 +95,45 @@ psa_status_t psa_ps_remove(psa_storage_uid_t uid)
 psa_status_t psa_ps_create(psa_storage_uid_t uid, size_t size,
                            psa_storage_create_flags_t create_flags)
 {
-    (void)uid;
-    (void)size;
-    (void)create_flags;
+    psa_status_t status;
 
-    return PSA_ERROR_NOT_SUPPORTED;
+    psa_invec in_vec[] = {
+        { .base = &uid, .len = sizeof(uid) },
+        { .base = &size, .len = sizeof(size) },
+        { .base = &create_flags, .len = sizeof(create_flags) }
+    };
+
+    status = psa_call(TFM_PROTECTED_STORAGE_SERVICE_HANDLE, TFM_PS_CREATE,
+                      in_vec, IOVEC_LEN(in_vec), NULL, 0);
+
+    return status;
 }
 
 psa_status_t psa_ps_set_extended(psa_storage_uid_t uid, size_t data_offset,
                                  size_t data_length, const void *p_data)
 {
-    (void)uid;
-    (void)data_offset;
-    (void)data_length;
-    (void)p_data;
+    psa_status_t status;
 
-    return PSA_ERROR_NOT_SUPPORTED;
+    psa_invec in_vec[] = {
+        { .base = &uid, .len = sizeof(uid) },
+        { .base = p_data, .len = data_length },
+        { .base = &data_offset, .len = sizeof(data_offset) }
+    };
+
+    status = psa_call(TFM_PROTECTED_STORAGE_SERVICE_HANDLE,
+                      TFM_PS_SET_EXTENDED, in_vec, IOVEC_LEN(in_vec), NULL, 0);
+
+    return status;
+}
+
+psa_status_t psa_ps_flush(void)
+{
+    psa_status_t status;
+
+    status = psa_call(TFM_PROTECTED_STORAGE_SERVICE_HANDLE, TFM_PS_FLUSH,
+                      NULL, 0, NULL, 0);
+
+    return status;
 }
 
 uint32_t psa_ps_get_support(void)
@@ -132,3 +155,40 @@ uint32_t psa_ps_get_support(void)
 
     return support_flags;
 }
+
+psa_status_t psa_ps_list(psa_storage_uid_t after_uid,
+                         size_t num_entries,
+                         struct psa_storage_uid_info_t *p_entries,
+                         size_t *p_num_entries)
+{
+    psa_status_t status;
+
+    psa_invec in_vec[] = {
+        { .base = &after_uid, .len = sizeof(after_uid) }
+    };
+
+    psa_outvec out_vec[] = {
+        { .base = p_entries, .len = num_entries * sizeof(*p_entries) }
+    };
+
+    if (p_num_entries == NULL) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    status = psa_call(TFM_PROTECTED_STORAGE_SERVICE_HANDLE, TFM_PS_LIST,
+                      in_vec, IOVEC_LEN(in_vec), out_vec, IOVEC_LEN(out_vec));
+
+    *p_num_entries = out_vec[0].len / sizeof(*p_entries);
+
+    return status;
+}
+
+psa_status_t psa_ps_get_capacity(struct psa_storage_capacity_t *p_capacity)
+{
+    psa_outvec out_vec[] = {
+        { .base = p_capacity, .len = sizeof(*p_capacity) }
+    };
+
+    return psa_call(TFM_PROTECTED_STORAGE_SERVICE_HANDLE, TFM_PS_GET_CAPACITY,
+                    NULL, 0, out_vec, IOVEC_LEN(out_vec));
+}
@@ -17,69 +17,222 @@
 /**
  * \def TFM_CRYPTO_CONC_OPER_NUM
  *
- * \brief This is the default value for the maximum number of concurrent
- *        operations that can be active (allocated) at any time, supported
- *        by the implementation
+ * \brief This is the default value for the number of operation contexts in
+ *        the shared pool, which can hold an operation of any type. It is used
+ *        for the operations of a type whose dedicated pool is full or not
+ *        configured.
  */
 #ifndef TFM_CRYPTO_CONC_OPER_NUM
 #define TFM_CRYPTO_CONC_OPER_NUM (8)
 #endif
 
+/**
+ * \def TFM_CRYPTO_CIPHER_OPER_NUM
+ * \def TFM_CRYPTO_MAC_OPER_NUM
+ * \def TFM_CRYPTO_HASH_OPER_NUM
+ * \def TFM_CRYPTO_KEY_DERIVATION_OPER_NUM
+ * \def TFM_CRYPTO_AEAD_OPER_NUM
+ *
+ * \brief Number of operation contexts in the dedicated pool of each operation
+ *        type. Each context of a dedicated pool is only as large as the
+ *        operations of its type, unlike those of the shared pool which are
+ *        sized for the largest operation. By default, there are no dedicated
+ *        pools.
+ */
+#ifndef TFM_CRYPTO_CIPHER_OPER_NUM
+#define TFM_CRYPTO_CIPHER_OPER_NUM (0)
+#endif
+
+#ifndef TFM_CRYPTO_MAC_OPER_NUM
+#define TFM_CRYPTO_MAC_OPER_NUM (0)
+#endif
+
+#ifndef TFM_CRYPTO_HASH_OPER_NUM
+#define TFM_CRYPTO_HASH_OPER_NUM (0)
+#endif
+
+#ifndef TFM_CRYPTO_KEY_DERIVATION_OPER_NUM
+#define TFM_CRYPTO_KEY_DERIVATION_OPER_NUM (0)
+#endif
+
+#ifndef TFM_CRYPTO_AEAD_OPER_NUM
+#define TFM_CRYPTO_AEAD_OPER_NUM (0)
+#endif
+
+/**
+ * \brief Number of pools: the shared pool, at the index of
+ *        TFM_CRYPTO_OPERATION_NONE, and the dedicated pool of each operation
+ *        type, at the index of the type.
+ */
+#define TFM_CRYPTO_NUM_POOLS (TFM_CRYPTO_AEAD_OPERATION + 1)
+
+/**
+ * \brief Value of the free list link of the last free slot of a pool
+ */
+#define TFM_CRYPTO_POOL_END (UINT32_MAX)
+
 struct tfm_crypto_operation_s {
     uint32_t in_use;                /*!< Indicates if the operation is in use */
     int32_t owner;                  /*!< Indicates an ID of the owner of
                                      *   the context
                                      */
     enum tfm_crypto_operation_type type; /*!< Type of the operation */
-    union {
-        psa_cipher_operation_t cipher;    /*!< Cipher operation context */
-        psa_mac_operation_t mac;          /*!< MAC operation context */
-        psa_hash_operation_t hash;        /*!< Hash operation context */
-        psa_key_derivation_operation_t key_deriv; /*!< Key derivation operation context */
-        psa_aead_operation_t aead;        /*!< AEAD operation context */
-    } operation;
+    uint32_t next_free;             /*!< Index of the next free slot of the
+                                     *   pool, if the slot is free
+                                     */
 };
 
-static struct tfm_crypto_operation_s operation[TFM_CRYPTO_CONC_OPER_NUM] ={{0}};
+union tfm_crypto_operation_u {
+    psa_cipher_operation_t cipher;    /*!< Cipher operation context */
+    psa_mac_operation_t mac;          /*!< MAC operation context */
+    psa_hash_operation_t hash;        /*!< Hash operation context */
+    psa_key_derivation_operation_t key_deriv; /*!< Key derivation operation context */
+    psa_aead_operation_t aead;        /*!< AEAD operation context */
+};
+
+struct tfm_crypto_pool_s {
+    uint8_t *ctx;                       /*!< Operation contexts */
+    size_t ctx_size;                    /*!< Size of each operation context */
+    struct tfm_crypto_operation_s *op;  /*!< Slot of each operation context */
+    uint32_t num_slots;                 /*!< Number of slots of the pool */
+    uint32_t handle_base;               /*!< Handle of the first slot, minus
+                                         *   one
+                                         */
+    uint32_t free_head;                 /*!< Index of the first free slot */
+    uint32_t in_use;                    /*!< Number of slots in use */
+    uint32_t max_in_use;                /*!< Largest number of slots in use
+                                         *   since initialisation
+                                         */
+};
+
+#if (TFM_CRYPTO_CONC_OPER_NUM > 0)
+static union tfm_crypto_operation_u shared_ctx[TFM_CRYPTO_CONC_OPER_NUM];
+static struct tfm_crypto_operation_s shared_op[TFM_CRYPTO_CONC_OPER_NUM];
+#endif
+#if (TFM_CRYPTO_CIPHER_OPER_NUM > 0)
+static psa_cipher_operation_t cipher_ctx[TFM_CRYPTO_CIPHER_OPER_NUM];
+static struct tfm_crypto_operation_s cipher_op[TFM_CRYPTO_CIPHER_OPER_NUM];
+#endif
+#if (TFM_CRYPTO_MAC_OPER_NUM > 0)
+static psa_mac_operation_t mac_ctx[TFM_CRYPTO_MAC_OPER_NUM];
+static struct tfm_crypto_operation_s mac_op[TFM_CRYPTO_MAC_OPER_NUM];
+#endif
+#if (TFM_CRYPTO_HASH_OPER_NUM > 0)
+static psa_hash_operation_t hash_ctx[TFM_CRYPTO_HASH_OPER_NUM];
+static struct tfm_crypto_operation_s hash_op[TFM_CRYPTO_HASH_OPER_NUM];
+#endif
+#if (TFM_CRYPTO_KEY_DERIVATION_OPER_NUM > 0)
+static psa_key_derivation_operation_t
+                            key_deriv_ctx[TFM_CRYPTO_KEY_DERIVATION_OPER_NUM];
+static struct tfm_crypto_operation_s
+                            key_deriv_op[TFM_CRYPTO_KEY_DERIVATION_OPER_NUM];
+#endif
+#if (TFM_CRYPTO_AEAD_OPER_NUM > 0)
+static psa_aead_operation_t aead_ctx[TFM_CRYPTO_AEAD_OPER_NUM];
+static struct tfm_crypto_operation_s aead_op[TFM_CRYPTO_AEAD_OPER_NUM];
+#endif
+
+static struct tfm_crypto_pool_s pool[TFM_CRYPTO_NUM_POOLS];
 
 /*
- * \brief Function used to clear the memory associated to a backend context
+ * \brief Function used to get the size of the backend context of an operation
  *
- * \param[in] index Numerical index in the database of the backend contexts
+ * \param[in] type Type of the operation
  *
- * \return None
+ * \return Size of the context in bytes
  *
  */
-static void memset_operation_context(uint32_t index)
+static size_t operation_context_size(enum tfm_crypto_operation_type type)
 {
-    uint32_t mem_size;
-
-    uint8_t *mem_ptr = (uint8_t *) &(operation[index].operation);
-
-    switch(operation[index].type) {
+    switch(type) {
     case TFM_CRYPTO_CIPHER_OPERATION:
-        mem_size = sizeof(psa_cipher_operation_t);
-        break;
+        return sizeof(psa_cipher_operation_t);
     case TFM_CRYPTO_MAC_OPERATION:
-        mem_size = sizeof(psa_mac_operation_t);
-        break;
+        return sizeof(psa_mac_operation_t);
     case TFM_CRYPTO_HASH_OPERATION:
-        mem_size = sizeof(psa_hash_operation_t);
-        break;
+        return sizeof(psa_hash_operation_t);
     case TFM_CRYPTO_KEY_DERIVATION_OPERATION:
-        mem_size = sizeof(psa_key_derivation_operation_t);
-        break;
+        return sizeof(psa_key_derivation_operation_t);
     case TFM_CRYPTO_AEAD_OPERATION:
-        mem_size = sizeof(psa_aead_operation_t);
-        break;
+        return sizeof(psa_aead_operation_t);
     case TFM_CRYPTO_OPERATION_NONE:
     default:
-        mem_size = 0;
-        break;
+        return 0;
+    }
+}
+
+/*
+ * \brief Function used to set up a pool, with all its slots free
+ *
+ * \param[in] type      Type of the operations of the pool, or
+ *                      TFM_CRYPTO_OPERATION_NONE for the shared pool
+ * \param[in] ctx       Operation contexts of the pool
+ * \param[in] ctx_size  Size of each operation context
+ * \param[in] op        Slots of the pool
+ * \param[in] num_slots Number of slots of the pool
+ *
+ * \return None
+ *
+ */
+static void pool_setup(enum tfm_crypto_operation_type type, void *ctx,
+                       size_t ctx_size, struct tfm_crypto_operation_s *op,
+                       uint32_t num_slots)
+{
+    struct tfm_crypto_pool_s *p = &pool[type];
+    uint32_t i;
+
+    p->ctx = (uint8_t *)ctx;
+    p->ctx_size = ctx_size;
+    p->op = op;
+    p->num_slots = num_slots;
+    p->handle_base = (type == TFM_CRYPTO_OPERATION_NONE) ? 0 :
+                     pool[type - 1].handle_base + pool[type - 1].num_slots;
+    p->free_head = (num_slots > 0) ? 0 : TFM_CRYPTO_POOL_END;
+    p->in_use = 0;
+    p->max_in_use = 0;
+
+    if (num_slots == 0) {
+        return;
+    }
+
+    (void)tfm_memset(ctx, 0, ctx_size * num_slots);
+    (void)tfm_memset(op, 0, sizeof(*op) * num_slots);
+
+    for (i = 0; i < num_slots; i++) {
+        op[i].next_free = (i + 1 < num_slots) ? (i + 1) : TFM_CRYPTO_POOL_END;
+    }
+}
+
+/*
+ * \brief Function used to find the slot of a handle
+ *
+ * \param[in]  handle Handle of the operation
+ * \param[out] p      Pool of the slot
+ * \param[out] index  Index of the slot in the pool
+ *
+ * \return Slot of the handle, or NULL if the handle is not valid
+ *
+ */
+static struct tfm_crypto_operation_s *handle_to_slot(uint32_t handle,
+                                                    struct tfm_crypto_pool_s **p,
+                                                    uint32_t *index)
+{
+    uint32_t i;
+
+    if (handle == TFM_CRYPTO_INVALID_HANDLE) {
+        return NULL;
     }
 
-    /* Clear the contents of the backend context */
-    (void)tfm_memset(mem_ptr, 0, mem_size);
+    for (i = 0; i < TFM_CRYPTO_NUM_POOLS; i++) {
+        if ((handle > pool[i].handle_base) &&
+            (handle - pool[i].handle_base <= pool[i].num_slots)) {
+            *p = &pool[i];
+            *index = handle - pool[i].handle_base - 1;
+            return &pool[i].op[*index];
+        }
+    }
+
+    return NULL;
 }
 
 /*!
@@ -90,8 +243,47 @@ static void memset_operation_context(uint32_t index)
 /*!@{*/
 psa_status_t tfm_crypto_init_alloc(void)
 {
-    /* Clear the contents of the local contexts */
-    (void)tfm_memset(operation, 0, sizeof(operation));
+    /* Set up the pools, with the contents of the local contexts cleared. A
+     * pool without slots is set up with NULL arrays.
+     */
+#if (TFM_CRYPTO_CONC_OPER_NUM > 0)
+    pool_setup(TFM_CRYPTO_OPERATION_NONE, shared_ctx, sizeof(shared_ctx[0]),
+               shared_op, TFM_CRYPTO_CONC_OPER_NUM);
+#else
+    pool_setup(TFM_CRYPTO_OPERATION_NONE, NULL, 0, NULL, 0);
+#endif
+#if (TFM_CRYPTO_CIPHER_OPER_NUM > 0)
+    pool_setup(TFM_CRYPTO_CIPHER_OPERATION, cipher_ctx, sizeof(cipher_ctx[0]),
+               cipher_op, TFM_CRYPTO_CIPHER_OPER_NUM);
+#else
+    pool_setup(TFM_CRYPTO_CIPHER_OPERATION, NULL, 0, NULL, 0);
+#endif
+#if (TFM_CRYPTO_MAC_OPER_NUM > 0)
+    pool_setup(TFM_CRYPTO_MAC_OPERATION, mac_ctx, sizeof(mac_ctx[0]),
+               mac_op, TFM_CRYPTO_MAC_OPER_NUM);
+#else
+    pool_setup(TFM_CRYPTO_MAC_OPERATION, NULL, 0, NULL, 0);
+#endif
+#if (TFM_CRYPTO_HASH_OPER_NUM > 0)
+    pool_setup(TFM_CRYPTO_HASH_OPERATION, hash_ctx, sizeof(hash_ctx[0]),
+               hash_op, TFM_CRYPTO_HASH_OPER_NUM);
+#else
+    pool_setup(TFM_CRYPTO_HASH_OPERATION, NULL, 0, NULL, 0);
+#endif
+#if (TFM_CRYPTO_KEY_DERIVATION_OPER_NUM > 0)
+    pool_setup(TFM_CRYPTO_KEY_DERIVATION_OPERATION, key_deriv_ctx,
+               sizeof(key_deriv_ctx[0]), key_deriv_op,
+               TFM_CRYPTO_KEY_DERIVATION_OPER_NUM);
+#else
+    pool_setup(TFM_CRYPTO_KEY_DERIVATION_OPERATION, NULL, 0, NULL, 0);
+#endif
+#if (TFM_CRYPTO_AEAD_OPER_NUM > 0)
+    pool_setup(TFM_CRYPTO_AEAD_OPERATION, aead_ctx, sizeof(aead_ctx[0]),
+               aead_op, TFM_CRYPTO_AEAD_OPER_NUM);
+#else
+    pool_setup(TFM_CRYPTO_AEAD_OPERATION, NULL, 0, NULL, 0);
+#endif
+
     return PSA_SUCCESS;
 }
 
@@ -99,6 +291,8 @@ psa_status_t tfm_crypto_operation_alloc(enum tfm_crypto_operation_type type,
                                         uint32_t *handle,
                                         void **ctx)
 {
+    struct tfm_crypto_pool_s *p = NULL;
+    struct tfm_crypto_operation_s *op;
     uint32_t i = 0;
     int32_t partition_id = 0;
     psa_status_t status;
@@ -110,9 +304,10 @@ psa_status_t tfm_crypto_operation_alloc(enum tfm_crypto_operation_type type,
 
     /* Handle must be initialised before calling a setup function */
     if (*handle != TFM_CRYPTO_INVALID_HANDLE) {
-        if ((*handle <= TFM_CRYPTO_CONC_OPER_NUM) &&
-            (operation[*handle - 1].in_use == TFM_CRYPTO_IN_USE) &&
-            (operation[*handle - 1].owner == partition_id)) {
+        op = handle_to_slot(*handle, &p, &i);
+        if ((op != NULL) &&
+            (op->in_use == TFM_CRYPTO_IN_USE) &&
+            (op->owner == partition_id)) {
             /* The handle is a valid one for already in progress operation */
             return PSA_ERROR_BAD_STATE;
         }
@@ -126,23 +321,43 @@ psa_status_t tfm_crypto_operation_alloc(enum tfm_crypto_operation_type type,
     }
     *ctx = NULL;
 
-    for (i=0; i<TFM_CRYPTO_CONC_OPER_NUM; i++) {
-        if (operation[i].in_use == TFM_CRYPTO_NOT_IN_USE) {
-            operation[i].in_use = TFM_CRYPTO_IN_USE;
-            operation[i].owner = partition_id;
-            operation[i].type = type;
-            *handle = i + 1;
-            *ctx = (void *) &(operation[i].operation);
-            return PSA_SUCCESS;
+    if ((type == TFM_CRYPTO_OPERATION_NONE) ||
+        ((uint32_t)type >= TFM_CRYPTO_NUM_POOLS)) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    /* Use the dedicated pool of the type, or the shared pool if it is full */
+    p = &pool[type];
+    if (p->free_head == TFM_CRYPTO_POOL_END) {
+        p = &pool[TFM_CRYPTO_OPERATION_NONE];
+        if (p->free_head == TFM_CRYPTO_POOL_END) {
+            return PSA_ERROR_NOT_PERMITTED;
         }
     }
 
-    return PSA_ERROR_NOT_PERMITTED;
+    i = p->free_head;
+    op = &p->op[i];
+    p->free_head = op->next_free;
+    p->in_use++;
+    if (p->in_use > p->max_in_use) {
+        p->max_in_use = p->in_use;
+    }
+
+    op->in_use = TFM_CRYPTO_IN_USE;
+    op->owner = partition_id;
+    op->type = type;
+    op->next_free = TFM_CRYPTO_POOL_END;
+    *handle = p->handle_base + i + 1;
+    *ctx = (void *)&p->ctx[i * p->ctx_size];
+
+    return PSA_SUCCESS;
 }
 
 psa_status_t tfm_crypto_operation_release(uint32_t *handle)
 {
-    uint32_t h_val = *handle;
+    struct tfm_crypto_pool_s *p = NULL;
+    struct tfm_crypto_operation_s *op;
+    uint32_t i = 0;
     int32_t partition_id = 0;
     psa_status_t status;
 
@@ -151,15 +366,20 @@ psa_status_t tfm_crypto_operation_release(uint32_t *handle)
         return status;
     }
 
-    if ( (h_val != TFM_CRYPTO_INVALID_HANDLE) &&
-         (h_val <= TFM_CRYPTO_CONC_OPER_NUM) &&
-         (operation[h_val - 1].in_use == TFM_CRYPTO_IN_USE) &&
-         (operation[h_val - 1].owner == partition_id)) {
+    op = handle_to_slot(*handle, &p, &i);
+    if ((op != NULL) &&
+        (op->in_use == TFM_CRYPTO_IN_USE) &&
+        (op->owner == partition_id)) {
 
-        memset_operation_context(h_val - 1);
-        operation[h_val - 1].in_use = TFM_CRYPTO_NOT_IN_USE;
-        operation[h_val - 1].type = TFM_CRYPTO_OPERATION_NONE;
-        operation[h_val - 1].owner = 0;
+        /* Clear the contents of the backend context */
+        (void)tfm_memset(&p->ctx[i * p->ctx_size], 0,
+                         operation_context_size(op->type));
+        op->in_use = TFM_CRYPTO_NOT_IN_USE;
+        op->type = TFM_CRYPTO_OPERATION_NONE;
+        op->owner = 0;
+        op->next_free = p->free_head;
+        p->free_head = i;
+        p->in_use--;
         *handle = TFM_CRYPTO_INVALID_HANDLE;
         return PSA_SUCCESS;
     }
@@ -171,6 +391,9 @@ psa_status_t tfm_crypto_operation_lookup(enum tfm_crypto_operation_type type,
                                          uint32_t handle,
                                          void **ctx)
 {
+    struct tfm_crypto_pool_s *p = NULL;
+    struct tfm_crypto_operation_s *op;
+    uint32_t i = 0;
     int32_t partition_id = 0;
     psa_status_t status;
 
@@ -179,16 +402,32 @@ psa_status_t tfm_crypto_operation_lookup(enum tfm_crypto_operation_type type,
         return status;
     }
 
-    if ( (handle != TFM_CRYPTO_INVALID_HANDLE) &&
-         (handle <= TFM_CRYPTO_CONC_OPER_NUM) &&
-         (operation[handle - 1].in_use == TFM_CRYPTO_IN_USE) &&
-         (operation[handle - 1].type == type) &&
-         (operation[handle - 1].owner == partition_id)) {
+    op = handle_to_slot(handle, &p, &i);
+    if ((op != NULL) &&
+        (op->in_use == TFM_CRYPTO_IN_USE) &&
+        (op->type == type) &&
+        (op->owner == partition_id)) {
 
-        *ctx = (void *) &(operation[handle - 1].operation);
+        *ctx = (void *)&p->ctx[i * p->ctx_size];
         return PSA_SUCCESS;
     }
 
     return PSA_ERROR_BAD_STATE;
 }
+
+psa_status_t tfm_crypto_operation_get_usage(
+                                    enum tfm_crypto_operation_type type,
+                                    struct tfm_crypto_pool_usage_t *usage)
+{
+    if (((uint32_t)type >= TFM_CRYPTO_NUM_POOLS) || (usage == NULL)) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    usage->num_slots = pool[type].num_slots;
+    usage->slot_size = pool[type].ctx_size;
+    usage->in_use = pool[type].in_use;
+    usage->max_in_use = pool[type].max_in_use;
+
+    return PSA_SUCCESS;
+}
 /*!@}*/
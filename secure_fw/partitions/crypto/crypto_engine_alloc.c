@@ -0,0 +1,565 @@
+/*
+ * Copyright (c) 2022, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tfm_mbedcrypto_include.h"
+
+#include "tfm_crypto_api.h"
+#include "tfm_memory_utils.h"
+
+#if defined(TFM_CRYPTO_ENGINE_SIZE_CLASS_ALLOC) && defined(TFM_PSA_API)
+#include "psa/service.h"
+#endif
+
+#ifdef TFM_CRYPTO_ENGINE_SIZE_CLASS_ALLOC
+/*
+ * The heap of the crypto backend is split on demand into blocks of a fixed set
+ * of sizes. A freed block is kept in the free list of its size class, so
+ * blocks are never split or merged. A request is served by the smallest class
+ * large enough, or by a larger class when that one has no block left.
+ * Allocation and release take a bounded time, and once every class has reached
+ * the largest number of blocks it needs, allocations can no longer fail
+ * because of fragmentation.
+ *
+ * The blocks are carved for good, so the end of the heap is kept as a
+ * first-fit heap instead. It serves the requests larger than the largest
+ * class, and the requests for which no class has a block left, for example
+ * when the workload moves to other sizes once the classes it used first have
+ * taken the rest of the heap.
+ *
+ * Each block and chunk starts with a marker, which is checked when it is freed
+ * and when the first-fit heap is walked. A release of a pointer which is not
+ * an allocation in use, such as a double free, or a corrupted header means
+ * that the heap can no longer be trusted, and stops the service.
+ */
+
+/**
+ * \brief Alignment of the blocks returned by the allocator
+ */
+#define ENGINE_ALLOC_ALIGN (8u)
+
+/**
+ * \brief Marker of the header of a block in use
+ */
+#define ENGINE_ALLOC_MAGIC (0xA10Cu)
+
+/**
+ * \brief Markers of the header of a chunk of the first-fit heap
+ */
+#define ENGINE_ALLOC_CHUNK_IN_USE (0xA10CC0DEu)
+#define ENGINE_ALLOC_CHUNK_FREE   (0xF4EEC0DEu)
+
+/**
+ * \brief Value of the next field of the last block of a free list
+ */
+#define ENGINE_ALLOC_LIST_END (UINT32_MAX)
+
+/**
+ * \brief Payload sizes of the size classes. Mbed TLS allocates mostly bignum
+ *        limbs, ECP points and tables, key buffers and ASN.1 data, whose
+ *        sizes are spread between a few bytes and a few kilobytes. The classes
+ *        follow powers of two with an intermediate step, which keeps the
+ *        space lost to rounding below a third of each block.
+ */
+static const uint16_t class_size[] = {
+    16, 24, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048,
+    3072, 4096
+};
+
+#define ENGINE_ALLOC_NUM_CLASSES (sizeof(class_size) / sizeof(class_size[0]))
+
+#define ENGINE_ALLOC_ALIGN_UP(x) (((x) + (ENGINE_ALLOC_ALIGN - 1)) & \
+                                  ~((size_t)ENGINE_ALLOC_ALIGN - 1))
+
+/**
+ * \brief Header preceding the payload of each block
+ */
+struct engine_block_hdr_t {
+    uint16_t magic;     /*!< ENGINE_ALLOC_MAGIC when in use, 0 when free */
+    uint16_t class_idx; /*!< Size class of the block */
+    uint32_t next;      /*!< Requested size when in use, offset of the next
+                         *   free block of the class when free
+                         */
+};
+
+/**
+ * \brief Header preceding the payload of each chunk of the first-fit heap
+ */
+struct engine_chunk_hdr_t {
+    uint32_t magic;     /*!< ENGINE_ALLOC_CHUNK_IN_USE when in use,
+                         *   ENGINE_ALLOC_CHUNK_FREE when free
+                         */
+    uint32_t size;      /*!< Size of the chunk, header included */
+    uint32_t len;       /*!< Requested size when in use, 0 when free */
+    uint32_t reserved;  /*!< Keeps the payload aligned */
+};
+
+/**
+ * \brief Smallest chunk of the first-fit heap, which holds a header and the
+ *        smallest aligned allocation
+ */
+#define ENGINE_ALLOC_MIN_CHUNK (sizeof(struct engine_chunk_hdr_t) + \
+                                ENGINE_ALLOC_ALIGN)
+
+/**
+ * \brief State of the allocator
+ */
+static struct {
+    uint8_t *base;        /*!< Aligned start of the heap */
+    size_t size;          /*!< Size of the part of the heap split into
+                           *   blocks
+                           */
+    uint8_t *ff_base;     /*!< Start of the first-fit heap */
+    size_t ff_size;       /*!< Size of the first-fit heap */
+    size_t ff_in_use;     /*!< Bytes of the chunks in use, with headers */
+    uint32_t num_ff_allocs; /*!< Allocations served by the first-fit heap */
+    size_t carved;        /*!< Bytes of the heap split into blocks */
+    size_t in_use;        /*!< Bytes of the blocks in use, with headers */
+    size_t peak_in_use;   /*!< Largest value of in_use */
+    size_t requested;     /*!< Bytes requested by the allocations in use */
+    uint32_t num_allocs;  /*!< Successful allocations */
+    uint32_t num_failed;  /*!< Failed allocations */
+    uint32_t free_list[ENGINE_ALLOC_NUM_CLASSES]; /*!< Offsets of the first
+                                                   *   free block of each
+                                                   *   class
+                                                   */
+    struct tfm_crypto_engine_alloc_class_stats_t
+        cls[ENGINE_ALLOC_NUM_CLASSES];            /*!< Statistics of each
+                                                   *   class
+                                                   */
+} engine_alloc;
+
+#ifdef TFM_CRYPTO_ENGINE_ALLOC_TRAP
+/* Function called instead of stopping the service, e.g. in a host build */
+void TFM_CRYPTO_ENGINE_ALLOC_TRAP(void);
+#endif
+
+/**
+ * \brief Stops the service on an invalid release or on a corrupted header.
+ *        The caller returns without using the heap if this function returns,
+ *        which only happens when TFM_CRYPTO_ENGINE_ALLOC_TRAP is defined.
+ */
+static void engine_alloc_trap(void)
+{
+#if defined(TFM_CRYPTO_ENGINE_ALLOC_TRAP)
+    TFM_CRYPTO_ENGINE_ALLOC_TRAP();
+#elif defined(TFM_PSA_API)
+    psa_panic();
+#else
+    /* A partition of the library model cannot request a panic */
+    while (1) {
+    }
+#endif
+}
+
+static inline size_t block_size(uint32_t class_idx)
+{
+    return sizeof(struct engine_block_hdr_t) + class_size[class_idx];
+}
+
+static inline struct engine_block_hdr_t *offset_to_block(uint32_t offset)
+{
+    return (struct engine_block_hdr_t *)(engine_alloc.base + offset);
+}
+
+/**
+ * \brief Takes a block of a class, from its free list or from the part of the
+ *        heap not split yet.
+ */
+static struct engine_block_hdr_t *take_block(uint32_t idx)
+{
+    struct engine_block_hdr_t *blk;
+
+    if (engine_alloc.free_list[idx] != ENGINE_ALLOC_LIST_END) {
+        blk = offset_to_block(engine_alloc.free_list[idx]);
+        engine_alloc.free_list[idx] = blk->next;
+        return blk;
+    }
+
+    if (block_size(idx) > (engine_alloc.size - engine_alloc.carved)) {
+        return NULL;
+    }
+
+    blk = offset_to_block((uint32_t)engine_alloc.carved);
+    blk->class_idx = (uint16_t)idx;
+    engine_alloc.carved += block_size(idx);
+    engine_alloc.cls[idx].num_blocks++;
+
+    return blk;
+}
+
+static inline struct engine_chunk_hdr_t *offset_to_chunk(size_t offset)
+{
+    return (struct engine_chunk_hdr_t *)(engine_alloc.ff_base + offset);
+}
+
+/**
+ * \brief Checks the header of the chunk at the given offset of the first-fit
+ *        heap: its marker, and a size which is aligned, not below the
+ *        smallest chunk and within the heap, so that a walk of the heap
+ *        always moves forward and ends at its end.
+ */
+static bool chunk_is_valid(size_t offset)
+{
+    const struct engine_chunk_hdr_t *chunk = offset_to_chunk(offset);
+
+    if ((chunk->magic != ENGINE_ALLOC_CHUNK_IN_USE) &&
+        (chunk->magic != ENGINE_ALLOC_CHUNK_FREE)) {
+        return false;
+    }
+
+    return (chunk->size >= ENGINE_ALLOC_MIN_CHUNK) &&
+           ((chunk->size & (ENGINE_ALLOC_ALIGN - 1)) == 0) &&
+           (chunk->size <= (engine_alloc.ff_size - offset));
+}
+
+/**
+ * \brief Merges a free chunk of the first-fit heap with the free chunks which
+ *        follow it. Chunks are merged when the heap is walked rather than when
+ *        they are released, so that no back pointer is needed.
+ */
+static bool merge_chunks(size_t offset)
+{
+    struct engine_chunk_hdr_t *chunk = offset_to_chunk(offset);
+    struct engine_chunk_hdr_t *next;
+
+    while ((offset + chunk->size) < engine_alloc.ff_size) {
+        if (!chunk_is_valid(offset + chunk->size)) {
+            return false;
+        }
+        next = offset_to_chunk(offset + chunk->size);
+        if (next->magic != ENGINE_ALLOC_CHUNK_FREE) {
+            break;
+        }
+        chunk->size += next->size;
+        next->magic = 0;
+    }
+
+    return true;
+}
+
+/**
+ * \brief Validates the chunk at the given offset of a walk of the first-fit
+ *        heap, and merges it with the free chunks which follow it.
+ *
+ * \return Returns false, after the trap, if a header is corrupted.
+ */
+static bool walk_chunk(size_t offset)
+{
+    if (!chunk_is_valid(offset) ||
+        ((offset_to_chunk(offset)->magic == ENGINE_ALLOC_CHUNK_FREE) &&
+         !merge_chunks(offset))) {
+        engine_alloc_trap();
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * \brief Allocates from the first-fit heap.
+ */
+static void *ff_calloc(size_t len)
+{
+    struct engine_chunk_hdr_t *chunk;
+    struct engine_chunk_hdr_t *rest;
+    size_t need;
+    size_t offset;
+
+    if ((engine_alloc.ff_size == 0) ||
+        (len > (engine_alloc.ff_size - sizeof(*chunk)))) {
+        return NULL;
+    }
+    need = ENGINE_ALLOC_ALIGN_UP(sizeof(*chunk) + len);
+
+    for (offset = 0; offset < engine_alloc.ff_size; offset += chunk->size) {
+        if (!walk_chunk(offset)) {
+            return NULL;
+        }
+        chunk = offset_to_chunk(offset);
+        if ((chunk->magic != ENGINE_ALLOC_CHUNK_FREE) ||
+            (chunk->size < need)) {
+            continue;
+        }
+
+        /* Split the chunk if the rest can hold an allocation */
+        if ((chunk->size - need) >= ENGINE_ALLOC_MIN_CHUNK) {
+            rest = offset_to_chunk(offset + need);
+            rest->magic = ENGINE_ALLOC_CHUNK_FREE;
+            rest->size = chunk->size - (uint32_t)need;
+            rest->len = 0;
+            chunk->size = (uint32_t)need;
+        }
+        chunk->magic = ENGINE_ALLOC_CHUNK_IN_USE;
+        chunk->len = (uint32_t)len;
+
+        engine_alloc.ff_in_use += chunk->size;
+        engine_alloc.in_use += chunk->size;
+        engine_alloc.num_ff_allocs++;
+
+        return chunk + 1;
+    }
+
+    return NULL;
+}
+
+static void ff_free(void *ptr)
+{
+    struct engine_chunk_hdr_t *chunk = (struct engine_chunk_hdr_t *)ptr - 1;
+    size_t offset = (size_t)((uint8_t *)chunk - engine_alloc.ff_base);
+
+    /* Only the start of a chunk in use can be freed */
+    if (((offset & (ENGINE_ALLOC_ALIGN - 1)) != 0) ||
+        !chunk_is_valid(offset) ||
+        (chunk->magic != ENGINE_ALLOC_CHUNK_IN_USE) ||
+        (chunk->len > (chunk->size - sizeof(*chunk)))) {
+        engine_alloc_trap();
+        return;
+    }
+
+    engine_alloc.requested -= chunk->len;
+    engine_alloc.ff_in_use -= chunk->size;
+    engine_alloc.in_use -= chunk->size;
+    chunk->magic = ENGINE_ALLOC_CHUNK_FREE;
+    chunk->len = 0;
+}
+
+/**
+ * \brief Gets the largest allocation the first-fit heap can currently serve.
+ */
+static size_t ff_largest_alloc(void)
+{
+    struct engine_chunk_hdr_t *chunk;
+    size_t largest = 0;
+    size_t offset;
+
+    for (offset = 0; offset < engine_alloc.ff_size; offset += chunk->size) {
+        if (!walk_chunk(offset)) {
+            return 0;
+        }
+        chunk = offset_to_chunk(offset);
+        if (chunk->magic != ENGINE_ALLOC_CHUNK_FREE) {
+            continue;
+        }
+
+        if ((chunk->size - sizeof(*chunk)) > largest) {
+            largest = chunk->size - sizeof(*chunk);
+        }
+    }
+
+    return largest;
+}
+
+void *tfm_crypto_engine_calloc(size_t nmemb, size_t size)
+{
+    struct engine_block_hdr_t *blk = NULL;
+    void *ptr;
+    size_t len;
+    uint32_t idx;
+
+    if ((nmemb == 0) || (size == 0) || (nmemb > (SIZE_MAX / size))) {
+        return NULL;
+    }
+    len = nmemb * size;
+
+    for (idx = 0; idx < ENGINE_ALLOC_NUM_CLASSES; idx++) {
+        if (len <= class_size[idx]) {
+            break;
+        }
+    }
+
+    /* Use a block of a larger class rather than fail */
+    for (; (idx < ENGINE_ALLOC_NUM_CLASSES) && (blk == NULL); idx++) {
+        blk = take_block(idx);
+    }
+
+    if (blk == NULL) {
+        ptr = ff_calloc(len);
+        if (ptr == NULL) {
+            engine_alloc.num_failed++;
+            return NULL;
+        }
+
+        engine_alloc.num_allocs++;
+        engine_alloc.requested += len;
+        if (engine_alloc.in_use > engine_alloc.peak_in_use) {
+            engine_alloc.peak_in_use = engine_alloc.in_use;
+        }
+
+        (void)tfm_memset(ptr, 0, len);
+
+        return ptr;
+    }
+    idx = blk->class_idx;
+
+    blk->magic = ENGINE_ALLOC_MAGIC;
+    blk->next = (uint32_t)len;
+
+    engine_alloc.num_allocs++;
+    engine_alloc.requested += len;
+    engine_alloc.in_use += block_size(idx);
+    if (engine_alloc.in_use > engine_alloc.peak_in_use) {
+        engine_alloc.peak_in_use = engine_alloc.in_use;
+    }
+    engine_alloc.cls[idx].in_use++;
+    if (engine_alloc.cls[idx].in_use > engine_alloc.cls[idx].max_in_use) {
+        engine_alloc.cls[idx].max_in_use = engine_alloc.cls[idx].in_use;
+    }
+
+    (void)tfm_memset(blk + 1, 0, len);
+
+    return blk + 1;
+}
+
+void tfm_crypto_engine_free(void *ptr)
+{
+    struct engine_block_hdr_t *blk;
+    uint32_t idx;
+
+    if (ptr == NULL) {
+        return;
+    }
+
+    if (((uint8_t *)ptr >= (engine_alloc.ff_base +
+                            sizeof(struct engine_chunk_hdr_t))) &&
+        ((uint8_t *)ptr < (engine_alloc.ff_base + engine_alloc.ff_size))) {
+        ff_free(ptr);
+        return;
+    }
+
+    if (((uint8_t *)ptr < (engine_alloc.base + sizeof(*blk))) ||
+        ((uint8_t *)ptr >= (engine_alloc.base + engine_alloc.carved)) ||
+        ((((uint8_t *)ptr - engine_alloc.base) &
+          (ENGINE_ALLOC_ALIGN - 1)) != 0)) {
+        engine_alloc_trap();
+        return;
+    }
+
+    blk = (struct engine_block_hdr_t *)ptr - 1;
+    if ((blk->magic != ENGINE_ALLOC_MAGIC) ||
+        (blk->class_idx >= ENGINE_ALLOC_NUM_CLASSES) ||
+        (blk->next > class_size[blk->class_idx])) {
+        engine_alloc_trap();
+        return;
+    }
+    idx = blk->class_idx;
+
+    engine_alloc.requested -= blk->next;
+    engine_alloc.in_use -= block_size(idx);
+    engine_alloc.cls[idx].in_use--;
+
+    blk->magic = 0;
+    blk->next = engine_alloc.free_list[idx];
+    engine_alloc.free_list[idx] = (uint32_t)((uint8_t *)blk -
+                                             engine_alloc.base);
+}
+
+psa_status_t tfm_crypto_engine_alloc_init(uint8_t *buf, size_t size,
+                                          size_t first_fit_size)
+{
+    size_t pad = (ENGINE_ALLOC_ALIGN -
+                  ((uintptr_t)buf & (ENGINE_ALLOC_ALIGN - 1))) &
+                 (ENGINE_ALLOC_ALIGN - 1);
+    uint32_t i;
+
+    if ((buf == NULL) || (size <= pad) || ((size - pad) >= UINT32_MAX)) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    /* The first-fit heap takes the end of the buffer */
+    first_fit_size &= ~((size_t)ENGINE_ALLOC_ALIGN - 1);
+    if (first_fit_size > (size - pad)) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+    if (first_fit_size < ENGINE_ALLOC_MIN_CHUNK) {
+        first_fit_size = 0;
+    }
+
+    (void)tfm_memset(&engine_alloc, 0, sizeof(engine_alloc));
+    engine_alloc.base = buf + pad;
+    /* The first-fit heap starts aligned, as its chunk offsets are checked */
+    engine_alloc.size = (size - pad - first_fit_size) &
+                        ~((size_t)ENGINE_ALLOC_ALIGN - 1);
+    engine_alloc.ff_base = engine_alloc.base + engine_alloc.size;
+    engine_alloc.ff_size = first_fit_size;
+    if (first_fit_size != 0) {
+        offset_to_chunk(0)->magic = ENGINE_ALLOC_CHUNK_FREE;
+        offset_to_chunk(0)->size = (uint32_t)first_fit_size;
+        offset_to_chunk(0)->len = 0;
+    }
+    for (i = 0; i < ENGINE_ALLOC_NUM_CLASSES; i++) {
+        engine_alloc.free_list[i] = ENGINE_ALLOC_LIST_END;
+        engine_alloc.cls[i].block_size = class_size[i];
+    }
+
+    return PSA_SUCCESS;
+}
+#endif /* TFM_CRYPTO_ENGINE_SIZE_CLASS_ALLOC */
+
+psa_status_t tfm_crypto_engine_alloc_get_stats(
+                                 struct tfm_crypto_engine_alloc_stats_t *stats)
+{
+#ifndef TFM_CRYPTO_ENGINE_SIZE_CLASS_ALLOC
+    return PSA_ERROR_NOT_SUPPORTED;
+#else
+    size_t i, free_bytes = 0, largest_alloc = 0, ff_largest;
+
+    if (stats == NULL) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    ff_largest = ff_largest_alloc();
+
+    for (i = 0; i < ENGINE_ALLOC_NUM_CLASSES; i++) {
+        free_bytes += (engine_alloc.cls[i].num_blocks -
+                       engine_alloc.cls[i].in_use) * block_size(i);
+        if ((engine_alloc.free_list[i] != ENGINE_ALLOC_LIST_END) ||
+            (block_size(i) <= (engine_alloc.size - engine_alloc.carved))) {
+            largest_alloc = class_size[i];
+        }
+    }
+    if (ff_largest > largest_alloc) {
+        largest_alloc = ff_largest;
+    }
+
+    stats->heap_size = engine_alloc.size + engine_alloc.ff_size;
+    stats->unused = engine_alloc.size - engine_alloc.carved;
+    stats->in_use = engine_alloc.in_use;
+    stats->peak_in_use = engine_alloc.peak_in_use;
+    stats->requested = engine_alloc.requested;
+    stats->free_in_classes = free_bytes;
+    stats->largest_alloc = largest_alloc;
+    stats->num_allocs = engine_alloc.num_allocs;
+    stats->num_failed = engine_alloc.num_failed;
+    stats->num_classes = ENGINE_ALLOC_NUM_CLASSES;
+    stats->first_fit_size = engine_alloc.ff_size;
+    stats->first_fit_in_use = engine_alloc.ff_in_use;
+    stats->num_first_fit_allocs = engine_alloc.num_ff_allocs;
+
+    return PSA_SUCCESS;
+#endif /* TFM_CRYPTO_ENGINE_SIZE_CLASS_ALLOC */
+}
+
+psa_status_t tfm_crypto_engine_alloc_get_class_stats(
+                           uint32_t class_idx,
+                           struct tfm_crypto_engine_alloc_class_stats_t *stats)
+{
+#ifndef TFM_CRYPTO_ENGINE_SIZE_CLASS_ALLOC
+    return PSA_ERROR_NOT_SUPPORTED;
+#else
+    if ((stats == NULL) || (class_idx >= ENGINE_ALLOC_NUM_CLASSES)) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    *stats = engine_alloc.cls[class_idx];
+
+    return PSA_SUCCESS;
+#endif /* TFM_CRYPTO_ENGINE_SIZE_CLASS_ALLOC */
+}
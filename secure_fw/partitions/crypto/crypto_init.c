@@ -5,10 +5,13 @@
  *
  */
 
+#include <stdbool.h>
+
 #include "tfm_mbedcrypto_include.h"
 
 #include "tfm_crypto_api.h"
 #include "tfm_crypto_defs.h"
+#include "tfm_crypto_private.h"
 #include "tfm_sp_log.h"
 
 /*
@@ -17,6 +20,10 @@
  */
 #include "mbedtls/memory_buffer_alloc.h"
 
+#ifdef TFM_CRYPTO_ENGINE_SIZE_CLASS_ALLOC
+#include "mbedtls/platform.h"
+#endif /* TFM_CRYPTO_ENGINE_SIZE_CLASS_ALLOC */
+
 #ifdef CRYPTO_NV_SEED
 #include "tfm_plat_crypto_nv_seed.h"
 #endif /* CRYPTO_NV_SEED */
@@ -32,6 +39,7 @@
 #ifdef TFM_PSA_API
 #include "psa/service.h"
 #include "psa_manifest/tfm_crypto.h"
+#include "tfm_crypto_pack.h"
 #include "tfm_memory_utils.h"
 
 /**
@@ -111,15 +119,177 @@ void tfm_crypto_clear_scratch(void)
     scratch.alloc_index = 0;
 }
 
+#if PSA_FRAMEWORK_HAS_MM_IOVEC
+/**
+ * \brief Size from which a client buffer is used in place by the secure
+ *        functions. The smaller vectors, which hold all the control parameters
+ *        of the requests, i.e. the handles, key ids, lengths and key
+ *        attributes, are copied into the internal scratch, so that the client
+ *        cannot change them while they are used.
+ */
+#ifndef TFM_CRYPTO_IOVEC_MAP_MIN_SIZE
+#define TFM_CRYPTO_IOVEC_MAP_MIN_SIZE (64u)
+#endif
+
+/**
+ * \brief Checks whether a mapped client buffer can be used in place by the
+ *        secure functions, which need the alignment of the internal scratch.
+ */
+#define TFM_CRYPTO_IOVEC_IN_PLACE(ptr, size)                          \
+    (((ptr) != NULL) &&                                               \
+     (((uintptr_t)(ptr) & (TFM_CRYPTO_IOVEC_ALIGNMENT - 1)) == 0) &&  \
+     ((size) >= TFM_CRYPTO_IOVEC_MAP_MIN_SIZE))
+
+/**
+ * \brief Checks whether a client buffer overlaps one of the first out_len
+ *        output vectors used in place.
+ */
+static bool tfm_crypto_overlaps_outvecs(const void *ptr, size_t len,
+                                        const psa_outvec *out_vec,
+                                        size_t out_len,
+                                        void *const *mapped_ptrs)
+{
+    uintptr_t start = (uintptr_t)ptr;
+    uintptr_t out_start;
+    size_t i;
+
+    for (i = 0; i < out_len; i++) {
+        if ((mapped_ptrs[i] == NULL) || (out_vec[i].base != mapped_ptrs[i])) {
+            continue;
+        }
+        out_start = (uintptr_t)out_vec[i].base;
+        if ((start < (out_start + out_vec[i].len)) &&
+            (out_start < (start + len))) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * \brief Maps the output vectors of the message. A vector that is small, not
+ *        aligned, or which overlaps another output used in place is allocated
+ *        in the internal scratch instead, and its mapping is returned in
+ *        mapped_ptrs so that it can be copied back.
+ */
+static psa_status_t tfm_crypto_map_outvecs(const psa_msg_t *msg,
+                                           psa_outvec *out_vec, size_t out_len,
+                                           void **mapped_ptrs)
+{
+    psa_status_t status;
+    void *alloc_buf_ptr;
+    size_t i;
+
+    for (i = 0; i < out_len; i++) {
+        mapped_ptrs[i] = NULL;
+        if (msg->out_size[i] != 0) {
+            mapped_ptrs[i] = psa_map_outvec(msg->handle, i);
+        }
+
+        if (TFM_CRYPTO_IOVEC_IN_PLACE(mapped_ptrs[i], msg->out_size[i]) &&
+            !tfm_crypto_overlaps_outvecs(mapped_ptrs[i], msg->out_size[i],
+                                         out_vec, i, mapped_ptrs)) {
+            out_vec[i].base = mapped_ptrs[i];
+        } else {
+            status = tfm_crypto_alloc_scratch(msg->out_size[i], &alloc_buf_ptr);
+            if (status != PSA_SUCCESS) {
+                return status;
+            }
+            out_vec[i].base = alloc_buf_ptr;
+        }
+        out_vec[i].len = msg->out_size[i];
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Maps the input vectors of the message, from the second one, as the
+ *        first is read when parsing. A vector that is small, not aligned, or
+ *        which overlaps an output used in place is copied into the internal
+ *        scratch instead, so that the crypto library never sees aliased input
+ *        and output buffers. The output vectors must be mapped first.
+ */
+static psa_status_t tfm_crypto_map_invecs(const psa_msg_t *msg,
+                                          psa_invec *in_vec, size_t in_len,
+                                          const psa_outvec *out_vec,
+                                          size_t out_len,
+                                          void *const *mapped_ptrs)
+{
+    psa_status_t status;
+    const void *mapped_ptr;
+    void *alloc_buf_ptr;
+    size_t i;
+
+    for (i = 1; i < in_len; i++) {
+        mapped_ptr = NULL;
+        if (msg->in_size[i] != 0) {
+            mapped_ptr = psa_map_invec(msg->handle, i);
+        }
+
+        if (TFM_CRYPTO_IOVEC_IN_PLACE(mapped_ptr, msg->in_size[i]) &&
+            !tfm_crypto_overlaps_outvecs(mapped_ptr, msg->in_size[i],
+                                         out_vec, out_len, mapped_ptrs)) {
+            in_vec[i].base = mapped_ptr;
+        } else {
+            status = tfm_crypto_alloc_scratch(msg->in_size[i], &alloc_buf_ptr);
+            if (status != PSA_SUCCESS) {
+                return status;
+            }
+            if (mapped_ptr != NULL) {
+                (void)tfm_memcpy(alloc_buf_ptr, mapped_ptr, msg->in_size[i]);
+            }
+            in_vec[i].base = alloc_buf_ptr;
+        }
+        in_vec[i].len = msg->in_size[i];
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Unmaps the vectors of the message, copying back the outputs that were
+ *        allocated in the internal scratch.
+ */
+static void tfm_crypto_unmap_iovecs(const psa_msg_t *msg, size_t in_len,
+                                    const psa_outvec *out_vec, size_t out_len,
+                                    void *const *mapped_ptrs)
+{
+    size_t i;
+
+    for (i = 1; i < in_len; i++) {
+        if (msg->in_size[i] != 0) {
+            psa_unmap_invec(msg->handle, i);
+        }
+    }
+
+    for (i = 0; i < out_len; i++) {
+        if (mapped_ptrs[i] == NULL) {
+            continue;
+        }
+        if (out_vec[i].base != mapped_ptrs[i]) {
+            (void)tfm_memcpy(mapped_ptrs[i], out_vec[i].base, out_vec[i].len);
+        }
+        psa_unmap_outvec(msg->handle, i, out_vec[i].len);
+    }
+}
+#endif /* PSA_FRAMEWORK_HAS_MM_IOVEC */
+
 static psa_status_t tfm_crypto_call_srv(psa_msg_t *msg,
                                         struct tfm_crypto_pack_iovec *iov,
                                         const uint32_t srv_id)
 {
     psa_status_t status = PSA_SUCCESS;
-    size_t in_len = PSA_MAX_IOVEC, out_len = PSA_MAX_IOVEC, i;
+    size_t in_len = PSA_MAX_IOVEC, out_len = PSA_MAX_IOVEC;
     psa_invec in_vec[PSA_MAX_IOVEC] = { {NULL, 0} };
     psa_outvec out_vec[PSA_MAX_IOVEC] = { {NULL, 0} };
+#if PSA_FRAMEWORK_HAS_MM_IOVEC
+    void *mapped_ptrs[PSA_MAX_IOVEC] = {NULL};
+#else
     void *alloc_buf_ptr = NULL;
+    size_t i;
+#endif
 
     /* Check the number of in_vec filled */
     while ((in_len > 0) && (msg->in_size[in_len - 1] == 0)) {
@@ -134,6 +304,25 @@ static psa_status_t tfm_crypto_call_srv(psa_msg_t *msg,
     in_vec[0].base = iov;
     in_vec[0].len = sizeof(struct tfm_crypto_pack_iovec);
 
+    /* Check the number of out_vec filled */
+    while ((out_len > 0) && (msg->out_size[out_len - 1] == 0)) {
+        out_len--;
+    }
+
+#if PSA_FRAMEWORK_HAS_MM_IOVEC
+    /* Operate directly on the large client buffers. The vectors that are
+     * still mapped if an error is returned are unmapped by the framework.
+     */
+    status = tfm_crypto_map_outvecs(msg, out_vec, out_len, mapped_ptrs);
+    if (status == PSA_SUCCESS) {
+        status = tfm_crypto_map_invecs(msg, in_vec, in_len,
+                                       out_vec, out_len, mapped_ptrs);
+    }
+    if (status != PSA_SUCCESS) {
+        tfm_crypto_clear_scratch();
+        return status;
+    }
+#else
     /* Alloc/read from the second element as the first is read when parsing */
     for (i = 1; i < in_len; i++) {
         /* Allocate necessary space in the internal scratch */
@@ -149,11 +338,6 @@ static psa_status_t tfm_crypto_call_srv(psa_msg_t *msg,
         in_vec[i].len = msg->in_size[i];
     }
 
-    /* Check the number of out_vec filled */
-    while ((out_len > 0) && (msg->out_size[out_len - 1] == 0)) {
-        out_len--;
-    }
-
     for (i = 0; i < out_len; i++) {
         /* Allocate necessary space for the output in the internal scratch */
         status = tfm_crypto_alloc_scratch(msg->out_size[i], &alloc_buf_ptr);
@@ -165,6 +349,7 @@ static psa_status_t tfm_crypto_call_srv(psa_msg_t *msg,
         out_vec[i].base = alloc_buf_ptr;
         out_vec[i].len = msg->out_size[i];
     }
+#endif /* PSA_FRAMEWORK_HAS_MM_IOVEC */
 
     /* Set the owner of the data in the scratch */
     (void)tfm_crypto_set_scratch_owner(msg->client_id);
@@ -172,10 +357,14 @@ static psa_status_t tfm_crypto_call_srv(psa_msg_t *msg,
     /* Call the uniform signature API */
     status = sfid_func_table[srv_id](in_vec, in_len, out_vec, out_len);
 
+#if PSA_FRAMEWORK_HAS_MM_IOVEC
+    tfm_crypto_unmap_iovecs(msg, in_len, out_vec, out_len, mapped_ptrs);
+#else
     /* Write into the IPC framework outputs from the scratch */
     for (i = 0; i < out_len; i++) {
         psa_write(msg->handle, i, out_vec[i].base, out_vec[i].len);
     }
+#endif
 
     /* Clear the allocated internal scratch before returning */
     tfm_crypto_clear_scratch();
@@ -183,27 +372,92 @@ static psa_status_t tfm_crypto_call_srv(psa_msg_t *msg,
     return status;
 }
 
+/**
+ * \brief Decodes the struct tfm_crypto_pack_iovec of a request from the wire
+ *        encoding described in tfm_crypto_pack.h. The encoding must hold
+ *        exactly the fields used by the requested service.
+ */
+static psa_status_t tfm_crypto_pack_decode(const uint8_t *buf, size_t len,
+                                           struct tfm_crypto_pack_iovec *iov)
+{
+    const struct tfm_crypto_pack_hdr *hdr = (const void *)buf;
+    const uint8_t *p = buf + sizeof(*hdr);
+    const uint8_t *end = buf + len;
+    uint32_t fields;
+    size_t n;
+
+    if ((hdr->version != TFM_CRYPTO_PACK_VERSION) || (hdr->reserved != 0) ||
+        (hdr->srv_id >= TFM_CRYPTO_SID_MAX)) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    (void)tfm_memset(iov, 0, sizeof(*iov));
+    iov->srv_id = hdr->srv_id;
+    fields = tfm_crypto_pack_fields(iov->srv_id);
+
+#define X(flag, member)                                                \
+    if (fields & (flag)) {                                             \
+        n = TFM_CRYPTO_PACK_ALIGN(sizeof(iov->member));                \
+        if (n > (size_t)(end - p)) {                                   \
+            return PSA_ERROR_GENERIC_ERROR;                            \
+        }                                                              \
+        (void)tfm_memcpy(&iov->member, p, sizeof(iov->member));        \
+        p += n;                                                        \
+    }
+    LIST_TFM_CRYPTO_PACK_FIELDS
+#undef X
+
+    if (fields & TFM_CRYPTO_PACK_AEAD_IN) {
+        if (sizeof(uint32_t) > (size_t)(end - p)) {
+            return PSA_ERROR_GENERIC_ERROR;
+        }
+        iov->aead_in.nonce_length = *(const uint32_t *)p;
+        p += sizeof(uint32_t);
+        if (iov->aead_in.nonce_length > TFM_CRYPTO_MAX_NONCE_LENGTH) {
+            return PSA_ERROR_GENERIC_ERROR;
+        }
+        n = TFM_CRYPTO_PACK_ALIGN(iov->aead_in.nonce_length);
+        if (n > (size_t)(end - p)) {
+            return PSA_ERROR_GENERIC_ERROR;
+        }
+        (void)tfm_memcpy(iov->aead_in.nonce, p, iov->aead_in.nonce_length);
+        p += n;
+    }
+
+    /* Reject the fields which are not used by the service */
+    if (p != end) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    return PSA_SUCCESS;
+}
+
 static psa_status_t tfm_crypto_parse_msg(psa_msg_t *msg,
                                          struct tfm_crypto_pack_iovec *iov,
                                          uint32_t *srv_id_p)
 {
+    uint32_t buf[TFM_CRYPTO_PACK_MAX_SIZE / sizeof(uint32_t)];
     size_t read_size;
+    psa_status_t status;
 
-    /* Read the in_vec[0] which holds the IOVEC always */
-    read_size = psa_read(msg->handle,
-                         0,
-                         iov,
-                         sizeof(struct tfm_crypto_pack_iovec));
+    *srv_id_p = TFM_CRYPTO_SID_INVALID;
 
-    if (read_size != sizeof(struct tfm_crypto_pack_iovec)) {
+    if ((msg->in_size[0] < sizeof(struct tfm_crypto_pack_hdr)) ||
+        (msg->in_size[0] > sizeof(buf))) {
         return PSA_ERROR_GENERIC_ERROR;
     }
 
-    if (iov->srv_id >= TFM_CRYPTO_SID_MAX) {
-        *srv_id_p = TFM_CRYPTO_SID_INVALID;
+    /* Read the in_vec[0] which holds the encoded IOVEC always */
+    read_size = psa_read(msg->handle, 0, buf, msg->in_size[0]);
+    if (read_size != msg->in_size[0]) {
         return PSA_ERROR_GENERIC_ERROR;
     }
 
+    status = tfm_crypto_pack_decode((const uint8_t *)buf, read_size, iov);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
     *srv_id_p = iov->srv_id;
 
     return PSA_SUCCESS;
@@ -235,6 +489,10 @@ static void tfm_crypto_ipc_handler(void)
                     status = tfm_crypto_call_srv(&msg, &iov, srv_id);
                 }
                 psa_reply(msg.handle, status);
+                /* Refill the pool of random bytes, if needed, once the
+                 * client has been answered
+                 */
+                tfm_crypto_rng_pool_refill();
                 break;
             default:
                 psa_panic();
@@ -247,6 +505,162 @@ static void tfm_crypto_ipc_handler(void)
     /* NOTREACHED */
     return;
 }
+
+/**
+ * \brief Checks that a buffer of a step of a batch lies within the buffer of
+ *        the batch and is aligned like the vectors of a direct call.
+ */
+static bool tfm_crypto_batch_check_buf(uint32_t offset, uint32_t len,
+                                       size_t batch_buf_len)
+{
+    return ((offset & (TFM_CRYPTO_IOVEC_ALIGNMENT - 1)) == 0) &&
+           (offset <= batch_buf_len) &&
+           (len <= (batch_buf_len - offset));
+}
+
+/**
+ * \brief Builds the vectors of a step of a batch, in the same way as
+ *        tfm_crypto_call_srv() builds the vectors of a direct call.
+ */
+static psa_status_t tfm_crypto_batch_setup_step(
+                                      struct tfm_crypto_batch_step_t *step,
+                                      const psa_invec *batch_in,
+                                      const psa_outvec *batch_out,
+                                      uint32_t *handle,
+                                      psa_invec in_vec[], size_t *in_len,
+                                      psa_outvec out_vec[], size_t *out_len)
+{
+    size_t i, n = 0;
+
+    if ((step->iov.srv_id >= TFM_CRYPTO_SID_MAX) ||
+        (step->iov.srv_id == TFM_CRYPTO_BATCH_SID) ||
+        (step->num_in > TFM_CRYPTO_BATCH_MAX_IN) ||
+        (step->num_out > TFM_CRYPTO_BATCH_MAX_OUT)) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (step->flags & TFM_CRYPTO_BATCH_USE_HANDLE) {
+        step->iov.op_handle = *handle;
+    }
+
+    in_vec[0].base = &step->iov;
+    in_vec[0].len = sizeof(struct tfm_crypto_pack_iovec);
+    for (i = 0; i < step->num_in; i++) {
+        if (!tfm_crypto_batch_check_buf(step->in_offset[i], step->in_len[i],
+                                        batch_in->len)) {
+            return PSA_ERROR_INVALID_ARGUMENT;
+        }
+        if (step->in_len[i] != 0) {
+            in_vec[i + 1].base = (const uint8_t *)batch_in->base +
+                                 step->in_offset[i];
+            in_vec[i + 1].len = step->in_len[i];
+        }
+    }
+
+    if (step->flags & TFM_CRYPTO_BATCH_HANDLE_OUT) {
+        if (step->num_out >= PSA_MAX_IOVEC) {
+            return PSA_ERROR_INVALID_ARGUMENT;
+        }
+        out_vec[0].base = handle;
+        out_vec[0].len = sizeof(uint32_t);
+        n = 1;
+    }
+    for (i = 0; i < step->num_out; i++) {
+        if (!tfm_crypto_batch_check_buf(step->out_offset[i],
+                                        step->out_size[i], batch_out->len)) {
+            return PSA_ERROR_INVALID_ARGUMENT;
+        }
+        if (step->out_size[i] != 0) {
+            out_vec[n + i].base = (uint8_t *)batch_out->base +
+                                  step->out_offset[i];
+            out_vec[n + i].len = step->out_size[i];
+        }
+    }
+
+    /* Drop the trailing empty vectors, as for a direct call */
+    *in_len = step->num_in + 1;
+    while ((*in_len > 1) && (in_vec[*in_len - 1].len == 0)) {
+        (*in_len)--;
+    }
+    *out_len = n + step->num_out;
+    while ((*out_len > 0) && (out_vec[*out_len - 1].len == 0)) {
+        (*out_len)--;
+    }
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t tfm_crypto_batch(psa_invec in_vec[],
+                              size_t in_len,
+                              psa_outvec out_vec[],
+                              size_t out_len)
+{
+    const struct tfm_crypto_pack_iovec *iov = in_vec[0].base;
+    const struct tfm_crypto_batch_step_t *steps = in_vec[1].base;
+    struct tfm_crypto_batch_result_t *results = out_vec[1].base;
+    struct tfm_crypto_batch_step_t step;
+    struct tfm_crypto_batch_result_t result;
+    psa_invec step_in[PSA_MAX_IOVEC];
+    psa_outvec step_out[PSA_MAX_IOVEC];
+    size_t step_in_len, step_out_len;
+    size_t num_steps, out_extent = 0, i, j, k;
+    uint32_t handle = iov->op_handle;
+    uint8_t *out_end;
+    psa_status_t status = PSA_SUCCESS;
+
+    CRYPTO_IN_OUT_LEN_VALIDATE(in_len, 2, 3, out_len, 2, 3);
+
+    if ((out_vec[0].len != sizeof(uint32_t)) ||
+        (in_vec[0].len != sizeof(struct tfm_crypto_pack_iovec)) ||
+        ((in_vec[1].len % sizeof(struct tfm_crypto_batch_step_t)) != 0)) {
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    num_steps = in_vec[1].len / sizeof(struct tfm_crypto_batch_step_t);
+    if ((num_steps == 0) || (num_steps > TFM_CRYPTO_BATCH_MAX_STEPS) ||
+        (out_vec[1].len < (num_steps * sizeof(*results)))) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    for (i = 0; (i < num_steps) && (status == PSA_SUCCESS); i++) {
+        /* Work on a copy, as the steps can be in client memory */
+        (void)tfm_memcpy(&step, &steps[i], sizeof(step));
+        (void)tfm_memset(step_in, 0, sizeof(step_in));
+        (void)tfm_memset(step_out, 0, sizeof(step_out));
+        (void)tfm_memset(&result, 0, sizeof(result));
+
+        status = tfm_crypto_batch_setup_step(&step, &in_vec[2], &out_vec[2],
+                                             &handle,
+                                             step_in, &step_in_len,
+                                             step_out, &step_out_len);
+        if (status == PSA_SUCCESS) {
+            status = sfid_func_table[step.iov.srv_id](step_in, step_in_len,
+                                                      step_out, step_out_len);
+        }
+
+        /* Report the lengths written to the client outputs of the step */
+        k = (step.flags & TFM_CRYPTO_BATCH_HANDLE_OUT) ? 1 : 0;
+        for (j = 0; (status == PSA_SUCCESS) && (j < step.num_out); j++) {
+            if (step_out[k + j].base == NULL) {
+                continue;
+            }
+            result.out_len[j] = step_out[k + j].len;
+            out_end = (uint8_t *)step_out[k + j].base + step_out[k + j].len;
+            if ((size_t)(out_end - (uint8_t *)out_vec[2].base) > out_extent) {
+                out_extent = out_end - (uint8_t *)out_vec[2].base;
+            }
+        }
+
+        result.status = status;
+        (void)tfm_memcpy(&results[i], &result, sizeof(result));
+    }
+
+    *(uint32_t *)out_vec[0].base = handle;
+    out_vec[1].len = i * sizeof(*results);
+    out_vec[2].len = out_extent;
+
+    return status;
+}
 #endif /* TFM_PSA_API */
 
 /**
@@ -257,6 +671,10 @@ static void tfm_crypto_ipc_handler(void)
 #error TFM_CRYPTO_ENGINE_BUF_SIZE is not defined
 #endif
 
+#ifndef TFM_CRYPTO_ENGINE_FIRST_FIT_SIZE
+#define TFM_CRYPTO_ENGINE_FIRST_FIT_SIZE (0x1000)
+#endif
+
 /**
  * \brief Static buffer to be used by Mbed Crypto for memory allocations
  *
@@ -280,12 +698,30 @@ static psa_status_t tfm_crypto_engine_init(void)
 #endif /* TFM_PSA_API */
 #endif /* CRYPTO_NV_SEED */
 
+#ifdef TFM_CRYPTO_ENGINE_SIZE_CLASS_ALLOC
+    /* Serve the Mbed Crypto allocations from size classes carved out of the
+     * provided buffer, which avoids the fragmentation of a first-fit heap.
+     * The end of the buffer is kept as a first-fit heap for the allocations
+     * the classes cannot serve.
+     */
+    if (tfm_crypto_engine_alloc_init(mbedtls_mem_buf,
+                                     TFM_CRYPTO_ENGINE_BUF_SIZE,
+                                     TFM_CRYPTO_ENGINE_FIRST_FIT_SIZE) !=
+        PSA_SUCCESS) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+    if (mbedtls_platform_set_calloc_free(tfm_crypto_engine_calloc,
+                                         tfm_crypto_engine_free) != 0) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+#else
     /* Initialise the Mbed Crypto memory allocator to use static
      * memory allocation from the provided buffer instead of using
      * the heap
      */
     mbedtls_memory_buffer_alloc_init(mbedtls_mem_buf,
                                      TFM_CRYPTO_ENGINE_BUF_SIZE);
+#endif /* TFM_CRYPTO_ENGINE_SIZE_CLASS_ALLOC */
 
     /* Initialise the crypto accelerator if one is enabled */
 #ifdef CRYPTO_HW_ACCELERATOR
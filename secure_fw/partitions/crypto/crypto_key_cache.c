@@ -0,0 +1,264 @@
+/*
+ * Copyright (c) 2022, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Included before crypto_spe.h, so that the functions of the ITS service are
+ * declared under their own names.
+ */
+#include "psa/internal_trusted_storage.h"
+
+#include "tfm_mbedcrypto_include.h"
+
+#include "tfm_crypto_api.h"
+#include "tfm_memory_utils.h"
+
+#ifndef TFM_CRYPTO_PERSISTENT_KEY_CACHE_SLOTS
+#define TFM_CRYPTO_PERSISTENT_KEY_CACHE_SLOTS (0)
+#endif
+
+#ifndef TFM_CRYPTO_PERSISTENT_KEY_CACHE_ENTRY_SIZE
+#define TFM_CRYPTO_PERSISTENT_KEY_CACHE_ENTRY_SIZE (128)
+#endif
+
+#if TFM_CRYPTO_PERSISTENT_KEY_CACHE_SLOTS > 0
+/*
+ * Mbed Crypto reads a persistent key from ITS each time it loads the key in a
+ * free key slot, with a psa_its_get_info() followed by a psa_its_get() of the
+ * whole key. crypto_spe.h routes these accesses through the functions below,
+ * which keep a copy of the last keys used. The ITS assets of the Crypto
+ * service can only be written by the service itself, so the copies are kept
+ * up to date by writing through on psa_its_set() and dropping them on
+ * psa_its_remove().
+ */
+
+/* This file calls the ITS service itself */
+#undef psa_its_get_info
+#undef psa_its_get
+#undef psa_its_set
+#undef psa_its_remove
+
+/**
+ * \brief Copy of a stored persistent key
+ */
+struct key_cache_entry_t {
+    psa_storage_uid_t uid;           /*!< UID of the ITS asset */
+    struct psa_storage_info_t info;  /*!< Metadata of the asset */
+    uint32_t in_use;                 /*!< 1 if the entry holds a copy */
+    uint32_t last_use;               /*!< Value of the use counter at the last
+                                      *   access, to find the entry to evict
+                                      */
+    uint8_t data[TFM_CRYPTO_PERSISTENT_KEY_CACHE_ENTRY_SIZE]; /*!< Content of
+                                                               *   the asset
+                                                               */
+};
+
+static struct key_cache_entry_t key_cache[TFM_CRYPTO_PERSISTENT_KEY_CACHE_SLOTS];
+static uint32_t key_cache_uses;
+static struct tfm_crypto_key_cache_stats_t key_cache_stats;
+
+static struct key_cache_entry_t *key_cache_find(psa_storage_uid_t uid)
+{
+    uint32_t i;
+
+    for (i = 0; i < TFM_CRYPTO_PERSISTENT_KEY_CACHE_SLOTS; i++) {
+        if (key_cache[i].in_use && (key_cache[i].uid == uid)) {
+            key_cache[i].last_use = ++key_cache_uses;
+            return &key_cache[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void key_cache_drop(struct key_cache_entry_t *entry)
+{
+    (void)tfm_memset(entry, 0, sizeof(*entry));
+}
+
+/**
+ * \brief Stores a copy of an asset, in an unused entry or in place of the
+ *        least recently used one. Assets larger than an entry are not kept.
+ */
+static void key_cache_store(psa_storage_uid_t uid,
+                            const struct psa_storage_info_t *info,
+                            const void *data)
+{
+    struct key_cache_entry_t *entry = key_cache_find(uid);
+    uint32_t i;
+
+    if (info->size > TFM_CRYPTO_PERSISTENT_KEY_CACHE_ENTRY_SIZE) {
+        if (entry != NULL) {
+            key_cache_drop(entry);
+        }
+        key_cache_stats.num_bypassed++;
+        return;
+    }
+
+    if (entry == NULL) {
+        entry = &key_cache[0];
+        for (i = 0; i < TFM_CRYPTO_PERSISTENT_KEY_CACHE_SLOTS; i++) {
+            if (!key_cache[i].in_use) {
+                entry = &key_cache[i];
+                break;
+            }
+            if ((key_cache_uses - key_cache[i].last_use) >
+                (key_cache_uses - entry->last_use)) {
+                entry = &key_cache[i];
+            }
+        }
+        if (entry->in_use) {
+            key_cache_stats.num_evictions++;
+        }
+        key_cache_drop(entry);
+    }
+
+    entry->uid = uid;
+    entry->info = *info;
+    entry->in_use = 1;
+    entry->last_use = ++key_cache_uses;
+    (void)tfm_memcpy(entry->data, data, info->size);
+}
+
+psa_status_t tfm_crypto_key_cache_its_get_info(psa_storage_uid_t uid,
+                                               struct psa_storage_info_t *p_info)
+{
+    struct key_cache_entry_t *entry = key_cache_find(uid);
+    uint8_t data[TFM_CRYPTO_PERSISTENT_KEY_CACHE_ENTRY_SIZE];
+    size_t data_length;
+    psa_status_t status;
+
+    if (p_info == NULL) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (entry != NULL) {
+        key_cache_stats.num_hits++;
+        *p_info = entry->info;
+        return PSA_SUCCESS;
+    }
+
+    status = psa_its_get_info(uid, p_info);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+    key_cache_stats.num_misses++;
+
+    /* Read the asset now, as it is read next when a key is loaded */
+    if (p_info->size <= sizeof(data)) {
+        if ((psa_its_get(uid, 0, p_info->size, data,
+                         &data_length) == PSA_SUCCESS) &&
+            (data_length == p_info->size)) {
+            key_cache_store(uid, p_info, data);
+        }
+        (void)tfm_memset(data, 0, sizeof(data));
+    } else {
+        key_cache_stats.num_bypassed++;
+    }
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t tfm_crypto_key_cache_its_get(psa_storage_uid_t uid,
+                                          size_t data_offset,
+                                          size_t data_size,
+                                          void *p_data,
+                                          size_t *p_data_length)
+{
+    struct key_cache_entry_t *entry = key_cache_find(uid);
+    size_t len;
+
+    if (entry == NULL) {
+        return psa_its_get(uid, data_offset, data_size, p_data,
+                           p_data_length);
+    }
+
+    if ((p_data_length == NULL) || ((p_data == NULL) && (data_size != 0))) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    /* Same semantics as the ITS service */
+    if (data_offset > entry->info.size) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+    len = entry->info.size - data_offset;
+    if (len > data_size) {
+        len = data_size;
+    }
+
+    key_cache_stats.num_hits++;
+    (void)tfm_memcpy(p_data, entry->data + data_offset, len);
+    *p_data_length = len;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t tfm_crypto_key_cache_its_set(psa_storage_uid_t uid,
+                                          size_t data_length,
+                                          const void *p_data,
+                                          psa_storage_create_flags_t create_flags)
+{
+    struct key_cache_entry_t *entry;
+    struct psa_storage_info_t info;
+    psa_status_t status;
+
+    status = psa_its_set(uid, data_length, p_data, create_flags);
+    if (status != PSA_SUCCESS) {
+        /* The asset may not be in the state of the copy any more */
+        entry = key_cache_find(uid);
+        if (entry != NULL) {
+            key_cache_drop(entry);
+        }
+        return status;
+    }
+
+    info.capacity = data_length;
+    info.size = data_length;
+    info.flags = create_flags;
+    key_cache_store(uid, &info, p_data);
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t tfm_crypto_key_cache_its_remove(psa_storage_uid_t uid)
+{
+    struct key_cache_entry_t *entry = key_cache_find(uid);
+
+    if (entry != NULL) {
+        key_cache_drop(entry);
+    }
+
+    return psa_its_remove(uid);
+}
+#endif /* TFM_CRYPTO_PERSISTENT_KEY_CACHE_SLOTS > 0 */
+
+psa_status_t tfm_crypto_key_cache_get_stats(
+                                   struct tfm_crypto_key_cache_stats_t *stats)
+{
+#if TFM_CRYPTO_PERSISTENT_KEY_CACHE_SLOTS == 0
+    (void)stats;
+
+    return PSA_ERROR_NOT_SUPPORTED;
+#else
+    uint32_t i;
+
+    if (stats == NULL) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    *stats = key_cache_stats;
+    stats->num_slots = TFM_CRYPTO_PERSISTENT_KEY_CACHE_SLOTS;
+    stats->entry_size = TFM_CRYPTO_PERSISTENT_KEY_CACHE_ENTRY_SIZE;
+    stats->in_use = 0;
+    for (i = 0; i < TFM_CRYPTO_PERSISTENT_KEY_CACHE_SLOTS; i++) {
+        stats->in_use += key_cache[i].in_use;
+    }
+
+    return PSA_SUCCESS;
+#endif /* TFM_CRYPTO_PERSISTENT_KEY_CACHE_SLOTS == 0 */
+}
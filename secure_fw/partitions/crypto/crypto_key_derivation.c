@@ -418,6 +418,10 @@ psa_status_t tfm_crypto_key_derivation_output_key(psa_invec in_vec[],
         status = psa_key_derivation_output_key(&key_attributes, operation,
                                                &encoded_key);
     }
+    if (status == PSA_SUCCESS) {
+        /* The id may have belonged to a key released before */
+        tfm_crypto_mac_key_cache_invalidate(encoded_key);
+    }
 
     *key_handle = encoded_key.MBEDTLS_PRIVATE(key_id);
 
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2021-2022, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -52,6 +52,10 @@ psa_status_t tfm_crypto_import_key(psa_invec in_vec[],
     }
 
     status = psa_import_key(&key_attributes, data, data_length, &encoded_key);
+    if (status == PSA_SUCCESS) {
+        /* The id may have belonged to a key released before */
+        tfm_crypto_mac_key_cache_invalidate(encoded_key);
+    }
 
     /* Update the imported key id */
     *psa_key = encoded_key.MBEDTLS_PRIVATE(key_id);
@@ -131,6 +135,8 @@ psa_status_t tfm_crypto_close_key(psa_invec in_vec[],
 
     encoded_key = mbedtls_svc_key_id_make(partition_id, key);
 
+    tfm_crypto_mac_key_cache_invalidate(encoded_key);
+
     return psa_close_key(encoded_key);
 #endif /* TFM_CRYPTO_KEY_MODULE_DISABLED */
 }
@@ -163,6 +169,8 @@ psa_status_t tfm_crypto_destroy_key(psa_invec in_vec[],
 
     encoded_key = mbedtls_svc_key_id_make(partition_id, key);
 
+    tfm_crypto_mac_key_cache_invalidate(encoded_key);
+
     return psa_destroy_key(encoded_key);
 #endif /* TFM_CRYPTO_KEY_MODULE_DISABLED */
 }
@@ -345,6 +353,8 @@ psa_status_t tfm_crypto_purge_key(psa_invec in_vec[],
 
     encoded_key = mbedtls_svc_key_id_make(partition_id, key);
 
+    tfm_crypto_mac_key_cache_invalidate(encoded_key);
+
     return psa_purge_key(encoded_key);
 #endif /* TFM_CRYPTO_KEY_MODULE_DISABLED */
 }
@@ -395,6 +405,9 @@ psa_status_t tfm_crypto_copy_key(psa_invec in_vec[],
         return status;
     }
 
+    /* The id may have belonged to a key released before */
+    tfm_crypto_mac_key_cache_invalidate(target_key);
+
     *target_key_id = target_key.MBEDTLS_PRIVATE(key_id);
 
     return status;
@@ -441,6 +454,9 @@ psa_status_t tfm_crypto_generate_key(psa_invec in_vec[],
         return status;
     }
 
+    /* The id may have belonged to a key released before */
+    tfm_crypto_mac_key_cache_invalidate(encoded_key);
+
     *key_handle = encoded_key.MBEDTLS_PRIVATE(key_id);
 
     return status;
@@ -1,10 +1,11 @@
 /*
- * Copyright (c) 2019-2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2019-2022, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
  */
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -13,6 +14,183 @@
 #include "tfm_crypto_api.h"
 #include "tfm_crypto_defs.h"
 #include "tfm_crypto_private.h"
+#include "tfm_memory_utils.h"
+
+#ifndef TFM_CRYPTO_MAC_KEY_CACHE_SIZE
+#define TFM_CRYPTO_MAC_KEY_CACHE_SIZE (0)
+#endif
+
+#if !defined(TFM_CRYPTO_MAC_MODULE_DISABLED) && \
+    (TFM_CRYPTO_MAC_KEY_CACHE_SIZE > 0)
+/*
+ * The setup of an HMAC operation hashes the key padded with ipad, and keeps
+ * the key padded with opad for the finish step. Both only depend on the key
+ * and on the hash algorithm, so the operation state reached at the end of the
+ * setup is kept for the last keys used, and copied instead of being computed
+ * again when the same key is set up for the same algorithm and direction.
+ *
+ * The entries of a key are wiped when the key is closed, destroyed or purged,
+ * and when a key is created with its id, as the crypto library gives the id of
+ * a released volatile key to the next one created. The attributes of the key
+ * are also kept in each entry and compared on a hit, so that an id taken by
+ * another key can never reuse the state of the previous one.
+ */
+
+/**
+ * \brief Attributes identifying the key an HMAC setup state belongs to
+ */
+struct tfm_mac_key_identity_t {
+    psa_key_type_t type;         /*!< Key type */
+    size_t bits;                 /*!< Key size in bits */
+    psa_key_lifetime_t lifetime; /*!< Key lifetime */
+    psa_key_usage_t usage;       /*!< Usage flags of the key policy */
+    psa_algorithm_t alg;         /*!< Algorithm of the key policy */
+};
+
+/**
+ * \brief Operation state saved after the setup of an HMAC operation
+ */
+struct tfm_mac_key_cache_entry_t {
+    mbedtls_svc_key_id_t key;      /*!< Key, with the owner encoded */
+    struct tfm_mac_key_identity_t identity; /*!< Attributes of the key */
+    psa_algorithm_t alg;           /*!< HMAC algorithm, 0 if the entry is
+                                    *   unused
+                                    */
+    uint32_t is_sign;              /*!< 1 for sign, 0 for verify */
+    uint32_t last_use;             /*!< Value of the use counter at the last
+                                    *   hit, to find the entry to evict
+                                    */
+    psa_mac_operation_t operation; /*!< State at the end of the setup */
+};
+
+static struct tfm_mac_key_cache_entry_t
+                                  mac_key_cache[TFM_CRYPTO_MAC_KEY_CACHE_SIZE];
+static uint32_t mac_key_cache_uses;
+
+/**
+ * \brief Operation used by the single-part functions, kept out of the stack
+ *        of the partition
+ */
+static psa_mac_operation_t mac_oneshot_operation;
+
+static void mac_key_cache_wipe(struct tfm_mac_key_cache_entry_t *entry)
+{
+    (void)tfm_memset(entry, 0, sizeof(*entry));
+}
+
+static psa_status_t mac_key_get_identity(
+                                        mbedtls_svc_key_id_t key,
+                                        struct tfm_mac_key_identity_t *identity)
+{
+    psa_key_attributes_t attributes = PSA_KEY_ATTRIBUTES_INIT;
+    psa_status_t status;
+
+    status = psa_get_key_attributes(key, &attributes);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    identity->type = psa_get_key_type(&attributes);
+    identity->bits = psa_get_key_bits(&attributes);
+    identity->lifetime = psa_get_key_lifetime(&attributes);
+    identity->usage = psa_get_key_usage_flags(&attributes);
+    identity->alg = psa_get_key_algorithm(&attributes);
+
+    psa_reset_key_attributes(&attributes);
+
+    return PSA_SUCCESS;
+}
+
+static bool mac_key_identity_equal(const struct tfm_mac_key_identity_t *a,
+                                   const struct tfm_mac_key_identity_t *b)
+{
+    return (a->type == b->type) && (a->bits == b->bits) &&
+           (a->lifetime == b->lifetime) && (a->usage == b->usage) &&
+           (a->alg == b->alg);
+}
+
+/**
+ * \brief Sets up an HMAC operation from the saved state of the key if there
+ *        is one, or through the crypto library otherwise, saving its state.
+ *        Other MAC algorithms are always set up by the crypto library.
+ */
+static psa_status_t mac_setup(psa_mac_operation_t *operation,
+                              mbedtls_svc_key_id_t key,
+                              psa_algorithm_t alg,
+                              uint32_t is_sign)
+{
+    struct tfm_mac_key_cache_entry_t *victim = &mac_key_cache[0];
+    struct tfm_mac_key_identity_t identity;
+    psa_status_t status;
+    uint32_t i;
+
+    if (!PSA_ALG_IS_HMAC(alg)) {
+        return is_sign ? psa_mac_sign_setup(operation, key, alg) :
+                         psa_mac_verify_setup(operation, key, alg);
+    }
+
+    /* Fails in the same way as the setup if the key does not exist */
+    status = mac_key_get_identity(key, &identity);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    mac_key_cache_uses++;
+
+    for (i = 0; i < TFM_CRYPTO_MAC_KEY_CACHE_SIZE; i++) {
+        if ((mac_key_cache[i].alg == alg) &&
+            (mac_key_cache[i].is_sign == is_sign) &&
+            mbedtls_svc_key_id_equal(mac_key_cache[i].key, key) &&
+            mac_key_identity_equal(&mac_key_cache[i].identity, &identity)) {
+            mac_key_cache[i].last_use = mac_key_cache_uses;
+            (void)tfm_memcpy(operation, &mac_key_cache[i].operation,
+                             sizeof(*operation));
+            return PSA_SUCCESS;
+        }
+
+        /* Prefer an unused entry, then the least recently used one */
+        if ((victim->alg != 0) &&
+            ((mac_key_cache[i].alg == 0) ||
+             ((mac_key_cache_uses - mac_key_cache[i].last_use) >
+              (mac_key_cache_uses - victim->last_use)))) {
+            victim = &mac_key_cache[i];
+        }
+    }
+
+    status = is_sign ? psa_mac_sign_setup(operation, key, alg) :
+                       psa_mac_verify_setup(operation, key, alg);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    mac_key_cache_wipe(victim);
+    victim->key = key;
+    victim->identity = identity;
+    victim->alg = alg;
+    victim->is_sign = is_sign;
+    victim->last_use = mac_key_cache_uses;
+    (void)tfm_memcpy(&victim->operation, operation, sizeof(*operation));
+
+    return PSA_SUCCESS;
+}
+#endif /* !TFM_CRYPTO_MAC_MODULE_DISABLED && TFM_CRYPTO_MAC_KEY_CACHE_SIZE */
+
+void tfm_crypto_mac_key_cache_invalidate(mbedtls_svc_key_id_t key)
+{
+#if !defined(TFM_CRYPTO_MAC_MODULE_DISABLED) && \
+    (TFM_CRYPTO_MAC_KEY_CACHE_SIZE > 0)
+    uint32_t i;
+
+    for (i = 0; i < TFM_CRYPTO_MAC_KEY_CACHE_SIZE; i++) {
+        if ((mac_key_cache[i].alg != 0) &&
+            mbedtls_svc_key_id_equal(mac_key_cache[i].key, key)) {
+            mac_key_cache_wipe(&mac_key_cache[i]);
+        }
+    }
+#else
+    (void)key;
+#endif
+}
 
 /*!
  * \defgroup public_psa Public functions, PSA
@@ -62,7 +240,11 @@ psa_status_t tfm_crypto_mac_sign_setup(psa_invec in_vec[],
         goto exit;
     }
 
+#if TFM_CRYPTO_MAC_KEY_CACHE_SIZE > 0
+    status = mac_setup(operation, encoded_key, alg, 1);
+#else
     status = psa_mac_sign_setup(operation, encoded_key, alg);
+#endif
     if (status != PSA_SUCCESS) {
         goto exit;
     }
@@ -118,7 +300,11 @@ psa_status_t tfm_crypto_mac_verify_setup(psa_invec in_vec[],
         goto exit;
     }
 
+#if TFM_CRYPTO_MAC_KEY_CACHE_SIZE > 0
+    status = mac_setup(operation, encoded_key, alg, 0);
+#else
     status = psa_mac_verify_setup(operation, encoded_key, alg);
+#endif
     if (status != PSA_SUCCESS) {
         goto exit;
     }
@@ -335,6 +521,22 @@ psa_status_t tfm_crypto_mac_compute(psa_invec in_vec[],
         return status;
     }
 
+#if TFM_CRYPTO_MAC_KEY_CACHE_SIZE > 0
+    if (PSA_ALG_IS_HMAC(alg)) {
+        status = mac_setup(&mac_oneshot_operation, encoded_key, alg, 1);
+        if (status == PSA_SUCCESS) {
+            status = psa_mac_update(&mac_oneshot_operation, input,
+                                    input_length);
+        }
+        if (status == PSA_SUCCESS) {
+            status = psa_mac_sign_finish(&mac_oneshot_operation, mac,
+                                         mac_size, &out_vec[0].len);
+        }
+        (void)psa_mac_abort(&mac_oneshot_operation);
+        return status;
+    }
+#endif
+
     return psa_mac_compute(encoded_key, alg, input, input_length, mac, mac_size,
                            &out_vec[0].len);
 #endif /* TFM_CRYPTO_MAC_MODULE_DISABLED */
@@ -369,6 +571,22 @@ psa_status_t tfm_crypto_mac_verify(psa_invec in_vec[],
         return status;
     }
 
+#if TFM_CRYPTO_MAC_KEY_CACHE_SIZE > 0
+    if (PSA_ALG_IS_HMAC(alg)) {
+        status = mac_setup(&mac_oneshot_operation, encoded_key, alg, 0);
+        if (status == PSA_SUCCESS) {
+            status = psa_mac_update(&mac_oneshot_operation, input,
+                                    input_length);
+        }
+        if (status == PSA_SUCCESS) {
+            status = psa_mac_verify_finish(&mac_oneshot_operation, mac,
+                                           mac_length);
+        }
+        (void)psa_mac_abort(&mac_oneshot_operation);
+        return status;
+    }
+#endif
+
     return psa_mac_verify(encoded_key, alg, input, input_length, mac,
                           mac_length);
 #endif /* TFM_CRYPTO_MAC_MODULE_DISABLED */
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019-2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2019-2022, Arm Limited. All rights reserved.
  * Copyright (c) 2021, Nordic Semiconductor ASA.
  *
  * SPDX-License-Identifier: BSD-3-Clause
@@ -14,7 +14,90 @@
 #include "tfm_crypto_api.h"
 #include "tfm_crypto_defs.h"
 #include "tfm_crypto_private.h"
+#include "tfm_memory_utils.h"
 
+/**
+ * \def TFM_CRYPTO_RNG_POOL_SIZE
+ *
+ * \brief Size in bytes of the pool of DRBG output used to serve small random
+ *        requests. The pool is disabled when it is 0, which is the default.
+ */
+#ifndef TFM_CRYPTO_RNG_POOL_SIZE
+#define TFM_CRYPTO_RNG_POOL_SIZE (0)
+#endif
+
+/**
+ * \def TFM_CRYPTO_RNG_POOL_MAX_REQUEST
+ *
+ * \brief Largest request in bytes served from the pool of DRBG output. Larger
+ *        requests are always served by the DRBG directly.
+ */
+#ifndef TFM_CRYPTO_RNG_POOL_MAX_REQUEST
+#define TFM_CRYPTO_RNG_POOL_MAX_REQUEST (16)
+#endif
+
+#if (TFM_CRYPTO_RNG_POOL_SIZE > 0) && !defined(TFM_CRYPTO_RNG_MODULE_DISABLED)
+#if TFM_CRYPTO_RNG_POOL_MAX_REQUEST > TFM_CRYPTO_RNG_POOL_SIZE
+#error "TFM_CRYPTO_RNG_POOL_MAX_REQUEST is larger than TFM_CRYPTO_RNG_POOL_SIZE"
+#endif
+
+/**
+ * \brief Pool of DRBG output. The bytes are served from the end of the pool
+ *        and wiped as soon as they are handed out, so each of them is only
+ *        used once and does not stay in memory.
+ */
+static struct {
+    uint8_t buf[TFM_CRYPTO_RNG_POOL_SIZE];
+    size_t avail; /*!< Number of bytes not served yet, at the start of buf */
+} rng_pool;
+
+static psa_status_t rng_pool_fill(void)
+{
+    psa_status_t status;
+
+    status = psa_generate_random(rng_pool.buf, sizeof(rng_pool.buf));
+    if (status != PSA_SUCCESS) {
+        (void)tfm_memset(rng_pool.buf, 0, sizeof(rng_pool.buf));
+        rng_pool.avail = 0;
+        return status;
+    }
+    rng_pool.avail = sizeof(rng_pool.buf);
+
+    return PSA_SUCCESS;
+}
+
+static psa_status_t rng_pool_get(uint8_t *output, size_t output_size)
+{
+    psa_status_t status;
+    uint8_t *src;
+
+    if (rng_pool.avail < output_size) {
+        status = rng_pool_fill();
+        if (status != PSA_SUCCESS) {
+            return status;
+        }
+    }
+
+    rng_pool.avail -= output_size;
+    src = &rng_pool.buf[rng_pool.avail];
+    (void)tfm_memcpy(output, src, output_size);
+    (void)tfm_memset(src, 0, output_size);
+
+    return PSA_SUCCESS;
+}
+#endif /* TFM_CRYPTO_RNG_POOL_SIZE > 0 && !TFM_CRYPTO_RNG_MODULE_DISABLED */
+
+void tfm_crypto_rng_pool_refill(void)
+{
+#if (TFM_CRYPTO_RNG_POOL_SIZE > 0) && !defined(TFM_CRYPTO_RNG_MODULE_DISABLED)
+    /* Only refill once the pool can no longer serve a request of any size,
+     * so that the DRBG is called in blocks of the size of the pool.
+     */
+    if (rng_pool.avail < TFM_CRYPTO_RNG_POOL_MAX_REQUEST) {
+        (void)rng_pool_fill();
+    }
+#endif
+}
 
 /*!
  * \defgroup public_psa Public functions, PSA
@@ -39,6 +122,13 @@ psa_status_t tfm_crypto_generate_random(psa_invec in_vec[],
     uint8_t *output = out_vec[0].base;
     size_t output_size = out_vec[0].len;
 
+#if TFM_CRYPTO_RNG_POOL_SIZE > 0
+    if ((output_size > 0) &&
+        (output_size <= TFM_CRYPTO_RNG_POOL_MAX_REQUEST)) {
+        return rng_pool_get(output, output_size);
+    }
+#endif
+
     return psa_generate_random(output, output_size);
 #endif /* TFM_CRYPTO_RNG_MODULE_DISABLED */
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019-2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2019-2022, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -161,4 +161,17 @@
 #define psa_generate_key \
         PSA_FUNCTION_NAME(psa_generate_key)
 
+#if defined(TFM_CRYPTO_PERSISTENT_KEY_CACHE_SLOTS) && \
+    (TFM_CRYPTO_PERSISTENT_KEY_CACHE_SLOTS > 0)
+/* The persistent keys are read from ITS through the cache of the service */
+#define psa_its_get_info \
+        tfm_crypto_key_cache_its_get_info
+#define psa_its_get \
+        tfm_crypto_key_cache_its_get
+#define psa_its_set \
+        tfm_crypto_key_cache_its_set
+#define psa_its_remove \
+        tfm_crypto_key_cache_its_remove
+#endif
+
 #endif /* CRYPTO_SPE_H */
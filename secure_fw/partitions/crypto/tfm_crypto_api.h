@@ -47,6 +47,85 @@ enum tfm_crypto_operation_type {
     TFM_CRYPTO_OPERATION_TYPE_MAX = INT_MAX
 };
 
+/**
+ * \brief Usage of a pool of operation contexts, as returned by
+ *        \ref tfm_crypto_operation_get_usage
+ */
+struct tfm_crypto_pool_usage_t {
+    uint32_t num_slots;  /*!< Number of operation contexts of the pool */
+    size_t slot_size;    /*!< Size of each operation context in bytes */
+    uint32_t in_use;     /*!< Number of operation contexts in use */
+    uint32_t max_in_use; /*!< Largest number of operation contexts in use
+                          *   since the service was initialised
+                          */
+};
+
+/**
+ * \brief Statistics of the heap of the crypto backend, as returned by
+ *        \ref tfm_crypto_engine_alloc_get_stats
+ */
+struct tfm_crypto_engine_alloc_stats_t {
+    size_t heap_size;       /*!< Usable size of the heap in bytes, first-fit
+                             *   heap included
+                             */
+    size_t unused;          /*!< Bytes of the heap not split into blocks yet */
+    size_t in_use;          /*!< Bytes of the blocks in use, headers included */
+    size_t peak_in_use;     /*!< Largest value of in_use since the service was
+                             *   initialised
+                             */
+    size_t requested;       /*!< Bytes requested by the allocations in use. The
+                             *   rest of in_use is lost to the block headers
+                             *   and to the rounding up to the size classes
+                             */
+    size_t free_in_classes; /*!< Bytes of the free blocks, which can only be
+                             *   reused for their size class or smaller ones
+                             */
+    size_t largest_alloc;   /*!< Largest allocation which can currently
+                             *   succeed
+                             */
+    uint32_t num_allocs;    /*!< Number of successful allocations */
+    uint32_t num_failed;    /*!< Number of failed allocations */
+    uint32_t num_classes;   /*!< Number of size classes */
+    size_t first_fit_size;  /*!< Size of the first-fit heap in bytes */
+    size_t first_fit_in_use; /*!< Bytes of the first-fit heap in use, headers
+                              *   included. They are part of in_use
+                              */
+    uint32_t num_first_fit_allocs; /*!< Number of allocations served by the
+                                    *   first-fit heap
+                                    */
+};
+
+/**
+ * \brief Statistics of a size class of the heap of the crypto backend, as
+ *        returned by \ref tfm_crypto_engine_alloc_get_class_stats
+ */
+struct tfm_crypto_engine_alloc_class_stats_t {
+    size_t block_size;   /*!< Largest allocation served by the class */
+    uint32_t num_blocks; /*!< Number of blocks split from the heap */
+    uint32_t in_use;     /*!< Number of blocks in use */
+    uint32_t max_in_use; /*!< Largest number of blocks in use since the
+                          *   service was initialised
+                          */
+};
+
+/**
+ * \brief Statistics of the cache of persistent keys, as returned by
+ *        \ref tfm_crypto_key_cache_get_stats
+ */
+struct tfm_crypto_key_cache_stats_t {
+    uint32_t num_slots;     /*!< Number of entries of the cache */
+    uint32_t entry_size;    /*!< Largest stored key kept in an entry, in bytes */
+    uint32_t in_use;        /*!< Number of entries holding a key */
+    uint32_t num_hits;      /*!< Reads served from the cache */
+    uint32_t num_misses;    /*!< Reads of keys not in the cache, which were
+                             *   read from ITS
+                             */
+    uint32_t num_evictions; /*!< Keys dropped to make room for another one */
+    uint32_t num_bypassed;  /*!< Accesses to keys too large to be kept in an
+                             *   entry
+                             */
+};
+
 /**
  * \brief Initialise the service
  *
@@ -129,6 +208,107 @@ psa_status_t tfm_crypto_operation_release(uint32_t *handle);
 psa_status_t tfm_crypto_operation_lookup(enum tfm_crypto_operation_type type,
                                          uint32_t handle,
                                          void **ctx);
+/**
+ * \brief Get the usage of the pool of operation contexts of a given type
+ *
+ * \param[in]  type   Type of the operations of the pool, or
+ *                    TFM_CRYPTO_OPERATION_NONE for the shared pool
+ * \param[out] usage  Usage of the pool, including its high watermark
+ *
+ * \return Return values as described in \ref psa_status_t
+ */
+psa_status_t tfm_crypto_operation_get_usage(
+                                    enum tfm_crypto_operation_type type,
+                                    struct tfm_crypto_pool_usage_t *usage);
+/**
+ * \brief Initialises the size class allocator of the crypto backend on a
+ *        static buffer
+ *
+ * \param[in] buf             Buffer holding the heap
+ * \param[in] size            Size of the buffer in bytes
+ * \param[in] first_fit_size  Bytes at the end of the buffer kept as a
+ *                            first-fit heap, for the allocations which the
+ *                            size classes cannot serve
+ *
+ * \return Return values as described in \ref psa_status_t
+ */
+psa_status_t tfm_crypto_engine_alloc_init(uint8_t *buf, size_t size,
+                                          size_t first_fit_size);
+
+/**
+ * \brief Allocates zeroed memory for the crypto backend, with the prototype
+ *        expected by mbedtls_platform_set_calloc_free()
+ *
+ * \param[in] nmemb  Number of elements
+ * \param[in] size   Size of each element in bytes
+ *
+ * \return Pointer to the allocated memory, NULL on failure
+ */
+void *tfm_crypto_engine_calloc(size_t nmemb, size_t size);
+
+/**
+ * \brief Releases memory allocated by \ref tfm_crypto_engine_calloc
+ *
+ * \param[in] ptr  Pointer to the memory to release, can be NULL
+ */
+void tfm_crypto_engine_free(void *ptr);
+
+/**
+ * \brief Gets the statistics of the heap of the crypto backend. This is a
+ *        debug query of the size class allocator.
+ *
+ * \param[out] stats  Statistics of the heap
+ *
+ * \return PSA_ERROR_NOT_SUPPORTED if the size class allocator is not used,
+ *         otherwise return values as described in \ref psa_status_t
+ */
+psa_status_t tfm_crypto_engine_alloc_get_stats(
+                                struct tfm_crypto_engine_alloc_stats_t *stats);
+
+/**
+ * \brief Gets the statistics of a size class of the heap of the crypto
+ *        backend. This is a debug query of the size class allocator.
+ *
+ * \param[in]  class_idx  Index of the class, smaller than the num_classes
+ *                        field of \ref tfm_crypto_engine_alloc_stats_t
+ * \param[out] stats      Statistics of the class
+ *
+ * \return PSA_ERROR_NOT_SUPPORTED if the size class allocator is not used,
+ *         otherwise return values as described in \ref psa_status_t
+ */
+psa_status_t tfm_crypto_engine_alloc_get_class_stats(
+                          uint32_t class_idx,
+                          struct tfm_crypto_engine_alloc_class_stats_t *stats);
+
+/**
+ * \brief Refills the pool of DRBG output used to serve small random requests,
+ *        if it is nearly empty. It is called when the service is idle, so that
+ *        the requests seldom wait for the DRBG. It does nothing when the pool
+ *        is disabled.
+ */
+void tfm_crypto_rng_pool_refill(void);
+
+/**
+ * \brief Gets the statistics of the cache of persistent keys read from ITS.
+ *
+ * \param[out] stats  Statistics of the cache
+ *
+ * \return PSA_ERROR_NOT_SUPPORTED if the cache is disabled, otherwise return
+ *         values as described in \ref psa_status_t
+ */
+psa_status_t tfm_crypto_key_cache_get_stats(
+                                   struct tfm_crypto_key_cache_stats_t *stats);
+
+/**
+ * \brief Drops the HMAC setup states saved for a key id, so that they cannot
+ *        be used once the key is closed, destroyed or removed from memory, or
+ *        by a new key created with the same id. It does nothing when the
+ *        cache of the MAC module is disabled.
+ *
+ * \param[in] key Key, with the owner encoded
+ */
+void tfm_crypto_mac_key_cache_invalidate(mbedtls_svc_key_id_t key);
+
 /**
  * \brief Encodes the input key id and owner to output key
  *
@@ -206,6 +386,7 @@ psa_status_t tfm_crypto_encode_id_and_owner(psa_key_id_t key_id,
     X(tfm_crypto_raw_key_agreement)           \
     X(tfm_crypto_generate_random)             \
     X(tfm_crypto_generate_key)                \
+    X(tfm_crypto_batch)                       \
 
 #define X(api_name) UNIFORM_SIGNATURE_API(api_name);
 LIST_TFM_CRYPTO_UNIFORM_SIGNATURE_API
@@ -11,6 +11,7 @@
 #ifdef TFM_PSA_API
 #include "psa/client.h"
 #include "psa_manifest/sid.h"
+#include "tfm_crypto_pack.h"
 #else
 #include "tfm_veneers.h"
 #endif
@@ -18,14 +19,40 @@
 #ifdef TFM_PSA_API
 
 #define API_DISPATCH(srv_name, srv_id)                         \
-    psa_call(TFM_CRYPTO_HANDLE, PSA_IPC_CALL,                  \
+    tfm_crypto_call(                                           \
         in_vec, ARRAY_SIZE(in_vec),                            \
         out_vec, ARRAY_SIZE(out_vec))
 
 #define API_DISPATCH_NO_OUTVEC(srv_name, srv_id)               \
-    psa_call(TFM_CRYPTO_HANDLE, PSA_IPC_CALL,                  \
+    tfm_crypto_call(                                           \
         in_vec, ARRAY_SIZE(in_vec),                            \
         (psa_outvec *)NULL, 0)
+
+/**
+ * \brief Sends a request to the crypto service, with the
+ *        struct tfm_crypto_pack_iovec of the first input vector replaced by
+ *        its compact encoding.
+ */
+static psa_status_t tfm_crypto_call(const psa_invec *in_vec, size_t in_len,
+                                    psa_outvec *out_vec, size_t out_len)
+{
+    uint32_t pack_buf[TFM_CRYPTO_PACK_MAX_SIZE / sizeof(uint32_t)];
+    psa_invec pack_in_vec[PSA_MAX_IOVEC];
+    size_t i;
+
+    if ((in_len == 0) || (in_len > PSA_MAX_IOVEC)) {
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    pack_in_vec[0].base = pack_buf;
+    pack_in_vec[0].len = tfm_crypto_pack_encode(in_vec[0].base, pack_buf);
+    for (i = 1; i < in_len; i++) {
+        pack_in_vec[i] = in_vec[i];
+    }
+
+    return psa_call(TFM_CRYPTO_HANDLE, PSA_IPC_CALL,
+                    pack_in_vec, in_len, out_vec, out_len);
+}
 #else
 #define API_DISPATCH(srv_name, srv_id)                         \
     srv_name##_veneer(                                         \
@@ -963,8 +990,8 @@ psa_status_t psa_aead_encrypt(psa_key_id_t key_id,
     if (additional_data == NULL) {
         in_len--;
     }
-    status = psa_call(TFM_CRYPTO_HANDLE, PSA_IPC_CALL, in_vec, in_len,
-                      out_vec, ARRAY_SIZE(out_vec));
+    status = tfm_crypto_call(in_vec, in_len,
+                             out_vec, ARRAY_SIZE(out_vec));
 #else
     status = API_DISPATCH(tfm_crypto_aead_encrypt,
                           TFM_CRYPTO_AEAD_ENCRYPT);
@@ -1033,8 +1060,8 @@ psa_status_t psa_aead_decrypt(psa_key_id_t key_id,
     if (additional_data == NULL) {
         in_len--;
     }
-    status = psa_call(TFM_CRYPTO_HANDLE, PSA_IPC_CALL, in_vec, in_len,
-                      out_vec, ARRAY_SIZE(out_vec));
+    status = tfm_crypto_call(in_vec, in_len,
+                             out_vec, ARRAY_SIZE(out_vec));
 #else
     status = API_DISPATCH(tfm_crypto_aead_decrypt,
                           TFM_CRYPTO_AEAD_DECRYPT);
@@ -1219,8 +1246,8 @@ psa_status_t psa_aead_update_ad(psa_aead_operation_t *operation,
     if (input == NULL) {
         in_len--;
     }
-    status = psa_call(TFM_CRYPTO_HANDLE, PSA_IPC_CALL, in_vec, in_len,
-                      out_vec, ARRAY_SIZE(out_vec));
+    status = tfm_crypto_call(in_vec, in_len,
+                             out_vec, ARRAY_SIZE(out_vec));
 #else
     status = API_DISPATCH(tfm_crypto_aead_update_ad,
                           TFM_CRYPTO_AEAD_UPDATE_AD);
@@ -1266,8 +1293,8 @@ psa_status_t psa_aead_update(psa_aead_operation_t *operation,
     if (input == NULL) {
         in_len--;
     }
-    status = psa_call(TFM_CRYPTO_HANDLE, PSA_IPC_CALL, in_vec, in_len,
-                      out_vec, ARRAY_SIZE(out_vec));
+    status = tfm_crypto_call(in_vec, in_len,
+                             out_vec, ARRAY_SIZE(out_vec));
 #else
     status = API_DISPATCH(tfm_crypto_aead_update,
                           TFM_CRYPTO_AEAD_UPDATE);
@@ -1319,9 +1346,8 @@ psa_status_t psa_aead_finish(psa_aead_operation_t *operation,
         return PSA_ERROR_INVALID_ARGUMENT;
     }
 
-    status = psa_call(TFM_CRYPTO_HANDLE, PSA_IPC_CALL,
-                      in_vec, ARRAY_SIZE(in_vec),
-                      out_vec, out_len);
+    status = tfm_crypto_call(in_vec, ARRAY_SIZE(in_vec),
+                             out_vec, out_len);
 
     if (out_len == 3) {
         *ciphertext_length = out_vec[2].len;
@@ -1381,9 +1407,8 @@ psa_status_t psa_aead_verify(psa_aead_operation_t *operation,
     if ((out_len == 2) && (plaintext_length == NULL)) {
         return PSA_ERROR_INVALID_ARGUMENT;
     }
-    status = psa_call(TFM_CRYPTO_HANDLE, PSA_IPC_CALL,
-                      in_vec, ARRAY_SIZE(in_vec),
-                      out_vec, out_len);
+    status = tfm_crypto_call(in_vec, ARRAY_SIZE(in_vec),
+                             out_vec, out_len);
 
     if (out_len == 2) {
         *plaintext_length = out_vec[1].len;
@@ -1596,8 +1621,8 @@ psa_status_t psa_asymmetric_encrypt(psa_key_id_t key_id,
     if (salt == NULL) {
         in_len--;
     }
-    status = psa_call(TFM_CRYPTO_HANDLE, PSA_IPC_CALL, in_vec, in_len,
-                      out_vec, ARRAY_SIZE(out_vec));
+    status = tfm_crypto_call(in_vec, in_len,
+                             out_vec, ARRAY_SIZE(out_vec));
 #else
     status = API_DISPATCH(tfm_crypto_asymmetric_encrypt,
                           TFM_CRYPTO_ASYMMETRIC_ENCRYPT);
@@ -1650,8 +1675,8 @@ psa_status_t psa_asymmetric_decrypt(psa_key_id_t key_id,
     if (salt == NULL) {
         in_len--;
     }
-    status = psa_call(TFM_CRYPTO_HANDLE, PSA_IPC_CALL, in_vec, in_len,
-                      out_vec, ARRAY_SIZE(out_vec));
+    status = tfm_crypto_call(in_vec, in_len,
+                             out_vec, ARRAY_SIZE(out_vec));
 #else
     status = API_DISPATCH(tfm_crypto_asymmetric_decrypt,
                           TFM_CRYPTO_ASYMMETRIC_DECRYPT);
@@ -2141,3 +2166,65 @@ psa_status_t psa_key_derivation_output_key(
     return status;
 #endif /* TFM_CRYPTO_KEY_DERIVATION_MODULE_DISABLED */
 }
+
+psa_status_t tfm_crypto_batch_call(uint32_t *op_handle,
+                                   const struct tfm_crypto_batch_step_t *steps,
+                                   size_t num_steps,
+                                   const void *input,
+                                   size_t input_length,
+                                   void *output,
+                                   size_t output_size,
+                                   struct tfm_crypto_batch_result_t *results,
+                                   size_t *num_results)
+{
+#ifndef TFM_PSA_API
+    /* Batched requests are only supported by the IPC model */
+    return PSA_ERROR_NOT_SUPPORTED;
+#else
+    psa_status_t status;
+    struct tfm_crypto_pack_iovec iov = {
+        .srv_id = TFM_CRYPTO_BATCH_SID,
+        .op_handle = *op_handle,
+    };
+
+    if ((num_steps == 0) || (num_steps > TFM_CRYPTO_BATCH_MAX_STEPS)) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    /* Sanitize the optional buffers */
+    if (((input == NULL) && (input_length != 0)) ||
+        ((output == NULL) && (output_size != 0))) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    psa_invec in_vec[] = {
+        {.base = &iov, .len = sizeof(struct tfm_crypto_pack_iovec)},
+        {.base = steps,
+         .len = num_steps * sizeof(struct tfm_crypto_batch_step_t)},
+        {.base = input, .len = input_length},
+    };
+    psa_outvec out_vec[] = {
+        {.base = op_handle, .len = sizeof(uint32_t)},
+        {.base = results,
+         .len = num_steps * sizeof(struct tfm_crypto_batch_result_t)},
+        {.base = output, .len = output_size},
+    };
+
+    size_t in_len = ARRAY_SIZE(in_vec);
+    size_t out_len = ARRAY_SIZE(out_vec);
+
+    if (input_length == 0) {
+        in_len--;
+    }
+    if (output_size == 0) {
+        out_len--;
+    }
+
+    status = tfm_crypto_call(in_vec, in_len,
+                             out_vec, out_len);
+
+    *num_results = out_vec[1].len / sizeof(struct tfm_crypto_batch_result_t);
+
+    return status;
+#endif /* TFM_PSA_API */
+}
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2021-2022, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -23,10 +23,10 @@ static uint8_t its_write_buf_0[ITS_FLASH_NAND_BUF_SIZE];
 static uint8_t its_write_buf_1[ITS_FLASH_NAND_BUF_SIZE];
 struct its_flash_nand_dev_t its_flash_nand_dev = {
     .driver = &TFM_HAL_ITS_FLASH_DRIVER,
-    .buf_block_id_0 = ITS_BLOCK_INVALID_ID,
-    .buf_block_id_1 = ITS_BLOCK_INVALID_ID,
-    .write_buf_0 = its_write_buf_0,
-    .write_buf_1 = its_write_buf_1,
+    .bufs = {
+        { .block_id = ITS_BLOCK_INVALID_ID, .data = its_write_buf_0 },
+        { .block_id = ITS_BLOCK_INVALID_ID, .data = its_write_buf_1 },
+    },
     .buf_size = sizeof(its_write_buf_0),
 };
 #endif
@@ -46,10 +46,10 @@ static uint8_t ps_write_buf_0[PS_FLASH_NAND_BUF_SIZE];
 static uint8_t ps_write_buf_1[PS_FLASH_NAND_BUF_SIZE];
 struct its_flash_nand_dev_t ps_flash_nand_dev = {
     .driver = &TFM_HAL_PS_FLASH_DRIVER,
-    .buf_block_id_0 = ITS_BLOCK_INVALID_ID,
-    .buf_block_id_1 = ITS_BLOCK_INVALID_ID,
-    .write_buf_0 = ps_write_buf_0,
-    .write_buf_1 = ps_write_buf_1,
+    .bufs = {
+        { .block_id = ITS_BLOCK_INVALID_ID, .data = ps_write_buf_0 },
+        { .block_id = ITS_BLOCK_INVALID_ID, .data = ps_write_buf_1 },
+    },
     .buf_size = sizeof(ps_write_buf_0),
 };
 #endif
@@ -9,6 +9,7 @@
 #include "its_flash_nand.h"
 
 #include "flash_fs/its_flash_fs.h"
+#include "its_utils.h"
 #include "tfm_memory_utils.h"
 
 /**
@@ -26,9 +27,55 @@ static uint32_t get_phys_address(const struct its_flash_fs_config_t *cfg,
     return cfg->flash_area_addr + (block_id * cfg->block_size) + offset;
 }
 
+/**
+ * \brief Gets the write buffer of the given block ID.
+ *
+ * \param[in] flash_dev  NAND flash device
+ * \param[in] block_id   Block ID, or ITS_BLOCK_INVALID_ID to get a free buffer
+ *
+ * \returns Returns the write buffer, or NULL if there is none.
+ */
+static struct its_flash_nand_buf_t *get_buf(
+                                        struct its_flash_nand_dev_t *flash_dev,
+                                        uint32_t block_id)
+{
+    uint32_t i;
+
+    for (i = 0; i < ITS_FLASH_NAND_NUM_BUFS; i++) {
+        if (flash_dev->bufs[i].block_id == block_id) {
+            return &flash_dev->bufs[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * \brief Releases a write buffer, discarding its content.
+ *
+ * \param[in]     cfg  Flash FS configuration
+ * \param[in,out] buf  Write buffer
+ */
+static void release_buf(const struct its_flash_fs_config_t *cfg,
+                        struct its_flash_nand_buf_t *buf)
+{
+    /* Only the written range needs to be cleared, as the rest of the buffer
+     * is already in the erased state.
+     */
+    if (buf->dirty_end > buf->dirty_start) {
+        (void)tfm_memset(buf->data + buf->dirty_start, cfg->erase_val,
+                         buf->dirty_end - buf->dirty_start);
+    }
+
+    buf->block_id = ITS_BLOCK_INVALID_ID;
+    buf->dirty_start = cfg->block_size;
+    buf->dirty_end = 0;
+}
+
 static psa_status_t its_flash_nand_init(const struct its_flash_fs_config_t *cfg)
 {
     int32_t err;
+    uint32_t i;
     struct its_flash_nand_dev_t *flash_dev =
         (struct its_flash_nand_dev_t *)cfg->flash_dev;
 
@@ -36,6 +83,17 @@ static psa_status_t its_flash_nand_init(const struct its_flash_fs_config_t *cfg)
         return PSA_ERROR_PROGRAMMER_ERROR;
     }
 
+    /* Any data left in the write buffers was never committed to flash. Fill
+     * the buffers with the erased value, so that the data of a block that has
+     * not been written reads as erased.
+     */
+    for (i = 0; i < ITS_FLASH_NAND_NUM_BUFS; i++) {
+        (void)tfm_memset(flash_dev->bufs[i].data, cfg->erase_val,
+                         flash_dev->buf_size);
+        flash_dev->bufs[i].dirty_end = 0;
+        release_buf(cfg, &flash_dev->bufs[i]);
+    }
+
     err = flash_dev->driver->Initialize(NULL);
     if (err != ARM_DRIVER_OK) {
         return PSA_ERROR_STORAGE_FAILURE;
@@ -50,6 +108,7 @@ static psa_status_t its_flash_nand_read(const struct its_flash_fs_config_t *cfg,
 {
     struct its_flash_nand_dev_t *flash_dev =
         (struct its_flash_nand_dev_t *)cfg->flash_dev;
+    struct its_flash_nand_buf_t *buf;
     uint32_t addr;
     uint32_t remaining_len, read_length = 0;
     uint32_t aligned_addr;
@@ -72,10 +131,9 @@ static psa_status_t its_flash_nand_read(const struct its_flash_fs_config_t *cfg,
         return PSA_ERROR_PROGRAMMER_ERROR;
     }
 
-    if (block_id == flash_dev->buf_block_id_0) {
-        (void)tfm_memcpy(buff, flash_dev->write_buf_0 + offset, size);
-    } else if (block_id == flash_dev->buf_block_id_1) {
-        (void)tfm_memcpy(buff, flash_dev->write_buf_1 + offset, size);
+    buf = get_buf(flash_dev, block_id);
+    if (buf != NULL) {
+        (void)tfm_memcpy(buff, buf->data + offset, size);
     } else {
         addr = get_phys_address(cfg, block_id, offset);
         remaining_len = size;
@@ -144,26 +202,34 @@ static psa_status_t its_flash_nand_write(
 {
     struct its_flash_nand_dev_t *flash_dev =
         (struct its_flash_nand_dev_t *)cfg->flash_dev;
+    struct its_flash_nand_buf_t *buf;
 
     if (block_id == ITS_BLOCK_INVALID_ID) {
         return PSA_ERROR_PROGRAMMER_ERROR;
     }
 
     /* Write to the match block buffer if exists. Otherwise use the empty
-     * buffer if exists. If no more empty buffer, return error.
+     * buffer if exists. If no more empty buffer, return error. A buffer cannot
+     * be flushed early to make room, as the pages of a NAND block can only be
+     * programmed once.
      */
-    if (block_id == flash_dev->buf_block_id_0) {
-        (void)tfm_memcpy(flash_dev->write_buf_0 + offset, buff, size);
-    } else if (block_id == flash_dev->buf_block_id_1) {
-        (void)tfm_memcpy(flash_dev->write_buf_1 + offset, buff, size);
-    } else if (flash_dev->buf_block_id_0 == ITS_BLOCK_INVALID_ID) {
-        flash_dev->buf_block_id_0 = block_id;
-        (void)tfm_memcpy(flash_dev->write_buf_0 + offset, buff, size);
-    } else if (flash_dev->buf_block_id_1 == ITS_BLOCK_INVALID_ID) {
-        flash_dev->buf_block_id_1 = block_id;
-        (void)tfm_memcpy(flash_dev->write_buf_1 + offset, buff, size);
-    } else {
-        return PSA_ERROR_PROGRAMMER_ERROR;
+    buf = get_buf(flash_dev, block_id);
+    if (buf == NULL) {
+        buf = get_buf(flash_dev, ITS_BLOCK_INVALID_ID);
+        if (buf == NULL) {
+            return PSA_ERROR_PROGRAMMER_ERROR;
+        }
+        buf->block_id = block_id;
+    }
+
+    if (size > 0) {
+        (void)tfm_memcpy(buf->data + offset, buff, size);
+
+        /* Track the written range, so that only the pages that hold data are
+         * programmed when the block is flushed.
+         */
+        buf->dirty_start = ITS_UTILS_MIN(buf->dirty_start, offset);
+        buf->dirty_end = ITS_UTILS_MAX(buf->dirty_end, offset + size);
     }
 
     return PSA_SUCCESS;
@@ -176,7 +242,11 @@ static psa_status_t its_flash_nand_flush(
     int32_t err;
     struct its_flash_nand_dev_t *flash_dev =
         (struct its_flash_nand_dev_t *)cfg->flash_dev;
+    struct its_flash_nand_buf_t *buf;
     uint32_t addr;
+    uint32_t page_size;
+    size_t start;
+    size_t end;
     ARM_FLASH_CAPABILITIES DriverCapabilities;
 
     /* Valid entries for data item width */
@@ -187,41 +257,46 @@ static psa_status_t its_flash_nand_flush(
     };
     uint8_t data_width;
 
+    if (block_id == ITS_BLOCK_INVALID_ID) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    buf = get_buf(flash_dev, block_id);
+    if (buf == NULL) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
     DriverCapabilities = flash_dev->driver->GetCapabilities();
     data_width = data_width_byte[DriverCapabilities.data_width];
-    if (block_id == flash_dev->buf_block_id_0) {
-        addr = get_phys_address(cfg, flash_dev->buf_block_id_0, 0);
+    page_size = flash_dev->driver->GetInfo()->program_unit;
 
-        /*
-         * Flush the buffered write data to flash. For NAND flash,
-         * cfg->block_size should always be a multiplier of data_width.
-         */
-        err = flash_dev->driver->ProgramData(addr, flash_dev->write_buf_0,
-                                             cfg->block_size / data_width);
-        if (err < 0) {
-            return PSA_ERROR_STORAGE_FAILURE;
-        }
-
-        /* Clear the write buffer */
-        (void)tfm_memset(flash_dev->write_buf_0, 0, flash_dev->buf_size);
-        flash_dev->buf_block_id_0 = ITS_BLOCK_INVALID_ID;
-    } else if (block_id == flash_dev->buf_block_id_1) {
-        addr = get_phys_address(cfg, flash_dev->buf_block_id_1, 0);
+    /* Program only the pages that were written. The other pages of the block
+     * are left erased. For NAND flash, cfg->block_size should always be a
+     * multiple of the page size, which is a multiple of data_width.
+     */
+    if (buf->dirty_end > buf->dirty_start) {
+        start = (buf->dirty_start / page_size) * page_size;
+        end = ITS_UTILS_ALIGN(buf->dirty_end, page_size);
+        addr = get_phys_address(cfg, block_id, start);
 
-        /* Flush the buffered write data to flash*/
-        err = flash_dev->driver->ProgramData(addr, flash_dev->write_buf_1,
-                                             cfg->block_size / data_width);
+        err = flash_dev->driver->ProgramData(addr, buf->data + start,
+                                             (end - start) / data_width);
         if (err < 0) {
             return PSA_ERROR_STORAGE_FAILURE;
         }
-
-        /* Clear the write buffer */
-        (void)tfm_memset(flash_dev->write_buf_1, 0, flash_dev->buf_size);
-        flash_dev->buf_block_id_1 = ITS_BLOCK_INVALID_ID;
     } else {
-        return PSA_ERROR_GENERIC_ERROR;
+        start = 0;
+        end = 0;
     }
 
+    flash_dev->stats.flushes++;
+    flash_dev->stats.pages_programmed += (end - start) / page_size;
+    flash_dev->stats.pages_skipped += (cfg->block_size - (end - start))
+                                      / page_size;
+
+    /* Clear the write buffer */
+    release_buf(cfg, buf);
+
     return PSA_SUCCESS;
 }
 
@@ -233,6 +308,15 @@ static psa_status_t its_flash_nand_erase(const struct its_flash_fs_config_t *cfg
     size_t offset;
     struct its_flash_nand_dev_t *flash_dev =
         (struct its_flash_nand_dev_t *)cfg->flash_dev;
+    struct its_flash_nand_buf_t *buf;
+
+    /* Discard any data buffered for the block, for example from an update
+     * that failed before the block was flushed.
+     */
+    buf = get_buf(flash_dev, block_id);
+    if (buf != NULL) {
+        release_buf(cfg, buf);
+    }
 
     for (offset = 0; offset < cfg->block_size; offset += cfg->sector_size) {
         addr = get_phys_address(cfg, block_id, offset);
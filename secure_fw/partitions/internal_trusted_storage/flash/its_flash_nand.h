@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019-2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2019-2022, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -24,16 +24,40 @@
 extern "C" {
 #endif
 
+/* Two write buffers are reserved as the metadata block and the file block
+ * write can be mixed in the file system operation.
+ */
+#define ITS_FLASH_NAND_NUM_BUFS 2
+
+/**
+ * \brief Write buffer of a NAND flash block.
+ *
+ * Writes to the block are coalesced in the buffer, and only the pages that
+ * were written are programmed when the block is flushed.
+ */
+struct its_flash_nand_buf_t {
+    uint32_t block_id;  /**< Block ID buffered, or ITS_BLOCK_INVALID_ID */
+    uint8_t *data;      /**< Buffered block content */
+    size_t dirty_start; /**< Start of the written range of the buffer */
+    size_t dirty_end;   /**< End of the written range of the buffer */
+};
+
+/**
+ * \brief NAND flash interface counters.
+ */
+struct its_flash_nand_stats_t {
+    uint32_t flushes;          /**< Number of blocks flushed */
+    uint32_t pages_programmed; /**< Number of pages programmed by flushes */
+    uint32_t pages_skipped;    /**< Number of pages of the flushed blocks that
+                                *   were not written, and so not programmed
+                                */
+};
+
 struct its_flash_nand_dev_t {
     ARM_DRIVER_FLASH *driver;
-    /* Two write buffers are reserved as the metadata block and the file block
-     * write can be mixed in the file system operation.
-     */
-    uint32_t buf_block_id_0;
-    uint32_t buf_block_id_1;
-    uint8_t *write_buf_0;
-    uint8_t *write_buf_1;
+    struct its_flash_nand_buf_t bufs[ITS_FLASH_NAND_NUM_BUFS];
     size_t buf_size;
+    struct its_flash_nand_stats_t stats;
 };
 
 extern const struct its_flash_fs_ops_t its_flash_fs_ops_nand;
@@ -202,4 +202,9 @@ const struct its_flash_fs_ops_t its_flash_fs_ops_nor = {
     .write = its_flash_nor_write,
     .flush = its_flash_nor_flush,
     .erase = its_flash_nor_erase,
+#ifdef ITS_FLASH_NOR_IN_PLACE_WRITE
+    .in_place_write = true,
+#else
+    .in_place_write = false,
+#endif
 };
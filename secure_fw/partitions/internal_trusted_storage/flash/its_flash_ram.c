@@ -83,4 +83,5 @@ const struct its_flash_fs_ops_t its_flash_fs_ops_ram = {
     .write = its_flash_ram_write,
     .flush = its_flash_ram_flush,
     .erase = its_flash_ram_erase,
+    .in_place_write = true,
 };
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2018-2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2018-2022, Arm Limited. All rights reserved.
  * Copyright (c) 2020, Cypress Semiconductor Corporation. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
@@ -21,6 +21,17 @@
 
 static psa_status_t its_flash_fs_delete_idx(struct its_flash_fs_ctx_t *fs_ctx,
                                             uint32_t del_file_idx);
+static psa_status_t its_flash_fs_txn_file_write(
+                                              struct its_flash_fs_ctx_t *fs_ctx,
+                                              const uint8_t *fid,
+                                              uint32_t flags,
+                                              size_t max_size,
+                                              size_t data_size,
+                                              size_t offset,
+                                              const uint8_t *data);
+static psa_status_t its_flash_fs_txn_file_delete(
+                                              struct its_flash_fs_ctx_t *fs_ctx,
+                                              const uint8_t *fid);
 
 static psa_status_t its_flash_fs_file_write_aligned_data(
                                       struct its_flash_fs_ctx_t *fs_ctx,
@@ -28,8 +39,11 @@ static psa_status_t its_flash_fs_file_write_aligned_data(
                                       const struct its_file_meta_t *file_meta,
                                       size_t offset,
                                       size_t size,
-                                      const uint8_t *data)
+                                      const uint8_t *data,
+                                      bool *in_place)
 {
+    psa_status_t err;
+
 #if (ITS_FLASH_MAX_ALIGNMENT != 1)
     /* Check that the offset is aligned with the flash program unit */
     if (!ITS_UTILS_IS_ALIGNED(offset, fs_ctx->cfg->program_unit)) {
@@ -51,6 +65,18 @@ static psa_status_t its_flash_fs_file_write_aligned_data(
         return PSA_ERROR_INVALID_ARGUMENT;
     }
 
+    /* Try to append the data in place first, which avoids copying the rest of
+     * the data block to the scratch data block.
+     */
+    err = its_flash_fs_dblock_write_file_in_place(fs_ctx, block_meta, file_meta,
+                                                  offset, size, data);
+    if (err == PSA_SUCCESS) {
+        *in_place = true;
+        return PSA_SUCCESS;
+    }
+
+    *in_place = false;
+
     return its_flash_fs_dblock_write_file(fs_ctx, block_meta, file_meta, offset,
                                           size, data);
 }
@@ -137,6 +163,36 @@ static psa_status_t its_flash_fs_validate_config(
     return ret;
 }
 
+/**
+ * \brief Deletes all the files marked for deletion.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_flash_fs_delete_marked(
+                                              struct its_flash_fs_ctx_t *fs_ctx)
+{
+    psa_status_t err;
+    uint32_t idx;
+
+    for (;;) {
+        err = its_flash_fs_mblock_get_file_idx_flag(fs_ctx,
+                                                    ITS_FLASH_FS_FLAG_DELETE,
+                                                    &idx);
+        if (err == PSA_ERROR_DOES_NOT_EXIST) {
+            return PSA_SUCCESS;
+        } else if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        err = its_flash_fs_delete_idx(fs_ctx, idx);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+    }
+}
+
 psa_status_t its_flash_fs_init_ctx(its_flash_fs_ctx_t *fs_ctx,
                                    const struct its_flash_fs_config_t *fs_cfg,
                                    const struct its_flash_fs_ops_t *fs_ops)
@@ -166,7 +222,6 @@ psa_status_t its_flash_fs_init_ctx(its_flash_fs_ctx_t *fs_ctx,
 psa_status_t its_flash_fs_prepare(its_flash_fs_ctx_t *fs_ctx)
 {
     psa_status_t err;
-    uint32_t idx;
 
     /* Initialize metadata block with the valid/active metablock */
     err = its_flash_fs_mblock_init(fs_ctx);
@@ -174,18 +229,10 @@ psa_status_t its_flash_fs_prepare(its_flash_fs_ctx_t *fs_ctx)
         return err;
     }
 
-    /* Check if a file marked for deletion has been left behind by a power
-     * failure. If so, delete it.
+    /* Check if files marked for deletion have been left behind by a power
+     * failure. If so, delete them.
      */
-    err = its_flash_fs_mblock_get_file_idx_flag(fs_ctx,
-                                                ITS_FLASH_FS_FLAG_DELETE, &idx);
-    if (err == PSA_SUCCESS) {
-        return its_flash_fs_delete_idx(fs_ctx, idx);
-    } else if (err != PSA_ERROR_DOES_NOT_EXIST) {
-        return err;
-    }
-
-    return PSA_SUCCESS;
+    return its_flash_fs_delete_marked(fs_ctx);
 }
 
 psa_status_t its_flash_fs_wipe_all(struct its_flash_fs_ctx_t *fs_ctx)
@@ -240,6 +287,54 @@ psa_status_t its_flash_fs_file_get_info(struct its_flash_fs_ctx_t *fs_ctx,
     return PSA_SUCCESS;
 }
 
+psa_status_t its_flash_fs_file_get_next(struct its_flash_fs_ctx_t *fs_ctx,
+                                        uint32_t *idx,
+                                        uint8_t *fid,
+                                        struct its_file_info_t *info)
+{
+    psa_status_t err;
+    uint32_t i;
+    struct its_file_meta_t tmp_metadata;
+
+    for (i = *idx; i < fs_ctx->cfg->max_num_files; i++) {
+        err = its_flash_fs_mblock_read_file_meta(fs_ctx, i, &tmp_metadata);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        /* Skip the free entries and the files marked for deletion */
+        if (its_utils_validate_fid(tmp_metadata.id) != PSA_SUCCESS ||
+            (tmp_metadata.flags & ITS_FLASH_FS_FLAG_DELETE)) {
+            continue;
+        }
+
+        tfm_memcpy(fid, tmp_metadata.id, ITS_FILE_ID_SIZE);
+        info->size_max = tmp_metadata.max_size;
+        info->size_current = tmp_metadata.cur_size;
+        info->flags = tmp_metadata.flags & ITS_FLASH_FS_USER_FLAGS_MASK;
+
+        *idx = i + 1;
+        return PSA_SUCCESS;
+    }
+
+    *idx = i;
+    return PSA_ERROR_DOES_NOT_EXIST;
+}
+
+psa_status_t its_flash_fs_get_space(struct its_flash_fs_ctx_t *fs_ctx,
+                                    struct its_fs_space_t *space)
+{
+    /* One free file is kept as a spare for the atomic replacement of files */
+    space->num_free_files = (fs_ctx->num_free_files > 1) ?
+                            (fs_ctx->num_free_files - 1) : 0;
+    space->free_size = fs_ctx->free_size;
+    space->max_file_size = (space->num_free_files > 0) ?
+                           ITS_UTILS_MIN(fs_ctx->max_free_size,
+                                         fs_ctx->cfg->max_file_size) : 0;
+
+    return PSA_SUCCESS;
+}
+
 psa_status_t its_flash_fs_file_write(struct its_flash_fs_ctx_t *fs_ctx,
                                      const uint8_t *fid,
                                      uint32_t flags,
@@ -250,12 +345,14 @@ psa_status_t its_flash_fs_file_write(struct its_flash_fs_ctx_t *fs_ctx,
 {
     struct its_block_meta_t block_meta;
     struct its_file_meta_t file_meta = {0};
+    struct its_flash_fs_space_change_t change = {0};
     uint32_t cur_phys_block;
     psa_status_t err;
     uint32_t idx;
     uint32_t old_idx = ITS_METADATA_INVALID_INDEX;
     uint32_t new_idx = ITS_METADATA_INVALID_INDEX;
     bool use_spare;
+    bool in_place = false;
 
     /* Do not permit the user to pass filesystem-internal flags */
     if (flags & ITS_FLASH_FS_INTERNAL_FLAGS_MASK) {
@@ -267,6 +364,12 @@ psa_status_t its_flash_fs_file_write(struct its_flash_fs_ctx_t *fs_ctx,
     max_size = ITS_UTILS_ALIGN(max_size, fs_ctx->cfg->program_unit);
 #endif
 
+    /* Stage the write if a transaction is open */
+    if (fs_ctx->txn.active) {
+        return its_flash_fs_txn_file_write(fs_ctx, fid, flags, max_size,
+                                           data_size, offset, data);
+    }
+
     /* Check if the file already exists */
     err = its_flash_fs_mblock_get_file_idx(fs_ctx, fid, &old_idx);
     if (err == PSA_SUCCESS) {
@@ -328,6 +431,12 @@ psa_status_t its_flash_fs_file_write(struct its_flash_fs_ctx_t *fs_ctx,
         if (err != PSA_SUCCESS) {
             return err;
         }
+
+        /* The new file uses a free entry and max_size bytes of the block */
+        change.num_free_files = -1;
+        its_flash_fs_mblock_space_change_block(fs_ctx,
+                                               block_meta.free_size + max_size,
+                                               block_meta.free_size, &change);
     } else {
         /* Read existing block metadata */
         err = its_flash_fs_mblock_read_block_metadata(fs_ctx, file_meta.lblock,
@@ -341,7 +450,7 @@ psa_status_t its_flash_fs_file_write(struct its_flash_fs_ctx_t *fs_ctx,
         /* Write the content into scratch data block */
         err = its_flash_fs_file_write_aligned_data(fs_ctx, &block_meta,
                                                    &file_meta, offset,
-                                                   data_size, data);
+                                                   data_size, data, &in_place);
         if (err != PSA_SUCCESS) {
             return PSA_ERROR_GENERIC_ERROR;
         }
@@ -352,15 +461,19 @@ psa_status_t its_flash_fs_file_write(struct its_flash_fs_ctx_t *fs_ctx,
             file_meta.cur_size = offset + data_size;
         }
 
-        cur_phys_block = block_meta.phy_id;
+        /* Data written in place is already in the active data block */
+        if (!in_place) {
+            cur_phys_block = block_meta.phy_id;
 
-        /* Cur scratch block become the active datablock */
-        block_meta.phy_id =
-            its_flash_fs_mblock_cur_data_scratch_id(fs_ctx, file_meta.lblock);
+            /* Cur scratch block become the active datablock */
+            block_meta.phy_id =
+                its_flash_fs_mblock_cur_data_scratch_id(fs_ctx,
+                                                        file_meta.lblock);
 
-        /* Swap the scratch data block */
-        its_flash_fs_mblock_set_data_scratch(fs_ctx, cur_phys_block,
-                                             file_meta.lblock);
+            /* Swap the scratch data block */
+            its_flash_fs_mblock_set_data_scratch(fs_ctx, cur_phys_block,
+                                                 file_meta.lblock);
+        }
     }
 
     /* Update block metadata in scratch metadata block */
@@ -421,7 +534,7 @@ psa_status_t its_flash_fs_file_write(struct its_flash_fs_ctx_t *fs_ctx,
     }
 
     /* Write metadata header, swap metadata blocks and erase scratch blocks */
-    err = its_flash_fs_mblock_meta_update_finalize(fs_ctx);
+    err = its_flash_fs_mblock_meta_update_finalize(fs_ctx, &change);
     if (err != PSA_SUCCESS) {
         return err;
     }
@@ -449,6 +562,8 @@ static psa_status_t its_flash_fs_delete_idx(struct its_flash_fs_ctx_t *fs_ctx,
     size_t nbr_bytes_to_move = 0;
     uint32_t idx;
     struct its_file_meta_t file_meta;
+    struct its_block_meta_t block_meta;
+    struct its_flash_fs_space_change_t change = {0};
 
     err = its_flash_fs_mblock_read_file_meta(fs_ctx, del_file_idx, &file_meta);
     if (err != PSA_SUCCESS) {
@@ -464,6 +579,18 @@ static psa_status_t its_flash_fs_delete_idx(struct its_flash_fs_ctx_t *fs_ctx,
     del_file_data_idx = file_meta.data_idx;
     del_file_max_size = file_meta.max_size;
 
+    /* The deleted file releases its entry and its space in the block */
+    err = its_flash_fs_mblock_read_block_metadata(fs_ctx, del_file_lblock,
+                                                  &block_meta);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    change.num_free_files = 1;
+    its_flash_fs_mblock_space_change_block(fs_ctx, block_meta.free_size,
+                                           block_meta.free_size +
+                                           del_file_max_size, &change);
+
     /* Remove file metadata */
     file_meta = (struct its_file_meta_t){0};
 
@@ -547,7 +674,7 @@ static psa_status_t its_flash_fs_delete_idx(struct its_flash_fs_ctx_t *fs_ctx,
     /* Update the metablock header, swap scratch and active blocks,
      * erase scratch blocks.
      */
-    return its_flash_fs_mblock_meta_update_finalize(fs_ctx);
+    return its_flash_fs_mblock_meta_update_finalize(fs_ctx, &change);
 }
 
 psa_status_t its_flash_fs_file_delete(struct its_flash_fs_ctx_t *fs_ctx,
@@ -556,6 +683,11 @@ psa_status_t its_flash_fs_file_delete(struct its_flash_fs_ctx_t *fs_ctx,
     psa_status_t err;
     uint32_t del_file_idx;
 
+    /* Stage the deletion if a transaction is open */
+    if (fs_ctx->txn.active) {
+        return its_flash_fs_txn_file_delete(fs_ctx, fid);
+    }
+
     /* Get the file index */
     err = its_flash_fs_mblock_get_file_idx(fs_ctx, fid, &del_file_idx);
     if (err != PSA_SUCCESS) {
@@ -607,3 +739,835 @@ psa_status_t its_flash_fs_file_read(struct its_flash_fs_ctx_t *fs_ctx,
 
     return PSA_SUCCESS;
 }
+
+/**
+ * \brief Gets the entry staged by the open transaction for a file metadata
+ *        entry index.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ * \param[in]     idx     File metadata entry index
+ *
+ * \return Returns a pointer to the staged entry, or NULL if the file metadata
+ *         entry has not been staged.
+ */
+static struct its_flash_fs_txn_file_t *its_flash_fs_txn_get_entry(
+                                              struct its_flash_fs_ctx_t *fs_ctx,
+                                              uint32_t idx)
+{
+    uint32_t i;
+
+    for (i = 0; i < fs_ctx->txn.num_files; i++) {
+        if (fs_ctx->txn.files[i].idx == idx) {
+            return &fs_ctx->txn.files[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * \brief Stages a file metadata entry in the open transaction.
+ *
+ * \param[in,out] fs_ctx     Filesystem context
+ * \param[in]     idx        File metadata entry index
+ * \param[in]     file_meta  File metadata to stage
+ *
+ * \return Returns a pointer to the staged entry, or NULL if there is no free
+ *         entry left in the transaction.
+ */
+static struct its_flash_fs_txn_file_t *its_flash_fs_txn_stage_file_meta(
+                                       struct its_flash_fs_ctx_t *fs_ctx,
+                                       uint32_t idx,
+                                       const struct its_file_meta_t *file_meta)
+{
+    struct its_flash_fs_txn_file_t *entry;
+
+    entry = its_flash_fs_txn_get_entry(fs_ctx, idx);
+    if (entry == NULL) {
+        if (fs_ctx->txn.num_files == ITS_TRANSACTION_MAX_FILES) {
+            return NULL;
+        }
+
+        entry = &fs_ctx->txn.files[fs_ctx->txn.num_files++];
+        entry->idx = idx;
+        entry->data_staged = false;
+        entry->data_end = 0;
+    }
+
+    entry->meta = *file_meta;
+
+    return entry;
+}
+
+/**
+ * \brief Checks if the open transaction is permitted to modify a logical data
+ *        block. Besides logical data block 0, which is stored in the metadata
+ *        block, only one other data block can be modified as there is only one
+ *        scratch data block.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ * \param[in]     lblock  Logical block number
+ *
+ * \return Returns true if the logical block can be modified, false otherwise.
+ */
+static bool its_flash_fs_txn_block_allowed(struct its_flash_fs_ctx_t *fs_ctx,
+                                           uint32_t lblock)
+{
+    return (lblock == ITS_LOGICAL_DBLOCK0) ||
+           (fs_ctx->txn.dblock == ITS_BLOCK_INVALID_ID) ||
+           (fs_ctx->txn.dblock == lblock);
+}
+
+/**
+ * \brief Stages a logical block's metadata in the open transaction.
+ *
+ * \param[in,out] fs_ctx      Filesystem context
+ * \param[in]     lblock      Logical block number. Must be permitted by
+ *                            its_flash_fs_txn_block_allowed().
+ * \param[in]     block_meta  Block metadata to stage
+ */
+static void its_flash_fs_txn_stage_block_meta(
+                                      struct its_flash_fs_ctx_t *fs_ctx,
+                                      uint32_t lblock,
+                                      const struct its_block_meta_t *block_meta)
+{
+    if (lblock == ITS_LOGICAL_DBLOCK0) {
+        fs_ctx->txn.lb0_meta = *block_meta;
+        fs_ctx->txn.lb0_staged = true;
+    } else {
+        fs_ctx->txn.dblock_meta = *block_meta;
+        fs_ctx->txn.dblock = lblock;
+    }
+}
+
+/**
+ * \brief Reads file metadata as seen by the open transaction.
+ *
+ * \param[in,out] fs_ctx     Filesystem context
+ * \param[in]     idx        File metadata entry index
+ * \param[out]    file_meta  Pointer to file meta structure
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_flash_fs_txn_read_file_meta(
+                                             struct its_flash_fs_ctx_t *fs_ctx,
+                                             uint32_t idx,
+                                             struct its_file_meta_t *file_meta)
+{
+    struct its_flash_fs_txn_file_t *entry;
+
+    entry = its_flash_fs_txn_get_entry(fs_ctx, idx);
+    if (entry != NULL) {
+        *file_meta = entry->meta;
+        return PSA_SUCCESS;
+    }
+
+    return its_flash_fs_mblock_read_file_meta(fs_ctx, idx, file_meta);
+}
+
+/**
+ * \brief Reads logical block metadata as seen by the open transaction.
+ *
+ * \param[in,out] fs_ctx      Filesystem context
+ * \param[in]     lblock      Logical block number
+ * \param[out]    block_meta  Pointer to block meta structure
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_flash_fs_txn_read_block_meta(
+                                           struct its_flash_fs_ctx_t *fs_ctx,
+                                           uint32_t lblock,
+                                           struct its_block_meta_t *block_meta)
+{
+    if ((lblock == ITS_LOGICAL_DBLOCK0) && fs_ctx->txn.lb0_staged) {
+        *block_meta = fs_ctx->txn.lb0_meta;
+        return PSA_SUCCESS;
+    } else if (lblock == fs_ctx->txn.dblock) {
+        *block_meta = fs_ctx->txn.dblock_meta;
+        return PSA_SUCCESS;
+    }
+
+    return its_flash_fs_mblock_read_block_metadata(fs_ctx, lblock, block_meta);
+}
+
+/**
+ * \brief Gets the file metadata entry index of a file, as seen by the open
+ *        transaction. Files marked for deletion are skipped.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ * \param[in]     fid     ID of the file
+ * \param[out]    idx     Index of the file metadata in the file system
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_flash_fs_txn_get_file_idx(
+                                              struct its_flash_fs_ctx_t *fs_ctx,
+                                              const uint8_t *fid,
+                                              uint32_t *idx)
+{
+    psa_status_t err;
+    uint32_t i;
+    struct its_file_meta_t tmp_metadata;
+
+    for (i = 0; i < fs_ctx->cfg->max_num_files; i++) {
+        err = its_flash_fs_txn_read_file_meta(fs_ctx, i, &tmp_metadata);
+        if (err != PSA_SUCCESS) {
+            return PSA_ERROR_GENERIC_ERROR;
+        }
+
+        if (!(tmp_metadata.flags & ITS_FLASH_FS_FLAG_DELETE) &&
+            !tfm_memcmp(tmp_metadata.id, fid, ITS_FILE_ID_SIZE)) {
+            /* Found */
+            *idx = i;
+            return PSA_SUCCESS;
+        }
+    }
+
+    return PSA_ERROR_DOES_NOT_EXIST;
+}
+
+/**
+ * \brief Finds space for a new file, as seen by the open transaction. Nothing
+ *        is staged by this function.
+ *
+ * \param[in,out] fs_ctx      Filesystem context
+ * \param[in]     fid         File ID
+ * \param[in]     use_spare   If true then the spare file will be used,
+ *                            otherwise at least one file will be left free
+ * \param[in]     size        Size of the file for which space is reserved
+ * \param[in]     flags       Flags set when the file is created
+ * \param[out]    idx         File metadata entry index
+ * \param[out]    file_meta   File metadata entry
+ * \param[out]    block_meta  Updated metadata of the block that contains the
+ *                            file
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_flash_fs_txn_reserve_file(
+                                           struct its_flash_fs_ctx_t *fs_ctx,
+                                           const uint8_t *fid,
+                                           bool use_spare,
+                                           size_t size,
+                                           uint32_t flags,
+                                           uint32_t *idx,
+                                           struct its_file_meta_t *file_meta,
+                                           struct its_block_meta_t *block_meta)
+{
+    psa_status_t err;
+    uint32_t i;
+    struct its_file_meta_t tmp_metadata;
+
+    /* Get a free file metadata entry */
+    *idx = ITS_METADATA_INVALID_INDEX;
+    for (i = 0; i < fs_ctx->cfg->max_num_files; i++) {
+        err = its_flash_fs_txn_read_file_meta(fs_ctx, i, &tmp_metadata);
+        if (err != PSA_SUCCESS) {
+            return PSA_ERROR_GENERIC_ERROR;
+        }
+
+        if (its_utils_validate_fid(tmp_metadata.id) != PSA_SUCCESS) {
+            if (!use_spare) {
+                /* Keep the first free file index as a spare */
+                use_spare = true;
+                continue;
+            }
+            *idx = i;
+            break;
+        }
+    }
+
+    if (*idx == ITS_METADATA_INVALID_INDEX) {
+        return PSA_ERROR_INSUFFICIENT_STORAGE;
+    }
+
+    /* Find a logical block with enough space that the transaction can use */
+    for (i = 0; i < its_flash_fs_num_active_dblocks(fs_ctx->cfg); i++) {
+        if (!its_flash_fs_txn_block_allowed(fs_ctx, i)) {
+            continue;
+        }
+
+        err = its_flash_fs_txn_read_block_meta(fs_ctx, i, block_meta);
+        if (err != PSA_SUCCESS) {
+            return PSA_ERROR_GENERIC_ERROR;
+        }
+
+        if (block_meta->free_size >= size) {
+            /* Set file metadata */
+            file_meta->lblock = i;
+            file_meta->data_idx = fs_ctx->cfg->block_size
+                                  - block_meta->free_size;
+            file_meta->max_size = size;
+            tfm_memcpy(file_meta->id, fid, ITS_FILE_ID_SIZE);
+            file_meta->cur_size = 0;
+            file_meta->flags = flags;
+
+            /* Update block metadata */
+            block_meta->free_size -= size;
+            return PSA_SUCCESS;
+        }
+    }
+
+    /* No block has large enough space to fit the requested file */
+    return PSA_ERROR_INSUFFICIENT_STORAGE;
+}
+
+/**
+ * \brief Writes file data staged by the open transaction into the scratch
+ *        block of the file's logical block.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ * \param[in,out] entry   Staged file entry
+ * \param[in]     offset  Offset in the file to write
+ * \param[in]     size    Size of the data, aligned to the program unit
+ * \param[in]     data    Pointer to buffer containing data to be written
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_flash_fs_txn_write_data(
+                                       struct its_flash_fs_ctx_t *fs_ctx,
+                                       struct its_flash_fs_txn_file_t *entry,
+                                       size_t offset,
+                                       size_t size,
+                                       const uint8_t *data)
+{
+    struct its_block_meta_t block_meta;
+    psa_status_t err;
+    uint32_t scratch_id;
+
+    scratch_id = its_flash_fs_mblock_cur_data_scratch_id(fs_ctx,
+                                                         entry->meta.lblock);
+    if (entry->meta.lblock != ITS_LOGICAL_DBLOCK0) {
+        fs_ctx->txn.dblock_written = true;
+    }
+
+    if (!entry->data_staged) {
+        if (offset > 0) {
+            /* Carry over the committed file data preceding the write */
+            err = its_flash_fs_mblock_read_block_metadata(fs_ctx,
+                                                          entry->meta.lblock,
+                                                          &block_meta);
+            if (err != PSA_SUCCESS) {
+                return err;
+            }
+
+            err = its_flash_fs_block_to_block_move(fs_ctx, scratch_id,
+                                                   entry->meta.data_idx,
+                                                   block_meta.phy_id,
+                                                   entry->meta.data_idx,
+                                                   offset);
+            if (err != PSA_SUCCESS) {
+                return err;
+            }
+        }
+
+        entry->data_staged = true;
+    }
+
+    err = fs_ctx->ops->write(fs_ctx->cfg, scratch_id, data,
+                             entry->meta.data_idx + offset, size);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    entry->data_end = offset + size;
+
+    return PSA_SUCCESS;
+}
+
+static psa_status_t its_flash_fs_txn_file_write(
+                                              struct its_flash_fs_ctx_t *fs_ctx,
+                                              const uint8_t *fid,
+                                              uint32_t flags,
+                                              size_t max_size,
+                                              size_t data_size,
+                                              size_t offset,
+                                              const uint8_t *data)
+{
+    struct its_flash_fs_txn_file_t *entry = NULL;
+    struct its_file_meta_t old_meta = {0};
+    struct its_file_meta_t file_meta = {0};
+    struct its_block_meta_t block_meta;
+    uint32_t old_idx = ITS_METADATA_INVALID_INDEX;
+    uint32_t new_idx = ITS_METADATA_INVALID_INDEX;
+    uint32_t num_new_entries = 0;
+    size_t write_size = data_size;
+    bool reserve = false;
+    psa_status_t err;
+
+    if (fs_ctx->txn.failed) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    /* Check if the file already exists, taking staged changes into account */
+    err = its_flash_fs_txn_get_file_idx(fs_ctx, fid, &old_idx);
+    if (err == PSA_SUCCESS) {
+        err = its_flash_fs_txn_read_file_meta(fs_ctx, old_idx, &old_meta);
+        if (err != PSA_SUCCESS) {
+            return PSA_ERROR_DOES_NOT_EXIST;
+        }
+
+        entry = its_flash_fs_txn_get_entry(fs_ctx, old_idx);
+        if (entry == NULL) {
+            num_new_entries++;
+        }
+
+        if (!(flags & ITS_FLASH_FS_FLAG_TRUNCATE)) {
+            /* Write to existing file */
+            file_meta = old_meta;
+            new_idx = old_idx;
+        } else if ((old_meta.max_size == max_size) &&
+                   ((entry == NULL) || !entry->data_staged)) {
+            /* Truncate and reuse the existing file, which is already the
+             * correct size.
+             */
+            file_meta = old_meta;
+            file_meta.cur_size = 0;
+            file_meta.flags = flags;
+            new_idx = old_idx;
+        } else {
+            /* Mark the existing file to be deleted after the transaction is
+             * committed and reserve a new one. This is also done when the
+             * file data has already been written by this transaction, as it
+             * cannot be programmed again in the scratch block.
+             */
+            old_meta.flags |= ITS_FLASH_FS_FLAG_DELETE;
+            reserve = true;
+        }
+    } else if (err == PSA_ERROR_DOES_NOT_EXIST) {
+        /* The create flag must be supplied to create a new file */
+        if (!(flags & ITS_FLASH_FS_FLAG_CREATE)) {
+            return PSA_ERROR_DOES_NOT_EXIST;
+        }
+        reserve = true;
+    } else {
+        return err;
+    }
+
+    if (reserve) {
+        /* Check that the file's maximum size is valid */
+        if (max_size > fs_ctx->cfg->max_file_size) {
+            return PSA_ERROR_INVALID_ARGUMENT;
+        }
+
+        err = its_flash_fs_txn_reserve_file(fs_ctx, fid,
+                                            old_idx != ITS_METADATA_INVALID_INDEX,
+                                            max_size, flags, &new_idx,
+                                            &file_meta, &block_meta);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        entry = NULL;
+        num_new_entries++;
+    } else if (data_size != 0) {
+        if (!its_flash_fs_txn_block_allowed(fs_ctx, file_meta.lblock)) {
+            /* The only scratch data block is in use by the transaction */
+            return PSA_ERROR_INSUFFICIENT_STORAGE;
+        }
+
+        if (file_meta.lblock != ITS_LOGICAL_DBLOCK0) {
+            err = its_flash_fs_txn_read_block_meta(fs_ctx, file_meta.lblock,
+                                                   &block_meta);
+            if (err != PSA_SUCCESS) {
+                return PSA_ERROR_GENERIC_ERROR;
+            }
+        }
+    }
+
+    if (data_size != 0) {
+#if (ITS_FLASH_MAX_ALIGNMENT != 1)
+        /* Check that the offset is aligned with the flash program unit */
+        if (!ITS_UTILS_IS_ALIGNED(offset, fs_ctx->cfg->program_unit)) {
+            return PSA_ERROR_INVALID_ARGUMENT;
+        }
+
+        /* Set the size to be aligned with the flash program unit */
+        write_size = ITS_UTILS_ALIGN(data_size, fs_ctx->cfg->program_unit);
+#endif
+
+        /* It is not permitted to create gaps in the file */
+        if (offset > file_meta.cur_size) {
+            return PSA_ERROR_INVALID_ARGUMENT;
+        }
+
+        /* Check that the new data is contained within the file's max size */
+        if (its_utils_check_contained_in(file_meta.max_size, offset,
+                                         write_size) != PSA_SUCCESS) {
+            return PSA_ERROR_INVALID_ARGUMENT;
+        }
+
+        /* Data written by this transaction can only be appended to */
+        if ((entry != NULL) && entry->data_staged &&
+            (offset != entry->data_end)) {
+            return PSA_ERROR_INVALID_ARGUMENT;
+        }
+    }
+
+    if (fs_ctx->txn.num_files + num_new_entries > ITS_TRANSACTION_MAX_FILES) {
+        return PSA_ERROR_INSUFFICIENT_MEMORY;
+    }
+
+    /* All checks have passed, so stage the changes */
+    if (reserve && (old_idx != ITS_METADATA_INVALID_INDEX)) {
+        (void)its_flash_fs_txn_stage_file_meta(fs_ctx, old_idx, &old_meta);
+    }
+
+    if (reserve ||
+        ((data_size != 0) && (file_meta.lblock != ITS_LOGICAL_DBLOCK0))) {
+        its_flash_fs_txn_stage_block_meta(fs_ctx, file_meta.lblock,
+                                          &block_meta);
+    }
+
+    entry = its_flash_fs_txn_stage_file_meta(fs_ctx, new_idx, &file_meta);
+
+    if (data_size != 0) {
+        err = its_flash_fs_txn_write_data(fs_ctx, entry, offset, write_size,
+                                          data);
+        if (err != PSA_SUCCESS) {
+            /* The scratch blocks are in an unknown state. The transaction is
+             * kept open, so that the changes staged before are not committed
+             * piecemeal, and can only be aborted.
+             */
+            fs_ctx->txn.failed = true;
+            return PSA_ERROR_GENERIC_ERROR;
+        }
+
+        /* Update the file's current size if required */
+        if (offset + data_size > entry->meta.cur_size) {
+            entry->meta.cur_size = offset + data_size;
+        }
+    }
+
+    return PSA_SUCCESS;
+}
+
+static psa_status_t its_flash_fs_txn_file_delete(
+                                              struct its_flash_fs_ctx_t *fs_ctx,
+                                              const uint8_t *fid)
+{
+    psa_status_t err;
+    uint32_t idx;
+    struct its_file_meta_t file_meta;
+
+    if (fs_ctx->txn.failed) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    err = its_flash_fs_txn_get_file_idx(fs_ctx, fid, &idx);
+    if (err != PSA_SUCCESS) {
+        return PSA_ERROR_DOES_NOT_EXIST;
+    }
+
+    err = its_flash_fs_txn_read_file_meta(fs_ctx, idx, &file_meta);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    /* Mark the file to be deleted after the transaction is committed. It is
+     * invisible to the transaction from now on.
+     */
+    file_meta.flags |= ITS_FLASH_FS_FLAG_DELETE;
+    if (its_flash_fs_txn_stage_file_meta(fs_ctx, idx, &file_meta) == NULL) {
+        return PSA_ERROR_INSUFFICIENT_MEMORY;
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Copies the committed data of a logical block to its scratch block,
+ *        skipping the file data areas already written by the open
+ *        transaction.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ * \param[in]     lblock  Logical block number
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_flash_fs_txn_copy_block(
+                                              struct its_flash_fs_ctx_t *fs_ctx,
+                                              uint32_t lblock)
+{
+    struct its_block_meta_t block_meta;
+    const struct its_flash_fs_txn_file_t *entry;
+    psa_status_t err;
+    uint32_t i;
+    uint32_t scratch_id;
+    size_t pos;
+    size_t end;
+    size_t next_start;
+    size_t next_end;
+
+    err = its_flash_fs_mblock_read_block_metadata(fs_ctx, lblock, &block_meta);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    scratch_id = its_flash_fs_mblock_cur_data_scratch_id(fs_ctx, lblock);
+    pos = block_meta.data_start;
+    end = fs_ctx->cfg->block_size - block_meta.free_size;
+
+    while (pos < end) {
+        /* Find the next file data area that has been written by the
+         * transaction. The rest of the file data is carried over from the
+         * committed block.
+         */
+        next_start = end;
+        next_end = end;
+        for (i = 0; i < fs_ctx->txn.num_files; i++) {
+            entry = &fs_ctx->txn.files[i];
+            if (entry->data_staged && (entry->meta.lblock == lblock) &&
+                (entry->meta.data_idx >= pos) &&
+                (entry->meta.data_idx < next_start)) {
+                next_start = entry->meta.data_idx;
+                next_end = entry->meta.data_idx + entry->data_end;
+            }
+        }
+
+        /* Copy the committed data up to that area */
+        err = its_flash_fs_block_to_block_move(fs_ctx, scratch_id, pos,
+                                               block_meta.phy_id, pos,
+                                               next_start - pos);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        pos = next_end;
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Gets the change of free space made by the changes staged by the open
+ *        transaction, from the staged metadata and the active metadata.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ * \param[out]    change  Change of free space made by the transaction
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_flash_fs_txn_space_change(
+                                     struct its_flash_fs_ctx_t *fs_ctx,
+                                     struct its_flash_fs_space_change_t *change)
+{
+    struct its_flash_fs_txn_t *txn = &fs_ctx->txn;
+    struct its_block_meta_t block_meta;
+    struct its_file_meta_t file_meta;
+    psa_status_t err;
+    uint32_t i;
+    bool was_free;
+    bool is_free;
+
+    for (i = 0; i < txn->num_files; i++) {
+        err = its_flash_fs_mblock_read_file_meta(fs_ctx, txn->files[i].idx,
+                                                 &file_meta);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        was_free = (its_utils_validate_fid(file_meta.id) != PSA_SUCCESS);
+        is_free = (its_utils_validate_fid(txn->files[i].meta.id) !=
+                   PSA_SUCCESS);
+        change->num_free_files += (int32_t)is_free - (int32_t)was_free;
+    }
+
+    if (txn->lb0_staged) {
+        err = its_flash_fs_mblock_read_block_metadata(fs_ctx,
+                                                      ITS_LOGICAL_DBLOCK0,
+                                                      &block_meta);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        its_flash_fs_mblock_space_change_block(fs_ctx, block_meta.free_size,
+                                               txn->lb0_meta.free_size,
+                                               change);
+    }
+
+    if (txn->dblock != ITS_BLOCK_INVALID_ID) {
+        err = its_flash_fs_mblock_read_block_metadata(fs_ctx, txn->dblock,
+                                                      &block_meta);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        its_flash_fs_mblock_space_change_block(fs_ctx, block_meta.free_size,
+                                               txn->dblock_meta.free_size,
+                                               change);
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Writes all the changes staged by the open transaction to the scratch
+ *        blocks, ready for the metadata block update to be finalized.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_flash_fs_txn_stage_to_scratch(
+                                              struct its_flash_fs_ctx_t *fs_ctx)
+{
+    struct its_flash_fs_txn_t *txn = &fs_ctx->txn;
+    struct its_block_meta_t block_meta;
+    struct its_flash_fs_txn_file_t *entry;
+    psa_status_t err;
+    uint32_t idx;
+    uint32_t start_idx = 0;
+    uint32_t scratch_id;
+
+    /* The file data in logical block 0 is stored in the metadata block, so it
+     * always needs to be carried over to the scratch metadata block.
+     */
+    err = its_flash_fs_txn_copy_block(fs_ctx, ITS_LOGICAL_DBLOCK0);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    if (txn->dblock_written) {
+        err = its_flash_fs_txn_copy_block(fs_ctx, txn->dblock);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        /* Commit data block modifications to flash */
+        scratch_id = its_flash_fs_mblock_cur_data_scratch_id(fs_ctx,
+                                                             txn->dblock);
+        err = fs_ctx->ops->flush(fs_ctx->cfg, scratch_id);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        /* Swap the scratch data block */
+        its_flash_fs_mblock_set_data_scratch(fs_ctx, txn->dblock_meta.phy_id,
+                                             txn->dblock);
+        txn->dblock_meta.phy_id = scratch_id;
+    }
+
+    /* Write all the block metadata in the scratch metadata block */
+    for (idx = 0; idx < its_flash_fs_num_active_dblocks(fs_ctx->cfg); idx++) {
+        err = its_flash_fs_txn_read_block_meta(fs_ctx, idx, &block_meta);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        if (idx == ITS_LOGICAL_DBLOCK0) {
+            block_meta.phy_id = fs_ctx->scratch_metablock;
+        }
+
+        err = its_flash_fs_mblock_write_scratch_block_meta(fs_ctx, idx,
+                                                           &block_meta);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+    }
+
+    /* Write the staged file metadata entries and copy the others */
+    for (idx = 0; idx < fs_ctx->cfg->max_num_files; idx++) {
+        entry = its_flash_fs_txn_get_entry(fs_ctx, idx);
+        if (entry == NULL) {
+            continue;
+        }
+
+        err = its_flash_fs_mblock_cp_file_meta(fs_ctx, start_idx, idx);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        err = its_flash_fs_mblock_update_scratch_file_meta(fs_ctx, idx,
+                                                           &entry->meta);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        start_idx = idx + 1;
+    }
+
+    return its_flash_fs_mblock_cp_file_meta(fs_ctx, start_idx,
+                                            fs_ctx->cfg->max_num_files);
+}
+
+psa_status_t its_flash_fs_txn_begin(struct its_flash_fs_ctx_t *fs_ctx)
+{
+    if (fs_ctx->txn.active) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    tfm_memset(&fs_ctx->txn, 0, sizeof(fs_ctx->txn));
+    fs_ctx->txn.dblock = ITS_BLOCK_INVALID_ID;
+    fs_ctx->txn.scratch_dblock = fs_ctx->meta_block_header.scratch_dblock;
+    fs_ctx->txn.active = true;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t its_flash_fs_txn_commit(struct its_flash_fs_ctx_t *fs_ctx)
+{
+    struct its_flash_fs_space_change_t change = {0};
+    uint32_t active_metablock;
+    psa_status_t err;
+
+    if (!fs_ctx->txn.active) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    if (fs_ctx->txn.failed) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    err = its_flash_fs_txn_space_change(fs_ctx, &change);
+    if (err == PSA_SUCCESS) {
+        err = its_flash_fs_txn_stage_to_scratch(fs_ctx);
+    }
+    if (err != PSA_SUCCESS) {
+        /* Nothing has been committed, and the transaction must be aborted */
+        fs_ctx->txn.failed = true;
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    /* Write metadata header, swap metadata blocks and erase scratch blocks */
+    active_metablock = fs_ctx->active_metablock;
+    err = its_flash_fs_mblock_meta_update_finalize(fs_ctx, &change);
+    if ((err != PSA_SUCCESS) && (fs_ctx->active_metablock == active_metablock)) {
+        /* The metadata block has not been committed */
+        fs_ctx->txn.failed = true;
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    fs_ctx->txn.active = false;
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    /* Delete the files removed or replaced by the transaction in further block
+     * updates. A power failure before the deletion has completed is handled
+     * at initialisation time.
+     */
+    return its_flash_fs_delete_marked(fs_ctx);
+}
+
+psa_status_t its_flash_fs_txn_abort(struct its_flash_fs_ctx_t *fs_ctx)
+{
+    if (!fs_ctx->txn.active) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    fs_ctx->txn.active = false;
+    fs_ctx->txn.failed = false;
+
+    /* Restore the scratch data block, in case it was swapped by the commit */
+    fs_ctx->meta_block_header.scratch_dblock = fs_ctx->txn.scratch_dblock;
+
+    /* Release any writes buffered for the scratch blocks before erasing them.
+     * Flushing a block that has no buffered writes is not an error here.
+     */
+    (void)fs_ctx->ops->flush(fs_ctx->cfg, fs_ctx->scratch_metablock);
+    if (fs_ctx->cfg->num_blocks > 2) {
+        (void)fs_ctx->ops->flush(fs_ctx->cfg, fs_ctx->txn.scratch_dblock);
+    }
+
+    return its_flash_fs_mblock_erase_scratch_blocks(fs_ctx);
+}
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2018-2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2018-2022, Arm Limited. All rights reserved.
  * Copyright (c) 2020, Cypress Semiconductor Corporation. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
@@ -17,6 +17,7 @@
 #ifndef __ITS_FLASH_FS_H__
 #define __ITS_FLASH_FS_H__
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -61,8 +62,29 @@ struct its_flash_fs_config_t {
     uint16_t max_file_size;   /**< Maximum file size */
     uint16_t max_num_files;   /**< Maximum number of files */
     uint8_t erase_val;        /**< Value of a byte after erase (usually 0xFF) */
+#ifdef ITS_VALIDATE_METADATA_FROM_FLASH
+    uint8_t *metadata_shadow; /**< Buffer to hold a validated copy of the
+                               *   active metadata in RAM, or NULL. See
+                               *   \ref ITS_FLASH_FS_METADATA_SIZE.
+                               */
+    size_t metadata_shadow_size; /**< Size of the metadata shadow buffer */
+#endif
 };
 
+/**
+ * \brief Gets the size of the metadata of a filesystem, not including the
+ *        metadata block header. A metadata shadow buffer of at least this size
+ *        allows the metadata to be validated once when it is loaded, rather
+ *        than each time it is read.
+ *
+ * \param[in] num_blocks  Number of logical erase blocks
+ * \param[in] num_files   Maximum number of files
+ */
+#define ITS_FLASH_FS_METADATA_SIZE(num_blocks, num_files) \
+    (((((num_blocks) > 2) ? ((num_blocks) - 2) : 1) \
+      * sizeof(struct its_block_meta_t)) \
+     + ((num_files) * sizeof(struct its_file_meta_t)))
+
 /**
  * \struct its_flash_fs_ops_t
  *
@@ -153,6 +175,18 @@ struct its_flash_fs_ops_t {
      */
     psa_status_t (*erase)(const struct its_flash_fs_config_t *cfg,
                           uint32_t block_id);
+
+    /**
+     * \brief True if write() can program any byte which holds the erase value
+     *        without the block first being erased, even if the byte has already
+     *        been programmed with the erase value. That permits the filesystem
+     *        to append file data in place, instead of copying the whole block
+     *        to a scratch block, as the space reserved for a file may have
+     *        been programmed when the file was moved. It must not be set for
+     *        flash with ECC, or whose program units can only be programmed
+     *        once after an erase.
+     */
+    bool in_place_write;
 };
 
 /**
@@ -178,6 +212,19 @@ struct its_file_info_t {
     uint32_t flags;      /*!< Flags set when the file was created */
 };
 
+/*!
+ * \struct its_fs_space_t
+ *
+ * \brief Structure to store the free space of the filesystem.
+ */
+struct its_fs_space_t {
+    size_t num_free_files; /*!< Number of files that can be created */
+    size_t free_size;      /*!< Free space of all the data blocks in bytes */
+    size_t max_file_size;  /*!< Maximum size of a file that can be created in
+                            *   bytes
+                            */
+};
+
 /**
  * \brief Initialises the filesystem context. Must be called successfully before
  *        any other filesystem API is called.
@@ -242,6 +289,45 @@ psa_status_t its_flash_fs_file_get_info(its_flash_fs_ctx_t *fs_ctx,
                                         const uint8_t *fid,
                                         struct its_file_info_t *info);
 
+/**
+ * \brief Gets the ID and information of the next file in the filesystem.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ * \param[in,out] idx     File metadata entry index from which to search. On
+ *                        success, it is set to the index after the file found,
+ *                        from which to search for the following file.
+ * \param[out]    fid     File ID
+ * \param[out]    info    Pointer to the information structure to store the
+ *                        file information values \ref its_file_info_t
+ *
+ * \note The files are returned in the order of their metadata entries, which
+ *       changes when files are created or deleted.
+ *
+ * \return Returns PSA_SUCCESS if a file is found, PSA_ERROR_DOES_NOT_EXIST if
+ *         there are no more files. Otherwise, it returns error code as
+ *         specified in \ref psa_status_t.
+ */
+psa_status_t its_flash_fs_file_get_next(its_flash_fs_ctx_t *fs_ctx,
+                                        uint32_t *idx,
+                                        uint8_t *fid,
+                                        struct its_file_info_t *info);
+
+/**
+ * \brief Gets the free space of the filesystem. The free space is maintained
+ *        each time the metadata is updated, so no metadata is read.
+ *
+ * \param[in]  fs_ctx  Filesystem context
+ * \param[out] space   Pointer to the structure to store the free space values
+ *                     \ref its_fs_space_t
+ *
+ * \note While a transaction is open, the free space does not include the
+ *       changes staged by the transaction.
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+psa_status_t its_flash_fs_get_space(its_flash_fs_ctx_t *fs_ctx,
+                                    struct its_fs_space_t *space);
+
 /**
  * \brief Writes data to a file.
  *
@@ -255,6 +341,13 @@ psa_status_t its_flash_fs_file_get_info(its_flash_fs_ctx_t *fs_ctx,
  *                           equal to the current file size.
  * \param[in]     data       Pointer to buffer containing data to be written
  *
+ * \note If the file is not truncated, only the data in the range [offset,
+ *       offset + data_size) is modified and the rest of the file data is
+ *       preserved. When the flash operations support in_place_write and the
+ *       range is past the end of the file data and still holds the erase
+ *       value, the data is written in place and only the metadata block is
+ *       updated.
+ *
  * \return Returns error code as specified in \ref psa_status_t
  */
 psa_status_t its_flash_fs_file_write(its_flash_fs_ctx_t *fs_ctx,
@@ -293,6 +386,53 @@ psa_status_t its_flash_fs_file_read(its_flash_fs_ctx_t *fs_ctx,
 psa_status_t its_flash_fs_file_delete(its_flash_fs_ctx_t *fs_ctx,
                                       const uint8_t *fid);
 
+/**
+ * \brief Opens a transaction. Subsequent calls to its_flash_fs_file_write()
+ *        and its_flash_fs_file_delete() are staged in the scratch blocks and
+ *        only become visible, all together, when the transaction is committed.
+ *
+ * \details Reads and file information queries return the committed state of
+ *          the filesystem while the transaction is open. Each file can be
+ *          written sequentially (appending to the data already written in the
+ *          transaction). The transaction can modify at most
+ *          ITS_TRANSACTION_MAX_FILES files, and the data of files located in at
+ *          most one dedicated data block besides logical data block 0.
+ *          If a staged write fails, the transaction stays open but further
+ *          writes, deletions and the commit fail with PSA_ERROR_BAD_STATE
+ *          until it is aborted.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+psa_status_t its_flash_fs_txn_begin(its_flash_fs_ctx_t *fs_ctx);
+
+/**
+ * \brief Commits the open transaction with a single metadata block update.
+ *
+ * \note Files removed or resized by the transaction are compacted in
+ *       additional block updates after the commit. If a power failure happens
+ *       before they complete, they are finished when the filesystem is
+ *       prepared.
+ *
+ * \note If the metadata block cannot be written, nothing is committed and
+ *       the transaction stays open until it is aborted.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+psa_status_t its_flash_fs_txn_commit(its_flash_fs_ctx_t *fs_ctx);
+
+/**
+ * \brief Discards all the changes staged by the open transaction.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+psa_status_t its_flash_fs_txn_abort(its_flash_fs_ctx_t *fs_ctx);
+
 #ifdef __cplusplus
 }
 #endif
@@ -8,6 +8,11 @@
 #include "its_flash_fs_dblock.h"
 
 #include "its_flash_fs.h"
+#include "its_utils.h"
+
+#ifndef ITS_ERASE_CHECK_BUF_SIZE
+#define ITS_ERASE_CHECK_BUF_SIZE 32
+#endif
 
 /**
  * \brief Converts logical data block number to physical number.
@@ -31,6 +36,50 @@ static uint32_t its_dblock_lo_to_phy(struct its_flash_fs_ctx_t *fs_ctx,
     return block_meta.phy_id;
 }
 
+/**
+ * \brief Checks that a range of a block is in the erased state.
+ *
+ * \param[in,out] fs_ctx    Filesystem context
+ * \param[in]     block_id  Physical block ID
+ * \param[in]     offset    Offset of the range in the block
+ * \param[in]     size      Size of the range
+ *
+ * \return Returns PSA_SUCCESS if the range is erased, PSA_ERROR_NOT_PERMITTED
+ *         if it is not, and otherwise an error code as specified in
+ *         \ref psa_status_t
+ */
+static psa_status_t its_dblock_check_erased(struct its_flash_fs_ctx_t *fs_ctx,
+                                            uint32_t block_id,
+                                            size_t offset,
+                                            size_t size)
+{
+    psa_status_t err;
+    size_t bytes_to_check;
+    size_t i;
+    uint8_t buf[ITS_ERASE_CHECK_BUF_SIZE];
+
+    while (size > 0) {
+        bytes_to_check = ITS_UTILS_MIN(size, sizeof(buf));
+
+        err = fs_ctx->ops->read(fs_ctx->cfg, block_id, buf, offset,
+                                bytes_to_check);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        for (i = 0; i < bytes_to_check; i++) {
+            if (buf[i] != fs_ctx->cfg->erase_val) {
+                return PSA_ERROR_NOT_PERMITTED;
+            }
+        }
+
+        offset += bytes_to_check;
+        size -= bytes_to_check;
+    }
+
+    return PSA_SUCCESS;
+}
+
 psa_status_t its_flash_fs_dblock_compact_block(
                                               struct its_flash_fs_ctx_t *fs_ctx,
                                               uint32_t lblock,
@@ -102,9 +151,11 @@ psa_status_t its_flash_fs_dblock_compact_block(
 
     /* Commit data block modifications to flash, unless the data is in logical
      * data block 0, in which case it will be flushed at the end of the metadata
-     * block update.
+     * block update. If no data was moved, then the scratch block was not
+     * written and there is nothing to flush.
      */
-    if (lblock != ITS_LOGICAL_DBLOCK0) {
+    if ((lblock != ITS_LOGICAL_DBLOCK0) &&
+        ((size > 0) || (dst_offset > block_meta.data_start))) {
         err = fs_ctx->ops->flush(fs_ctx->cfg, scratch_id);
     }
 
@@ -166,6 +217,21 @@ psa_status_t its_flash_fs_dblock_write_file(
         return err;
     }
 
+    /* Calculate the position of the end of the file data, aligned to the
+     * program unit.
+     */
+    num_bytes = ITS_UTILS_ALIGN(file_meta->cur_size, fs_ctx->cfg->program_unit);
+
+    /* Move the existing file data after the new file data, if any */
+    if (offset + size < num_bytes) {
+        err = its_flash_fs_block_to_block_move(fs_ctx, scratch_id, pos + size,
+                                               block_meta->phy_id, pos + size,
+                                               num_bytes - (offset + size));
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+    }
+
     /* Calculate the position of the end of the file */
     pos = file_meta->data_idx + file_meta->max_size;
 
@@ -189,3 +255,50 @@ psa_status_t its_flash_fs_dblock_write_file(
 
     return err;
 }
+
+psa_status_t its_flash_fs_dblock_write_file_in_place(
+                                      struct its_flash_fs_ctx_t *fs_ctx,
+                                      const struct its_block_meta_t *block_meta,
+                                      const struct its_file_meta_t *file_meta,
+                                      size_t offset,
+                                      size_t size,
+                                      const uint8_t *data)
+{
+    psa_status_t err;
+    size_t pos;
+
+    /* The data in logical data block 0 is stored in the metadata block, which
+     * is swapped on every update, so there is nothing to gain from writing it
+     * in place.
+     */
+    if (!fs_ctx->ops->in_place_write ||
+        (file_meta->lblock == ITS_LOGICAL_DBLOCK0)) {
+        return PSA_ERROR_NOT_SUPPORTED;
+    }
+
+    /* Only the data after the end of the current file data can still hold the
+     * erase value. It may have been programmed with it when the file was
+     * moved, which in_place_write declares to be safe to program again.
+     */
+    if (offset < ITS_UTILS_ALIGN(file_meta->cur_size,
+                                 fs_ctx->cfg->program_unit)) {
+        return PSA_ERROR_NOT_PERMITTED;
+    }
+
+    pos = file_meta->data_idx + offset;
+
+    /* An interrupted update may have left data outside of the file, so check
+     * that the range is still erased.
+     */
+    err = its_dblock_check_erased(fs_ctx, block_meta->phy_id, pos, size);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    err = fs_ctx->ops->write(fs_ctx->cfg, block_meta->phy_id, data, pos, size);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    return fs_ctx->ops->flush(fs_ctx->cfg, block_meta->phy_id);
+}
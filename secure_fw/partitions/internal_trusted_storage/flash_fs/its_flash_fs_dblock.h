@@ -60,13 +60,14 @@ psa_status_t its_flash_fs_dblock_read_file(
 
 /**
  * \brief Writes scratch data block content with requested data and the rest of
- *        the data from the given logical block.
+ *        the data from the given logical block. The existing file data outside
+ *        of the written range is preserved.
  *
  * \param[in,out] fs_ctx      Filesystem context
  * \param[in]     block_meta  Block metadata
- * \param[in]     file_meta   File metadata
- * \param[in]     offset      Offset in the scratch data block where to start
- *                            the copy of the incoming data
+ * \param[in]     file_meta   File metadata, before the write
+ * \param[in]     offset      Offset in the file where to start the copy of the
+ *                            incoming data
  * \param[in]     size        Size of the incoming data
  * \param[in]     data        Pointer to data buffer to copy in the scratch data
  *                            block
@@ -81,6 +82,33 @@ psa_status_t its_flash_fs_dblock_write_file(
                                       size_t size,
                                       const uint8_t *data);
 
+/**
+ * \brief Writes the requested data directly to the erased part of the active
+ *        data block containing the file, instead of copying the block to the
+ *        scratch data block.
+ *
+ * \param[in,out] fs_ctx      Filesystem context
+ * \param[in]     block_meta  Block metadata
+ * \param[in]     file_meta   File metadata
+ * \param[in]     offset      Offset in the file where to write the incoming
+ *                            data. Must not be less than the current file size
+ *                            aligned to the program unit.
+ * \param[in]     size        Size of the incoming data
+ * \param[in]     data        Pointer to data buffer to write in the data block
+ *
+ * \return Returns PSA_SUCCESS if the data has been written in place. Returns
+ *         PSA_ERROR_NOT_SUPPORTED or PSA_ERROR_NOT_PERMITTED if the data cannot
+ *         be written in place, in which case nothing has been written.
+ *         Otherwise, returns error code as specified in \ref psa_status_t.
+ */
+psa_status_t its_flash_fs_dblock_write_file_in_place(
+                                      struct its_flash_fs_ctx_t *fs_ctx,
+                                      const struct its_block_meta_t *block_meta,
+                                      const struct its_file_meta_t *file_meta,
+                                      size_t offset,
+                                      size_t size,
+                                      const uint8_t *data);
+
 #ifdef __cplusplus
 }
 #endif
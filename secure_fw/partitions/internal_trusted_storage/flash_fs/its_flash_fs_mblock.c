@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2018-2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2018-2022, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -461,6 +461,147 @@ static psa_status_t its_mblock_validate_metadata_xor(
     }
     return PSA_SUCCESS;
 }
+
+/**
+ * \brief Gets the size of the metadata, not including the metadata block
+ *        header.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ *
+ * \return Returns the size of the metadata in bytes.
+ */
+static size_t its_mblock_metadata_size(struct its_flash_fs_ctx_t *fs_ctx)
+{
+    return its_mblock_file_meta_offset(fs_ctx, fs_ctx->cfg->max_num_files)
+           - ITS_BLOCK_META_HEADER_SIZE;
+}
+
+/**
+ * \brief Accumulates the XOR value of the metadata programmed to the scratch
+ *        metadata block, so that it does not need to be read back to calculate
+ *        the XOR value when the metadata block header is written.
+ *
+ * \param[in,out] fs_ctx    Filesystem context
+ * \param[in]     block_id  Physical block ID written
+ * \param[in]     data      Data written
+ * \param[in]     offset    Offset of the data in the block
+ * \param[in]     size      Size of the data
+ */
+static void its_mblock_scratch_xor_update(struct its_flash_fs_ctx_t *fs_ctx,
+                                          uint32_t block_id,
+                                          const uint8_t *data,
+                                          size_t offset,
+                                          size_t size)
+{
+    size_t start = ITS_BLOCK_META_HEADER_SIZE;
+    size_t end = start + its_mblock_metadata_size(fs_ctx);
+    size_t i;
+
+    if (block_id != fs_ctx->scratch_metablock) {
+        return;
+    }
+
+    /* Only the metadata is included, not the header or the file data in
+     * logical data block 0.
+     */
+    for (i = ITS_UTILS_MAX(offset, start);
+         i < ITS_UTILS_MIN(offset + size, end); i++) {
+        fs_ctx->scratch_xor ^= data[i - offset];
+        fs_ctx->scratch_xor_size++;
+    }
+}
+
+/**
+ * \brief Loads the metadata of the active metadata block into the metadata
+ *        shadow and validates it. The metadata is then read from the shadow
+ *        without further validation until the metadata blocks are swapped.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_mblock_load_shadow(struct its_flash_fs_ctx_t *fs_ctx)
+{
+    struct its_block_meta_t block_meta;
+    struct its_file_meta_t file_meta;
+    psa_status_t err;
+    size_t size = its_mblock_metadata_size(fs_ctx);
+    uint8_t *shadow = fs_ctx->cfg->metadata_shadow;
+    uint8_t xor_value = 0;
+    size_t i;
+
+    fs_ctx->shadow_valid = false;
+
+    /* Metadata is read from flash and validated on each read if the shadow
+     * buffer is not large enough.
+     */
+    if ((shadow == NULL) || (fs_ctx->cfg->metadata_shadow_size < size)) {
+        return PSA_SUCCESS;
+    }
+
+    err = fs_ctx->ops->read(fs_ctx->cfg, fs_ctx->active_metablock, shadow,
+                            ITS_BLOCK_META_HEADER_SIZE, size);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    for (i = 0; i < size; i++) {
+        xor_value ^= shadow[i];
+    }
+
+    if (xor_value != fs_ctx->meta_block_header.metadata_xor) {
+        return PSA_ERROR_STORAGE_FAILURE;
+    }
+
+    for (i = 0; i < its_num_active_dblocks(fs_ctx); i++) {
+        (void)tfm_memcpy(&block_meta, shadow + (i * ITS_BLOCK_METADATA_SIZE),
+                         ITS_BLOCK_METADATA_SIZE);
+        err = its_mblock_validate_block_meta(fs_ctx, &block_meta);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+    }
+
+    shadow += its_num_active_dblocks(fs_ctx) * ITS_BLOCK_METADATA_SIZE;
+    for (i = 0; i < fs_ctx->cfg->max_num_files; i++) {
+        (void)tfm_memcpy(&file_meta, shadow + (i * ITS_FILE_METADATA_SIZE),
+                         ITS_FILE_METADATA_SIZE);
+        err = its_mblock_validate_file_meta(fs_ctx, &file_meta);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+    }
+
+    fs_ctx->shadow_valid = true;
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Reads metadata of the active metadata block from the metadata shadow,
+ *        if it is valid.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ * \param[out]    buf     Buffer to read the metadata into
+ * \param[in]     offset  Offset of the metadata in the metadata block
+ * \param[in]     size    Size of the metadata
+ *
+ * \return Returns true if the metadata was read from the shadow.
+ */
+static bool its_mblock_read_shadow(struct its_flash_fs_ctx_t *fs_ctx,
+                                   uint8_t *buf, size_t offset, size_t size)
+{
+    if (!fs_ctx->shadow_valid || (offset < ITS_BLOCK_META_HEADER_SIZE) ||
+        (offset + size >
+         ITS_BLOCK_META_HEADER_SIZE + its_mblock_metadata_size(fs_ctx))) {
+        return false;
+    }
+
+    (void)tfm_memcpy(buf, fs_ctx->cfg->metadata_shadow
+                          + (offset - ITS_BLOCK_META_HEADER_SIZE), size);
+
+    return true;
+}
 #endif /* ITS_VALIDATE_METADATA_FROM_FLASH */
 
 /**
@@ -505,13 +646,129 @@ static uint32_t its_get_free_file_index(struct its_flash_fs_ctx_t *fs_ctx,
 }
 
 /**
- * \brief Erases data and meta scratch blocks.
+ * \brief Counts the free space of the data blocks from the block metadata of
+ *        the active metadata block.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_mblock_count_block_space(
+                                              struct its_flash_fs_ctx_t *fs_ctx)
+{
+    psa_status_t err;
+    uint32_t i;
+    struct its_block_meta_t block_meta;
+
+    fs_ctx->free_size = 0;
+    fs_ctx->max_free_size = 0;
+
+    for (i = 0; i < its_num_active_dblocks(fs_ctx); i++) {
+        err = its_flash_fs_mblock_read_block_metadata(fs_ctx, i, &block_meta);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        fs_ctx->free_size += block_meta.free_size;
+        if (block_meta.free_size > fs_ctx->max_free_size) {
+            fs_ctx->max_free_size = block_meta.free_size;
+        }
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Counts the free space counters of the filesystem context from the
+ *        whole active metadata block. Only called when the metadata is loaded
+ *        or reset, as each update then applies its own change to the
+ *        counters, so that the free space can be checked without reading the
+ *        metadata.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_mblock_update_free_space(
+                                              struct its_flash_fs_ctx_t *fs_ctx)
+{
+    psa_status_t err;
+    uint32_t i;
+    struct its_file_meta_t file_meta;
+
+    err = its_mblock_count_block_space(fs_ctx);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    fs_ctx->num_free_files = 0;
+
+    for (i = 0; i < fs_ctx->cfg->max_num_files; i++) {
+        err = its_flash_fs_mblock_read_file_meta(fs_ctx, i, &file_meta);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        if (its_utils_validate_fid(file_meta.id) != PSA_SUCCESS) {
+            fs_ctx->num_free_files++;
+        }
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Applies the change of free space made by a metadata block update to
+ *        the free space counters of the filesystem context. Called once the
+ *        metadata blocks are swapped.
  *
  * \param[in,out] fs_ctx  Filesystem context
+ * \param[in]     change  Change of free space made by the update
  *
  * \return Returns error code as specified in \ref psa_status_t
  */
-static psa_status_t its_mblock_erase_scratch_blocks(
+static psa_status_t its_mblock_apply_space_change(
+                               struct its_flash_fs_ctx_t *fs_ctx,
+                               const struct its_flash_fs_space_change_t *change)
+{
+    fs_ctx->num_free_files = (uint32_t)((int32_t)fs_ctx->num_free_files +
+                                        change->num_free_files);
+
+    /* Another data block may now have the largest free space, so only the
+     * block metadata is read again.
+     */
+    if (change->max_free_size_reduced) {
+        return its_mblock_count_block_space(fs_ctx);
+    }
+
+    fs_ctx->free_size = (size_t)((int32_t)fs_ctx->free_size +
+                                 change->free_size);
+    if (change->max_free_size > fs_ctx->max_free_size) {
+        fs_ctx->max_free_size = change->max_free_size;
+    }
+
+    return PSA_SUCCESS;
+}
+
+void its_flash_fs_mblock_space_change_block(
+                                     const struct its_flash_fs_ctx_t *fs_ctx,
+                                     size_t old_free_size,
+                                     size_t new_free_size,
+                                     struct its_flash_fs_space_change_t *change)
+{
+    change->free_size += (int32_t)new_free_size - (int32_t)old_free_size;
+
+    if (new_free_size > change->max_free_size) {
+        change->max_free_size = new_free_size;
+    }
+
+    if ((new_free_size < old_free_size) &&
+        (old_free_size == fs_ctx->max_free_size)) {
+        change->max_free_size_reduced = true;
+    }
+}
+
+psa_status_t its_flash_fs_mblock_erase_scratch_blocks(
                                               struct its_flash_fs_ctx_t *fs_ctx)
 {
     psa_status_t err;
@@ -526,6 +783,11 @@ static psa_status_t its_mblock_erase_scratch_blocks(
         return err;
     }
 
+#ifdef ITS_VALIDATE_METADATA_FROM_FLASH
+    fs_ctx->scratch_xor = 0;
+    fs_ctx->scratch_xor_size = 0;
+#endif
+
     /* If the number of blocks is bigger than 2, the code needs to erase the
      * scratch block used to process any change in the data block which contains
      * only data. Otherwise, if the number of blocks is equal to 2, it means
@@ -556,13 +818,24 @@ static psa_status_t its_mblock_update_scratch_block_meta(
                                       uint32_t lblock,
                                       const struct its_block_meta_t *block_meta)
 {
+    psa_status_t err;
     size_t pos;
 
     /* Calculate the position */
     pos = its_mblock_block_meta_offset(lblock);
-    return fs_ctx->ops->write(fs_ctx->cfg, fs_ctx->scratch_metablock,
-                              (const uint8_t *)block_meta, pos,
-                              ITS_BLOCK_METADATA_SIZE);
+    err = fs_ctx->ops->write(fs_ctx->cfg, fs_ctx->scratch_metablock,
+                             (const uint8_t *)block_meta, pos,
+                             ITS_BLOCK_METADATA_SIZE);
+
+#ifdef ITS_VALIDATE_METADATA_FROM_FLASH
+    if (err == PSA_SUCCESS) {
+        its_mblock_scratch_xor_update(fs_ctx, fs_ctx->scratch_metablock,
+                                      (const uint8_t *)block_meta, pos,
+                                      ITS_BLOCK_METADATA_SIZE);
+    }
+#endif
+
+    return err;
 }
 
 /**
@@ -758,12 +1031,19 @@ static psa_status_t its_mblock_write_scratch_meta_header(
         fs_ctx->meta_block_header.active_swap_count++;
     }
 #ifdef ITS_VALIDATE_METADATA_FROM_FLASH
-    /* Calculate metadata XOR value. */
-    err = its_mblock_calculate_metadata_xor(fs_ctx,
+    if (fs_ctx->scratch_xor_size == its_mblock_metadata_size(fs_ctx)) {
+        /* All the metadata was programmed since the scratch metadata block was
+         * erased, so the accumulated XOR value is complete.
+         */
+        fs_ctx->meta_block_header.metadata_xor = fs_ctx->scratch_xor;
+    } else {
+        /* Calculate metadata XOR value. */
+        err = its_mblock_calculate_metadata_xor(fs_ctx,
                                        fs_ctx->scratch_metablock,
                                        &fs_ctx->meta_block_header.metadata_xor);
-    if (err != PSA_SUCCESS) {
-        return err;
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
     }
 #else
     fs_ctx->meta_block_header.metadata_xor = 0;
@@ -791,6 +1071,7 @@ static psa_status_t its_mblock_upgrade_meta_header(
     size_t number;
     struct its_metadata_block_header_comp_t *meta_block_header_comp;
     struct its_block_meta_t block_meta_0;
+    struct its_flash_fs_space_change_t no_change = {0};
 
     err = its_mblock_validate_fs_version(fs_ctx->meta_block_header.fs_version,
                                          &backward_compatible);
@@ -833,7 +1114,9 @@ static psa_status_t its_mblock_upgrade_meta_header(
     fs_ctx->meta_block_header.active_swap_count =
              meta_block_header_comp->active_swap_count;
     fs_ctx->meta_block_header.fs_version = ITS_SUPPORTED_VERSION;
-    return its_flash_fs_mblock_meta_update_finalize(fs_ctx);
+
+    /* The free space is counted once the metadata has been loaded */
+    return its_flash_fs_mblock_meta_update_finalize(fs_ctx, &no_change);
 }
 
 /**
@@ -1047,6 +1330,10 @@ psa_status_t its_flash_fs_mblock_init(struct its_flash_fs_ctx_t *fs_ctx)
 {
     psa_status_t err;
 
+#ifdef ITS_VALIDATE_METADATA_FROM_FLASH
+    fs_ctx->shadow_valid = false;
+#endif
+
     /* Initialize Flash Interface */
     err = fs_ctx->ops->init(fs_ctx->cfg);
     if (err != PSA_SUCCESS) {
@@ -1066,17 +1353,31 @@ psa_status_t its_flash_fs_mblock_init(struct its_flash_fs_ctx_t *fs_ctx)
     /* Erase the other scratch metadata block. It can be used in the later
      * step.
      */
-    err = its_mblock_erase_scratch_blocks(fs_ctx);
+    err = its_flash_fs_mblock_erase_scratch_blocks(fs_ctx);
     if (err != PSA_SUCCESS) {
         return PSA_ERROR_GENERIC_ERROR;
     }
 
     /* Upgrade the metadata header if required. */
-    return its_mblock_upgrade_meta_header(fs_ctx);
+    err = its_mblock_upgrade_meta_header(fs_ctx);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+#ifdef ITS_VALIDATE_METADATA_FROM_FLASH
+    /* Validate the metadata once and read it from RAM from now on */
+    err = its_mblock_load_shadow(fs_ctx);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+#endif
+
+    return its_mblock_update_free_space(fs_ctx);
 }
 
 psa_status_t its_flash_fs_mblock_meta_update_finalize(
-                                              struct its_flash_fs_ctx_t *fs_ctx)
+                               struct its_flash_fs_ctx_t *fs_ctx,
+                               const struct its_flash_fs_space_change_t *change)
 {
     psa_status_t err;
 
@@ -1095,8 +1396,20 @@ psa_status_t its_flash_fs_mblock_meta_update_finalize(
     /* Update the running context */
     its_mblock_swap_metablocks(fs_ctx);
 
+#ifdef ITS_VALIDATE_METADATA_FROM_FLASH
+    err = its_mblock_load_shadow(fs_ctx);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+#endif
+
+    err = its_mblock_apply_space_change(fs_ctx, change);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
     /* Erase meta block and current scratch block */
-    return its_mblock_erase_scratch_blocks(fs_ctx);
+    return its_flash_fs_mblock_erase_scratch_blocks(fs_ctx);
 }
 
 psa_status_t its_flash_fs_mblock_migrate_lb0_data_to_scratch(
@@ -1131,6 +1444,15 @@ psa_status_t its_flash_fs_mblock_read_file_meta(
     size_t offset;
 
     offset = its_mblock_file_meta_offset(fs_ctx, idx);
+
+#ifdef ITS_VALIDATE_METADATA_FROM_FLASH
+    /* Metadata in the shadow has already been validated */
+    if (its_mblock_read_shadow(fs_ctx, (uint8_t *)file_meta, offset,
+                               ITS_FILE_METADATA_SIZE)) {
+        return PSA_SUCCESS;
+    }
+#endif
+
     err = fs_ctx->ops->read(fs_ctx->cfg, fs_ctx->active_metablock,
                             (uint8_t *)file_meta, offset,
                             ITS_FILE_METADATA_SIZE);
@@ -1153,6 +1475,15 @@ psa_status_t its_flash_fs_mblock_read_block_metadata(
     size_t pos;
 
     pos = its_mblock_block_meta_offset(lblock);
+
+#ifdef ITS_VALIDATE_METADATA_FROM_FLASH
+    /* Metadata in the shadow has already been validated */
+    if (its_mblock_read_shadow(fs_ctx, (uint8_t *)block_meta, pos,
+                               ITS_BLOCK_METADATA_SIZE)) {
+        return PSA_SUCCESS;
+    }
+#endif
+
     err = fs_ctx->ops->read(fs_ctx->cfg, fs_ctx->active_metablock,
                             (uint8_t *)block_meta, pos,
                             ITS_BLOCK_METADATA_SIZE);
@@ -1202,6 +1533,15 @@ psa_status_t its_flash_fs_mblock_reserve_file(
 {
     psa_status_t err;
 
+    /* Fail early, without reading the metadata, if no data block has enough
+     * free space or there is no free file metadata entry. The spare entry can
+     * only be used if use_spare is set.
+     */
+    if ((size > fs_ctx->max_free_size) ||
+        (fs_ctx->num_free_files < (use_spare ? 1U : 2U))) {
+        return PSA_ERROR_INSUFFICIENT_STORAGE;
+    }
+
     err = its_mblock_reserve_file(fs_ctx, fid, size, flags, file_meta,
                                   block_meta);
 
@@ -1242,6 +1582,12 @@ psa_status_t its_flash_fs_mblock_reset_metablock(
         return err;
     }
 
+#ifdef ITS_VALIDATE_METADATA_FROM_FLASH
+    fs_ctx->shadow_valid = false;
+    fs_ctx->scratch_xor = 0;
+    fs_ctx->scratch_xor_size = 0;
+#endif
+
     fs_ctx->meta_block_header.active_swap_count =
                                     (fs_ctx->cfg->erase_val == 0x00U) ? 1U : 0U;
     fs_ctx->meta_block_header.scratch_dblock = its_init_scratch_dblock(fs_ctx);
@@ -1322,7 +1668,14 @@ psa_status_t its_flash_fs_mblock_reset_metablock(
     /* Swap active and scratch metablocks */
     its_mblock_swap_metablocks(fs_ctx);
 
-    return PSA_SUCCESS;
+#ifdef ITS_VALIDATE_METADATA_FROM_FLASH
+    err = its_mblock_load_shadow(fs_ctx);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+#endif
+
+    return its_mblock_update_free_space(fs_ctx);
 }
 
 void its_flash_fs_mblock_set_data_scratch(struct its_flash_fs_ctx_t *fs_ctx,
@@ -1356,18 +1709,37 @@ psa_status_t its_flash_fs_mblock_update_scratch_block_meta(
     return its_mblock_copy_remaining_block_meta(fs_ctx, lblock);
 }
 
+psa_status_t its_flash_fs_mblock_write_scratch_block_meta(
+                                      struct its_flash_fs_ctx_t *fs_ctx,
+                                      uint32_t lblock,
+                                      const struct its_block_meta_t *block_meta)
+{
+    return its_mblock_update_scratch_block_meta(fs_ctx, lblock, block_meta);
+}
+
 psa_status_t its_flash_fs_mblock_update_scratch_file_meta(
                                         struct its_flash_fs_ctx_t *fs_ctx,
                                         uint32_t idx,
                                         const struct its_file_meta_t *file_meta)
 {
+    psa_status_t err;
     size_t pos;
 
     /* Calculate the position */
     pos = its_mblock_file_meta_offset(fs_ctx, idx);
-    return fs_ctx->ops->write(fs_ctx->cfg, fs_ctx->scratch_metablock,
-                              (const uint8_t *)file_meta, pos,
-                              ITS_FILE_METADATA_SIZE);
+    err = fs_ctx->ops->write(fs_ctx->cfg, fs_ctx->scratch_metablock,
+                             (const uint8_t *)file_meta, pos,
+                             ITS_FILE_METADATA_SIZE);
+
+#ifdef ITS_VALIDATE_METADATA_FROM_FLASH
+    if (err == PSA_SUCCESS) {
+        its_mblock_scratch_xor_update(fs_ctx, fs_ctx->scratch_metablock,
+                                      (const uint8_t *)file_meta, pos,
+                                      ITS_FILE_METADATA_SIZE);
+    }
+#endif
+
+    return err;
 }
 
 psa_status_t its_flash_fs_block_to_block_move(struct its_flash_fs_ctx_t *fs_ctx,
@@ -1401,6 +1773,11 @@ psa_status_t its_flash_fs_block_to_block_move(struct its_flash_fs_ctx_t *fs_ctx,
             return status;
         }
 
+#ifdef ITS_VALIDATE_METADATA_FROM_FLASH
+        its_mblock_scratch_xor_update(fs_ctx, dst_block, dst_block_data_copy,
+                                      dst_offset, bytes_to_move);
+#endif
+
         /* Updates pointers to the source and destination flash regions */
         dst_offset += bytes_to_move;
         src_offset += bytes_to_move;
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2018-2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2018-2022, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -49,6 +49,16 @@ extern "C" {
  */
 #define ITS_LOGICAL_DBLOCK0  0
 
+/*!
+ * \def ITS_TRANSACTION_MAX_FILES
+ *
+ * \brief Defines the maximum number of files that can be modified in one
+ *        filesystem transaction.
+ */
+#ifndef ITS_TRANSACTION_MAX_FILES
+#define ITS_TRANSACTION_MAX_FILES 4
+#endif
+
 /*!
  * \struct its_metadata_block_header_t
  *
@@ -171,6 +181,78 @@ struct its_file_meta_t {
 };
 #undef _T3
 
+/*!
+ * \struct its_flash_fs_space_change_t
+ *
+ * \brief Structure to store the change of free space made by a metadata block
+ *        update, which is applied to the free space counters of the
+ *        filesystem context when the update is finalized.
+ */
+struct its_flash_fs_space_change_t {
+    int32_t num_free_files;        /*!< Change of the number of free file
+                                    *   metadata entries
+                                    */
+    int32_t free_size;             /*!< Change of the free space of all the
+                                    *   data blocks
+                                    */
+    size_t max_free_size;          /*!< Largest free space of a data block
+                                    *   modified by the update
+                                    */
+    bool max_free_size_reduced;    /*!< True if the update reduced the free
+                                    *   space of a data block which had the
+                                    *   largest free space
+                                    */
+};
+
+/*!
+ * \struct its_flash_fs_txn_file_t
+ *
+ * \brief Structure to store a file metadata entry staged by a transaction.
+ */
+struct its_flash_fs_txn_file_t {
+    uint32_t idx;                  /*!< File metadata entry index */
+    bool data_staged;              /*!< True if the file data has been written
+                                    *   to the scratch data block
+                                    */
+    size_t data_end;               /*!< End of the file data written to the
+                                    *   scratch data block, relative to the
+                                    *   start of the file
+                                    */
+    struct its_file_meta_t meta;   /*!< Staged file metadata */
+};
+
+/*!
+ * \struct its_flash_fs_txn_t
+ *
+ * \brief Structure to store the state of an open filesystem transaction.
+ *
+ * \note The staged metadata is kept in RAM and only programmed to the scratch
+ *       metadata block when the transaction is committed, so that each
+ *       metadata entry is programmed exactly once per metadata block update.
+ */
+struct its_flash_fs_txn_t {
+    bool active;                   /*!< True if a transaction is open */
+    bool failed;                   /*!< True if a staged change has failed, so
+                                    *   the transaction can only be aborted
+                                    */
+    bool lb0_staged;               /*!< True if lb0_meta is staged */
+    bool dblock_written;           /*!< True if file data has been written to
+                                    *   the scratch data block
+                                    */
+    uint32_t dblock;               /*!< Dedicated logical data block modified
+                                    *   by the transaction, or
+                                    *   ITS_BLOCK_INVALID_ID if none
+                                    */
+    uint32_t scratch_dblock;       /*!< Scratch data block when the
+                                    *   transaction was opened
+                                    */
+    struct its_block_meta_t lb0_meta;    /*!< Staged logical block 0 metadata */
+    struct its_block_meta_t dblock_meta; /*!< Staged metadata of dblock */
+    uint32_t num_files;            /*!< Number of staged file entries */
+    struct its_flash_fs_txn_file_t files[ITS_TRANSACTION_MAX_FILES];
+                                   /*!< Staged file metadata entries */
+};
+
 /**
  * \struct its_flash_fs_ctx_t
  *
@@ -184,6 +266,22 @@ struct its_flash_fs_ctx_t {
                                                            */
     uint32_t active_metablock;  /**< Active metadata block */
     uint32_t scratch_metablock; /**< Scratch metadata block */
+    struct its_flash_fs_txn_t txn; /**< Open transaction state */
+    uint32_t num_free_files;    /**< Number of free file metadata entries in
+                                 *   the active metadata block
+                                 */
+    size_t free_size;           /**< Free space of all the data blocks */
+    size_t max_free_size;       /**< Largest free space of a data block */
+#ifdef ITS_VALIDATE_METADATA_FROM_FLASH
+    bool shadow_valid;          /**< True if the metadata shadow holds the
+                                 *   validated metadata of the active metadata
+                                 *   block
+                                 */
+    uint8_t scratch_xor;        /**< XOR of the metadata programmed to the
+                                 *   scratch metadata block since it was erased
+                                 */
+    size_t scratch_xor_size;    /**< Number of metadata bytes in scratch_xor */
+#endif
 };
 
 /**
@@ -253,11 +351,31 @@ psa_status_t its_flash_fs_mblock_get_file_idx_flag(
  *        Last step when a create/write/delete is performed.
  *
  * \param[in,out] fs_ctx  Filesystem context
+ * \param[in]     change  Change of free space made by the update, which is
+ *                        applied to the free space counters once the metadata
+ *                        blocks are swapped
  *
  * \return Returns offset value in metadata block
  */
 psa_status_t its_flash_fs_mblock_meta_update_finalize(
-                                             struct its_flash_fs_ctx_t *fs_ctx);
+                               struct its_flash_fs_ctx_t *fs_ctx,
+                               const struct its_flash_fs_space_change_t *change);
+
+/**
+ * \brief Records the change of the free space of a data block made by a
+ *        metadata block update.
+ *
+ * \param[in]     fs_ctx         Filesystem context
+ * \param[in]     old_free_size  Free space of the data block in the active
+ *                               metadata block
+ * \param[in]     new_free_size  Free space of the data block after the update
+ * \param[in,out] change         Change of free space made by the update
+ */
+void its_flash_fs_mblock_space_change_block(
+                                     const struct its_flash_fs_ctx_t *fs_ctx,
+                                     size_t old_free_size,
+                                     size_t new_free_size,
+                                     struct its_flash_fs_space_change_t *change);
 
 /**
  * \brief Writes the files data area of logical block 0 into the scratch
@@ -378,6 +496,31 @@ psa_status_t its_flash_fs_mblock_update_scratch_block_meta(
                                            uint32_t lblock,
                                            struct its_block_meta_t *block_meta);
 
+/**
+ * \brief Writes a single logical block's metadata in the scratch metadata
+ *        block, without copying the metadata of the other logical blocks.
+ *
+ * \param[in,out] fs_ctx      Filesystem context
+ * \param[in]     lblock      Logical block number
+ * \param[in]     block_meta  Pointer to block's metadata
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+psa_status_t its_flash_fs_mblock_write_scratch_block_meta(
+                                      struct its_flash_fs_ctx_t *fs_ctx,
+                                      uint32_t lblock,
+                                      const struct its_block_meta_t *block_meta);
+
+/**
+ * \brief Erases the scratch metadata block and the scratch data block.
+ *
+ * \param[in,out] fs_ctx  Filesystem context
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+psa_status_t its_flash_fs_mblock_erase_scratch_blocks(
+                                             struct its_flash_fs_ctx_t *fs_ctx);
+
 /**
  * \brief Writes a file metadata entry into scratch metadata block.
  *
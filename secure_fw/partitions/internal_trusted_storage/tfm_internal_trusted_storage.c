@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019-2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2019-2022, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -29,6 +29,17 @@
 #define ITS_BUF_SIZE ITS_MAX_ASSET_SIZE
 #endif
 
+#ifndef ITS_CLIENT_QUOTA
+/* By default, the storage space used by each client is not limited */
+#define ITS_CLIENT_QUOTA 0
+#endif
+
+/* Number of files listed per scan of the file metadata */
+#define ITS_LIST_BATCH_ENTRIES 8
+
+/* Number of clients whose storage usage is cached */
+#define ITS_USAGE_CACHE_CLIENTS 8
+
 /* Buffer to store asset data from the caller.
  * Note: size must be aligned to the max flash program unit to meet the
  * alignment requirement of the filesystem.
@@ -39,12 +50,33 @@ static uint8_t asset_data[ITS_UTILS_ALIGN(ITS_BUF_SIZE,
 static uint8_t g_fid[ITS_FILE_ID_SIZE];
 static struct its_file_info_t g_file_info;
 
+#if defined(ITS_VALIDATE_METADATA_FROM_FLASH) && \
+    (ITS_METADATA_SHADOW_MAX_BLOCKS > 0)
+/* Buffers to hold a validated copy of the active metadata of each filesystem.
+ * If the filesystem has more blocks than ITS_METADATA_SHADOW_MAX_BLOCKS, then
+ * the metadata is instead validated every time it is read from flash.
+ */
+static uint8_t its_metadata_shadow[ITS_FLASH_FS_METADATA_SIZE(
+                                                ITS_METADATA_SHADOW_MAX_BLOCKS,
+                                                ITS_NUM_ASSETS + 1)];
+#ifdef TFM_PARTITION_PROTECTED_STORAGE
+static uint8_t ps_metadata_shadow[ITS_FLASH_FS_METADATA_SIZE(
+                                                ITS_METADATA_SHADOW_MAX_BLOCKS,
+                                                PS_MAX_NUM_OBJECTS)];
+#endif
+#endif
+
 static its_flash_fs_ctx_t fs_ctx_its;
 static struct its_flash_fs_config_t fs_cfg_its = {
     .flash_dev = &ITS_FLASH_DEV,
     .program_unit = ITS_FLASH_ALIGNMENT,
     .max_file_size = ITS_UTILS_ALIGN(ITS_MAX_ASSET_SIZE, ITS_FLASH_ALIGNMENT),
     .max_num_files = ITS_NUM_ASSETS + 1, /* Extra file for atomic replacement */
+#if defined(ITS_VALIDATE_METADATA_FROM_FLASH) && \
+    (ITS_METADATA_SHADOW_MAX_BLOCKS > 0)
+    .metadata_shadow = its_metadata_shadow,
+    .metadata_shadow_size = sizeof(its_metadata_shadow),
+#endif
 };
 
 #ifdef TFM_PARTITION_PROTECTED_STORAGE
@@ -54,9 +86,35 @@ static struct its_flash_fs_config_t fs_cfg_ps = {
     .program_unit = PS_FLASH_ALIGNMENT,
     .max_file_size = ITS_UTILS_ALIGN(PS_MAX_OBJECT_SIZE, PS_FLASH_ALIGNMENT),
     .max_num_files = PS_MAX_NUM_OBJECTS,
+#if defined(ITS_VALIDATE_METADATA_FROM_FLASH) && \
+    (ITS_METADATA_SHADOW_MAX_BLOCKS > 0)
+    .metadata_shadow = ps_metadata_shadow,
+    .metadata_shadow_size = sizeof(ps_metadata_shadow),
+#endif
 };
 #endif
 
+/* Client ID of the owner of the open ITS transaction, or zero if there is no
+ * open transaction.
+ */
+static int32_t txn_client_id;
+
+/* Storage usage of a client. The usage of a client is counted from the file
+ * metadata the first time it is needed, and then kept up to date as the
+ * client's files are modified, so that quotas and capacity queries do not need
+ * to scan the file metadata.
+ */
+struct its_client_usage_t {
+    int32_t client_id; /* Client ID, or zero if the entry is free */
+    size_t num_files;  /* Number of files owned by the client */
+    size_t size;       /* Sum of the maximum sizes of the client's files */
+};
+
+static struct its_client_usage_t its_usage[ITS_USAGE_CACHE_CLIENTS];
+
+/* Next usage cache entry to be replaced */
+static uint32_t its_usage_next;
+
 static its_flash_fs_ctx_t *get_fs_ctx(int32_t client_id)
 {
 #ifdef TFM_PARTITION_PROTECTED_STORAGE
@@ -82,6 +140,183 @@ static void tfm_its_get_fid(int32_t client_id,
     tfm_memcpy(fid + sizeof(client_id), (const void *)&uid, sizeof(uid));
 }
 
+/**
+ * \brief Checks if a client is permitted to modify the filesystem associated
+ *        with it. While a transaction is open on the ITS filesystem, only the
+ *        owner of the transaction can modify it.
+ *
+ * \param[in] client_id  Identifier of the asset's owner (client)
+ *
+ * \return Returns PSA_ERROR_BAD_STATE if another client has an open
+ *         transaction, and PSA_SUCCESS otherwise.
+ */
+static psa_status_t check_txn_owner(int32_t client_id)
+{
+    if ((txn_client_id != 0) && (txn_client_id != client_id) &&
+        (get_fs_ctx(client_id) == &fs_ctx_its)) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Gets the storage usage of a client. If it is not cached, then it is
+ *        counted from the file metadata and cached, replacing the oldest
+ *        cached usage.
+ *
+ * \param[in]  client_id  Identifier of the assets' owner (client)
+ * \param[out] p_usage    Pointer to the cached usage of the client
+ *
+ * \note While a transaction is open, the committed files are counted.
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t its_usage_get(int32_t client_id,
+                                  struct its_client_usage_t **p_usage)
+{
+    psa_status_t status;
+    struct its_client_usage_t *usage;
+    uint8_t fid[ITS_FILE_ID_SIZE];
+    struct its_file_info_t info;
+    int32_t file_client_id;
+    uint32_t idx = 0;
+    uint32_t i;
+
+    for (i = 0; i < ITS_USAGE_CACHE_CLIENTS; i++) {
+        if (its_usage[i].client_id == client_id) {
+            *p_usage = &its_usage[i];
+            return PSA_SUCCESS;
+        }
+    }
+
+    usage = &its_usage[its_usage_next];
+    its_usage_next = (its_usage_next + 1) % ITS_USAGE_CACHE_CLIENTS;
+
+    usage->client_id = 0;
+    usage->num_files = 0;
+    usage->size = 0;
+
+    while (1) {
+        status = its_flash_fs_file_get_next(get_fs_ctx(client_id), &idx, fid,
+                                            &info);
+        if (status == PSA_ERROR_DOES_NOT_EXIST) {
+            break;
+        } else if (status != PSA_SUCCESS) {
+            return status;
+        }
+
+        tfm_memcpy(&file_client_id, fid, sizeof(file_client_id));
+        if (file_client_id == client_id) {
+            usage->num_files++;
+            usage->size += info.size_max;
+        }
+    }
+
+    usage->client_id = client_id;
+    *p_usage = usage;
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Removes the storage usage of a client from the cache, so that it is
+ *        counted again the next time it is needed.
+ *
+ * \param[in] client_id  Identifier of the assets' owner (client)
+ */
+static void its_usage_invalidate(int32_t client_id)
+{
+    uint32_t i;
+
+    for (i = 0; i < ITS_USAGE_CACHE_CLIENTS; i++) {
+        if (its_usage[i].client_id == client_id) {
+            its_usage[i].client_id = 0;
+        }
+    }
+}
+
+/**
+ * \brief Updates the cached storage usage of a client after one of its files
+ *        is created, resized or deleted.
+ *
+ * \param[in] client_id  Identifier of the assets' owner (client)
+ * \param[in] old_size   Maximum size of the file before the update, or 0 if
+ *                       the file did not exist
+ * \param[in] new_size   Maximum size of the file after the update, or 0 if
+ *                       the file was deleted
+ * \param[in] old_exist  True if the file existed before the update
+ * \param[in] new_exist  True if the file exists after the update
+ */
+static void its_usage_update(int32_t client_id,
+                             size_t old_size, size_t new_size,
+                             bool old_exist, bool new_exist)
+{
+    uint32_t i;
+
+    /* The changes staged by a transaction are not counted until it is
+     * committed.
+     */
+    if (client_id == txn_client_id) {
+        its_usage_invalidate(client_id);
+        return;
+    }
+
+    for (i = 0; i < ITS_USAGE_CACHE_CLIENTS; i++) {
+        if (its_usage[i].client_id == client_id) {
+            its_usage[i].num_files += (new_exist ? 1 : 0);
+            its_usage[i].num_files -= (old_exist ? 1 : 0);
+            its_usage[i].size += ITS_UTILS_ALIGN(new_size,
+                                   get_fs_ctx(client_id)->cfg->program_unit);
+            its_usage[i].size -= old_size;
+            return;
+        }
+    }
+}
+
+/**
+ * \brief Checks that a client's quota permits one of its files to be created
+ *        or resized. The files of the PS partition are not subject to the
+ *        quota, as PS limits the storage used by its own clients.
+ *
+ * \param[in] client_id  Identifier of the assets' owner (client)
+ * \param[in] old_size   Maximum size of the file, or 0 if it does not exist
+ * \param[in] new_size   Requested maximum size of the file
+ *
+ * \return Returns PSA_ERROR_INSUFFICIENT_STORAGE if the quota would be
+ *         exceeded, and PSA_SUCCESS otherwise. Otherwise, it returns error code
+ *         as specified in \ref psa_status_t.
+ */
+static psa_status_t its_usage_check_quota(int32_t client_id, size_t old_size,
+                                          size_t new_size)
+{
+#if (ITS_CLIENT_QUOTA > 0)
+    psa_status_t status;
+    struct its_client_usage_t *usage;
+
+    if (get_fs_ctx(client_id) != &fs_ctx_its) {
+        return PSA_SUCCESS;
+    }
+
+    status = its_usage_get(client_id, &usage);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    new_size = ITS_UTILS_ALIGN(new_size, fs_cfg_its.program_unit);
+    if ((new_size > ITS_CLIENT_QUOTA) ||
+        (usage->size - old_size > ITS_CLIENT_QUOTA - new_size)) {
+        return PSA_ERROR_INSUFFICIENT_STORAGE;
+    }
+#else
+    (void)client_id;
+    (void)old_size;
+    (void)new_size;
+#endif
+
+    return PSA_SUCCESS;
+}
+
 /**
  * \brief Initialise the static filesystem configurations.
  *
@@ -149,6 +384,9 @@ psa_status_t tfm_its_init(void)
         return status;
     }
 
+    /* The usage of the clients is counted again from the prepared filesystems */
+    tfm_memset(its_usage, 0, sizeof(its_usage));
+
     /* Initialise the ITS filesystem context */
     status = its_flash_fs_init_ctx(&fs_ctx_its, &fs_cfg_its, &ITS_FLASH_OPS);
     if (status != PSA_SUCCESS) {
@@ -238,6 +476,8 @@ psa_status_t tfm_its_set(int32_t client_id,
     size_t write_size;
     size_t offset;
     uint32_t flags;
+    size_t size = data_length;
+    bool exist = false;
 
     /* Check that the UID is valid */
     if (uid == TFM_ITS_INVALID_UID) {
@@ -251,6 +491,11 @@ psa_status_t tfm_its_set(int32_t client_id,
         return PSA_ERROR_NOT_SUPPORTED;
     }
 
+    status = check_txn_owner(client_id);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
     /* Set file id */
     tfm_its_get_fid(client_id, uid, g_fid);
 
@@ -264,10 +509,18 @@ psa_status_t tfm_its_set(int32_t client_id,
         if (g_file_info.flags & PSA_STORAGE_FLAG_WRITE_ONCE) {
             return PSA_ERROR_NOT_PERMITTED;
         }
-    } else if (status != PSA_ERROR_DOES_NOT_EXIST) {
-        /* If the file does not exist, then do nothing.
-         * If other error occurred, return it
-         */
+
+        exist = true;
+    } else if (status == PSA_ERROR_DOES_NOT_EXIST) {
+        /* The file will be created */
+        g_file_info.size_max = 0;
+    } else {
+        /* If other error occurred, return it */
+        return status;
+    }
+
+    status = its_usage_check_quota(client_id, g_file_info.size_max, size);
+    if (status != PSA_SUCCESS) {
         return status;
     }
 
@@ -287,9 +540,11 @@ psa_status_t tfm_its_set(int32_t client_id,
 
         /* Write to the file in the file system */
         status = its_flash_fs_file_write(get_fs_ctx(client_id), g_fid, flags,
-                                         data_length, write_size, offset,
+                                         size, write_size, offset,
                                          asset_data);
         if (status != PSA_SUCCESS) {
+            /* The file may have been replaced by the first iteration */
+            its_usage_invalidate(client_id);
             return status;
         }
 
@@ -300,6 +555,131 @@ psa_status_t tfm_its_set(int32_t client_id,
         data_length -= write_size;
     } while (data_length > 0);
 
+    its_usage_update(client_id, g_file_info.size_max, size, exist, true);
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t tfm_its_create(int32_t client_id,
+                            psa_storage_uid_t uid,
+                            size_t capacity,
+                            psa_storage_create_flags_t create_flags)
+{
+    psa_status_t status;
+
+    /* Check that the UID is valid */
+    if (uid == TFM_ITS_INVALID_UID) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    /* Check that the create_flags does not contain any unsupported flags. An
+     * empty write once asset could never be written, so that flag is not
+     * supported either.
+     */
+    if (create_flags & ~(PSA_STORAGE_FLAG_NO_CONFIDENTIALITY |
+                         PSA_STORAGE_FLAG_NO_REPLAY_PROTECTION)) {
+        return PSA_ERROR_NOT_SUPPORTED;
+    }
+
+    status = check_txn_owner(client_id);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    /* Set file id */
+    tfm_its_get_fid(client_id, uid, g_fid);
+
+    /* Check that the file does not already exist */
+    status = its_flash_fs_file_exist(get_fs_ctx(client_id), g_fid);
+    if (status == PSA_SUCCESS) {
+        return PSA_ERROR_ALREADY_EXISTS;
+    } else if (status != PSA_ERROR_DOES_NOT_EXIST) {
+        return status;
+    }
+
+    status = its_usage_check_quota(client_id, 0, capacity);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    /* Reserve the file with the requested capacity and no data */
+    status = its_flash_fs_file_write(get_fs_ctx(client_id), g_fid,
+                                     (uint32_t)create_flags |
+                                     ITS_FLASH_FS_FLAG_CREATE,
+                                     capacity, 0, 0, NULL);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    its_usage_update(client_id, 0, capacity, false, true);
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t tfm_its_set_extended(int32_t client_id,
+                                  psa_storage_uid_t uid,
+                                  size_t data_offset,
+                                  size_t data_length)
+{
+    psa_status_t status;
+    size_t write_size;
+
+    /* Check that the UID is valid */
+    if (uid == TFM_ITS_INVALID_UID) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    status = check_txn_owner(client_id);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    /* Set file id */
+    tfm_its_get_fid(client_id, uid, g_fid);
+
+    /* Read file info */
+    status = its_flash_fs_file_get_info(get_fs_ctx(client_id), g_fid,
+                                        &g_file_info);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    /* If the object has the write once flag set, then it cannot be modified */
+    if (g_file_info.flags & PSA_STORAGE_FLAG_WRITE_ONCE) {
+        return PSA_ERROR_NOT_PERMITTED;
+    }
+
+    /* It is not permitted to create gaps in the data, and the data must fit
+     * within the capacity of the file.
+     */
+    if ((data_offset > g_file_info.size_current) ||
+        (its_utils_check_contained_in(g_file_info.size_max, data_offset,
+                                      data_length) != PSA_SUCCESS)) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    /* Iteratively read data from the caller and write it to the filesystem, in
+     * chunks no larger than the size of the asset_data buffer. Only the data
+     * in the written range is modified.
+     */
+    while (data_length > 0) {
+        /* Write as much of the data as will fit in the asset_data buffer */
+        write_size = ITS_UTILS_MIN(data_length, sizeof(asset_data));
+
+        /* Read asset data from the caller */
+        (void)its_req_mngr_read(asset_data, write_size);
+
+        /* Write to the file in the file system */
+        status = its_flash_fs_file_write(get_fs_ctx(client_id), g_fid, 0, 0,
+                                         write_size, data_offset, asset_data);
+        if (status != PSA_SUCCESS) {
+            return status;
+        }
+
+        data_offset += write_size;
+        data_length -= write_size;
+    }
+
     return PSA_SUCCESS;
 }
 
@@ -394,7 +774,7 @@ psa_status_t tfm_its_get_info(int32_t client_id, psa_storage_uid_t uid,
     }
 
     /* Copy file info to the PSA info struct */
-    p_info->capacity = g_file_info.size_current;
+    p_info->capacity = g_file_info.size_max;
     p_info->size = g_file_info.size_current;
     p_info->flags = g_file_info.flags;
 
@@ -419,6 +799,11 @@ psa_status_t tfm_its_remove(int32_t client_id, psa_storage_uid_t uid)
         return PSA_ERROR_INVALID_ARGUMENT;
     }
 
+    status = check_txn_owner(client_id);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
     /* Set file id */
     tfm_its_get_fid(client_id, uid, g_fid);
 
@@ -436,5 +821,219 @@ psa_status_t tfm_its_remove(int32_t client_id, psa_storage_uid_t uid)
     }
 
     /* Delete old file from the persistent area */
-    return its_flash_fs_file_delete(get_fs_ctx(client_id), g_fid);
+    status = its_flash_fs_file_delete(get_fs_ctx(client_id), g_fid);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    its_usage_update(client_id, g_file_info.size_max, 0, true, false);
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Lists the client's files with a uid greater than after_uid, keeping
+ *        the ones with the smallest uids, sorted by uid.
+ *
+ * \param[in]  client_id    Identifier of the assets' owner (client)
+ * \param[in]  after_uid    Identifier after which to start listing
+ * \param[out] entries      Entries of the listed files
+ * \param[in]  num_entries  Maximum number of files to list
+ * \param[out] p_num        Number of listed files
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t tfm_its_list_batch(int32_t client_id,
+                                       psa_storage_uid_t after_uid,
+                                       struct psa_storage_uid_info_t *entries,
+                                       size_t num_entries,
+                                       size_t *p_num)
+{
+    psa_status_t status;
+    uint32_t idx = 0;
+    int32_t file_client_id;
+    psa_storage_uid_t uid;
+    size_t num = 0;
+    size_t pos;
+
+    while (1) {
+        status = its_flash_fs_file_get_next(get_fs_ctx(client_id), &idx,
+                                            g_fid, &g_file_info);
+        if (status == PSA_ERROR_DOES_NOT_EXIST) {
+            break;
+        } else if (status != PSA_SUCCESS) {
+            return status;
+        }
+
+        /* Recover the client id and uid from the file id */
+        tfm_memcpy(&file_client_id, g_fid, sizeof(file_client_id));
+        tfm_memcpy(&uid, g_fid + sizeof(file_client_id), sizeof(uid));
+
+        if (file_client_id != client_id || uid <= after_uid) {
+            continue;
+        }
+
+        if (num < num_entries) {
+            pos = num++;
+        } else if (uid < entries[num_entries - 1].uid) {
+            pos = num_entries - 1;
+        } else {
+            continue;
+        }
+
+        for (; pos > 0 && entries[pos - 1].uid > uid; pos--) {
+            entries[pos] = entries[pos - 1];
+        }
+
+        entries[pos].uid = uid;
+        entries[pos].size = g_file_info.size_current;
+        entries[pos].flags = g_file_info.flags;
+    }
+
+    *p_num = num;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t tfm_its_list(int32_t client_id,
+                          psa_storage_uid_t after_uid,
+                          size_t num_entries,
+                          size_t *p_num_entries)
+{
+    psa_status_t status;
+    struct psa_storage_uid_info_t batch[ITS_LIST_BATCH_ENTRIES];
+    size_t batch_size;
+    size_t batch_num;
+
+    *p_num_entries = 0;
+
+    /* Write the entries to the caller in batches, each one starting after the
+     * last uid of the previous batch.
+     */
+    while (*p_num_entries < num_entries) {
+        batch_size = ITS_UTILS_MIN(num_entries - *p_num_entries,
+                                   ITS_LIST_BATCH_ENTRIES);
+
+        status = tfm_its_list_batch(client_id, after_uid, batch, batch_size,
+                                    &batch_num);
+        if (status != PSA_SUCCESS) {
+            return status;
+        }
+
+        if (batch_num > 0) {
+            its_req_mngr_write((const uint8_t *)batch,
+                               batch_num * sizeof(batch[0]));
+            *p_num_entries += batch_num;
+            after_uid = batch[batch_num - 1].uid;
+        }
+
+        if (batch_num < batch_size) {
+            break;
+        }
+    }
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t tfm_its_get_capacity(int32_t client_id,
+                                  struct psa_storage_capacity_t *p_capacity)
+{
+    psa_status_t status;
+    struct its_client_usage_t *usage;
+    struct its_fs_space_t space;
+    size_t max_asset_size = ITS_MAX_ASSET_SIZE;
+    size_t quota = 0;
+
+    status = its_usage_get(client_id, &usage);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    status = its_flash_fs_get_space(get_fs_ctx(client_id), &space);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    if (get_fs_ctx(client_id) == &fs_ctx_its) {
+        quota = ITS_CLIENT_QUOTA;
+    }
+#ifdef TFM_PARTITION_PROTECTED_STORAGE
+    else {
+        max_asset_size = PS_MAX_OBJECT_SIZE;
+    }
+#endif
+
+    p_capacity->num_assets = usage->num_files;
+    p_capacity->size = usage->size;
+    p_capacity->quota = quota;
+    p_capacity->free_assets = space.num_free_files;
+    p_capacity->free_size = ITS_UTILS_MIN(space.max_file_size, max_asset_size);
+
+    if (quota > 0) {
+        /* Only whole program units of the remaining quota can be used */
+        quota = (quota > usage->size) ? (quota - usage->size) : 0;
+        quota -= quota % get_fs_ctx(client_id)->cfg->program_unit;
+        p_capacity->free_size = ITS_UTILS_MIN(p_capacity->free_size, quota);
+    }
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t tfm_its_txn_begin(int32_t client_id)
+{
+    psa_status_t status;
+
+    /* An open transaction blocks modifications by all other clients, so only
+     * secure clients are permitted to open one.
+     */
+    if (client_id <= 0) {
+        return PSA_ERROR_NOT_PERMITTED;
+    }
+
+    if (txn_client_id != 0) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    status = its_flash_fs_txn_begin(&fs_ctx_its);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    txn_client_id = client_id;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t tfm_its_txn_commit(int32_t client_id)
+{
+    psa_status_t status;
+
+    if ((txn_client_id == 0) || (txn_client_id != client_id)) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    status = its_flash_fs_txn_commit(&fs_ctx_its);
+
+    /* A transaction with a failed change stays open, and blocks the other
+     * clients, until its owner aborts it.
+     */
+    if (!fs_ctx_its.txn.active) {
+        txn_client_id = 0;
+    }
+
+    /* The usage of the client is counted again with the committed files */
+    its_usage_invalidate(client_id);
+
+    return status;
+}
+
+psa_status_t tfm_its_txn_abort(int32_t client_id)
+{
+    if ((txn_client_id == 0) || (txn_client_id != client_id)) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    txn_client_id = 0;
+
+    return its_flash_fs_txn_abort(&fs_ctx_its);
 }
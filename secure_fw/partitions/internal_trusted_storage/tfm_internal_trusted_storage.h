@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019-2020, Arm Limited. All rights reserved.
+ * Copyright (c) 2019-2022, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -56,7 +56,8 @@ psa_status_t tfm_its_init(void);
  *                                         not valid
  * \retval PSA_ERROR_INSUFFICIENT_STORAGE  The operation failed because there
  *                                         was insufficient space on the
- *                                         storage medium
+ *                                         storage medium, or the client's
+ *                                         quota would be exceeded
  * \retval PSA_ERROR_STORAGE_FAILURE       The operation failed because the
  *                                         physical storage has failed (Fatal
  *                                         error)
@@ -65,12 +66,84 @@ psa_status_t tfm_its_init(void);
  *                                         is invalid, for example is `NULL` or
  *                                         references memory the caller cannot
  *                                         access
+ * \retval PSA_ERROR_BAD_STATE             The operation failed because another
+ *                                         client has an open transaction
  */
 psa_status_t tfm_its_set(int32_t client_id,
                          psa_storage_uid_t uid,
                          size_t data_length,
                          psa_storage_create_flags_t create_flags);
 
+/**
+ * \brief Reserve storage for the provided uid without writing any data
+ *
+ * \param[in] client_id     Identifier of the asset's owner (client)
+ * \param[in] uid           The identifier for the data
+ * \param[in] capacity      The maximum size in bytes of the data that can be
+ *                          written to the asset with tfm_its_set_extended()
+ * \param[in] create_flags  The flags that the data will be stored with
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS                     The operation completed successfully
+ * \retval PSA_ERROR_ALREADY_EXISTS        The operation failed because the
+ *                                         provided `uid` value already exists
+ * \retval PSA_ERROR_NOT_SUPPORTED         The operation failed because one or
+ *                                         more of the flags provided in
+ *                                         `create_flags` is not supported or is
+ *                                         not valid
+ * \retval PSA_ERROR_INSUFFICIENT_STORAGE  The operation failed because there
+ *                                         was insufficient space on the
+ *                                         storage medium, or the client's
+ *                                         quota would be exceeded
+ * \retval PSA_ERROR_INVALID_ARGUMENT      The operation failed because
+ *                                         `capacity` is larger than the
+ *                                         maximum asset size
+ * \retval PSA_ERROR_BAD_STATE             The operation failed because another
+ *                                         client has an open transaction
+ */
+psa_status_t tfm_its_create(int32_t client_id,
+                            psa_storage_uid_t uid,
+                            size_t capacity,
+                            psa_storage_create_flags_t create_flags);
+
+/**
+ * \brief Write part of the data associated with a provided uid
+ *
+ * Writes `data_length` bytes at `data_offset` bytes from the beginning of the
+ * data, leaving the rest of the data unchanged. The write can extend the data,
+ * up to the capacity of the asset, but must not leave a gap after the current
+ * end of the data.
+ *
+ * \param[in] client_id    Identifier of the asset's owner (client)
+ * \param[in] uid          The identifier for the data
+ * \param[in] data_offset  The offset within the data at which to write
+ * \param[in] data_length  The size in bytes of the data to write
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS                 The operation completed successfully
+ * \retval PSA_ERROR_DOES_NOT_EXIST    The operation failed because the
+ *                                     provided `uid` value was not found in
+ *                                     the storage
+ * \retval PSA_ERROR_NOT_PERMITTED     The operation failed because the
+ *                                     provided `uid` value was created with
+ *                                     PSA_STORAGE_FLAG_WRITE_ONCE
+ * \retval PSA_ERROR_INVALID_ARGUMENT  The operation failed because
+ *                                     `data_offset` is larger than the current
+ *                                     size of the data, or the write would
+ *                                     exceed the capacity of the asset
+ * \retval PSA_ERROR_STORAGE_FAILURE   The operation failed because the
+ *                                     physical storage has failed (Fatal
+ *                                     error)
+ * \retval PSA_ERROR_BAD_STATE         The operation failed because another
+ *                                     client has an open transaction
+ */
+psa_status_t tfm_its_set_extended(int32_t client_id,
+                                  psa_storage_uid_t uid,
+                                  size_t data_offset,
+                                  size_t data_length);
+
 /**
  * \brief Retrieve data associated with a provided UID
  *
@@ -160,9 +233,108 @@ psa_status_t tfm_its_get_info(int32_t client_id, psa_storage_uid_t uid,
  *                                     PSA_STORAGE_FLAG_WRITE_ONCE
  * \retval PSA_ERROR_STORAGE_FAILURE   The operation failed because the physical
  *                                     storage has failed (Fatal error)
+ * \retval PSA_ERROR_BAD_STATE         The operation failed because another
+ *                                     client has an open transaction
  */
 psa_status_t tfm_its_remove(int32_t client_id, psa_storage_uid_t uid);
 
+/**
+ * \brief List the uids stored by the client
+ *
+ * Writes the metadata of up to `num_entries` of the client's uids which are
+ * greater than `after_uid` to the client, in ascending order of uid, as
+ * `psa_storage_uid_info_t` structures.
+ *
+ * \param[in]  client_id      Identifier of the assets' owner (client)
+ * \param[in]  after_uid      The uid after which to start listing
+ * \param[in]  num_entries    The maximum number of uids to list
+ * \param[out] p_num_entries  On success, the number of listed uids
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS                 The operation completed successfully
+ * \retval PSA_ERROR_STORAGE_FAILURE   The operation failed because the physical
+ *                                     storage has failed (Fatal error)
+ */
+psa_status_t tfm_its_list(int32_t client_id,
+                          psa_storage_uid_t after_uid,
+                          size_t num_entries,
+                          size_t *p_num_entries);
+
+/**
+ * \brief Retrieve the storage usage of the client and the free storage
+ *
+ * \param[in]  client_id   Identifier of the assets' owner (client)
+ * \param[out] p_capacity  A pointer to a `psa_storage_capacity_t` struct that
+ *                         will be populated with the usage and free storage
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS                 The operation completed successfully
+ * \retval PSA_ERROR_STORAGE_FAILURE   The operation failed because the physical
+ *                                     storage has failed (Fatal error)
+ */
+psa_status_t tfm_its_get_capacity(int32_t client_id,
+                                  struct psa_storage_capacity_t *p_capacity);
+
+/**
+ * \brief Open a transaction on the internal trusted storage
+ *
+ * All subsequent calls to tfm_its_set() and tfm_its_remove() made by the
+ * client are applied atomically when the transaction is committed. While the
+ * transaction is open, tfm_its_get() and tfm_its_get_info() return the
+ * committed data, and other clients are not permitted to modify the internal
+ * trusted storage.
+ *
+ * \param[in] client_id  Identifier of the client opening the transaction
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS              The operation completed successfully
+ * \retval PSA_ERROR_NOT_PERMITTED  The operation failed because the caller is
+ *                                  not a secure client
+ * \retval PSA_ERROR_BAD_STATE      The operation failed because a transaction
+ *                                  is already open
+ */
+psa_status_t tfm_its_txn_begin(int32_t client_id);
+
+/**
+ * \brief Commit the open internal trusted storage transaction
+ *
+ * \param[in] client_id  Identifier of the client that opened the transaction
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS                The operation completed successfully
+ * \retval PSA_ERROR_BAD_STATE        The operation failed because the client
+ *                                    does not have an open transaction, or
+ *                                    because a change staged by the
+ *                                    transaction has failed. The transaction
+ *                                    must then be aborted.
+ * \retval PSA_ERROR_STORAGE_FAILURE  The operation failed because the physical
+ *                                    storage has failed (Fatal error)
+ * \retval PSA_ERROR_GENERIC_ERROR    The operation failed because of an
+ *                                    unspecified internal failure. Nothing has
+ *                                    been committed, and the transaction must
+ *                                    be aborted.
+ */
+psa_status_t tfm_its_txn_commit(int32_t client_id);
+
+/**
+ * \brief Discard the open internal trusted storage transaction
+ *
+ * \param[in] client_id  Identifier of the client that opened the transaction
+ *
+ * \return A status indicating the success/failure of the operation
+ *
+ * \retval PSA_SUCCESS                The operation completed successfully
+ * \retval PSA_ERROR_BAD_STATE        The operation failed because the client
+ *                                    does not have an open transaction
+ * \retval PSA_ERROR_STORAGE_FAILURE  The operation failed because the physical
+ *                                    storage has failed (Fatal error)
+ */
+psa_status_t tfm_its_txn_abort(int32_t client_id);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019-2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2019-2022, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -211,6 +211,66 @@ static psa_status_t tfm_its_set_ipc(void)
     return tfm_its_set(msg.client_id, uid, data_length, create_flags);
 }
 
+static psa_status_t tfm_its_create_ipc(void)
+{
+    psa_storage_uid_t uid;
+    size_t capacity;
+    psa_storage_create_flags_t create_flags;
+    size_t num;
+
+    if (msg.in_size[0] != sizeof(uid) ||
+        msg.in_size[1] != sizeof(capacity) ||
+        msg.in_size[2] != sizeof(create_flags)) {
+        /* The size of one of the arguments is incorrect */
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    num = psa_read(msg.handle, 0, &uid, sizeof(uid));
+    if (num != sizeof(uid)) {
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    num = psa_read(msg.handle, 1, &capacity, sizeof(capacity));
+    if (num != sizeof(capacity)) {
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    num = psa_read(msg.handle, 2, &create_flags, sizeof(create_flags));
+    if (num != sizeof(create_flags)) {
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    return tfm_its_create(msg.client_id, uid, capacity, create_flags);
+}
+
+static psa_status_t tfm_its_set_extended_ipc(void)
+{
+    psa_storage_uid_t uid;
+    size_t data_offset;
+    size_t data_length;
+    size_t num;
+
+    if (msg.in_size[0] != sizeof(uid) ||
+        msg.in_size[2] != sizeof(data_offset)) {
+        /* The size of one of the arguments is incorrect */
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    data_length = msg.in_size[1];
+
+    num = psa_read(msg.handle, 0, &uid, sizeof(uid));
+    if (num != sizeof(uid)) {
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    num = psa_read(msg.handle, 2, &data_offset, sizeof(data_offset));
+    if (num != sizeof(data_offset)) {
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    return tfm_its_set_extended(msg.client_id, uid, data_offset, data_length);
+}
+
 static psa_status_t tfm_its_get_ipc(void)
 {
     psa_storage_uid_t uid;
@@ -285,6 +345,45 @@ static psa_status_t tfm_its_remove_ipc(void)
     return tfm_its_remove(msg.client_id, uid);
 }
 
+static psa_status_t tfm_its_list_ipc(void)
+{
+    psa_storage_uid_t after_uid;
+    size_t num_entries;
+    size_t num;
+
+    if (msg.in_size[0] != sizeof(after_uid)) {
+        /* The input argument size is incorrect */
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    num = psa_read(msg.handle, 0, &after_uid, sizeof(after_uid));
+    if (num != sizeof(after_uid)) {
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    return tfm_its_list(msg.client_id, after_uid,
+                        msg.out_size[0] / sizeof(struct psa_storage_uid_info_t),
+                        &num_entries);
+}
+
+static psa_status_t tfm_its_get_capacity_ipc(void)
+{
+    psa_status_t status;
+    struct psa_storage_capacity_t capacity;
+
+    if (msg.out_size[0] != sizeof(capacity)) {
+        /* The output argument size is incorrect */
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    status = tfm_its_get_capacity(msg.client_id, &capacity);
+    if (status == PSA_SUCCESS) {
+        psa_write(msg.handle, 0, &capacity, sizeof(capacity));
+    }
+
+    return status;
+}
+
 static void its_signal_handle(psa_signal_t signal)
 {
     psa_status_t status;
@@ -311,6 +410,34 @@ static void its_signal_handle(psa_signal_t signal)
         status = tfm_its_remove_ipc();
         psa_reply(msg.handle, status);
         break;
+    case TFM_ITS_CREATE:
+        status = tfm_its_create_ipc();
+        psa_reply(msg.handle, status);
+        break;
+    case TFM_ITS_SET_EXTENDED:
+        status = tfm_its_set_extended_ipc();
+        psa_reply(msg.handle, status);
+        break;
+    case TFM_ITS_LIST:
+        status = tfm_its_list_ipc();
+        psa_reply(msg.handle, status);
+        break;
+    case TFM_ITS_GET_CAPACITY:
+        status = tfm_its_get_capacity_ipc();
+        psa_reply(msg.handle, status);
+        break;
+    case TFM_ITS_TXN_BEGIN:
+        status = tfm_its_txn_begin(msg.client_id);
+        psa_reply(msg.handle, status);
+        break;
+    case TFM_ITS_TXN_COMMIT:
+        status = tfm_its_txn_commit(msg.client_id);
+        psa_reply(msg.handle, status);
+        break;
+    case TFM_ITS_TXN_ABORT:
+        status = tfm_its_txn_abort(msg.client_id);
+        psa_reply(msg.handle, status);
+        break;
     default:
         psa_panic();
     }
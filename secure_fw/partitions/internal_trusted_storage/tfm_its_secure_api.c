@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019-2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2019-2022, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -153,3 +153,139 @@ psa_status_t psa_its_remove(psa_storage_uid_t uid)
 
     return status;
 }
+
+psa_status_t psa_its_create(psa_storage_uid_t uid,
+                            size_t capacity,
+                            psa_storage_create_flags_t create_flags)
+{
+#ifdef TFM_PSA_API
+    psa_invec in_vec[] = {
+        { .base = &uid, .len = sizeof(uid) },
+        { .base = &capacity, .len = sizeof(capacity) },
+        { .base = &create_flags, .len = sizeof(create_flags) }
+    };
+
+    return psa_call(TFM_INTERNAL_TRUSTED_STORAGE_SERVICE_HANDLE, TFM_ITS_CREATE,
+                    in_vec, IOVEC_LEN(in_vec), NULL, 0);
+#else
+    (void)uid;
+    (void)capacity;
+    (void)create_flags;
+
+    /* Not supported in the library model */
+    return PSA_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+psa_status_t psa_its_set_extended(psa_storage_uid_t uid,
+                                  size_t data_offset,
+                                  size_t data_length,
+                                  const void *p_data)
+{
+#ifdef TFM_PSA_API
+    psa_invec in_vec[] = {
+        { .base = &uid, .len = sizeof(uid) },
+        { .base = p_data, .len = data_length },
+        { .base = &data_offset, .len = sizeof(data_offset) }
+    };
+
+    return psa_call(TFM_INTERNAL_TRUSTED_STORAGE_SERVICE_HANDLE,
+                    TFM_ITS_SET_EXTENDED, in_vec, IOVEC_LEN(in_vec), NULL, 0);
+#else
+    (void)uid;
+    (void)data_offset;
+    (void)data_length;
+    (void)p_data;
+
+    /* Not supported in the library model */
+    return PSA_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+psa_status_t psa_its_list(psa_storage_uid_t after_uid,
+                          size_t num_entries,
+                          struct psa_storage_uid_info_t *p_entries,
+                          size_t *p_num_entries)
+{
+#ifdef TFM_PSA_API
+    psa_status_t status;
+
+    psa_invec in_vec[] = {
+        { .base = &after_uid, .len = sizeof(after_uid) }
+    };
+
+    psa_outvec out_vec[] = {
+        { .base = p_entries, .len = num_entries * sizeof(*p_entries) }
+    };
+
+    if (p_num_entries == NULL) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    status = psa_call(TFM_INTERNAL_TRUSTED_STORAGE_SERVICE_HANDLE,
+                      TFM_ITS_LIST, in_vec, IOVEC_LEN(in_vec),
+                      out_vec, IOVEC_LEN(out_vec));
+
+    *p_num_entries = out_vec[0].len / sizeof(*p_entries);
+
+    return status;
+#else
+    (void)after_uid;
+    (void)num_entries;
+    (void)p_entries;
+    (void)p_num_entries;
+
+    /* Not supported in the library model */
+    return PSA_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+psa_status_t psa_its_get_capacity(struct psa_storage_capacity_t *p_capacity)
+{
+#ifdef TFM_PSA_API
+    psa_outvec out_vec[] = {
+        { .base = p_capacity, .len = sizeof(*p_capacity) }
+    };
+
+    return psa_call(TFM_INTERNAL_TRUSTED_STORAGE_SERVICE_HANDLE,
+                    TFM_ITS_GET_CAPACITY, NULL, 0, out_vec, IOVEC_LEN(out_vec));
+#else
+    (void)p_capacity;
+
+    /* Not supported in the library model */
+    return PSA_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+psa_status_t psa_its_txn_begin(void)
+{
+#ifdef TFM_PSA_API
+    return psa_call(TFM_INTERNAL_TRUSTED_STORAGE_SERVICE_HANDLE,
+                    TFM_ITS_TXN_BEGIN, NULL, 0, NULL, 0);
+#else
+    /* Transactions are not supported in the library model */
+    return PSA_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+psa_status_t psa_its_txn_commit(void)
+{
+#ifdef TFM_PSA_API
+    return psa_call(TFM_INTERNAL_TRUSTED_STORAGE_SERVICE_HANDLE,
+                    TFM_ITS_TXN_COMMIT, NULL, 0, NULL, 0);
+#else
+    /* Transactions are not supported in the library model */
+    return PSA_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+psa_status_t psa_its_txn_abort(void)
+{
+#ifdef TFM_PSA_API
+    return psa_call(TFM_INTERNAL_TRUSTED_STORAGE_SERVICE_HANDLE,
+                    TFM_ITS_TXN_ABORT, NULL, 0, NULL, 0);
+#else
+    /* Transactions are not supported in the library model */
+    return PSA_ERROR_NOT_SUPPORTED;
+#endif
+}
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2017-2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2017-2022, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -26,6 +26,9 @@
 #define PS_CRYPTO_ALG \
     PSA_ALG_AEAD_WITH_SHORTENED_TAG(PS_CRYPTO_AEAD_ALG, PS_TAG_LEN_BYTES)
 
+/* The PSA hash algorithm used by this implementation */
+#define PS_CRYPTO_HASH_ALG PSA_ALG_SHA_256
+
 /*
  * \brief Check whether the PS AEAD algorithm is a valid one
  *
@@ -35,27 +38,47 @@
  */
 typedef char PS_ERROR_NOT_AEAD_ALG[(PSA_ALG_IS_AEAD(PS_CRYPTO_ALG)) ? 1 : -1];
 
+/* The maximum length of a key label that can be held in the key cache. This
+ * covers the object table label and the object labels.
+ */
+#define PS_CRYPTO_KEY_LABEL_MAX_LEN 16
+
+#if PS_CRYPTO_KEY_CACHE_SIZE > 0
+/* Derived key cache entry */
+struct ps_crypto_key_cache_entry_t {
+    psa_key_id_t key;                            /*!< Derived key */
+    size_t label_len;                            /*!< Length of the label */
+    uint8_t label[PS_CRYPTO_KEY_LABEL_MAX_LEN];  /*!< Key derivation label */
+};
+
+/* Derived key cache, ordered from the most to the least recently used entry */
+static struct ps_crypto_key_cache_entry_t ps_key_cache[PS_CRYPTO_KEY_CACHE_SIZE];
+static uint32_t ps_key_cache_num;
+static struct ps_crypto_key_cache_stats_t ps_key_cache_stats;
+#endif /* PS_CRYPTO_KEY_CACHE_SIZE > 0 */
+
 static psa_key_id_t ps_key;
+static bool ps_key_cached;
 static uint8_t ps_crypto_iv_buf[PS_IV_LEN_BYTES];
+static psa_hash_operation_t ps_hash_op = PSA_HASH_OPERATION_INIT;
 
-psa_status_t ps_crypto_init(void)
-{
-    /* Currently, no initialisation is required. This may change if key
-     * handling is changed.
-     */
-    return PSA_SUCCESS;
-}
-
-psa_status_t ps_crypto_setkey(const uint8_t *key_label, size_t key_label_len)
+/**
+ * \brief Derives a storage key from the HUK and the given label.
+ *
+ * \param[in]  key_label      Pointer to the key label
+ * \param[in]  key_label_len  Length of the key label
+ * \param[out] key            On success, the ID of the derived key
+ *
+ * \return Returns values as described in \ref psa_status_t
+ */
+static psa_status_t ps_crypto_derive_key(const uint8_t *key_label,
+                                         size_t key_label_len,
+                                         psa_key_id_t *key)
 {
     psa_status_t status;
     psa_key_attributes_t attributes = PSA_KEY_ATTRIBUTES_INIT;
     psa_key_derivation_operation_t op = PSA_KEY_DERIVATION_OPERATION_INIT;
 
-    if (key_label_len == 0 || key_label == NULL) {
-        return PSA_ERROR_INVALID_ARGUMENT;
-    }
-
     /* Set the key attributes for the storage key */
     psa_set_key_usage_flags(&attributes, PS_KEY_USAGE);
     psa_set_key_algorithm(&attributes, PS_CRYPTO_ALG);
@@ -77,7 +100,7 @@ psa_status_t ps_crypto_setkey(const uint8_t *key_label, size_t key_label_len)
     }
 
     /* Create the storage key from the key derivation operation */
-    status = psa_key_derivation_output_key(&attributes, &op, &ps_key);
+    status = psa_key_derivation_output_key(&attributes, &op, key);
     if (status != PSA_SUCCESS) {
         goto err_release_op;
     }
@@ -91,7 +114,7 @@ psa_status_t ps_crypto_setkey(const uint8_t *key_label, size_t key_label_len)
     return PSA_SUCCESS;
 
 err_release_key:
-    (void)psa_destroy_key(ps_key);
+    (void)psa_destroy_key(*key);
 
 err_release_op:
     (void)psa_key_derivation_abort(&op);
@@ -99,10 +122,132 @@ err_release_op:
     return PSA_ERROR_GENERIC_ERROR;
 }
 
+#if PS_CRYPTO_KEY_CACHE_SIZE > 0
+/**
+ * \brief Moves the given key cache entry to the front of the cache, making it
+ *        the most recently used one.
+ *
+ * \param[in] idx  Index of the entry in the cache
+ */
+static void ps_crypto_key_cache_promote(uint32_t idx)
+{
+    struct ps_crypto_key_cache_entry_t entry = ps_key_cache[idx];
+
+    for (; idx > 0; idx--) {
+        ps_key_cache[idx] = ps_key_cache[idx - 1];
+    }
+
+    ps_key_cache[0] = entry;
+}
+
+/**
+ * \brief Gets the key derived from the given label from the key cache,
+ *        deriving it and adding it to the cache if it is not cached yet.
+ *
+ * \param[in]  key_label      Pointer to the key label
+ * \param[in]  key_label_len  Length of the key label
+ * \param[out] key            On success, the ID of the derived key
+ *
+ * \return Returns values as described in \ref psa_status_t
+ */
+static psa_status_t ps_crypto_key_cache_get(const uint8_t *key_label,
+                                            size_t key_label_len,
+                                            psa_key_id_t *key)
+{
+    psa_status_t status;
+    uint32_t idx;
+
+    for (idx = 0; idx < ps_key_cache_num; idx++) {
+        if (ps_key_cache[idx].label_len == key_label_len &&
+            tfm_memcmp(ps_key_cache[idx].label, key_label,
+                       key_label_len) == 0) {
+            ps_key_cache_stats.num_hits++;
+            ps_crypto_key_cache_promote(idx);
+            *key = ps_key_cache[0].key;
+            return PSA_SUCCESS;
+        }
+    }
+
+    ps_key_cache_stats.num_misses++;
+
+    status = ps_crypto_derive_key(key_label, key_label_len, key);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    /* Evict the least recently used entry if the cache is full */
+    if (ps_key_cache_num == PS_CRYPTO_KEY_CACHE_SIZE) {
+        ps_key_cache_num--;
+        (void)psa_destroy_key(ps_key_cache[ps_key_cache_num].key);
+        ps_key_cache_stats.num_evictions++;
+    }
+
+    ps_key_cache[ps_key_cache_num].key = *key;
+    ps_key_cache[ps_key_cache_num].label_len = key_label_len;
+    (void)tfm_memcpy(ps_key_cache[ps_key_cache_num].label, key_label,
+                     key_label_len);
+    ps_crypto_key_cache_promote(ps_key_cache_num);
+    ps_key_cache_num++;
+
+    return PSA_SUCCESS;
+}
+#endif /* PS_CRYPTO_KEY_CACHE_SIZE > 0 */
+
+psa_status_t ps_crypto_init(void)
+{
+#if PS_CRYPTO_KEY_CACHE_SIZE > 0
+    uint32_t idx;
+
+    /* Destroy the keys derived before a reinitialisation, and clear the
+     * cache.
+     */
+    for (idx = 0; idx < ps_key_cache_num; idx++) {
+        (void)psa_destroy_key(ps_key_cache[idx].key);
+    }
+
+    (void)tfm_memset(ps_key_cache, 0, sizeof(ps_key_cache));
+    (void)tfm_memset(&ps_key_cache_stats, 0, sizeof(ps_key_cache_stats));
+    ps_key_cache_num = 0;
+#endif
+
+    ps_key_cached = false;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_crypto_setkey(const uint8_t *key_label, size_t key_label_len)
+{
+    psa_status_t status;
+
+    if (key_label_len == 0 || key_label == NULL) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+#if PS_CRYPTO_KEY_CACHE_SIZE > 0
+    if (key_label_len <= PS_CRYPTO_KEY_LABEL_MAX_LEN) {
+        status = ps_crypto_key_cache_get(key_label, key_label_len, &ps_key);
+        ps_key_cached = (status == PSA_SUCCESS);
+        return status;
+    }
+    ps_key_cache_stats.num_bypassed++;
+#endif
+
+    status = ps_crypto_derive_key(key_label, key_label_len, &ps_key);
+    ps_key_cached = false;
+
+    return status;
+}
+
 psa_status_t ps_crypto_destroykey(void)
 {
     psa_status_t status;
 
+    /* A cached key stays alive until it is evicted from the cache */
+    if (ps_key_cached) {
+        ps_key_cached = false;
+        return PSA_SUCCESS;
+    }
+
     /* Destroy the transient key */
     status = psa_destroy_key(ps_key);
     if (status != PSA_SUCCESS) {
@@ -112,6 +257,104 @@ psa_status_t ps_crypto_destroykey(void)
     return PSA_SUCCESS;
 }
 
+psa_status_t ps_crypto_key_cache_get_stats(
+                                    struct ps_crypto_key_cache_stats_t *stats)
+{
+#if PS_CRYPTO_KEY_CACHE_SIZE == 0
+    (void)stats;
+
+    return PSA_ERROR_NOT_SUPPORTED;
+#else
+    if (stats == NULL) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    *stats = ps_key_cache_stats;
+    stats->num_slots = PS_CRYPTO_KEY_CACHE_SIZE;
+    stats->entry_size = PS_CRYPTO_KEY_LABEL_MAX_LEN;
+    stats->in_use = ps_key_cache_num;
+
+    return PSA_SUCCESS;
+#endif /* PS_CRYPTO_KEY_CACHE_SIZE == 0 */
+}
+
+psa_status_t ps_crypto_hash(const uint8_t *in_1,
+                            size_t in_1_len,
+                            const uint8_t *in_2,
+                            size_t in_2_len,
+                            uint8_t *hash)
+{
+    psa_status_t status;
+    psa_hash_operation_t op = PSA_HASH_OPERATION_INIT;
+    size_t hash_len;
+
+    status = psa_hash_setup(&op, PS_CRYPTO_HASH_ALG);
+    if (status != PSA_SUCCESS) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    status = psa_hash_update(&op, in_1, in_1_len);
+    if (status == PSA_SUCCESS) {
+        status = psa_hash_update(&op, in_2, in_2_len);
+    }
+
+    if (status == PSA_SUCCESS) {
+        status = psa_hash_finish(&op, hash, PS_HASH_LEN_BYTES, &hash_len);
+    }
+
+    if (status != PSA_SUCCESS) {
+        (void)psa_hash_abort(&op);
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_crypto_hash_start(void)
+{
+    psa_status_t status;
+
+    status = psa_hash_setup(&ps_hash_op, PS_CRYPTO_HASH_ALG);
+    if (status != PSA_SUCCESS) {
+        ps_crypto_hash_abort();
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_crypto_hash_update(const uint8_t *in, size_t in_len)
+{
+    psa_status_t status;
+
+    status = psa_hash_update(&ps_hash_op, in, in_len);
+    if (status != PSA_SUCCESS) {
+        ps_crypto_hash_abort();
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_crypto_hash_finish(uint8_t *hash)
+{
+    psa_status_t status;
+    size_t hash_len;
+
+    status = psa_hash_finish(&ps_hash_op, hash, PS_HASH_LEN_BYTES, &hash_len);
+    if (status != PSA_SUCCESS) {
+        ps_crypto_hash_abort();
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    return PSA_SUCCESS;
+}
+
+void ps_crypto_hash_abort(void)
+{
+    (void)psa_hash_abort(&ps_hash_op);
+}
+
 void ps_crypto_set_iv(const union ps_crypto_t *crypto)
 {
     (void)tfm_memcpy(ps_crypto_iv_buf, crypto->ref.iv, PS_IV_LEN_BYTES);
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2017-2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2017-2022, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -20,6 +20,11 @@ extern "C" {
 #define PS_KEY_LEN_BYTES  16
 #define PS_TAG_LEN_BYTES  16
 #define PS_IV_LEN_BYTES   12
+#define PS_HASH_LEN_BYTES 32
+
+#ifndef PS_CRYPTO_KEY_CACHE_SIZE
+#define PS_CRYPTO_KEY_CACHE_SIZE 4
+#endif
 
 /* Union containing crypto policy implementations. The ref member provides the
  * reference implementation. Further members can be added to the union to
@@ -34,9 +39,31 @@ union ps_crypto_t {
     } ref;
 };
 
+/**
+ * \brief Statistics of the derived key cache, as returned by
+ *        \ref ps_crypto_key_cache_get_stats
+ */
+struct ps_crypto_key_cache_stats_t {
+    uint32_t num_slots;     /*!< Number of entries of the cache */
+    uint32_t entry_size;    /*!< Longest key label kept in an entry, in bytes */
+    uint32_t in_use;        /*!< Number of entries holding a key */
+    uint32_t num_hits;      /*!< Keys found in the cache */
+    uint32_t num_misses;    /*!< Keys not in the cache, which were derived
+                             *   from the HUK
+                             */
+    uint32_t num_evictions; /*!< Keys destroyed to make room for another one */
+    uint32_t num_bypassed;  /*!< Keys whose label is too long to be kept in
+                             *   an entry
+                             */
+};
+
 /**
  * \brief Initializes the crypto engine.
  *
+ * \note Destroys the keys held in the derived key cache and clears the cache
+ *       and its statistics, so it must be called whenever PS is
+ *       (re)initialised.
+ *
  * \return Returns values as described in \ref psa_status_t
  */
 psa_status_t ps_crypto_init(void);
@@ -44,6 +71,10 @@ psa_status_t ps_crypto_init(void);
 /**
  * \brief Sets the key to use for crypto operations for the current client.
  *
+ * \note The key derived from a label is kept in a cache of
+ *       PS_CRYPTO_KEY_CACHE_SIZE keys, so that it is only derived again from
+ *       the HUK once it has been evicted by the least recently used policy.
+ *
  * \param[in]     key_label       Pointer to the key label
  * \param[in]     key_label_len   Length of the key label
  *
@@ -52,12 +83,25 @@ psa_status_t ps_crypto_init(void);
 psa_status_t ps_crypto_setkey(const uint8_t *key_label, size_t key_label_len);
 
 /**
- * \brief Destroys the transient key used for crypto operations.
+ * \brief Releases the key used for crypto operations. The key is destroyed
+ *        unless it is held in the derived key cache.
  *
  * \return Returns values as described in \ref psa_status_t
  */
 psa_status_t ps_crypto_destroykey(void);
 
+/**
+ * \brief Gets the statistics of the derived key cache, accumulated since the
+ *        last call to \ref ps_crypto_init.
+ *
+ * \param[out] stats  Statistics of the cache
+ *
+ * \return PSA_ERROR_NOT_SUPPORTED if the cache is disabled, otherwise return
+ *         values as described in \ref psa_status_t
+ */
+psa_status_t ps_crypto_key_cache_get_stats(
+                                    struct ps_crypto_key_cache_stats_t *stats);
+
 /**
  * \brief Encrypts and tags the given plaintext data.
  *
@@ -130,6 +174,56 @@ psa_status_t ps_crypto_authenticate(const union ps_crypto_t *crypto,
                                     const uint8_t *add,
                                     uint32_t add_len);
 
+/**
+ * \brief Computes the hash of the concatenation of two buffers.
+ *
+ * \param[in]  in_1      Pointer to the first buffer
+ * \param[in]  in_1_len  Length of the first buffer
+ * \param[in]  in_2      Pointer to the second buffer
+ * \param[in]  in_2_len  Length of the second buffer
+ * \param[out] hash      Pointer to the output buffer, of PS_HASH_LEN_BYTES
+ *
+ * \return Returns values as described in \ref psa_status_t
+ */
+psa_status_t ps_crypto_hash(const uint8_t *in_1,
+                            size_t in_1_len,
+                            const uint8_t *in_2,
+                            size_t in_2_len,
+                            uint8_t *hash);
+
+/**
+ * \brief Starts a multi-part hash computation.
+ *
+ * \note Only one multi-part hash computation can be active at a time.
+ *
+ * \return Returns values as described in \ref psa_status_t
+ */
+psa_status_t ps_crypto_hash_start(void);
+
+/**
+ * \brief Adds a buffer to the active multi-part hash computation.
+ *
+ * \param[in] in      Pointer to the buffer
+ * \param[in] in_len  Length of the buffer
+ *
+ * \return Returns values as described in \ref psa_status_t
+ */
+psa_status_t ps_crypto_hash_update(const uint8_t *in, size_t in_len);
+
+/**
+ * \brief Finishes the active multi-part hash computation.
+ *
+ * \param[out] hash  Pointer to the output buffer, of PS_HASH_LEN_BYTES
+ *
+ * \return Returns values as described in \ref psa_status_t
+ */
+psa_status_t ps_crypto_hash_finish(uint8_t *hash);
+
+/**
+ * \brief Aborts the active multi-part hash computation, if any.
+ */
+void ps_crypto_hash_abort(void);
+
 /**
  * \brief Provides current IV value to crypto layer.
  *
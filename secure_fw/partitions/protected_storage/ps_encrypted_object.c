@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2018-2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2018-2022, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -14,26 +14,56 @@
 #include "tfm_memory_utils.h"
 #include "ps_object_defs.h"
 #include "ps_utils.h"
+#include "tfm_ps_req_mngr.h"
 
-/* Gets the size of data to encrypt */
-#define PS_ENCRYPT_SIZE(plaintext_size) \
-    ((plaintext_size) + PS_OBJECT_HEADER_SIZE - sizeof(union ps_crypto_t))
-
-#define PS_OBJECT_START_POSITION  0
+/*
+ * Encrypted object layout in the file system:
+ *
+ * +---------+---------+-----+-------------+--------+
+ * | Chunk 0 | Chunk 1 | ... | Chunk (n-1) | Header |
+ * +---------+---------+-----+-------------+--------+
+ *
+ * Each chunk record is made up of its IV, its tag and up to
+ * PS_CRYPTO_CHUNK_SIZE bytes of encrypted object data. Each chunk uses its
+ * index as the associated data, so that chunks cannot be reordered.
+ *
+ * The header record is made up of its IV and the encrypted object information
+ * followed by the digest of the tags of all chunks, so that chunks cannot be
+ * replaced by chunks of an older version of the object. The header uses the
+ * File ID as the associated data, and its tag is stored in the object table.
+ *
+ * The header is written last, so that the object can be written to the file
+ * system one chunk at a time. As the chunks do not depend on the File ID, the
+ * chunks that are not modified by a write are copied to the new file as they
+ * are, and only the modified chunks are encrypted again.
+ */
 
-/* Buffer to store the maximum encrypted object */
-/* FIXME: Do partial encrypt/decrypt to reduce the size of internal buffer */
-#define PS_MAX_ENCRYPTED_OBJ_SIZE PS_ENCRYPT_SIZE(PS_MAX_OBJECT_DATA_SIZE)
+/* Offset of the given chunk record in the file */
+#define PS_ENC_CHUNK_OFFSET(chunk_idx) ((chunk_idx) * PS_ENC_CHUNK_RECORD_SIZE)
 
-/* FIXME: add the tag length to the crypto buffer size to account for the tag
- * being appended to the ciphertext by the crypto layer.
+/* Buffer to store one encrypted chunk record, with space for the tag to be
+ * appended to the ciphertext by the crypto layer. It is also used for the
+ * header record and the key label, which are smaller.
  */
-#define PS_TAG_IV_LEN_MAX   ((PS_TAG_LEN_BYTES > PS_IV_LEN_BYTES) ? \
-                             PS_TAG_LEN_BYTES : PS_IV_LEN_BYTES)
-#define PS_CRYPTO_BUF_LEN (PS_MAX_ENCRYPTED_OBJ_SIZE + PS_TAG_IV_LEN_MAX)
+#define PS_CRYPTO_BUF_LEN (PS_ENC_CHUNK_RECORD_SIZE + PS_TAG_LEN_BYTES)
 
 static uint8_t ps_crypto_buf[PS_CRYPTO_BUF_LEN];
 
+/* Check at compilation time if the header record fits in the crypto buffer */
+PS_UTILS_BOUND_CHECK(ENC_HEADER_NOT_FIT_IN_CRYPTO_BUF,
+                     PS_ENC_HEADER_SIZE + PS_TAG_LEN_BYTES, PS_CRYPTO_BUF_LEN);
+
+/* Offset in the file of the next data to be written */
+static size_t ps_obj_wrt_offset;
+
+#ifndef TFM_PSA_API
+/* The library model does not support psa_its_create and
+ * psa_its_set_extended, so the encrypted object is staged in this buffer and
+ * written to the file system in one go.
+ */
+static uint8_t ps_obj_staging_buf[PS_MAX_OBJECT_SIZE];
+#endif
+
 static psa_status_t fill_key_label(struct ps_object_t *obj, size_t *length)
 {
     psa_storage_uid_t uid = obj->header.crypto.ref.uid;
@@ -52,87 +82,393 @@ static psa_status_t fill_key_label(struct ps_object_t *obj, size_t *length)
 }
 
 /**
- * \brief Performs authenticated decryption on object data, with the header as
- *        the associated data.
+ * \brief Sets the key of the given object for the crypto operations.
  *
- * \param[in]  fid       File ID
- * \param[in]  cur_size  Size of the object data to decrypt
- * \param[in,out] obj    Pointer to the object structure to authenticate and
- *                       fill in with the decrypted data. The tag of the object
- *                       is the one stored in the object table for the given
- *                       File ID.
+ * \param[in] obj  Pointer to the object structure, with the UID and client ID
+ *                 set in the crypto metadata
  *
  * \return Returns error code as specified in \ref psa_status_t
  */
-static psa_status_t ps_object_auth_decrypt(uint32_t fid,
-                                           uint32_t cur_size,
-                                           struct ps_object_t *obj)
+static psa_status_t ps_object_setkey(struct ps_object_t *obj)
 {
     psa_status_t err;
-    uint8_t *p_obj_data = (uint8_t *)&obj->header.info;
-    size_t out_len, label_length;
+    size_t label_length;
 
     err = fill_key_label(obj, &label_length);
     if (err != PSA_SUCCESS) {
         return err;
     }
 
-    err = ps_crypto_setkey(ps_crypto_buf, label_length);
+    return ps_crypto_setkey(ps_crypto_buf, label_length);
+}
+
+/**
+ * \brief Reads and authenticates the object header record.
+ *
+ * \param[in]     fid  File ID
+ * \param[in,out] obj  Pointer to the object structure to fill in with the
+ *                     decrypted object information and chunk digest. The tag
+ *                     of the header is the one stored in the object table for
+ *                     the given File ID.
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_object_read_header(uint32_t fid,
+                                          struct ps_object_t *obj)
+{
+    psa_status_t err;
+    struct psa_storage_info_t file_info;
+    size_t data_length;
+    size_t out_len;
+
+    /* The header record is at the end of the file */
+    err = psa_its_get_info(fid, &file_info);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    if (file_info.size < PS_ENC_HEADER_SIZE) {
+        return PSA_ERROR_DATA_CORRUPT;
+    }
+
+    err = psa_its_get(fid, file_info.size - PS_ENC_HEADER_SIZE,
+                      PS_ENC_HEADER_SIZE, (void *)ps_crypto_buf,
+                      &data_length);
     if (err != PSA_SUCCESS) {
         return err;
     }
 
-    (void)tfm_memcpy(ps_crypto_buf, p_obj_data, cur_size);
+    if (data_length != PS_ENC_HEADER_SIZE) {
+        return PSA_ERROR_DATA_CORRUPT;
+    }
+
+    (void)tfm_memcpy(obj->header.crypto.ref.iv, ps_crypto_buf,
+                     PS_IV_LEN_BYTES);
 
     /* Use File ID as a part of the associated data to authenticate
      * the object in the FS. The tag will be stored in the object table and
      * not as a part of the object's data stored in the FS.
      */
-
     err = ps_crypto_auth_and_decrypt(&obj->header.crypto,
                                      (const uint8_t *)&fid,
                                      sizeof(fid),
-                                     ps_crypto_buf,
-                                     cur_size,
-                                     p_obj_data,
-                                     sizeof(*obj) - sizeof(obj->header.crypto),
+                                     ps_crypto_buf + PS_IV_LEN_BYTES,
+                                     PS_ENC_HEADER_DATA_SIZE,
+                                     (uint8_t *)&obj->header.info,
+                                     PS_ENC_HEADER_DATA_SIZE,
                                      &out_len);
-    if (err != PSA_SUCCESS || out_len != cur_size) {
-        (void)ps_crypto_destroykey();
+    if (err != PSA_SUCCESS || out_len != PS_ENC_HEADER_DATA_SIZE) {
         return PSA_ERROR_GENERIC_ERROR;
     }
 
-    return ps_crypto_destroykey();
+    /* Check that the file holds exactly the chunks of the object data */
+    if ((obj->header.info.current_size > obj->header.info.max_size) ||
+        (PS_ENC_OBJECT_SIZE(obj->header.info.current_size) !=
+         file_info.size)) {
+        return PSA_ERROR_DATA_CORRUPT;
+    }
+
+    return PSA_SUCCESS;
 }
 
 /**
- * \brief Performs authenticated encryption on object data, with the header as
- *        the associated data.
+ * \brief Checks that the tags of the object chunks match the chunk digest in
+ *        the authenticated object header.
  *
- * \param[in]  fid       File ID
- * \param[in]  cur_size  Size of the object data to encrypt
- * \param[out] obj       Pointer to the object structure to authenticate and
- *                       fill in with the encrypted data.
+ * \param[in] fid  File ID
+ * \param[in] obj  Pointer to the object structure, with an authenticated
+ *                 header
  *
  * \return Returns error code as specified in \ref psa_status_t
  */
-static psa_status_t ps_object_auth_encrypt(uint32_t fid,
-                                           uint32_t cur_size,
-                                           struct ps_object_t *obj)
+static psa_status_t ps_object_verify_chunks(uint32_t fid,
+                                            const struct ps_object_t *obj)
 {
     psa_status_t err;
-    uint8_t *p_obj_data = (uint8_t *)&obj->header.info;
-    size_t out_len, label_length;
+    uint32_t num_chunks = PS_ENC_NUM_CHUNKS(obj->header.info.current_size);
+    uint32_t chunk_idx;
+    size_t data_length;
 
-    err = fill_key_label(obj, &label_length);
+    err = ps_crypto_hash_start();
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    for (chunk_idx = 0; chunk_idx < num_chunks; chunk_idx++) {
+        err = psa_its_get(fid, PS_ENC_CHUNK_OFFSET(chunk_idx) + PS_IV_LEN_BYTES,
+                          PS_TAG_LEN_BYTES, (void *)ps_crypto_buf,
+                          &data_length);
+        if (err == PSA_SUCCESS && data_length != PS_TAG_LEN_BYTES) {
+            err = PSA_ERROR_DATA_CORRUPT;
+        }
+        if (err != PSA_SUCCESS) {
+            ps_crypto_hash_abort();
+            return err;
+        }
+
+        err = ps_crypto_hash_update(ps_crypto_buf, PS_TAG_LEN_BYTES);
+        if (err != PSA_SUCCESS) {
+            ps_crypto_hash_abort();
+            return err;
+        }
+    }
+
+    err = ps_crypto_hash_finish(ps_crypto_buf);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    if (tfm_memcmp(ps_crypto_buf, obj->header.digest,
+                   PS_HASH_LEN_BYTES) != 0) {
+        return PSA_ERROR_INVALID_SIGNATURE;
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Reads, authenticates and decrypts one chunk of the object data into
+ *        the object data buffer.
+ *
+ * \param[in]     fid        File ID
+ * \param[in,out] obj        Pointer to the object structure
+ * \param[in]     chunk_idx  Index of the chunk
+ * \param[in]     chunk_len  Length of the chunk data
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_object_read_chunk(uint32_t fid,
+                                         struct ps_object_t *obj,
+                                         uint32_t chunk_idx,
+                                         uint32_t chunk_len)
+{
+    psa_status_t err;
+    union ps_crypto_t crypto;
+    size_t data_length;
+    size_t out_len;
+
+    err = psa_its_get(fid, PS_ENC_CHUNK_OFFSET(chunk_idx),
+                      PS_ENC_CHUNK_META_SIZE + chunk_len,
+                      (void *)ps_crypto_buf, &data_length);
     if (err != PSA_SUCCESS) {
         return err;
     }
 
-    err = ps_crypto_setkey(ps_crypto_buf, label_length);
+    if (data_length != PS_ENC_CHUNK_META_SIZE + chunk_len) {
+        return PSA_ERROR_DATA_CORRUPT;
+    }
+
+    (void)tfm_memcpy(crypto.ref.iv, ps_crypto_buf, PS_IV_LEN_BYTES);
+    (void)tfm_memcpy(crypto.ref.tag, ps_crypto_buf + PS_IV_LEN_BYTES,
+                     PS_TAG_LEN_BYTES);
+
+    err = ps_crypto_auth_and_decrypt(&crypto,
+                                     (const uint8_t *)&chunk_idx,
+                                     sizeof(chunk_idx),
+                                     ps_crypto_buf + PS_ENC_CHUNK_META_SIZE,
+                                     chunk_len,
+                                     obj->data,
+                                     sizeof(obj->data),
+                                     &out_len);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    if (out_len != chunk_len) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Starts writing a new encrypted object to the file system.
+ *
+ * \param[in] fid        File ID
+ * \param[in] data_size  Size of the object data
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_object_write_start(uint32_t fid, uint32_t data_size)
+{
+    ps_obj_wrt_offset = 0;
+
+#ifdef TFM_PSA_API
+    /* Reserve the whole file, so that it can be written one record at a
+     * time.
+     */
+    return psa_its_create(fid, PS_ENC_OBJECT_SIZE(data_size),
+                          PSA_STORAGE_FLAG_NONE);
+#else
+    (void)fid;
+    (void)data_size;
+
+    return PSA_SUCCESS;
+#endif
+}
+
+/**
+ * \brief Appends a record to the encrypted object being written.
+ *
+ * \param[in] fid   File ID
+ * \param[in] data  Pointer to the record to append
+ * \param[in] len   Length of the record
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_object_append(uint32_t fid, const uint8_t *data,
+                                     size_t len)
+{
+#ifdef TFM_PSA_API
+    psa_status_t err;
+
+    err = psa_its_set_extended(fid, ps_obj_wrt_offset, len, data);
     if (err != PSA_SUCCESS) {
         return err;
     }
+#else
+    (void)fid;
+
+    if (len > sizeof(ps_obj_staging_buf) - ps_obj_wrt_offset) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    (void)tfm_memcpy(ps_obj_staging_buf + ps_obj_wrt_offset, data, len);
+#endif
+
+    ps_obj_wrt_offset += len;
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Finishes writing a new encrypted object to the file system.
+ *
+ * \param[in] fid  File ID
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_object_write_finish(uint32_t fid)
+{
+#ifdef TFM_PSA_API
+    (void)fid;
+
+    return PSA_SUCCESS;
+#else
+    return psa_its_set(fid, ps_obj_wrt_offset,
+                       (const void *)ps_obj_staging_buf,
+                       PSA_STORAGE_FLAG_NONE);
+#endif
+}
+
+/**
+ * \brief Encrypts one chunk of object data from the object data buffer and
+ *        appends it to the encrypted object being written. The tag of the
+ *        chunk is added to the active hash computation.
+ *
+ * \param[in] fid        File ID
+ * \param[in] obj        Pointer to the object structure
+ * \param[in] chunk_idx  Index of the chunk
+ * \param[in] chunk_len  Length of the chunk data
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_object_write_chunk(uint32_t fid,
+                                          const struct ps_object_t *obj,
+                                          uint32_t chunk_idx,
+                                          uint32_t chunk_len)
+{
+    psa_status_t err;
+    union ps_crypto_t crypto;
+    size_t out_len;
+
+    /* Get a new IV for each chunk */
+    err = ps_crypto_get_iv(&crypto);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    err = ps_crypto_encrypt_and_tag(&crypto,
+                                    (const uint8_t *)&chunk_idx,
+                                    sizeof(chunk_idx),
+                                    obj->data,
+                                    chunk_len,
+                                    ps_crypto_buf + PS_ENC_CHUNK_META_SIZE,
+                                    sizeof(ps_crypto_buf) -
+                                    PS_ENC_CHUNK_META_SIZE,
+                                    &out_len);
+    if (err != PSA_SUCCESS || out_len != chunk_len) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    (void)tfm_memcpy(ps_crypto_buf, crypto.ref.iv, PS_IV_LEN_BYTES);
+    (void)tfm_memcpy(ps_crypto_buf + PS_IV_LEN_BYTES, crypto.ref.tag,
+                     PS_TAG_LEN_BYTES);
+
+    err = ps_crypto_hash_update(crypto.ref.tag, PS_TAG_LEN_BYTES);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    return ps_object_append(fid, ps_crypto_buf,
+                            PS_ENC_CHUNK_META_SIZE + chunk_len);
+}
+
+/**
+ * \brief Copies one encrypted chunk record of an old object to the encrypted
+ *        object being written, without decrypting it.
+ *
+ * \param[in] fid        File ID
+ * \param[in] old_fid    File ID of the old object
+ * \param[in] chunk_idx  Index of the chunk
+ * \param[in] chunk_len  Length of the chunk data
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_object_copy_chunk(uint32_t fid,
+                                         uint32_t old_fid,
+                                         uint32_t chunk_idx,
+                                         uint32_t chunk_len)
+{
+    psa_status_t err;
+    size_t data_length;
+
+    err = psa_its_get(old_fid, PS_ENC_CHUNK_OFFSET(chunk_idx),
+                      PS_ENC_CHUNK_META_SIZE + chunk_len,
+                      (void *)ps_crypto_buf, &data_length);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    if (data_length != PS_ENC_CHUNK_META_SIZE + chunk_len) {
+        return PSA_ERROR_DATA_CORRUPT;
+    }
+
+    err = ps_crypto_hash_update(ps_crypto_buf + PS_IV_LEN_BYTES,
+                                PS_TAG_LEN_BYTES);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    return ps_object_append(fid, ps_crypto_buf,
+                            PS_ENC_CHUNK_META_SIZE + chunk_len);
+}
+
+/**
+ * \brief Encrypts the object header and appends it to the encrypted object
+ *        being written.
+ *
+ * \param[in]     fid  File ID
+ * \param[in,out] obj  Pointer to the object structure. On success, the header
+ *                     tag to be stored in the object table is set in it.
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_object_write_header(uint32_t fid,
+                                           struct ps_object_t *obj)
+{
+    psa_status_t err;
+    size_t out_len;
 
     /* Get a new IV for each encryption */
     err = ps_crypto_get_iv(&obj->header.crypto);
@@ -144,94 +480,257 @@ static psa_status_t ps_object_auth_encrypt(uint32_t fid,
      * the object in the FS. The tag will be stored in the object table and
      * not as a part of the object's data stored in the FS.
      */
-
     err = ps_crypto_encrypt_and_tag(&obj->header.crypto,
                                     (const uint8_t *)&fid,
                                     sizeof(fid),
-                                    p_obj_data,
-                                    cur_size,
-                                    ps_crypto_buf,
-                                    sizeof(ps_crypto_buf),
+                                    (const uint8_t *)&obj->header.info,
+                                    PS_ENC_HEADER_DATA_SIZE,
+                                    ps_crypto_buf + PS_IV_LEN_BYTES,
+                                    sizeof(ps_crypto_buf) - PS_IV_LEN_BYTES,
                                     &out_len);
-    if (err != PSA_SUCCESS || out_len != cur_size) {
-        (void)ps_crypto_destroykey();
+    if (err != PSA_SUCCESS || out_len != PS_ENC_HEADER_DATA_SIZE) {
         return PSA_ERROR_GENERIC_ERROR;
     }
 
-    (void)tfm_memcpy(p_obj_data, ps_crypto_buf, cur_size);
+    (void)tfm_memcpy(ps_crypto_buf, obj->header.crypto.ref.iv,
+                     PS_IV_LEN_BYTES);
 
-    return ps_crypto_destroykey();
+    return ps_object_append(fid, ps_crypto_buf, PS_ENC_HEADER_SIZE);
 }
 
-psa_status_t ps_encrypted_object_read(uint32_t fid, struct ps_object_t *obj)
+psa_status_t ps_encrypted_object_read_header(uint32_t fid,
+                                             struct ps_object_t *obj)
 {
     psa_status_t err;
-    uint32_t decrypt_size;
-    size_t data_length;
 
-    /* Read the encrypted object from the persistent area. The data stored via
-     * ITS interface of this `fid` is the encrypted object together with the
-     * `IV`.
-     * In the psa_its_get, the buffer size is not checked. Check the buffer size
-     * here.
-     */
-    if (sizeof(ps_crypto_buf) < PS_MAX_ENCRYPTED_OBJ_SIZE + PS_IV_LEN_BYTES) {
-        return PSA_ERROR_GENERIC_ERROR;
+    err = ps_object_setkey(obj);
+    if (err != PSA_SUCCESS) {
+        return err;
     }
-    err = psa_its_get(fid, PS_OBJECT_START_POSITION,
-                      PS_MAX_ENCRYPTED_OBJ_SIZE + PS_IV_LEN_BYTES,
-                      (void *)ps_crypto_buf,
-                      &data_length);
+
+    err = ps_object_read_header(fid, obj);
     if (err != PSA_SUCCESS) {
+        (void)ps_crypto_destroykey();
         return err;
     }
 
-    /* Get the decrypt size. IV is also stored by ITS service. It is at the end
-     * of the read out data. Toolchains may add padding byte after iv array in
-     * crypto.ref structure. Separate the copies of header.info and iv array to
-     * skip the padding byte.
-     */
-    decrypt_size = data_length - sizeof(obj->header.crypto.ref.iv);
-    tfm_memcpy(&obj->header.info, ps_crypto_buf, decrypt_size);
-    tfm_memcpy(obj->header.crypto.ref.iv,
-               ps_crypto_buf + decrypt_size,
-               sizeof(obj->header.crypto.ref.iv));
+    return ps_crypto_destroykey();
+}
 
-    /* Decrypt the object data */
-    err = ps_object_auth_decrypt(fid, decrypt_size, obj);
+psa_status_t ps_encrypted_object_read(uint32_t fid, struct ps_object_t *obj,
+                                      uint32_t offset, uint32_t size,
+                                      size_t *p_data_length,
+                                      uint8_t *obj_buf, size_t obj_buf_size)
+{
+    psa_status_t err;
+    uint32_t chunk_idx;
+    uint32_t chunk_start;
+    uint32_t chunk_len;
+    uint32_t part_start;
+    uint32_t part_end;
+    uint32_t rd_start;
+    uint32_t rd_end;
+
+    err = ps_object_setkey(obj);
     if (err != PSA_SUCCESS) {
         return err;
     }
 
-    return PSA_SUCCESS;
+    err = ps_object_read_header(fid, obj);
+    if (err != PSA_SUCCESS) {
+        goto release_key;
+    }
+
+    /* Boundary check the incoming request */
+    if (offset > obj->header.info.current_size) {
+        err = PSA_ERROR_INVALID_ARGUMENT;
+        goto release_key;
+    }
+
+    size = PS_UTILS_MIN(size, obj->header.info.current_size - offset);
+
+    /* Decrypt the whole object if it is to be copied to the object buffer */
+    if (obj_buf != NULL && obj->header.info.current_size <= obj_buf_size) {
+        rd_start = 0;
+        rd_end = obj->header.info.current_size;
+    } else {
+        obj_buf = NULL;
+        rd_start = offset;
+        rd_end = offset + size;
+    }
+
+    if (rd_end > rd_start) {
+        err = ps_object_verify_chunks(fid, obj);
+        if (err != PSA_SUCCESS) {
+            goto release_key;
+        }
+    }
+
+    /* Decrypt only the chunks that hold the requested data, or all of them
+     * when the object is copied to the object buffer, and write the requested
+     * data of each chunk to the client.
+     */
+    for (chunk_idx = rd_start / PS_CRYPTO_CHUNK_SIZE;
+         (chunk_idx * PS_CRYPTO_CHUNK_SIZE) < rd_end;
+         chunk_idx++) {
+        chunk_start = chunk_idx * PS_CRYPTO_CHUNK_SIZE;
+        chunk_len = PS_UTILS_MIN(PS_CRYPTO_CHUNK_SIZE,
+                                 obj->header.info.current_size - chunk_start);
+
+        err = ps_object_read_chunk(fid, obj, chunk_idx, chunk_len);
+        if (err != PSA_SUCCESS) {
+            goto release_key;
+        }
+
+        if (obj_buf != NULL) {
+            (void)tfm_memcpy(obj_buf + chunk_start, obj->data, chunk_len);
+        }
+
+        part_start = PS_UTILS_MAX(offset, chunk_start);
+        part_end = PS_UTILS_MIN(offset + size, chunk_start + chunk_len);
+
+        if (part_start < part_end) {
+            ps_req_mngr_write_asset_data(
+                                    obj->data + (part_start - chunk_start),
+                                    part_end - part_start);
+        }
+    }
+
+    *p_data_length = size;
+
+    return ps_crypto_destroykey();
+
+release_key:
+    (void)ps_crypto_destroykey();
+
+    return err;
 }
 
-psa_status_t ps_encrypted_object_write(uint32_t fid, struct ps_object_t *obj)
+psa_status_t ps_encrypted_object_write(uint32_t fid, struct ps_object_t *obj,
+                                       uint32_t old_fid, uint32_t offset,
+                                       uint32_t size)
 {
     psa_status_t err;
-    uint32_t wrt_size;
+    uint32_t old_size = 0;
+    uint32_t new_size;
+    uint32_t num_chunks;
+    uint32_t chunk_idx;
+    uint32_t chunk_start;
+    uint32_t chunk_len;
+    uint32_t part_start;
+    uint32_t part_end;
+    uint32_t wrt_end = offset + size;
+
+    if (old_fid != PS_INVALID_FID) {
+        old_size = obj->header.info.current_size;
+    }
 
-    wrt_size = PS_ENCRYPT_SIZE(obj->header.info.current_size);
+    new_size = PS_UTILS_MAX(old_size, wrt_end);
+    num_chunks = PS_ENC_NUM_CHUNKS(new_size);
 
-    /* Authenticate and encrypt the object */
-    err = ps_object_auth_encrypt(fid, wrt_size, obj);
+    err = ps_object_setkey(obj);
     if (err != PSA_SUCCESS) {
         return err;
     }
 
-    /* The IV will also be stored. The encrypted data is stored in ps_crypto_buf
-     * now. Append the value of the 'iv' to the end of the encrypted data.
-     * Toolchains may add padding byte after iv array in crypto.ref structure.
-     * The padding byte shall not be written into the storage area.
+    /* The data of the old object is only used if the chunk digest of its
+     * authenticated header matches its chunks.
      */
-    (void)tfm_memcpy(ps_crypto_buf + wrt_size,
-                     obj->header.crypto.ref.iv,
-                     sizeof(obj->header.crypto.ref.iv));
-    wrt_size += sizeof(obj->header.crypto.ref.iv);
+    if (old_size > 0) {
+        err = ps_object_verify_chunks(old_fid, obj);
+        if (err != PSA_SUCCESS) {
+            goto release_key;
+        }
+    }
 
-    /* Write the encrypted object to the persistent area. The tag values is not
-     * copied as it is stored in the object table.
-     */
-    return psa_its_set(fid, wrt_size, (const void *)ps_crypto_buf,
-                       PSA_STORAGE_FLAG_NONE);
+    err = ps_object_write_start(fid, new_size);
+    if (err != PSA_SUCCESS) {
+        goto release_key;
+    }
+
+    err = ps_crypto_hash_start();
+    if (err != PSA_SUCCESS) {
+        goto remove_object;
+    }
+
+    for (chunk_idx = 0; chunk_idx < num_chunks; chunk_idx++) {
+        chunk_start = chunk_idx * PS_CRYPTO_CHUNK_SIZE;
+        chunk_len = PS_UTILS_MIN(PS_CRYPTO_CHUNK_SIZE, new_size - chunk_start);
+
+        /* Part of the chunk written by the client */
+        part_start = PS_UTILS_MAX(offset, chunk_start);
+        part_end = PS_UTILS_MIN(wrt_end, chunk_start + chunk_len);
+
+        /* A chunk of the old object that is not written by the client has the
+         * same length in the new object, so it is copied without being
+         * decrypted and encrypted again.
+         */
+        if ((chunk_start < old_size) && (part_start >= part_end)) {
+            err = ps_object_copy_chunk(fid, old_fid, chunk_idx, chunk_len);
+            if (err != PSA_SUCCESS) {
+                goto abort_hash;
+            }
+            continue;
+        }
+
+        /* Decrypt the old data of the chunk, unless it is all overwritten */
+        if ((chunk_start < old_size) &&
+            ((chunk_start < offset) || (chunk_start + chunk_len > wrt_end))) {
+            err = ps_object_read_chunk(old_fid, obj, chunk_idx,
+                                       PS_UTILS_MIN(PS_CRYPTO_CHUNK_SIZE,
+                                                    old_size - chunk_start));
+            if (err != PSA_SUCCESS) {
+                goto abort_hash;
+            }
+        }
+
+        /* Read the part of the chunk written by the client. As gaps are not
+         * permitted in the object data, this covers any data of the chunk
+         * beyond the end of the old object.
+         */
+        if (part_start < part_end) {
+            err = ps_req_mngr_read_asset_data(obj->data +
+                                              (part_start - chunk_start),
+                                              part_end - part_start);
+            if (err != PSA_SUCCESS) {
+                goto abort_hash;
+            }
+        }
+
+        err = ps_object_write_chunk(fid, obj, chunk_idx, chunk_len);
+        if (err != PSA_SUCCESS) {
+            goto abort_hash;
+        }
+    }
+
+    err = ps_crypto_hash_finish(obj->header.digest);
+    if (err != PSA_SUCCESS) {
+        goto remove_object;
+    }
+
+    obj->header.info.current_size = new_size;
+
+    err = ps_object_write_header(fid, obj);
+    if (err != PSA_SUCCESS) {
+        goto remove_object;
+    }
+
+    err = ps_object_write_finish(fid);
+    if (err != PSA_SUCCESS) {
+        goto remove_object;
+    }
+
+    return ps_crypto_destroykey();
+
+abort_hash:
+    ps_crypto_hash_abort();
+
+remove_object:
+    /* Remove the partially written object */
+    (void)psa_its_remove(fid);
+
+release_key:
+    (void)ps_crypto_destroykey();
+
+    return err;
 }
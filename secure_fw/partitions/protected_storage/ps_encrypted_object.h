@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2018-2020, Arm Limited. All rights reserved.
+ * Copyright (c) 2018-2022, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -8,6 +8,7 @@
 #ifndef __PS_ENCRYPTED_OBJECT_H__
 #define __PS_ENCRYPTED_OBJECT_H__
 
+#include <stddef.h>
 #include <stdint.h>
 #include "ps_object_defs.h"
 #include "psa/protected_storage.h"
@@ -17,32 +18,70 @@ extern "C" {
 #endif
 
 /**
- * \brief Reads object referenced by the object File ID.
+ * \brief Reads and authenticates the header of the object referenced by the
+ *        object File ID. The object data is not read.
  *
- * \param[in]  fid      File ID
- * \param[out] obj      Pointer to the object structure to fill in
+ * \param[in]     fid  File ID
+ * \param[in,out] obj  Pointer to the object structure to fill in. The UID,
+ *                     client ID and tag must be set in its crypto metadata.
  *
  * \return Returns error code specified in \ref psa_status_t
  */
-psa_status_t ps_encrypted_object_read(uint32_t fid,
-                                      struct ps_object_t *obj);
+psa_status_t ps_encrypted_object_read_header(uint32_t fid,
+                                             struct ps_object_t *obj);
 
 /**
- * \brief Creates and writes a new encrypted object based on the given
- *        ps_object_t structure data.
+ * \brief Reads the object referenced by the object File ID and writes the
+ *        requested range of its data to the client. Only the chunks holding
+ *        the requested range are decrypted, one chunk at a time.
  *
- * \param[in]     fid      File ID
- * \param[in,out] obj      Pointer to the object structure to write.
+ * \param[in]     fid            File ID
+ * \param[in,out] obj            Pointer to the object structure to fill in.
+ *                               The UID, client ID and tag must be set in its
+ *                               crypto metadata.
+ * \param[in]     offset         Offset in the object data to read from
+ * \param[in]     size           Maximum number of bytes to read
+ * \param[out]    p_data_length  On success, the number of bytes read
+ * \param[out]    obj_buf        Pointer to a buffer to copy the whole object
+ *                               data to, or NULL. If the object data fits in
+ *                               the buffer, all the chunks are decrypted.
+ * \param[in]     obj_buf_size   Size of the obj_buf buffer
  *
- * Note: The function will use obj to store the encrypted data before write it
- *       into the flash to reduce the memory requirements and the number of
- *       internal copies. So, this object will contain the encrypted object
- *       stored in the flash.
+ * \return Returns error code specified in \ref psa_status_t
+ */
+psa_status_t ps_encrypted_object_read(uint32_t fid, struct ps_object_t *obj,
+                                      uint32_t offset, uint32_t size,
+                                      size_t *p_data_length,
+                                      uint8_t *obj_buf, size_t obj_buf_size);
+
+/**
+ * \brief Creates and writes a new encrypted object, one chunk at a time. The
+ *        data in the given range is read from the client, and the rest of the
+ *        object data is taken from the old object, if any. Only the chunks
+ *        that contain client data are encrypted, the other chunks of the old
+ *        object are copied as they are.
+ *
+ * \param[in]     fid      File ID of the new object
+ * \param[in,out] obj      Pointer to the object structure. If old_fid is
+ *                         valid, it must hold the authenticated header of the
+ *                         old object. On success, it holds the header of the
+ *                         new object, with the tag to store in the object
+ *                         table.
+ * \param[in]     old_fid  File ID of the old object, or PS_INVALID_FID if the
+ *                         object data is only made up of the written range
+ * \param[in]     offset   Offset in the object data to write the client data
+ *                         to. It must not be greater than the current size of
+ *                         the old object.
+ * \param[in]     size     Number of bytes of client data to write
+ *
+ * \note The object data buffer of obj is used to process the object data one
+ *       chunk at a time.
  *
  * \return Returns error code specified in \ref psa_status_t
  */
-psa_status_t ps_encrypted_object_write(uint32_t fid,
-                                       struct ps_object_t *obj);
+psa_status_t ps_encrypted_object_write(uint32_t fid, struct ps_object_t *obj,
+                                       uint32_t old_fid, uint32_t offset,
+                                       uint32_t size);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2022, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "ps_object_cache.h"
+
+#include "tfm_memory_utils.h"
+#include "ps_utils.h"
+
+/* Object cache entries */
+static struct ps_object_cache_entry_t ps_obj_cache[PS_OBJECT_CACHE_ENTRIES];
+
+/* Indexes of the cache entries. The first ps_obj_cache_num indexes refer to
+ * the valid entries, ordered from the most to the least recently used one, and
+ * the remaining indexes refer to the free entries.
+ */
+static uint8_t ps_obj_cache_lru[PS_OBJECT_CACHE_ENTRIES];
+
+/* Number of valid cache entries */
+static uint32_t ps_obj_cache_num;
+
+/**
+ * \brief Moves the cache entry at the given position in the LRU list to the
+ *        front of the list.
+ *
+ * \param[in] pos  Position of the entry in the LRU list
+ */
+static void ps_object_cache_promote(uint32_t pos)
+{
+    uint8_t idx = ps_obj_cache_lru[pos];
+
+    for (; pos > 0; pos--) {
+        ps_obj_cache_lru[pos] = ps_obj_cache_lru[pos - 1];
+    }
+
+    ps_obj_cache_lru[0] = idx;
+}
+
+/**
+ * \brief Wipes the valid cache entry at the given position in the LRU list,
+ *        and moves it to the free entries.
+ *
+ * \param[in] pos  Position of the entry in the LRU list
+ */
+static void ps_object_cache_remove(uint32_t pos)
+{
+    uint8_t idx = ps_obj_cache_lru[pos];
+
+    (void)tfm_memset(&ps_obj_cache[idx], PS_DEFAULT_EMPTY_BUFF_VAL,
+                     sizeof(ps_obj_cache[idx]));
+
+    for (; pos < ps_obj_cache_num - 1; pos++) {
+        ps_obj_cache_lru[pos] = ps_obj_cache_lru[pos + 1];
+    }
+
+    ps_obj_cache_num--;
+    ps_obj_cache_lru[ps_obj_cache_num] = idx;
+}
+
+/**
+ * \brief Gets the position of the given object in the LRU list.
+ *
+ * \param[in] uid        Identifier for the data
+ * \param[in] client_id  Identifier of the asset's owner (client)
+ *
+ * \return Returns the position of the object, or PS_OBJECT_CACHE_ENTRIES if
+ *         the object is not cached.
+ */
+static uint32_t ps_object_cache_find(psa_storage_uid_t uid, int32_t client_id)
+{
+    uint32_t pos;
+    const struct ps_object_cache_entry_t *entry;
+
+    for (pos = 0; pos < ps_obj_cache_num; pos++) {
+        entry = &ps_obj_cache[ps_obj_cache_lru[pos]];
+        if (entry->uid == uid && entry->client_id == client_id) {
+            return pos;
+        }
+    }
+
+    return PS_OBJECT_CACHE_ENTRIES;
+}
+
+void ps_object_cache_clear(void)
+{
+    uint32_t idx;
+
+    (void)tfm_memset(ps_obj_cache, PS_DEFAULT_EMPTY_BUFF_VAL,
+                     sizeof(ps_obj_cache));
+
+    for (idx = 0; idx < PS_OBJECT_CACHE_ENTRIES; idx++) {
+        ps_obj_cache_lru[idx] = (uint8_t)idx;
+    }
+
+    ps_obj_cache_num = 0;
+}
+
+const struct ps_object_cache_entry_t *ps_object_cache_get(
+                              psa_storage_uid_t uid, int32_t client_id,
+                              const struct ps_obj_table_info_t *obj_tbl_info)
+{
+    uint32_t pos;
+    const struct ps_object_cache_entry_t *entry;
+
+    pos = ps_object_cache_find(uid, client_id);
+    if (pos == PS_OBJECT_CACHE_ENTRIES) {
+        return NULL;
+    }
+
+    entry = &ps_obj_cache[ps_obj_cache_lru[pos]];
+
+    /* The object table is authenticated, so the cached data can only be used
+     * if it was read from the object version the table refers to.
+     */
+#ifdef PS_ENCRYPTION
+    if (entry->fid != obj_tbl_info->fid ||
+        tfm_memcmp(entry->tag, obj_tbl_info->tag, PS_TAG_LEN_BYTES) != 0) {
+#else
+    if (entry->fid != obj_tbl_info->fid ||
+        entry->version != obj_tbl_info->version) {
+#endif
+        ps_object_cache_remove(pos);
+        return NULL;
+    }
+
+    ps_object_cache_promote(pos);
+
+    return entry;
+}
+
+struct ps_object_cache_entry_t *ps_object_cache_alloc(uint32_t size)
+{
+    /* An object which cannot be cached must not evict another one */
+    if (size > PS_OBJECT_CACHE_MAX_OBJECT_SIZE) {
+        return NULL;
+    }
+
+    if (ps_obj_cache_num == PS_OBJECT_CACHE_ENTRIES) {
+        ps_object_cache_remove(ps_obj_cache_num - 1);
+    }
+
+    return &ps_obj_cache[ps_obj_cache_lru[ps_obj_cache_num]];
+}
+
+void ps_object_cache_insert(struct ps_object_cache_entry_t *entry,
+                            psa_storage_uid_t uid, int32_t client_id,
+                            const struct ps_obj_table_info_t *obj_tbl_info,
+                            const struct ps_object_info_t *info)
+{
+    entry->uid = uid;
+    entry->client_id = client_id;
+    entry->fid = obj_tbl_info->fid;
+#ifdef PS_ENCRYPTION
+    (void)tfm_memcpy(entry->tag, obj_tbl_info->tag, PS_TAG_LEN_BYTES);
+#else
+    entry->version = obj_tbl_info->version;
+#endif
+    entry->info = *info;
+
+    /* The allocated entry is the first free entry in the LRU list */
+    ps_obj_cache_num++;
+    ps_object_cache_promote(ps_obj_cache_num - 1);
+}
+
+void ps_object_cache_discard(struct ps_object_cache_entry_t *entry)
+{
+    (void)tfm_memset(entry, PS_DEFAULT_EMPTY_BUFF_VAL, sizeof(*entry));
+}
+
+void ps_object_cache_invalidate(psa_storage_uid_t uid, int32_t client_id)
+{
+    uint32_t pos;
+
+    pos = ps_object_cache_find(uid, client_id);
+    if (pos != PS_OBJECT_CACHE_ENTRIES) {
+        ps_object_cache_remove(pos);
+    }
+}
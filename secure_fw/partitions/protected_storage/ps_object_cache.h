@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2022, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef __PS_OBJECT_CACHE_H__
+#define __PS_OBJECT_CACHE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ps_object_defs.h"
+#include "ps_object_table.h"
+#include "psa/protected_storage.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * \def PS_OBJECT_CACHE_ENTRIES
+ *
+ * \brief Specifies the number of objects held in the object cache.
+ */
+#ifndef PS_OBJECT_CACHE_ENTRIES
+#define PS_OBJECT_CACHE_ENTRIES 4
+#endif
+
+/*!
+ * \def PS_OBJECT_CACHE_MAX_OBJECT_SIZE
+ *
+ * \brief Specifies the maximum size of the data of an object held in the
+ *        object cache. Larger objects are not cached.
+ */
+#ifndef PS_OBJECT_CACHE_MAX_OBJECT_SIZE
+#define PS_OBJECT_CACHE_MAX_OBJECT_SIZE 256
+#endif
+
+#if (PS_OBJECT_CACHE_ENTRIES < 1) || (PS_OBJECT_CACHE_ENTRIES > 255)
+#error "PS_OBJECT_CACHE_ENTRIES must be between 1 and 255"
+#endif
+
+/*!
+ * \struct ps_object_cache_entry_t
+ *
+ * \brief Object cache entry, holding the authenticated data of one version of
+ *        an object. The version is identified by the object table information
+ *        of the object when it was read.
+ */
+struct ps_object_cache_entry_t {
+    psa_storage_uid_t uid;          /*!< UID of the object */
+    int32_t client_id;              /*!< Owner client ID of the object */
+    uint32_t fid;                   /*!< File ID of the object version */
+#ifdef PS_ENCRYPTION
+    uint8_t tag[PS_TAG_LEN_BYTES];  /*!< Tag of the object version */
+#else
+    uint32_t version;               /*!< Object version */
+#endif
+    struct ps_object_info_t info;   /*!< Object information */
+    uint8_t data[PS_OBJECT_CACHE_MAX_OBJECT_SIZE]; /*!< Object data */
+};
+
+/**
+ * \brief Wipes all the entries of the object cache.
+ */
+void ps_object_cache_clear(void);
+
+/**
+ * \brief Gets the cache entry of the given object, if the cached version is
+ *        the one referenced by the object table. An entry holding another
+ *        version of the object is wiped.
+ *
+ * \param[in] uid           Identifier for the data
+ * \param[in] client_id     Identifier of the asset's owner (client)
+ * \param[in] obj_tbl_info  Object table information of the object
+ *
+ * \return Returns a pointer to the cache entry, or NULL if the object is not
+ *         cached.
+ */
+const struct ps_object_cache_entry_t *ps_object_cache_get(
+                              psa_storage_uid_t uid, int32_t client_id,
+                              const struct ps_obj_table_info_t *obj_tbl_info);
+
+/**
+ * \brief Allocates a cache entry to read an object into, evicting and wiping
+ *        the least recently used entry if the cache is full. The entry is not
+ *        valid until it is added with \ref ps_object_cache_insert.
+ *
+ * \param[in] size  Current size of the object data, from the object table
+ *
+ * \return Returns a pointer to the allocated cache entry, or NULL without
+ *         evicting any entry if the object is larger than
+ *         PS_OBJECT_CACHE_MAX_OBJECT_SIZE.
+ */
+struct ps_object_cache_entry_t *ps_object_cache_alloc(uint32_t size);
+
+/**
+ * \brief Adds the entry allocated by \ref ps_object_cache_alloc to the cache,
+ *        once its data has been filled with the authenticated object data.
+ *
+ * \param[in,out] entry         Pointer to the allocated cache entry
+ * \param[in]     uid           Identifier for the data
+ * \param[in]     client_id     Identifier of the asset's owner (client)
+ * \param[in]     obj_tbl_info  Object table information of the object
+ * \param[in]     info          Object information. The current size must not
+ *                              exceed PS_OBJECT_CACHE_MAX_OBJECT_SIZE.
+ */
+void ps_object_cache_insert(struct ps_object_cache_entry_t *entry,
+                            psa_storage_uid_t uid, int32_t client_id,
+                            const struct ps_obj_table_info_t *obj_tbl_info,
+                            const struct ps_object_info_t *info);
+
+/**
+ * \brief Wipes the entry allocated by \ref ps_object_cache_alloc, when the
+ *        object could not be read or is too large to be cached.
+ *
+ * \param[out] entry  Pointer to the allocated cache entry
+ */
+void ps_object_cache_discard(struct ps_object_cache_entry_t *entry);
+
+/**
+ * \brief Wipes the cache entry of the given object, if any. Must be called
+ *        before the object is modified or deleted.
+ *
+ * \param[in] uid        Identifier for the data
+ * \param[in] client_id  Identifier of the asset's owner (client)
+ */
+void ps_object_cache_invalidate(psa_storage_uid_t uid, int32_t client_id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PS_OBJECT_CACHE_H__ */
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2018-2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2018-2022, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -40,16 +40,63 @@ struct ps_obj_header_t {
     uint32_t fid;                  /*!< File ID */
 #endif
     struct ps_object_info_t info; /*!< Object information */
+#ifdef PS_ENCRYPTION
+    uint8_t digest[PS_HASH_LEN_BYTES]; /*!< Digest of the object chunk tags */
+#endif
 };
 
+#ifdef PS_ENCRYPTION
+/*!
+ * \def PS_CRYPTO_CHUNK_SIZE
+ *
+ * \brief Specifies the size of the chunks that the data of an encrypted object
+ *        is split into. Each chunk is encrypted and authenticated separately,
+ *        so only one chunk of object data needs to be held in RAM at a time.
+ */
+#ifndef PS_CRYPTO_CHUNK_SIZE
+#define PS_CRYPTO_CHUNK_SIZE 256
+#endif
+
+/* Size of the IV and tag stored in front of each encrypted chunk */
+#define PS_ENC_CHUNK_META_SIZE   (PS_IV_LEN_BYTES + PS_TAG_LEN_BYTES)
+
+/* Size of a full encrypted chunk record in the file system */
+#define PS_ENC_CHUNK_RECORD_SIZE (PS_ENC_CHUNK_META_SIZE + PS_CRYPTO_CHUNK_SIZE)
+
+/* Number of chunks needed to store the given amount of object data */
+#define PS_ENC_NUM_CHUNKS(data_size) \
+    (((data_size) + PS_CRYPTO_CHUNK_SIZE - 1) / PS_CRYPTO_CHUNK_SIZE)
+
+/* Size of the encrypted part of the object header, which is the object
+ * information followed by the digest of the chunk tags.
+ */
+#define PS_ENC_HEADER_DATA_SIZE  (sizeof(struct ps_object_info_t) + \
+                                  PS_HASH_LEN_BYTES)
+
+/* Size of the object header record stored after the last chunk. The tag of the
+ * header is stored in the object table.
+ */
+#define PS_ENC_HEADER_SIZE       (PS_IV_LEN_BYTES + PS_ENC_HEADER_DATA_SIZE)
+
+/* Size of an encrypted object with the given amount of object data in the file
+ * system.
+ */
+#define PS_ENC_OBJECT_SIZE(data_size) \
+    ((data_size) + (PS_ENC_NUM_CHUNKS(data_size) * PS_ENC_CHUNK_META_SIZE) + \
+     PS_ENC_HEADER_SIZE)
 
+/* Encrypted object data is processed one chunk at a time */
+#define PS_MAX_OBJECT_DATA_SIZE  PS_CRYPTO_CHUNK_SIZE
+#else
 #define PS_MAX_OBJECT_DATA_SIZE  PS_MAX_ASSET_SIZE
+#endif /* PS_ENCRYPTION */
 
 /*!
  * \struct ps_object_t
  *
  * \brief The object to be written to the file system below. Made up of the
- *        object header and the object data.
+ *        object header and the object data. When PS encryption is enabled, the
+ *        data buffer only holds a single chunk of the object data.
  */
 struct ps_object_t {
     struct ps_obj_header_t header;         /*!< Object header */
@@ -58,15 +105,91 @@ struct ps_object_t {
 
 
 #define PS_OBJECT_HEADER_SIZE    sizeof(struct ps_obj_header_t)
+#ifdef PS_ENCRYPTION
+#define PS_MAX_OBJECT_SIZE       PS_ENC_OBJECT_SIZE(PS_MAX_ASSET_SIZE)
+#else
 #define PS_MAX_OBJECT_SIZE       sizeof(struct ps_object_t)
+#endif
+
+/*!
+ * \def PS_WRITE_BACK_MAX_UPDATES
+ *
+ * \brief Specifies the maximum number of updates batched into one object table
+ *        commit when PS_WRITE_BACK is enabled.
+ */
+#ifndef PS_WRITE_BACK_MAX_UPDATES
+#define PS_WRITE_BACK_MAX_UPDATES 8
+#endif
+
+#if (PS_WRITE_BACK_MAX_UPDATES < 1)
+#error "PS_WRITE_BACK_MAX_UPDATES must be at least 1"
+#endif
+
+/*!
+ * \def PS_OBJ_TABLE_WRITE_BACK_ENTRIES
+ *
+ * \brief Specifies the number of object table entries which can be released
+ *        by updates that are not committed yet. Their files are still used by
+ *        the committed object table, so they cannot be reused until the next
+ *        commit.
+ */
+#ifdef PS_WRITE_BACK
+#define PS_OBJ_TABLE_WRITE_BACK_ENTRIES (PS_WRITE_BACK_MAX_UPDATES - 1)
+#else
+#define PS_OBJ_TABLE_WRITE_BACK_ENTRIES 0
+#endif
+
+/*!
+ * \def PS_CLIENT_QUOTA
+ *
+ * \brief Specifies the maximum sum of the sizes of the objects of each client,
+ *        in bytes, or 0 if the storage used by the clients is not limited.
+ */
+#ifndef PS_CLIENT_QUOTA
+#define PS_CLIENT_QUOTA 0
+#endif
+
+/*!
+ * \def PS_OBJ_TABLE_ENTRIES
+ *
+ * \brief Specifies the number of entries in the object table, which is the
+ *        number of assets plus one extra entry to store a new object when the
+ *        code processes a change in a file, and the entries released by
+ *        updates that are not committed yet.
+ */
+#define PS_OBJ_TABLE_ENTRIES (PS_NUM_ASSETS + 1 + \
+                              PS_OBJ_TABLE_WRITE_BACK_ENTRIES)
+
+/*!
+ * \def PS_OBJ_TABLE_PAGE_ENTRIES
+ *
+ * \brief Specifies the number of object table entries stored in each object
+ *        table page.
+ */
+#ifndef PS_OBJ_TABLE_PAGE_ENTRIES
+#define PS_OBJ_TABLE_PAGE_ENTRIES 8
+#endif
+
+/*!
+ * \def PS_OBJ_TABLE_PAGES
+ *
+ * \brief Specifies the number of pages the object table is split into.
+ */
+#define PS_OBJ_TABLE_PAGES ((PS_OBJ_TABLE_ENTRIES + \
+                             PS_OBJ_TABLE_PAGE_ENTRIES - 1) / \
+                            PS_OBJ_TABLE_PAGE_ENTRIES)
 
 /*!
  * \def PS_MAX_NUM_OBJECTS
  *
  * \brief Specifies the maximum number of objects in the system, which is the
- *        number of defined assets, the object table and 2 temporary objects to
- *        store the temporary object table and temporary updated object.
+ *        number of defined assets, a temporary object to store the updated
+ *        object, the active and scratch object table headers, two copies of
+ *        each object table page, a spare object to replace a stale object
+ *        table page and the objects released by updates that are not
+ *        committed yet.
  */
-#define PS_MAX_NUM_OBJECTS (PS_NUM_ASSETS + 3)
+#define PS_MAX_NUM_OBJECTS (PS_NUM_ASSETS + 4 + (2 * PS_OBJ_TABLE_PAGES) + \
+                            PS_OBJ_TABLE_WRITE_BACK_ENTRIES)
 
 #endif /* __PS_OBJECT_DEFS_H__ */
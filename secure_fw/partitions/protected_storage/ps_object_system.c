@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2017-2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2017-2022, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -13,8 +13,12 @@
 #include "psa/internal_trusted_storage.h"
 #include "tfm_memory_utils.h"
 #ifdef PS_ENCRYPTION
+#include "crypto/ps_crypto_interface.h"
 #include "ps_encrypted_object.h"
 #endif
+#ifdef PS_OBJECT_CACHE
+#include "ps_object_cache.h"
+#endif
 #include "ps_object_defs.h"
 #include "ps_object_table.h"
 #include "ps_utils.h"
@@ -26,6 +30,9 @@
 #define PS_OBJECT_START_POSITION  0
 #endif /* PS_ENCRYPTION */
 
+/* Number of object table entries listed per scan of the object table */
+#define PS_LIST_BATCH_ENTRIES 8
+
 /* Allocate static variables to process objects */
 static struct ps_object_t g_ps_object;
 static struct ps_obj_table_info_t g_obj_tbl_info;
@@ -45,7 +52,7 @@ __STATIC_INLINE void ps_init_empty_object(
                                         struct ps_object_t *obj)
 {
     /* Set all object data to 0 */
-    (void)tfm_memset(obj, PS_DEFAULT_EMPTY_BUFF_VAL, PS_MAX_OBJECT_SIZE);
+    (void)tfm_memset(obj, PS_DEFAULT_EMPTY_BUFF_VAL, sizeof(*obj));
 
 #ifndef PS_ENCRYPTION
     /* Initialize object version */
@@ -57,6 +64,39 @@ __STATIC_INLINE void ps_init_empty_object(
     obj->header.info.create_flags = create_flags;
 }
 
+/**
+ * \brief Checks that a client's quota permits the size of one of its objects
+ *        to be changed.
+ *
+ * \param[in] client_id  Identifier of the asset's owner (client)
+ * \param[in] old_size   Size of the object, or 0 if it does not exist
+ * \param[in] new_size   Requested size of the object
+ *
+ * \return Returns PSA_ERROR_INSUFFICIENT_STORAGE if the quota would be
+ *         exceeded, and PSA_SUCCESS otherwise.
+ */
+static psa_status_t ps_check_quota(int32_t client_id, uint32_t old_size,
+                                   uint32_t new_size)
+{
+#if (PS_CLIENT_QUOTA > 0)
+    size_t num_objects;
+    size_t size;
+
+    ps_object_table_get_usage(client_id, &num_objects, &size);
+
+    if ((new_size > PS_CLIENT_QUOTA) ||
+        (size - old_size > PS_CLIENT_QUOTA - new_size)) {
+        return PSA_ERROR_INSUFFICIENT_STORAGE;
+    }
+#else
+    (void)client_id;
+    (void)old_size;
+    (void)new_size;
+#endif
+
+    return PSA_SUCCESS;
+}
+
 /**
  * \brief Removes the old object table and object from the file system.
  *
@@ -74,10 +114,45 @@ static psa_status_t ps_remove_old_data(uint32_t old_fid)
         return err;
     }
 
-    /* Delete old file from the persistent area */
-    return psa_its_remove(old_fid);
+    /* Delete old file from the persistent area, once it is not used by the
+     * committed object table anymore.
+     */
+    return ps_object_table_release_fid(old_fid);
 }
 
+#ifdef PS_OBJECT_CACHE
+/**
+ * \brief Writes the requested range of the data of a cached object to the
+ *        client.
+ *
+ * \param[in]  entry          Pointer to the cache entry of the object
+ * \param[in]  offset         Offset in the object data to read from
+ * \param[in]  size           Maximum number of bytes to read
+ * \param[out] p_data_length  On success, the number of bytes read
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_read_cached_object(
+                                  const struct ps_object_cache_entry_t *entry,
+                                  uint32_t offset, uint32_t size,
+                                  size_t *p_data_length)
+{
+    /* Boundary check the incoming request */
+    if (offset > entry->info.current_size) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    size = PS_UTILS_MIN(size, entry->info.current_size - offset);
+
+    /* Copy the object data to the output buffer */
+    ps_req_mngr_write_asset_data(entry->data + offset, size);
+
+    *p_data_length = size;
+
+    return PSA_SUCCESS;
+}
+#endif /* PS_OBJECT_CACHE */
+
 #ifndef PS_ENCRYPTION
 enum read_type_t {
     READ_HEADER_ONLY = 0,
@@ -158,6 +233,14 @@ psa_status_t ps_system_prepare(void)
 {
     psa_status_t err;
 
+#ifdef PS_ENCRYPTION
+    /* Clear the keys derived before a reinitialisation */
+    err = ps_crypto_init();
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+#endif
+
     /* Reuse the allocated g_ps_object.data to store a temporary object table
      * data to be validate inside the function.
      * The stored date will be cleaned up when the g_ps_object.data will
@@ -165,6 +248,11 @@ psa_status_t ps_system_prepare(void)
      */
     err = ps_object_table_init(g_ps_object.data);
 
+#ifdef PS_OBJECT_CACHE
+    /* The cached objects may not match the object table loaded */
+    ps_object_cache_clear();
+#endif
+
 #ifdef PS_ENCRYPTION
     g_obj_tbl_info.tag = g_ps_object.header.crypto.ref.tag;
 #endif
@@ -177,6 +265,10 @@ psa_status_t ps_object_read(psa_storage_uid_t uid, int32_t client_id,
                             size_t *p_data_length)
 {
     psa_status_t err;
+#ifdef PS_OBJECT_CACHE
+    const struct ps_object_cache_entry_t *cached;
+    struct ps_object_cache_entry_t *cache_entry;
+#endif
 
     /* Retrieve the object information from the object table if the object
      * exists.
@@ -186,12 +278,34 @@ psa_status_t ps_object_read(psa_storage_uid_t uid, int32_t client_id,
         return err;
     }
 
+#ifdef PS_OBJECT_CACHE
+    /* Use the cached object data if it was read from the current version of
+     * the object.
+     */
+    cached = ps_object_cache_get(uid, client_id, &g_obj_tbl_info);
+    if (cached != NULL) {
+        return ps_read_cached_object(cached, offset, size, p_data_length);
+    }
+
+    cache_entry = ps_object_cache_alloc(g_obj_tbl_info.size);
+#endif
+
     /* Read object */
 #ifdef PS_ENCRYPTION
     g_ps_object.header.crypto.ref.uid = uid;
     g_ps_object.header.crypto.ref.client_id = client_id;
 
-    err = ps_encrypted_object_read(g_obj_tbl_info.fid, &g_ps_object);
+    /* Decrypt the requested object data and write it to the output buffer */
+#ifdef PS_OBJECT_CACHE
+    err = ps_encrypted_object_read(g_obj_tbl_info.fid, &g_ps_object,
+                                   offset, size, p_data_length,
+                                   (cache_entry != NULL) ?
+                                   cache_entry->data : NULL,
+                                   sizeof(cache_entry->data));
+#else
+    err = ps_encrypted_object_read(g_obj_tbl_info.fid, &g_ps_object,
+                                   offset, size, p_data_length, NULL, 0);
+#endif
 #else
     /* Read object header */
     err = ps_read_object(READ_ALL_OBJECT);
@@ -200,6 +314,7 @@ psa_status_t ps_object_read(psa_storage_uid_t uid, int32_t client_id,
         goto clear_data_and_return;
     }
 
+#ifndef PS_ENCRYPTION
     /* Boundary check the incoming request */
     if (offset > g_ps_object.header.info.current_size) {
        err = PSA_ERROR_INVALID_ARGUMENT;
@@ -209,15 +324,36 @@ psa_status_t ps_object_read(psa_storage_uid_t uid, int32_t client_id,
     size = PS_UTILS_MIN(size,
                         g_ps_object.header.info.current_size - offset);
 
-    /* Copy the decrypted object data to the output buffer */
+    /* Copy the object data to the output buffer */
     ps_req_mngr_write_asset_data(g_ps_object.data + offset, size);
 
     *p_data_length = size;
+#endif
+
+#ifdef PS_OBJECT_CACHE
+    /* Keep the authenticated object data in the cache if it fits */
+    if ((cache_entry != NULL) &&
+        (g_ps_object.header.info.current_size <= sizeof(cache_entry->data))) {
+#ifndef PS_ENCRYPTION
+        (void)tfm_memcpy(cache_entry->data, g_ps_object.data,
+                         g_ps_object.header.info.current_size);
+#endif
+        ps_object_cache_insert(cache_entry, uid, client_id, &g_obj_tbl_info,
+                               &g_ps_object.header.info);
+        cache_entry = NULL;
+    }
+#endif
 
 clear_data_and_return:
+#ifdef PS_OBJECT_CACHE
+    if (cache_entry != NULL) {
+        ps_object_cache_discard(cache_entry);
+    }
+#endif
+
     /* Remove data stored in the object before leaving the function */
     (void)tfm_memset(&g_ps_object, PS_DEFAULT_EMPTY_BUFF_VAL,
-                     PS_MAX_OBJECT_SIZE);
+                     sizeof(g_ps_object));
 
     return err;
 }
@@ -228,6 +364,7 @@ psa_status_t ps_object_create(psa_storage_uid_t uid, int32_t client_id,
 {
     psa_status_t err;
     uint32_t old_fid = PS_INVALID_FID;
+    uint32_t old_size = 0;
     uint32_t fid_am_reserved = 1;
 
 #ifndef PS_ENCRYPTION
@@ -244,12 +381,17 @@ psa_status_t ps_object_create(psa_storage_uid_t uid, int32_t client_id,
      */
     err = ps_object_table_get_obj_tbl_info(uid, client_id, &g_obj_tbl_info);
     if (err == PSA_SUCCESS) {
+#ifdef PS_OBJECT_CACHE
+        ps_object_cache_invalidate(uid, client_id);
+#endif
+
 #ifdef PS_ENCRYPTION
-        /* Read the object */
+        /* Read the object header */
         g_ps_object.header.crypto.ref.uid = uid;
         g_ps_object.header.crypto.ref.client_id = client_id;
 
-        err = ps_encrypted_object_read(g_obj_tbl_info.fid, &g_ps_object);
+        err = ps_encrypted_object_read_header(g_obj_tbl_info.fid,
+                                              &g_ps_object);
 #else
         /* Read the object header */
         err = ps_read_object(READ_HEADER_ONLY);
@@ -271,8 +413,9 @@ psa_status_t ps_object_create(psa_storage_uid_t uid, int32_t client_id,
         g_ps_object.header.info.create_flags = create_flags;
         g_ps_object.header.info.max_size = size;
 
-        /* Save old file ID */
+        /* Save old file ID and size */
         old_fid = g_obj_tbl_info.fid;
+        old_size = g_obj_tbl_info.size;
     } else if (err == PSA_ERROR_DOES_NOT_EXIST) {
         /* If the object does not exist, then initialize it based on the input
          * arguments and empty content. Requests 2 FIDs to prevent exhaustion.
@@ -283,6 +426,12 @@ psa_status_t ps_object_create(psa_storage_uid_t uid, int32_t client_id,
         goto clear_data_and_return;
     }
 
+    err = ps_check_quota(client_id, old_size, size);
+    if (err != PSA_SUCCESS) {
+        goto clear_data_and_return;
+    }
+
+#ifndef PS_ENCRYPTION
     /* Update the object data */
     err = ps_req_mngr_read_asset_data(g_ps_object.data, size);
     if (err != PSA_SUCCESS) {
@@ -291,6 +440,7 @@ psa_status_t ps_object_create(psa_storage_uid_t uid, int32_t client_id,
 
     /* Update the current object size */
     g_ps_object.header.info.current_size = size;
+#endif
 
     /* Get new file ID */
     err = ps_object_table_get_free_fid(fid_am_reserved,
@@ -303,7 +453,11 @@ psa_status_t ps_object_create(psa_storage_uid_t uid, int32_t client_id,
     g_ps_object.header.crypto.ref.uid = uid;
     g_ps_object.header.crypto.ref.client_id = client_id;
 
-    err = ps_encrypted_object_write(g_obj_tbl_info.fid, &g_ps_object);
+    /* Encrypt the object data while it is read from the client, replacing
+     * any data of the old object.
+     */
+    err = ps_encrypted_object_write(g_obj_tbl_info.fid, &g_ps_object,
+                                    PS_INVALID_FID, 0, size);
 #else
     wrt_size = PS_OBJECT_SIZE(g_ps_object.header.info.current_size);
 
@@ -314,9 +468,11 @@ psa_status_t ps_object_create(psa_storage_uid_t uid, int32_t client_id,
         goto clear_data_and_return;
     }
 
-    /* Update the table with the new internal ID and version for the object, and
-     * store it in the persistent area.
+    /* Update the table with the new internal ID, version and info for the
+     * object, and store it in the persistent area.
      */
+    g_obj_tbl_info.size = g_ps_object.header.info.current_size;
+    g_obj_tbl_info.flags = g_ps_object.header.info.create_flags;
     err = ps_object_table_set_obj_tbl_info(uid, client_id, &g_obj_tbl_info);
     if (err != PSA_SUCCESS) {
         /* Remove new object as object table is not persistent and propagate
@@ -338,7 +494,86 @@ psa_status_t ps_object_create(psa_storage_uid_t uid, int32_t client_id,
 clear_data_and_return:
     /* Remove data stored in the object before leaving the function */
     (void)tfm_memset(&g_ps_object, PS_DEFAULT_EMPTY_BUFF_VAL,
-                     PS_MAX_OBJECT_SIZE);
+                     sizeof(g_ps_object));
+
+    return err;
+}
+
+psa_status_t ps_object_reserve(psa_storage_uid_t uid, int32_t client_id,
+                               psa_storage_create_flags_t create_flags,
+                               uint32_t capacity)
+{
+    psa_status_t err;
+
+#ifndef PS_ENCRYPTION
+    uint32_t wrt_size;
+#endif
+
+    /* Boundary check the incoming request */
+    if (capacity > PS_MAX_ASSET_SIZE) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    /* The object must not exist already */
+    err = ps_object_table_get_obj_tbl_info(uid, client_id, &g_obj_tbl_info);
+    if (err == PSA_SUCCESS) {
+        return PSA_ERROR_ALREADY_EXISTS;
+    } else if (err != PSA_ERROR_DOES_NOT_EXIST) {
+        return err;
+    }
+
+    /* The object is created empty, but its capacity must fit in the quota */
+    err = ps_check_quota(client_id, 0, capacity);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    /* Initialize the object with the given capacity and empty content */
+    ps_init_empty_object(create_flags, capacity, &g_ps_object);
+
+    /* Get new file ID. Requests 2 FIDs to prevent exhaustion. */
+    err = ps_object_table_get_free_fid(2, &g_obj_tbl_info.fid);
+    if (err != PSA_SUCCESS) {
+        goto clear_data_and_return;
+    }
+
+#ifdef PS_ENCRYPTION
+    g_ps_object.header.crypto.ref.uid = uid;
+    g_ps_object.header.crypto.ref.client_id = client_id;
+
+    /* Write the object without any chunks of data */
+    err = ps_encrypted_object_write(g_obj_tbl_info.fid, &g_ps_object,
+                                    PS_INVALID_FID, 0, 0);
+#else
+    wrt_size = PS_OBJECT_SIZE(g_ps_object.header.info.current_size);
+
+    /* Write g_ps_object */
+    err = ps_write_object(wrt_size);
+#endif
+    if (err != PSA_SUCCESS) {
+        goto clear_data_and_return;
+    }
+
+    /* Add the object to the table and store it in the persistent area */
+    g_obj_tbl_info.size = g_ps_object.header.info.current_size;
+    g_obj_tbl_info.flags = g_ps_object.header.info.create_flags;
+    err = ps_object_table_set_obj_tbl_info(uid, client_id, &g_obj_tbl_info);
+    if (err != PSA_SUCCESS) {
+        /* Remove new object as object table is not persistent and propagate
+         * object table manipulation error.
+         */
+        (void)psa_its_remove(g_obj_tbl_info.fid);
+
+        goto clear_data_and_return;
+    }
+
+    /* Delete old object table from the persistent area */
+    err = ps_object_table_delete_old_table();
+
+clear_data_and_return:
+    /* Remove data stored in the object before leaving the function */
+    (void)tfm_memset(&g_ps_object, PS_DEFAULT_EMPTY_BUFF_VAL,
+                     sizeof(g_ps_object));
 
     return err;
 }
@@ -361,12 +596,16 @@ psa_status_t ps_object_write(psa_storage_uid_t uid, int32_t client_id,
         return err;
     }
 
+#ifdef PS_OBJECT_CACHE
+    ps_object_cache_invalidate(uid, client_id);
+#endif
+
     /* Read the object */
 #ifdef PS_ENCRYPTION
     g_ps_object.header.crypto.ref.uid = uid;
     g_ps_object.header.crypto.ref.client_id = client_id;
 
-    err = ps_encrypted_object_read(g_obj_tbl_info.fid, &g_ps_object);
+    err = ps_encrypted_object_read_header(g_obj_tbl_info.fid, &g_ps_object);
 #else
     err = ps_read_object(READ_ALL_OBJECT);
 #endif
@@ -395,6 +634,14 @@ psa_status_t ps_object_write(psa_storage_uid_t uid, int32_t client_id,
         goto clear_data_and_return;
     }
 
+    err = ps_check_quota(client_id, g_ps_object.header.info.current_size,
+                         PS_UTILS_MAX(g_ps_object.header.info.current_size,
+                                      offset + size));
+    if (err != PSA_SUCCESS) {
+        goto clear_data_and_return;
+    }
+
+#ifndef PS_ENCRYPTION
     /* Update the object data */
     err = ps_req_mngr_read_asset_data(g_ps_object.data + offset, size);
     if (err != PSA_SUCCESS) {
@@ -405,6 +652,7 @@ psa_status_t ps_object_write(psa_storage_uid_t uid, int32_t client_id,
     if ((offset + size) > g_ps_object.header.info.current_size) {
         g_ps_object.header.info.current_size = offset + size;
     }
+#endif
 
     /* Save old file ID */
     old_fid = g_obj_tbl_info.fid;
@@ -419,7 +667,11 @@ psa_status_t ps_object_write(psa_storage_uid_t uid, int32_t client_id,
     g_ps_object.header.crypto.ref.uid = uid;
     g_ps_object.header.crypto.ref.client_id = client_id;
 
-    err = ps_encrypted_object_write(g_obj_tbl_info.fid, &g_ps_object);
+    /* Encrypt the object data while it is read from the client, keeping the
+     * data of the old object outside of the written range.
+     */
+    err = ps_encrypted_object_write(g_obj_tbl_info.fid, &g_ps_object,
+                                    old_fid, offset, size);
 #else
     wrt_size = PS_OBJECT_SIZE(g_ps_object.header.info.current_size);
 
@@ -430,9 +682,11 @@ psa_status_t ps_object_write(psa_storage_uid_t uid, int32_t client_id,
         goto clear_data_and_return;
     }
 
-    /* Update the table with the new internal ID and version for the object, and
-     * store it in the persistent area.
+    /* Update the table with the new internal ID, version and info for the
+     * object, and store it in the persistent area.
      */
+    g_obj_tbl_info.size = g_ps_object.header.info.current_size;
+    g_obj_tbl_info.flags = g_ps_object.header.info.create_flags;
     err = ps_object_table_set_obj_tbl_info(uid, client_id, &g_obj_tbl_info);
     if (err != PSA_SUCCESS) {
         /* Remove new object as object table is not persistent and propagate
@@ -449,7 +703,7 @@ psa_status_t ps_object_write(psa_storage_uid_t uid, int32_t client_id,
 clear_data_and_return:
     /* Remove data stored in the object before leaving the function */
     (void)tfm_memset(&g_ps_object, PS_DEFAULT_EMPTY_BUFF_VAL,
-                     PS_MAX_OBJECT_SIZE);
+                     sizeof(g_ps_object));
 
     return err;
 }
@@ -458,6 +712,9 @@ psa_status_t ps_object_get_info(psa_storage_uid_t uid, int32_t client_id,
                                 struct psa_storage_info_t *info)
 {
     psa_status_t err;
+#ifdef PS_OBJECT_CACHE
+    const struct ps_object_cache_entry_t *cached;
+#endif
 
     /* Retrieve the object information from the object table if the object
      * exists.
@@ -467,11 +724,20 @@ psa_status_t ps_object_get_info(psa_storage_uid_t uid, int32_t client_id,
         return err;
     }
 
+#ifdef PS_OBJECT_CACHE
+    cached = ps_object_cache_get(uid, client_id, &g_obj_tbl_info);
+    if (cached != NULL) {
+        info->size = cached->info.current_size;
+        info->flags = cached->info.create_flags;
+        return PSA_SUCCESS;
+    }
+#endif
+
 #ifdef PS_ENCRYPTION
     g_ps_object.header.crypto.ref.uid = uid;
     g_ps_object.header.crypto.ref.client_id = client_id;
 
-    err = ps_encrypted_object_read(g_obj_tbl_info.fid, &g_ps_object);
+    err = ps_encrypted_object_read_header(g_obj_tbl_info.fid, &g_ps_object);
 #else
     err = ps_read_object(READ_HEADER_ONLY);
 #endif
@@ -486,11 +752,96 @@ psa_status_t ps_object_get_info(psa_storage_uid_t uid, int32_t client_id,
 clear_data_and_return:
     /* Remove data stored in the object before leaving the function */
     (void)tfm_memset(&g_ps_object, PS_DEFAULT_EMPTY_BUFF_VAL,
-                     PS_MAX_OBJECT_SIZE);
+                     sizeof(g_ps_object));
 
     return err;
 }
 
+psa_status_t ps_object_list(int32_t client_id, psa_storage_uid_t after_uid,
+                            size_t num_entries, size_t *p_num_entries)
+{
+    psa_status_t err;
+    struct psa_storage_uid_info_t batch[PS_LIST_BATCH_ENTRIES];
+    size_t batch_size;
+    size_t batch_num;
+
+    *p_num_entries = 0;
+
+    /* Write the entries to the client in batches, each one starting after the
+     * last UID of the previous batch.
+     */
+    while (*p_num_entries < num_entries) {
+        batch_size = PS_UTILS_MIN(num_entries - *p_num_entries,
+                                  PS_LIST_BATCH_ENTRIES);
+
+        err = ps_object_table_list(client_id, after_uid, batch, batch_size,
+                                   &batch_num);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        if (batch_num > 0) {
+            ps_req_mngr_write_asset_data((const uint8_t *)batch,
+                                         batch_num * sizeof(batch[0]));
+            *p_num_entries += batch_num;
+            after_uid = batch[batch_num - 1].uid;
+        }
+
+        if (batch_num < batch_size) {
+            break;
+        }
+    }
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_object_get_capacity(int32_t client_id,
+                                    struct psa_storage_capacity_t *p_capacity)
+{
+    psa_status_t err;
+    struct psa_storage_capacity_t fs_capacity;
+    size_t free_size;
+#if (PS_CLIENT_QUOTA > 0)
+    size_t quota;
+#endif
+
+    ps_object_table_get_usage(client_id, &p_capacity->num_assets,
+                              &p_capacity->size);
+    p_capacity->quota = PS_CLIENT_QUOTA;
+
+    /* Get the free space of the filesystem that holds the objects */
+    err = psa_its_get_capacity(&fs_capacity);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    p_capacity->free_assets = PS_UTILS_MIN(ps_object_table_num_free_objects(),
+                                           fs_capacity.free_assets);
+
+    /* Estimate the largest object data that fits in the largest free file,
+     * from the overhead of an object of the maximum size.
+     */
+    free_size = fs_capacity.free_size;
+    if ((p_capacity->free_assets == 0) ||
+        (free_size < PS_MAX_OBJECT_SIZE - PS_MAX_ASSET_SIZE)) {
+        free_size = 0;
+    } else {
+        free_size = PS_UTILS_MIN(free_size - (PS_MAX_OBJECT_SIZE -
+                                              PS_MAX_ASSET_SIZE),
+                                 PS_MAX_ASSET_SIZE);
+    }
+
+#if (PS_CLIENT_QUOTA > 0)
+    quota = (PS_CLIENT_QUOTA > p_capacity->size) ?
+            (PS_CLIENT_QUOTA - p_capacity->size) : 0;
+    free_size = PS_UTILS_MIN(free_size, quota);
+#endif
+
+    p_capacity->free_size = free_size;
+
+    return PSA_SUCCESS;
+}
+
 psa_status_t ps_object_delete(psa_storage_uid_t uid, int32_t client_id)
 {
     psa_status_t err;
@@ -503,11 +854,15 @@ psa_status_t ps_object_delete(psa_storage_uid_t uid, int32_t client_id)
         return err;
     }
 
+#ifdef PS_OBJECT_CACHE
+    ps_object_cache_invalidate(uid, client_id);
+#endif
+
 #ifdef PS_ENCRYPTION
     g_ps_object.header.crypto.ref.uid = uid;
     g_ps_object.header.crypto.ref.client_id = client_id;
 
-    err = ps_encrypted_object_read(g_obj_tbl_info.fid, &g_ps_object);
+    err = ps_encrypted_object_read_header(g_obj_tbl_info.fid, &g_ps_object);
 #else
     err = ps_read_object(READ_HEADER_ONLY);
 #endif
@@ -535,7 +890,7 @@ psa_status_t ps_object_delete(psa_storage_uid_t uid, int32_t client_id)
 clear_data_and_return:
     /* Remove data stored in the object before leaving the function */
     (void)tfm_memset(&g_ps_object, PS_DEFAULT_EMPTY_BUFF_VAL,
-                     PS_MAX_OBJECT_SIZE);
+                     sizeof(g_ps_object));
 
     return err;
 }
@@ -549,5 +904,14 @@ psa_status_t ps_system_wipe_all(void)
      * this function doesn't block on the lock and directly
      * moves to erasing the flash instead.
      */
+#ifdef PS_OBJECT_CACHE
+    ps_object_cache_clear();
+#endif
+
     return ps_object_table_create();
 }
+
+psa_status_t ps_system_flush(void)
+{
+    return ps_object_table_flush();
+}
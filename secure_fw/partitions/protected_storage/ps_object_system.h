@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2017-2020, Arm Limited. All rights reserved.
+ * Copyright (c) 2017-2022, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -8,6 +8,7 @@
 #ifndef __PS_OBJECT_SYSTEM_H__
 #define __PS_OBJECT_SYSTEM_H__
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include "psa/protected_storage.h"
@@ -39,6 +40,21 @@ psa_status_t ps_object_create(psa_storage_uid_t uid, int32_t client_id,
                               psa_storage_create_flags_t create_flags,
                               uint32_t size);
 
+/**
+ * \brief Creates a new object with the provided UID and client ID, with the
+ *        given capacity and no data.
+ *
+ * \param[in] uid           Unique identifier for the data
+ * \param[in] client_id     Identifier of the asset's owner (client)
+ * \param[in] create_flags  Flags indicating the properties of the data
+ * \param[in] capacity      Maximum size of the object data in bytes
+ *
+ * \return Returns error code specified in \ref psa_status_t
+ */
+psa_status_t ps_object_reserve(psa_storage_uid_t uid, int32_t client_id,
+                               psa_storage_create_flags_t create_flags,
+                               uint32_t capacity);
+
 /**
  * \brief Gets the data of the object with the provided UID and client ID.
  *
@@ -92,6 +108,33 @@ psa_status_t ps_object_delete(psa_storage_uid_t uid, int32_t client_id);
 psa_status_t ps_object_get_info(psa_storage_uid_t uid, int32_t client_id,
                                 struct psa_storage_info_t *info);
 
+/**
+ * \brief Writes the UID, size and flags of the client's objects with a UID
+ *        greater than after_uid to the client, in ascending order of UID.
+ *
+ * \param[in]  client_id      Identifier of the assets' owner (client)
+ * \param[in]  after_uid      UID after which to start listing
+ * \param[in]  num_entries    Maximum number of objects to list
+ * \param[out] p_num_entries  Pointer to the location to store the number of
+ *                            listed objects
+ *
+ * \return Returns error code specified in \ref psa_status_t
+ */
+psa_status_t ps_object_list(int32_t client_id, psa_storage_uid_t after_uid,
+                            size_t num_entries, size_t *p_num_entries);
+
+/**
+ * \brief Gets the storage usage of the client and the free storage.
+ *
+ * \param[in]  client_id   Identifier of the assets' owner (client)
+ * \param[out] p_capacity  Pointer to the `psa_storage_capacity_t` struct that
+ *                         will be populated with the usage and free storage
+ *
+ * \return Returns error code specified in \ref psa_status_t
+ */
+psa_status_t ps_object_get_capacity(int32_t client_id,
+                                    struct psa_storage_capacity_t *p_capacity);
+
 /**
  * \brief Wipes the protected storage system and all object data.
  *
@@ -99,6 +142,13 @@ psa_status_t ps_object_get_info(psa_storage_uid_t uid, int32_t client_id,
  */
 psa_status_t ps_system_wipe_all(void);
 
+/**
+ * \brief Commits the object system updates which are not persistent yet.
+ *
+ * \return Returns error code specified in \ref psa_status_t
+ */
+psa_status_t ps_system_flush(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2018-2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2018-2022, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -7,6 +7,7 @@
 
 #include "ps_object_table.h"
 
+#include <stdbool.h>
 #include <stddef.h>
 
 #include "cmsis_compiler.h"
@@ -14,6 +15,7 @@
 #include "nv_counters/ps_nv_counters.h"
 #include "psa/internal_trusted_storage.h"
 #include "tfm_memory_utils.h"
+#include "ps_object_defs.h"
 #include "ps_utils.h"
 #include "tfm_ps_defs.h"
 
@@ -25,7 +27,7 @@
  *
  * \brief Current object system version.
  */
-#define PS_OBJECT_SYSTEM_VERSION  0x01
+#define PS_OBJECT_SYSTEM_VERSION  0x03
 
 /*!
  * \struct ps_obj_table_info_t
@@ -40,20 +42,40 @@ struct ps_obj_table_entry_t {
 #endif
     psa_storage_uid_t uid;          /*!< Object UID */
     int32_t client_id;              /*!< Client ID */
+    uint32_t size;                  /*!< Current size of the object data */
+    uint32_t flags;                 /*!< Object creation flags */
 };
 
-/* Specifies number of entries in the table. The number of entries is the
- * number of assets, defined in asset_defs.h, plus one extra entry to store
- * a new object when the code processes a change in a file.
- */
-#define PS_OBJ_TABLE_ENTRIES (PS_NUM_ASSETS + 1)
+/* Number of entries in the table, rounded up to a whole number of pages */
+#define PS_OBJ_TABLE_PAGED_ENTRIES (PS_OBJ_TABLE_PAGES * \
+                                    PS_OBJ_TABLE_PAGE_ENTRIES)
+
+/* Size of a bitmap with one bit per object table page */
+#define PS_OBJ_TABLE_PAGE_BITMAP_SIZE ((PS_OBJ_TABLE_PAGES + 7) / 8)
+
+#ifdef PS_WRITE_BACK
+/* Size of a bitmap with one bit per object table entry */
+#define PS_OBJ_TABLE_ENTRY_BITMAP_SIZE ((PS_OBJ_TABLE_ENTRIES + 7) / 8)
+#endif
+
+/* Number of clients whose storage usage is cached */
+#define PS_USAGE_CACHE_CLIENTS 8
+
+#define PS_OBJ_TABLE_BIT_TEST(map, n) (((map)[(n) / 8] >> ((n) % 8)) & 1U)
+#define PS_OBJ_TABLE_BIT_SET(map, n)  ((map)[(n) / 8] |= (1U << ((n) % 8)))
+#define PS_OBJ_TABLE_BIT_FLIP(map, n) ((map)[(n) / 8] ^= (1U << ((n) % 8)))
 
 /*!
- * \struct ps_obj_table_t
+ * \struct ps_obj_table_header_t
  *
- * \brief Object table structure.
+ * \brief Object table header structure.
+ *
+ * \note The table entries are stored in pages, each one in its own file. A page
+ *       has two files and is updated by writing the file that is not used by
+ *       the current header, so the pages in use only change when the new
+ *       header is written.
  */
-struct ps_obj_table_t {
+struct ps_obj_table_header_t {
 #ifdef PS_ENCRYPTION
   union ps_crypto_t crypto;      /*!< Crypto metadata. */
 #endif
@@ -66,9 +88,28 @@ struct ps_obj_table_t {
                                   */
 #endif /* PS_ROLLBACK_PROTECTION */
 
-  struct ps_obj_table_entry_t obj_db[PS_OBJ_TABLE_ENTRIES]; /*!< Table's
-                                                             *   entries
-                                                             */
+  uint8_t page_slot[PS_OBJ_TABLE_PAGE_BITMAP_SIZE]; /*!< File used by each
+                                                     *   table page
+                                                     */
+
+#ifdef PS_ENCRYPTION
+  uint8_t root[PS_HASH_LEN_BYTES]; /*!< Root of the Merkle tree of the table
+                                    *   pages
+                                    */
+#endif
+};
+
+/*!
+ * \struct ps_obj_table_t
+ *
+ * \brief Object table structure.
+ */
+struct ps_obj_table_t {
+  struct ps_obj_table_header_t header; /*!< Table's header */
+
+  struct ps_obj_table_entry_t obj_db[PS_OBJ_TABLE_PAGED_ENTRIES]; /*!< Table's
+                                                                   *   entries
+                                                                   */
 };
 
 static uint8_t ps_table_key_label[] = "table_key_label";
@@ -83,7 +124,7 @@ static uint8_t ps_table_key_label[] = "table_key_label";
 /*!
  * \def PS_TABLE_FS_ID
  *
- * \brief File ID to be used in order to store the object table in the
+ * \brief File ID to be used in order to store the object table header in the
  *        file system.
  *
  * \param[in] idx  Table index to convert into a file ID.
@@ -118,26 +159,129 @@ static uint8_t ps_table_key_label[] = "table_key_label";
 #define PS_OBJECT_FS_ID_TO_IDX(fid) ((fid - 1) - \
                                       PS_TABLE_FS_ID(PS_OBJ_TABLE_IDX_1))
 
+/*!
+ * \def PS_TABLE_PAGE_FS_ID
+ *
+ * \brief File ID to be used in order to store an object table page in the
+ *        file system.
+ *
+ * \param[in] page  Page index
+ * \param[in] slot  Page file to use, 0 or 1
+ *
+ * \return Returns file ID
+ */
+#define PS_TABLE_PAGE_FS_ID(page, slot) \
+    (PS_OBJECT_FS_ID(PS_OBJ_TABLE_ENTRIES) + ((page) * 2) + (slot))
+
+/* Number of hash chains in the object table index */
+#define PS_OBJ_TABLE_HASH_BUCKETS PS_OBJ_TABLE_ENTRIES
+
+/* Marks the end of an object table index list */
+#define PS_OBJ_TABLE_ENTRY_NONE 0xFFFFU
+
+#if (PS_OBJ_TABLE_ENTRIES >= PS_OBJ_TABLE_ENTRY_NONE)
+#error "PS_NUM_ASSETS is too large for the object table index"
+#endif
+
+#if (PS_OBJ_TABLE_PAGE_ENTRIES == 0)
+#error "PS_OBJ_TABLE_PAGE_ENTRIES must not be 0"
+#endif
+
+#ifdef PS_ENCRYPTION
+/* Number of nodes in the Merkle tree of the table pages. The nodes are stored
+ * as a binary heap: node 1 is the root, the children of node i are nodes 2i
+ * and 2i + 1, and the leaf of page p is node PS_OBJ_TABLE_PAGES + p. Node 0 is
+ * not used.
+ */
+#define PS_OBJ_TABLE_MERKLE_NODES (2 * PS_OBJ_TABLE_PAGES)
+
+/* Merkle tree root node */
+#define PS_OBJ_TABLE_MERKLE_ROOT 1
+
+/* Domain separation prefixes of the leaf and inner node hashes */
+#define PS_OBJ_TABLE_MERKLE_LEAF  0x00U
+#define PS_OBJ_TABLE_MERKLE_INNER 0x01U
+#endif /* PS_ENCRYPTION */
+
+/*!
+ * \struct ps_client_usage_t
+ *
+ * \brief Storage usage of a client.
+ */
+struct ps_client_usage_t {
+    int32_t client_id;   /*!< Client ID, or zero if the entry is free */
+    size_t num_objects;  /*!< Number of objects owned by the client */
+    size_t size;         /*!< Sum of the sizes of the client's objects */
+};
+
 /*!
  * \struct ps_obj_table_ctx_t
  *
  * \brief Object table context structure.
+ *
+ * \note The index is kept in RAM only and rebuilt from the object table when
+ *       the table is loaded. Each table entry is linked either in the hash
+ *       chain of its UID and client ID, or in the list of free entries.
+ *
+ * \note With PS_WRITE_BACK, the entries released by updates that are not
+ *       committed yet stay in the list of free entries, but are not allocated
+ *       until the table is committed, as the committed table still uses their
+ *       files.
+ *
+ * \note The usage of a client is counted from the table the first time it is
+ *       queried, and then kept up to date by the index as entries are added
+ *       and removed.
  */
 struct ps_obj_table_ctx_t {
     struct ps_obj_table_t obj_table;  /*!< Object tables */
     uint8_t active_table;             /*!< Active object table */
     uint8_t scratch_table;            /*!< Scratch object table */
+    uint16_t num_free;                /*!< Number of free table entries */
+    uint16_t free_head;               /*!< First free table entry */
+    uint16_t hash_head[PS_OBJ_TABLE_HASH_BUCKETS]; /*!< First table entry of
+                                                    *   each hash chain
+                                                    */
+    uint16_t next[PS_OBJ_TABLE_ENTRIES]; /*!< Next table entry in the same
+                                          *   hash chain or free list
+                                          */
+    uint8_t dirty[PS_OBJ_TABLE_PAGE_BITMAP_SIZE]; /*!< Pages modified since
+                                                   *   the table was last
+                                                   *   saved
+                                                   */
+#ifdef PS_ENCRYPTION
+    uint8_t merkle[PS_OBJ_TABLE_MERKLE_NODES][PS_HASH_LEN_BYTES]; /*!< Merkle
+                                                                   *   tree
+                                                                   */
+#endif
+    struct ps_client_usage_t usage[PS_USAGE_CACHE_CLIENTS]; /*!< Usage of
+                                                             *   the clients
+                                                             *   last queried
+                                                             */
+    uint32_t usage_next;              /*!< Next usage entry to replace */
+#ifdef PS_WRITE_BACK
+    uint32_t num_pending;             /*!< Number of updates not committed
+                                       *   yet
+                                       */
+    uint8_t released[PS_OBJ_TABLE_ENTRY_BITMAP_SIZE]; /*!< Entries released
+                                                       *   by updates not
+                                                       *   committed yet
+                                                       */
+#endif
 };
 
 /* Object table context */
 static struct ps_obj_table_ctx_t ps_obj_table_ctx;
 
-/* Object table size */
-#define PS_OBJ_TABLE_SIZE            sizeof(struct ps_obj_table_t)
+/* Object table header size */
+#define PS_OBJ_TABLE_HEADER_SIZE     sizeof(struct ps_obj_table_header_t)
 
 /* Object table entry size */
 #define PS_OBJECTS_TABLE_ENTRY_SIZE  sizeof(struct ps_obj_table_entry_t)
 
+/* Object table page size */
+#define PS_OBJ_TABLE_PAGE_SIZE       (PS_OBJ_TABLE_PAGE_ENTRIES * \
+                                      PS_OBJECTS_TABLE_ENTRY_SIZE)
+
 /* Size of the data that is not required to authenticate */
 #define PS_NON_AUTH_OBJ_TABLE_SIZE   sizeof(union ps_crypto_t)
 
@@ -149,7 +293,7 @@ static struct ps_obj_table_ctx_t ps_obj_table_ctx;
                                             PS_NON_AUTH_OBJ_TABLE_SIZE)
 
 #ifdef PS_ROLLBACK_PROTECTION
-#define PS_OBJ_TABLE_AUTH_DATA_SIZE (PS_OBJ_TABLE_SIZE - \
+#define PS_OBJ_TABLE_AUTH_DATA_SIZE (PS_OBJ_TABLE_HEADER_SIZE - \
                                      PS_NON_AUTH_OBJ_TABLE_SIZE)
 
 struct ps_crypto_assoc_data_t {
@@ -162,21 +306,25 @@ struct ps_crypto_assoc_data_t {
 #else
 
 /* The associated data is the header, minus the the tag data */
-#define PS_CRYPTO_ASSOCIATED_DATA_LEN (PS_OBJ_TABLE_SIZE - \
+#define PS_CRYPTO_ASSOCIATED_DATA_LEN (PS_OBJ_TABLE_HEADER_SIZE - \
                                        PS_NON_AUTH_OBJ_TABLE_SIZE)
 #endif /* PS_ROLLBACK_PROTECTION */
 
 /* The ps_object_table_init function uses the static memory allocated for
  * the object data manipulation, in ps_object_table.c (g_ps_object), to load a
- * temporary object table to be validated at that stage.
- * To make sure the object table data fits in the static memory allocated for
- * object manipulation, the following macro checks if the memory allocated is
- * big enough, at compile time
+ * temporary object table header to be validated at that stage.
+ * To make sure the object table header fits in the static memory allocated
+ * for object manipulation, the following macro checks if the memory allocated
+ * is big enough, at compile time
  */
 
 /* Check at compilation time if metadata fits in g_ps_object.data */
 PS_UTILS_BOUND_CHECK(OBJ_TABLE_NOT_FIT_IN_STATIC_OBJ_DATA_BUF,
-                     PS_OBJ_TABLE_SIZE, PS_MAX_ASSET_SIZE);
+                     PS_OBJ_TABLE_HEADER_SIZE, PS_MAX_OBJECT_DATA_SIZE);
+
+/* Check at compilation time if a table page fits in a file system object */
+PS_UTILS_BOUND_CHECK(OBJ_TABLE_PAGE_NOT_FIT_IN_FS_OBJECT,
+                     PS_OBJ_TABLE_PAGE_SIZE, PS_MAX_OBJECT_SIZE);
 
 enum ps_obj_table_state {
     PS_OBJ_TABLE_VALID = 0,   /*!< Table content is valid */
@@ -194,9 +342,10 @@ enum ps_obj_table_state {
  * \brief Object table init context structure.
  */
 struct ps_obj_table_init_ctx_t {
-    struct ps_obj_table_t *p_table[PS_NUM_OBJ_TABLES]; /*!< Pointers to
-                                                        *   object tables
-                                                        */
+    struct ps_obj_table_header_t *p_table[PS_NUM_OBJ_TABLES]; /*!< Pointers to
+                                                               *   object table
+                                                               *   headers
+                                                               */
     enum ps_obj_table_state table_state[PS_NUM_OBJ_TABLES]; /*!< Array to
                                                              *   indicate if
                                                              *   the object
@@ -210,7 +359,7 @@ struct ps_obj_table_init_ctx_t {
 };
 
 /**
- * \brief Reads object table from persistent memory.
+ * \brief Reads object table headers from persistent memory.
  *
  * \param[out] init_ctx  Pointer to the init object table context
  *
@@ -222,48 +371,112 @@ __STATIC_INLINE void ps_object_table_fs_read_table(
     psa_status_t err;
     size_t data_length;
 
-    /* Read file with the table 0 data */
+    /* Read file with the table 0 header */
 
     err = psa_its_get(PS_TABLE_FS_ID(PS_OBJ_TABLE_IDX_0),
                       PS_OBJECT_TABLE_OBJECT_OFFSET,
-                      PS_OBJ_TABLE_SIZE,
+                      PS_OBJ_TABLE_HEADER_SIZE,
                       (void *)init_ctx->p_table[PS_OBJ_TABLE_IDX_0],
                       &data_length);
-    if (err != PSA_SUCCESS) {
+    if (err != PSA_SUCCESS || data_length != PS_OBJ_TABLE_HEADER_SIZE) {
         init_ctx->table_state[PS_OBJ_TABLE_IDX_0] = PS_OBJ_TABLE_INVALID;
     }
 
-    /* Read file with the table 1 data */
+    /* Read file with the table 1 header */
     err = psa_its_get(PS_TABLE_FS_ID(PS_OBJ_TABLE_IDX_1),
                       PS_OBJECT_TABLE_OBJECT_OFFSET,
-                      PS_OBJ_TABLE_SIZE,
+                      PS_OBJ_TABLE_HEADER_SIZE,
                       (void *)init_ctx->p_table[PS_OBJ_TABLE_IDX_1],
                       &data_length);
-    if (err != PSA_SUCCESS) {
+    if (err != PSA_SUCCESS || data_length != PS_OBJ_TABLE_HEADER_SIZE) {
         init_ctx->table_state[PS_OBJ_TABLE_IDX_1] = PS_OBJ_TABLE_INVALID;
     }
 }
 
 /**
- * \brief Writes object table in persistent memory.
+ * \brief Reads the pages of the active object table from persistent memory.
  *
- * \param[in,out] obj_table  Pointer to the object table to generate
- *                           authentication
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_object_table_fs_read_pages(void)
+{
+    struct ps_obj_table_t *p_table = &ps_obj_table_ctx.obj_table;
+    psa_status_t err;
+    size_t data_length;
+    uint32_t page;
+    uint32_t slot;
+
+    for (page = 0; page < PS_OBJ_TABLE_PAGES; page++) {
+        slot = PS_OBJ_TABLE_BIT_TEST(p_table->header.page_slot, page);
+
+        err = psa_its_get(PS_TABLE_PAGE_FS_ID(page, slot),
+                          PS_OBJECT_TABLE_OBJECT_OFFSET,
+                          PS_OBJ_TABLE_PAGE_SIZE,
+                          (void *)&p_table->obj_db[page *
+                                                  PS_OBJ_TABLE_PAGE_ENTRIES],
+                          &data_length);
+        if (err != PSA_SUCCESS || data_length != PS_OBJ_TABLE_PAGE_SIZE) {
+            return PSA_ERROR_GENERIC_ERROR;
+        }
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Writes the modified object table pages in persistent memory, to the
+ *        page files used by the given object table header.
+ *
+ * \param[in] obj_table  Pointer to the object table to save
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_object_table_fs_write_pages(
+                                        const struct ps_obj_table_t *obj_table)
+{
+    psa_status_t err;
+    uint32_t page;
+    uint32_t slot;
+
+    for (page = 0; page < PS_OBJ_TABLE_PAGES; page++) {
+        if (!PS_OBJ_TABLE_BIT_TEST(ps_obj_table_ctx.dirty, page)) {
+            continue;
+        }
+
+        slot = PS_OBJ_TABLE_BIT_TEST(obj_table->header.page_slot, page);
+
+        err = psa_its_set(PS_TABLE_PAGE_FS_ID(page, slot),
+                          PS_OBJ_TABLE_PAGE_SIZE,
+                          (const void *)&obj_table->obj_db[page *
+                                                    PS_OBJ_TABLE_PAGE_ENTRIES],
+                          PSA_STORAGE_FLAG_NONE);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Writes object table header in persistent memory.
+ *
+ * \param[in] header  Pointer to the object table header to write
  *
  * \return Returns error code as specified in \ref psa_status_t
  */
 __attribute__ ((always_inline))
 __STATIC_INLINE psa_status_t ps_object_table_fs_write_table(
-                                              struct ps_obj_table_t *obj_table)
+                                   const struct ps_obj_table_header_t *header)
 {
     psa_status_t err;
     uint32_t obj_table_id = PS_TABLE_FS_ID(ps_obj_table_ctx.scratch_table);
     uint8_t swap_table_idxs = ps_obj_table_ctx.scratch_table;
 
-    /* Create file to store object table in the FS */
+    /* Create file to store object table header in the FS */
     err = psa_its_set(obj_table_id,
-                      PS_OBJ_TABLE_SIZE,
-                      (const void *)obj_table,
+                      PS_OBJ_TABLE_HEADER_SIZE,
+                      (const void *)header,
                       PSA_STORAGE_FLAG_NONE);
 
     if (err != PSA_SUCCESS) {
@@ -277,6 +490,92 @@ __STATIC_INLINE psa_status_t ps_object_table_fs_write_table(
     return PSA_SUCCESS;
 }
 
+#ifdef PS_ENCRYPTION
+/**
+ * \brief Updates the Merkle tree of the object table pages.
+ *
+ * \param[in] all_pages  If true, the whole tree is computed. Otherwise, only
+ *                       the leaves of the modified pages and their paths to
+ *                       the root are.
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_object_table_merkle_update(bool all_pages)
+{
+    psa_status_t err;
+    uint32_t i;
+    uint8_t prefix;
+    uint8_t changed[(PS_OBJ_TABLE_MERKLE_NODES + 7) / 8] = {0};
+    uint8_t (*merkle)[PS_HASH_LEN_BYTES] = ps_obj_table_ctx.merkle;
+    const struct ps_obj_table_entry_t *obj_db =
+                                          ps_obj_table_ctx.obj_table.obj_db;
+
+    /* The leaves are the hashes of the page content */
+    prefix = PS_OBJ_TABLE_MERKLE_LEAF;
+    for (i = 0; i < PS_OBJ_TABLE_PAGES; i++) {
+        if (!all_pages && !PS_OBJ_TABLE_BIT_TEST(ps_obj_table_ctx.dirty, i)) {
+            continue;
+        }
+
+        err = ps_crypto_hash(&prefix, sizeof(prefix),
+                             (const uint8_t *)&obj_db[i *
+                                                   PS_OBJ_TABLE_PAGE_ENTRIES],
+                             PS_OBJ_TABLE_PAGE_SIZE,
+                             merkle[PS_OBJ_TABLE_PAGES + i]);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        PS_OBJ_TABLE_BIT_SET(changed, PS_OBJ_TABLE_PAGES + i);
+    }
+
+    /* The inner nodes are the hashes of their two children, which are adjacent
+     * and have higher node numbers, so are updated first.
+     */
+    prefix = PS_OBJ_TABLE_MERKLE_INNER;
+    for (i = PS_OBJ_TABLE_PAGES - 1; i >= PS_OBJ_TABLE_MERKLE_ROOT; i--) {
+        if (!PS_OBJ_TABLE_BIT_TEST(changed, 2 * i) &&
+            !PS_OBJ_TABLE_BIT_TEST(changed, (2 * i) + 1)) {
+            continue;
+        }
+
+        err = ps_crypto_hash(&prefix, sizeof(prefix), merkle[2 * i],
+                             2 * PS_HASH_LEN_BYTES, merkle[i]);
+        if (err != PSA_SUCCESS) {
+            return err;
+        }
+
+        PS_OBJ_TABLE_BIT_SET(changed, i);
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Checks the object table pages against the Merkle tree root in the
+ *        active table header.
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_object_table_merkle_verify(void)
+{
+    psa_status_t err;
+
+    err = ps_object_table_merkle_update(true);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    if (tfm_memcmp(ps_obj_table_ctx.merkle[PS_OBJ_TABLE_MERKLE_ROOT],
+                   ps_obj_table_ctx.obj_table.header.root,
+                   PS_HASH_LEN_BYTES) != 0) {
+        return PSA_ERROR_INVALID_SIGNATURE;
+    }
+
+    return PSA_SUCCESS;
+}
+#endif /* PS_ENCRYPTION */
+
 #ifdef PS_ENCRYPTION
 #ifdef PS_ROLLBACK_PROTECTION
 /**
@@ -323,19 +622,19 @@ static psa_status_t ps_object_table_align_nv_counters(uint32_t nvc_1)
 /**
  * \brief Generates table authentication tag.
  *
- * \param[in]     nvc_1      Value of PS non-volatile counter 1
- * \param[in,out] obj_table  Pointer to the object table to generate
- *                           authentication
+ * \param[in]     nvc_1   Value of PS non-volatile counter 1
+ * \param[in,out] header  Pointer to the object table header to generate
+ *                        authentication
  *
  * \return Returns error code as specified in \ref psa_status_t
  */
 __attribute__ ((always_inline))
 __STATIC_INLINE psa_status_t ps_object_table_nvc_generate_auth_tag(
-                                              uint32_t nvc_1,
-                                              struct ps_obj_table_t *obj_table)
+                                         uint32_t nvc_1,
+                                         struct ps_obj_table_header_t *header)
 {
     struct ps_crypto_assoc_data_t assoc_data;
-    union ps_crypto_t *crypto = &obj_table->crypto;
+    union ps_crypto_t *crypto = &header->crypto;
     psa_status_t err;
 
     /* Get new IV */
@@ -454,16 +753,16 @@ __STATIC_INLINE psa_status_t ps_object_table_nvc_authenticate(
 /**
  * \brief Generates table authentication
  *
- * \param[in,out] obj_table  Pointer to the object table to generate
- *                           authentication
+ * \param[in,out] header  Pointer to the object table header to generate
+ *                        authentication
  *
  * \return Returns error code as specified in \ref psa_status_t
  */
 __attribute__ ((always_inline))
 __STATIC_INLINE psa_status_t ps_object_table_generate_auth_tag(
-                                              struct ps_obj_table_t *obj_table)
+                                         struct ps_obj_table_header_t *header)
 {
-    union ps_crypto_t *crypto = &obj_table->crypto;
+    union ps_crypto_t *crypto = &header->crypto;
     psa_status_t err;
 
     /* Get new IV */
@@ -519,6 +818,9 @@ __STATIC_INLINE void ps_object_table_authenticate_ctx_tables(
 /**
  * \brief Saves object table in the persistent memory.
  *
+ * \note Only the pages modified since the table was last saved are written,
+ *       followed by the table header which makes them active.
+ *
  * \param[in,out] obj_table  Pointer to the object table to save
  *
  * \return Returns error code as specified in \ref psa_status_t
@@ -527,10 +829,19 @@ static psa_status_t ps_object_table_save_table(
                                               struct ps_obj_table_t *obj_table)
 {
     psa_status_t err;
-
+    uint32_t page;
+    struct ps_obj_table_header_t *header = &obj_table->header;
+    struct ps_obj_table_header_t old_header;
 #ifdef PS_ROLLBACK_PROTECTION
     uint32_t nvc_1 = 0;
+#endif
+
+    /* Keep a copy of the header of the active table, to restore it if the
+     * update fails.
+     */
+    (void)tfm_memcpy(&old_header, header, PS_OBJ_TABLE_HEADER_SIZE);
 
+#ifdef PS_ROLLBACK_PROTECTION
     err = ps_increment_nv_counter(TFM_PS_NV_COUNTER_1);
     if (err != PSA_SUCCESS) {
         return err;
@@ -541,58 +852,92 @@ static psa_status_t ps_object_table_save_table(
         return err;
     }
 #else
-    obj_table->swap_count++;
+    header->swap_count++;
 
-    if (obj_table->swap_count == PS_FLASH_DEFAULT_VAL) {
+    if (header->swap_count == PS_FLASH_DEFAULT_VAL) {
         /* When a flash block is erased, the default value is usually 0xFF
          * (i.e. all 1s). Since the swap count is updated last (when encryption
          * is disabled), it is possible that due to a power failure, the swap
          * count value in metadata header is 0xFFFF..., which mean it will
          * appear to be most recent block.
          */
-        obj_table->swap_count = 0;
+        header->swap_count = 0;
     }
 #endif /* PS_ROLLBACK_PROTECTION */
 
+    /* The modified pages are written to the page files which are not used by
+     * the active table header, so that they are only used once the new header
+     * is written.
+     */
+    for (page = 0; page < PS_OBJ_TABLE_PAGES; page++) {
+        if (PS_OBJ_TABLE_BIT_TEST(ps_obj_table_ctx.dirty, page)) {
+            PS_OBJ_TABLE_BIT_FLIP(header->page_slot, page);
+        }
+    }
+
 #ifdef PS_ENCRYPTION
+    /* Update the Merkle tree root, which binds the pages to the header */
+    err = ps_object_table_merkle_update(false);
+    if (err != PSA_SUCCESS) {
+        goto restore_header;
+    }
+
+    (void)tfm_memcpy(header->root,
+                     ps_obj_table_ctx.merkle[PS_OBJ_TABLE_MERKLE_ROOT],
+                     PS_HASH_LEN_BYTES);
+
     /* Set object table key */
     err = ps_crypto_setkey(ps_table_key_label, sizeof(ps_table_key_label));
     if (err != PSA_SUCCESS) {
-        return err;
+        goto restore_header;
     }
 
 #ifdef PS_ROLLBACK_PROTECTION
-    /* Generate authentication tag from the current table content and PS
+    /* Generate authentication tag from the current table header and PS
      * NV counter 1.
      */
-    err = ps_object_table_nvc_generate_auth_tag(nvc_1, obj_table);
+    err = ps_object_table_nvc_generate_auth_tag(nvc_1, header);
 #else
-    /* Generate authentication tag from the current table content */
-    err = ps_object_table_generate_auth_tag(obj_table);
+    /* Generate authentication tag from the current table header */
+    err = ps_object_table_generate_auth_tag(header);
 #endif /* PS_ROLLBACK_PROTECTION */
 
     if (err != PSA_SUCCESS) {
         (void)ps_crypto_destroykey();
-        return err;
+        goto restore_header;
     }
 
     err = ps_crypto_destroykey();
     if (err != PSA_SUCCESS) {
-        return err;
+        goto restore_header;
     }
 #endif /* PS_ENCRYPTION */
 
-    err = ps_object_table_fs_write_table(obj_table);
+    err = ps_object_table_fs_write_pages(obj_table);
+    if (err != PSA_SUCCESS) {
+        goto restore_header;
+    }
 
-#ifdef PS_ROLLBACK_PROTECTION
+    err = ps_object_table_fs_write_table(header);
     if (err != PSA_SUCCESS) {
-        return err;
+        goto restore_header;
     }
 
+    (void)tfm_memset(ps_obj_table_ctx.dirty, 0, sizeof(ps_obj_table_ctx.dirty));
+
+#ifdef PS_ROLLBACK_PROTECTION
     /* Align PS NV counters to have the same value */
     err = ps_object_table_align_nv_counters(nvc_1);
 #endif /* PS_ROLLBACK_PROTECTION */
 
+    return err;
+
+restore_header:
+    /* The active table header still uses the previous page files. The pages
+     * stay marked as modified, so they are written again by the next update.
+     */
+    (void)tfm_memcpy(header, &old_header, PS_OBJ_TABLE_HEADER_SIZE);
+
     return err;
 }
 
@@ -653,9 +998,9 @@ static psa_status_t ps_set_active_object_table(
           /* As table 1 is the active object, load the content into the
            * PS object table context.
            */
-          (void)tfm_memcpy(&ps_obj_table_ctx.obj_table,
+          (void)tfm_memcpy(&ps_obj_table_ctx.obj_table.header,
                            init_ctx->p_table[PS_OBJ_TABLE_IDX_1],
-                           PS_OBJ_TABLE_SIZE);
+                           PS_OBJ_TABLE_HEADER_SIZE);
 
           return PSA_SUCCESS;
     } else if (init_ctx->table_state[PS_OBJ_TABLE_IDX_1] ==
@@ -725,14 +1070,173 @@ static psa_status_t ps_set_active_object_table(
      * PS object table context.
      */
     if (ps_obj_table_ctx.active_table == PS_OBJ_TABLE_IDX_1) {
-        (void)tfm_memcpy(&ps_obj_table_ctx.obj_table,
+        (void)tfm_memcpy(&ps_obj_table_ctx.obj_table.header,
                          init_ctx->p_table[PS_OBJ_TABLE_IDX_1],
-                         PS_OBJ_TABLE_SIZE);
+                         PS_OBJ_TABLE_HEADER_SIZE);
     }
 
     return PSA_SUCCESS;
 }
 
+/**
+ * \brief Gets the hash chain of an object in the object table index.
+ *
+ * \param[in] uid        Identifier of the data
+ * \param[in] client_id  Client UID
+ *
+ * \return Returns the hash chain index
+ */
+static uint32_t ps_table_hash(psa_storage_uid_t uid, int32_t client_id)
+{
+    uint32_t hash = (uint32_t)uid ^ (uint32_t)(uid >> 32);
+
+    hash ^= (uint32_t)client_id * 0x9E3779B1U;
+    hash ^= hash >> 16;
+
+    return hash % PS_OBJ_TABLE_HASH_BUCKETS;
+}
+
+/**
+ * \brief Gets the head of the index list that holds a table entry, based on
+ *        the current content of the entry.
+ *
+ * \param[in] idx  Entry index
+ *
+ * \return Returns a pointer to the head of the list
+ */
+static uint16_t *ps_table_index_list(uint32_t idx)
+{
+    struct ps_obj_table_entry_t *entry =
+                                        &ps_obj_table_ctx.obj_table.obj_db[idx];
+
+    if (entry->uid == TFM_PS_INVALID_UID) {
+        return &ps_obj_table_ctx.free_head;
+    }
+
+    return &ps_obj_table_ctx.hash_head[ps_table_hash(entry->uid,
+                                                     entry->client_id)];
+}
+
+/**
+ * \brief Updates the cached usage of the owner of a table entry, when the entry
+ *        is added to or removed from the object table index.
+ *
+ * \param[in] entry  Table entry
+ * \param[in] add    True if the entry is added, false if it is removed
+ */
+static void ps_table_usage_update(const struct ps_obj_table_entry_t *entry,
+                                  bool add)
+{
+    uint32_t i;
+    struct ps_client_usage_t *usage;
+
+    for (i = 0; i < PS_USAGE_CACHE_CLIENTS; i++) {
+        usage = &ps_obj_table_ctx.usage[i];
+        if (usage->client_id == entry->client_id) {
+            if (add) {
+                usage->num_objects++;
+                usage->size += entry->size;
+            } else {
+                usage->num_objects--;
+                usage->size -= entry->size;
+            }
+            return;
+        }
+    }
+}
+
+/**
+ * \brief Adds a table entry to the object table index.
+ *
+ * \param[in] idx  Entry index
+ */
+static void ps_table_index_insert(uint32_t idx)
+{
+    uint16_t *head = ps_table_index_list(idx);
+
+    ps_obj_table_ctx.next[idx] = *head;
+    *head = (uint16_t)idx;
+
+    if (head == &ps_obj_table_ctx.free_head) {
+        ps_obj_table_ctx.num_free++;
+    } else {
+        ps_table_usage_update(&ps_obj_table_ctx.obj_table.obj_db[idx], true);
+    }
+}
+
+/**
+ * \brief Removes a table entry from the object table index. Must be called
+ *        before the content of the entry is modified.
+ *
+ * \param[in] idx  Entry index
+ */
+static void ps_table_index_remove(uint32_t idx)
+{
+    uint16_t *head = ps_table_index_list(idx);
+    uint16_t *link = head;
+
+    /* The entry is normally at, or close to, the head of its list */
+    while (*link != PS_OBJ_TABLE_ENTRY_NONE) {
+        if (*link == idx) {
+            *link = ps_obj_table_ctx.next[idx];
+
+            if (head == &ps_obj_table_ctx.free_head) {
+                ps_obj_table_ctx.num_free--;
+            } else {
+                ps_table_usage_update(&ps_obj_table_ctx.obj_table.obj_db[idx],
+                                      false);
+            }
+            return;
+        }
+        link = &ps_obj_table_ctx.next[*link];
+    }
+}
+
+/**
+ * \brief Rebuilds the object table index from the object table content.
+ */
+static void ps_table_index_rebuild(void)
+{
+    uint32_t i;
+
+    ps_obj_table_ctx.num_free = 0;
+    ps_obj_table_ctx.free_head = PS_OBJ_TABLE_ENTRY_NONE;
+
+    /* The usage of the clients is counted again when it is next queried */
+    (void)tfm_memset(ps_obj_table_ctx.usage, 0,
+                     sizeof(ps_obj_table_ctx.usage));
+    ps_obj_table_ctx.usage_next = 0;
+
+    for (i = 0; i < PS_OBJ_TABLE_HASH_BUCKETS; i++) {
+        ps_obj_table_ctx.hash_head[i] = PS_OBJ_TABLE_ENTRY_NONE;
+    }
+
+    /* Insert in reverse order, so that the free entries are allocated from
+     * the lowest index.
+     */
+    for (i = PS_OBJ_TABLE_ENTRIES; i > 0; i--) {
+        ps_table_index_insert(i - 1);
+    }
+}
+
+/**
+ * \brief Sets the content of a table entry and updates the index.
+ *
+ * \param[in] idx    Entry index
+ * \param[in] entry  New content of the entry
+ */
+static void ps_table_set_entry(uint32_t idx,
+                               const struct ps_obj_table_entry_t *entry)
+{
+    ps_table_index_remove(idx);
+    (void)tfm_memcpy(&ps_obj_table_ctx.obj_table.obj_db[idx], entry,
+                     PS_OBJECTS_TABLE_ENTRY_SIZE);
+    ps_table_index_insert(idx);
+
+    PS_OBJ_TABLE_BIT_SET(ps_obj_table_ctx.dirty,
+                         idx / PS_OBJ_TABLE_PAGE_ENTRIES);
+}
+
 /**
  * \brief Gets table's entry index based on the given object UID and client ID.
  *
@@ -750,7 +1254,12 @@ static psa_status_t ps_get_object_entry_idx(psa_storage_uid_t uid,
     uint32_t i;
     struct ps_obj_table_t *p_table = &ps_obj_table_ctx.obj_table;
 
-    for (i = 0; i < PS_OBJ_TABLE_ENTRIES; i++) {
+    if (uid == TFM_PS_INVALID_UID) {
+        return PSA_ERROR_DOES_NOT_EXIST;
+    }
+
+    for (i = ps_obj_table_ctx.hash_head[ps_table_hash(uid, client_id)];
+         i != PS_OBJ_TABLE_ENTRY_NONE; i = ps_obj_table_ctx.next[i]) {
         if (p_table->obj_db[i].uid == uid
             && p_table->obj_db[i].client_id == client_id) {
             *idx = i;
@@ -770,7 +1279,8 @@ static psa_status_t ps_get_object_entry_idx(psa_storage_uid_t uid,
  *                     1 index.
  * \param[out] idx     Pointer to store the free index
  *
- * \note The table is dimensioned to fit PS_NUM_ASSETS + 1
+ * \note The table is dimensioned to fit PS_NUM_ASSETS + 1, plus the entries
+ *       which can be released by updates that are not committed yet.
  *
  * \return Returns PSA_SUCCESS and a table index if idx_num free indices are
  *         available. Otherwise, it returns PSA_ERROR_INSUFFICIENT_STORAGE.
@@ -779,27 +1289,33 @@ __attribute__ ((always_inline))
 __STATIC_INLINE psa_status_t ps_table_free_idx(uint32_t idx_num,
                                                uint32_t *idx)
 {
-    uint32_t i;
-    uint32_t last_free = 0;
-    struct ps_obj_table_t *p_table = &ps_obj_table_ctx.obj_table;
+    uint32_t i = ps_obj_table_ctx.free_head;
 
     if (idx_num == 0) {
         return PSA_ERROR_INVALID_ARGUMENT;
     }
 
-    for (i = 0; i < PS_OBJ_TABLE_ENTRIES && idx_num > 0; i++) {
-        if (p_table->obj_db[i].uid == TFM_PS_INVALID_UID) {
-            last_free = i;
-            idx_num--;
-        }
+    if (ps_obj_table_ctx.num_free < idx_num + PS_OBJ_TABLE_WRITE_BACK_ENTRIES) {
+        return PSA_ERROR_INSUFFICIENT_STORAGE;
     }
 
-    if (idx_num != 0) {
-        return PSA_ERROR_INSUFFICIENT_STORAGE;
-    } else {
-        *idx = last_free;
-        return PSA_SUCCESS;
+#ifdef PS_WRITE_BACK
+    /* Skip the entries released by updates that are not committed yet. At
+     * most PS_OBJ_TABLE_WRITE_BACK_ENTRIES entries are released, so there is
+     * always another free entry.
+     */
+    while (i != PS_OBJ_TABLE_ENTRY_NONE &&
+           PS_OBJ_TABLE_BIT_TEST(ps_obj_table_ctx.released, i)) {
+        i = ps_obj_table_ctx.next[i];
     }
+
+    if (i == PS_OBJ_TABLE_ENTRY_NONE) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+#endif
+
+    *idx = i;
+    return PSA_SUCCESS;
 }
 
 /**
@@ -810,9 +1326,39 @@ __STATIC_INLINE psa_status_t ps_table_free_idx(uint32_t idx_num,
  */
 static void ps_table_delete_entry(uint32_t idx)
 {
+    ps_table_index_remove(idx);
+
     /* Initialise object table entry structure */
     (void)tfm_memset(&ps_obj_table_ctx.obj_table.obj_db[idx],
                      PS_DEFAULT_EMPTY_BUFF_VAL, PS_OBJECTS_TABLE_ENTRY_SIZE);
+
+    ps_table_index_insert(idx);
+
+    PS_OBJ_TABLE_BIT_SET(ps_obj_table_ctx.dirty,
+                         idx / PS_OBJ_TABLE_PAGE_ENTRIES);
+}
+
+/**
+ * \brief Commits an update of the object table.
+ *
+ * \note With PS_WRITE_BACK, the table is only saved once
+ *       PS_WRITE_BACK_MAX_UPDATES updates are pending, or when it is flushed.
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+static psa_status_t ps_object_table_commit(void)
+{
+#ifdef PS_WRITE_BACK
+    ps_obj_table_ctx.num_pending++;
+
+    if (ps_obj_table_ctx.num_pending < PS_WRITE_BACK_MAX_UPDATES) {
+        return PSA_SUCCESS;
+    }
+
+    return ps_object_table_flush();
+#else
+    return ps_object_table_save_table(&ps_obj_table_ctx.obj_table);
+#endif
 }
 
 psa_status_t ps_object_table_create(void)
@@ -829,7 +1375,13 @@ psa_status_t ps_object_table_create(void)
     ps_obj_table_ctx.active_table  = PS_OBJ_TABLE_IDX_1;
     ps_obj_table_ctx.scratch_table = PS_OBJ_TABLE_IDX_0;
 
-    p_table->version = PS_OBJECT_SYSTEM_VERSION;
+    p_table->header.version = PS_OBJECT_SYSTEM_VERSION;
+
+    ps_table_index_rebuild();
+
+    /* All the pages are written when the table is created */
+    (void)tfm_memset(ps_obj_table_ctx.dirty, 0xFF,
+                     sizeof(ps_obj_table_ctx.dirty));
 
     /* Save object table contents */
     return ps_object_table_save_table(p_table);
@@ -839,7 +1391,7 @@ psa_status_t ps_object_table_init(uint8_t *obj_data)
 {
     psa_status_t err;
     struct ps_obj_table_init_ctx_t init_ctx = {
-        .p_table = {&ps_obj_table_ctx.obj_table, NULL},
+        .p_table = {&ps_obj_table_ctx.obj_table.header, NULL},
         .table_state = {PS_OBJ_TABLE_VALID, PS_OBJ_TABLE_VALID},
 #ifdef PS_ROLLBACK_PROTECTION
         .nvc_1 = 0U,
@@ -847,9 +1399,10 @@ psa_status_t ps_object_table_init(uint8_t *obj_data)
 #endif /* PS_ROLLBACK_PROTECTION */
     };
 
-    init_ctx.p_table[PS_OBJ_TABLE_IDX_1] = (struct ps_obj_table_t *)obj_data;
+    init_ctx.p_table[PS_OBJ_TABLE_IDX_1] =
+                                    (struct ps_obj_table_header_t *)obj_data;
 
-    /* Read table from the file system */
+    /* Read table headers from the file system */
     ps_object_table_fs_read_table(&init_ctx);
 
 #ifdef PS_ENCRYPTION
@@ -885,7 +1438,32 @@ psa_status_t ps_object_table_init(uint8_t *obj_data)
         return err;
     }
 
-    /* Remove the old object table file */
+    /* Read the pages of the active table from the file system */
+    err = ps_object_table_fs_read_pages();
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+#ifdef PS_ENCRYPTION
+    /* Authenticate the pages against the table header */
+    err = ps_object_table_merkle_verify();
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+#endif /* PS_ENCRYPTION */
+
+    (void)tfm_memset(ps_obj_table_ctx.dirty, 0, sizeof(ps_obj_table_ctx.dirty));
+
+#ifdef PS_WRITE_BACK
+    /* Any update which was not committed is lost */
+    ps_obj_table_ctx.num_pending = 0;
+    (void)tfm_memset(ps_obj_table_ctx.released, 0,
+                     sizeof(ps_obj_table_ctx.released));
+#endif
+
+    ps_table_index_rebuild();
+
+    /* Remove the old object table header file */
     err = psa_its_remove(PS_TABLE_FS_ID(ps_obj_table_ctx.scratch_table));
     if (err != PSA_SUCCESS && err != PSA_ERROR_DOES_NOT_EXIST) {
         return err;
@@ -900,7 +1478,7 @@ psa_status_t ps_object_table_init(uint8_t *obj_data)
 #endif /* PS_ROLLBACK_PROTECTION */
 
 #ifdef PS_ENCRYPTION
-    ps_crypto_set_iv(&ps_obj_table_ctx.obj_table.crypto);
+    ps_crypto_set_iv(&ps_obj_table_ctx.obj_table.header.crypto);
 #endif
 
     return PSA_SUCCESS;
@@ -960,7 +1538,10 @@ psa_status_t ps_object_table_set_obj_tbl_info(psa_storage_uid_t uid,
 #endif /* PS_ENCRYPTION */
         .uid = TFM_PS_INVALID_UID,
         .client_id = 0,
+        .size = 0U,
+        .flags = 0U,
     };
+    struct ps_obj_table_entry_t new_entry;
     struct ps_obj_table_t *p_table = &ps_obj_table_ctx.obj_table;
 
     err = ps_get_object_entry_idx(uid, client_id, &backup_idx);
@@ -976,26 +1557,30 @@ psa_status_t ps_object_table_set_obj_tbl_info(psa_storage_uid_t uid,
     }
 
     idx = PS_OBJECT_FS_ID_TO_IDX(obj_tbl_info->fid);
-    p_table->obj_db[idx].uid = uid;
-    p_table->obj_db[idx].client_id = client_id;
+    (void)tfm_memset(&new_entry, PS_DEFAULT_EMPTY_BUFF_VAL,
+                     PS_OBJECTS_TABLE_ENTRY_SIZE);
+    new_entry.uid = uid;
+    new_entry.client_id = client_id;
+    new_entry.size = obj_tbl_info->size;
+    new_entry.flags = obj_tbl_info->flags;
 
     /* Add new object information */
 #ifdef PS_ENCRYPTION
-    (void)tfm_memcpy(p_table->obj_db[idx].tag, obj_tbl_info->tag,
-                     PS_TAG_LEN_BYTES);
+    (void)tfm_memcpy(new_entry.tag, obj_tbl_info->tag, PS_TAG_LEN_BYTES);
 #else
-    p_table->obj_db[idx].version = obj_tbl_info->version;
+    new_entry.version = obj_tbl_info->version;
 #endif
 
-    err = ps_object_table_save_table(p_table);
+    ps_table_set_entry(idx, &new_entry);
+
+    err = ps_object_table_commit();
     if (err != PSA_SUCCESS) {
+        ps_table_delete_entry(idx);
+
         if (backup_entry.uid != TFM_PS_INVALID_UID) {
             /* Rollback the change in the table */
-            (void)tfm_memcpy(&p_table->obj_db[backup_idx], &backup_entry,
-                             PS_OBJECTS_TABLE_ENTRY_SIZE);
+            ps_table_set_entry(backup_idx, &backup_entry);
         }
-
-        ps_table_delete_entry(idx);
     }
 
     return err;
@@ -1022,10 +1607,112 @@ psa_status_t ps_object_table_get_obj_tbl_info(psa_storage_uid_t uid,
 #else
     obj_tbl_info->version = p_table->obj_db[idx].version;
 #endif
+    obj_tbl_info->size = p_table->obj_db[idx].size;
+    obj_tbl_info->flags = p_table->obj_db[idx].flags;
 
     return PSA_SUCCESS;
 }
 
+psa_status_t ps_object_table_list(int32_t client_id,
+                                  psa_storage_uid_t after_uid,
+                                  struct psa_storage_uid_info_t *entries,
+                                  size_t num_entries,
+                                  size_t *p_num_entries)
+{
+    uint32_t idx;
+    size_t num = 0;
+    size_t pos;
+    const struct ps_obj_table_entry_t *entry;
+
+    if (num_entries == 0) {
+        *p_num_entries = 0;
+        return PSA_SUCCESS;
+    }
+
+    /* Keep the num_entries smallest UIDs of the client after after_uid,
+     * sorted by UID. The free entries have an invalid UID, which is never
+     * greater than after_uid.
+     */
+    for (idx = 0; idx < PS_OBJ_TABLE_ENTRIES; idx++) {
+        entry = &ps_obj_table_ctx.obj_table.obj_db[idx];
+
+        if (entry->client_id != client_id || entry->uid <= after_uid) {
+            continue;
+        }
+
+        if (num < num_entries) {
+            pos = num++;
+        } else if (entry->uid < entries[num_entries - 1].uid) {
+            pos = num_entries - 1;
+        } else {
+            continue;
+        }
+
+        for (; pos > 0 && entries[pos - 1].uid > entry->uid; pos--) {
+            entries[pos] = entries[pos - 1];
+        }
+
+        entries[pos].uid = entry->uid;
+        entries[pos].size = entry->size;
+        entries[pos].flags = entry->flags;
+    }
+
+    *p_num_entries = num;
+
+    return PSA_SUCCESS;
+}
+
+void ps_object_table_get_usage(int32_t client_id, size_t *p_num_objects,
+                               size_t *p_size)
+{
+    uint32_t i;
+    struct ps_client_usage_t *usage;
+    const struct ps_obj_table_entry_t *entry;
+
+    for (i = 0; i < PS_USAGE_CACHE_CLIENTS; i++) {
+        usage = &ps_obj_table_ctx.usage[i];
+        if (usage->client_id == client_id) {
+            *p_num_objects = usage->num_objects;
+            *p_size = usage->size;
+            return;
+        }
+    }
+
+    /* Count the usage of the client and cache it, replacing the oldest cached
+     * usage.
+     */
+    usage = &ps_obj_table_ctx.usage[ps_obj_table_ctx.usage_next];
+    ps_obj_table_ctx.usage_next = (ps_obj_table_ctx.usage_next + 1)
+                                  % PS_USAGE_CACHE_CLIENTS;
+
+    usage->client_id = client_id;
+    usage->num_objects = 0;
+    usage->size = 0;
+
+    for (i = 0; i < PS_OBJ_TABLE_ENTRIES; i++) {
+        entry = &ps_obj_table_ctx.obj_table.obj_db[i];
+        if (entry->uid != TFM_PS_INVALID_UID && entry->client_id == client_id) {
+            usage->num_objects++;
+            usage->size += entry->size;
+        }
+    }
+
+    *p_num_objects = usage->num_objects;
+    *p_size = usage->size;
+}
+
+size_t ps_object_table_num_free_objects(void)
+{
+    /* Creating an object requires one more free entry than it uses, so that
+     * there is always a free entry to update an object.
+     */
+    if (ps_obj_table_ctx.num_free < 2 + PS_OBJ_TABLE_WRITE_BACK_ENTRIES) {
+        return 0;
+    }
+
+    return ps_obj_table_ctx.num_free - 1 - PS_OBJ_TABLE_WRITE_BACK_ENTRIES;
+}
+
 psa_status_t ps_object_table_delete_object(psa_storage_uid_t uid,
                                            int32_t client_id)
 {
@@ -1052,11 +1739,10 @@ psa_status_t ps_object_table_delete_object(psa_storage_uid_t uid,
 
     ps_table_delete_entry(backup_idx);
 
-    err = ps_object_table_save_table(p_table);
+    err = ps_object_table_commit();
     if (err != PSA_SUCCESS) {
        /* Rollback the change in the table */
-       (void)tfm_memcpy(&p_table->obj_db[backup_idx], &backup_entry,
-                        PS_OBJECTS_TABLE_ENTRY_SIZE);
+       ps_table_set_entry(backup_idx, &backup_entry);
     }
 
     return err;
@@ -1064,7 +1750,59 @@ psa_status_t ps_object_table_delete_object(psa_storage_uid_t uid,
 
 psa_status_t ps_object_table_delete_old_table(void)
 {
-    uint32_t table_id = PS_TABLE_FS_ID(ps_obj_table_ctx.scratch_table);
+    /* The old object table header is not removed, as that would cost a file
+     * system update for every table update. It is replaced by the next table
+     * update instead. Some of its pages may have been overwritten by then, but
+     * it is never selected over the newer table header.
+     */
+    return PSA_SUCCESS;
+}
 
-    return psa_its_remove(table_id);
+psa_status_t ps_object_table_release_fid(uint32_t fid)
+{
+#ifdef PS_WRITE_BACK
+    /* The file is still used by the committed table, so it is only removed
+     * once the table is committed.
+     */
+    if (ps_obj_table_ctx.num_pending > 0) {
+        PS_OBJ_TABLE_BIT_SET(ps_obj_table_ctx.released,
+                             PS_OBJECT_FS_ID_TO_IDX(fid));
+        return PSA_SUCCESS;
+    }
+#endif
+
+    return psa_its_remove(fid);
+}
+
+psa_status_t ps_object_table_flush(void)
+{
+#ifdef PS_WRITE_BACK
+    psa_status_t err;
+    uint32_t idx;
+
+    if (ps_obj_table_ctx.num_pending == 0) {
+        return PSA_SUCCESS;
+    }
+
+    err = ps_object_table_save_table(&ps_obj_table_ctx.obj_table);
+    if (err != PSA_SUCCESS) {
+        return err;
+    }
+
+    ps_obj_table_ctx.num_pending = 0;
+
+    /* Remove the files of the entries released since the last commit. If a
+     * file cannot be removed, it is removed when its entry is allocated again.
+     */
+    for (idx = 0; idx < PS_OBJ_TABLE_ENTRIES; idx++) {
+        if (PS_OBJ_TABLE_BIT_TEST(ps_obj_table_ctx.released, idx)) {
+            (void)psa_its_remove(PS_OBJECT_FS_ID(idx));
+        }
+    }
+
+    (void)tfm_memset(ps_obj_table_ctx.released, 0,
+                     sizeof(ps_obj_table_ctx.released));
+#endif
+
+    return PSA_SUCCESS;
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2018-2020, Arm Limited. All rights reserved.
+ * Copyright (c) 2018-2022, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -8,6 +8,7 @@
 #ifndef __PS_OBJECT_TABLE_H__
 #define __PS_OBJECT_TABLE_H__
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include "psa/protected_storage.h"
@@ -28,6 +29,8 @@ struct ps_obj_table_info_t {
 #else
     uint32_t version;  /*!< Object version */
 #endif
+    uint32_t size;     /*!< Current size of the object data */
+    uint32_t flags;    /*!< Object creation flags */
 };
 
 /**
@@ -88,7 +91,8 @@ psa_status_t ps_object_table_get_free_fid(uint32_t fid_num, uint32_t *p_fid);
  *                          information \ref ps_obj_table_info_t
  *
  * \note  A call to this function results in writing the table to the
- *        file system.
+ *        file system, unless PS_WRITE_BACK is enabled and fewer than
+ *        PS_WRITE_BACK_MAX_UPDATES updates are pending.
  *
  * \return Returns error code as specified in \ref psa_status_t
  */
@@ -112,6 +116,51 @@ psa_status_t ps_object_table_get_obj_tbl_info(psa_storage_uid_t uid,
                                               int32_t client_id,
                                       struct ps_obj_table_info_t *obj_tbl_info);
 
+/**
+ * \brief Lists the objects of a client in the object table, in ascending order
+ *        of UID.
+ *
+ * \param[in]  client_id      Identifier of the assets' owner (client)
+ * \param[in]  after_uid      UID after which to start listing
+ * \param[out] entries        Pointer to the location to store the UID, size
+ *                            and flags of the listed objects
+ * \param[in]  num_entries    Maximum number of objects to list
+ * \param[out] p_num_entries  Pointer to the location to store the number of
+ *                            listed objects
+ *
+ * \note The list is served from the object table in RAM, without reading the
+ *       objects from the file system.
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+psa_status_t ps_object_table_list(int32_t client_id,
+                                  psa_storage_uid_t after_uid,
+                                  struct psa_storage_uid_info_t *entries,
+                                  size_t num_entries,
+                                  size_t *p_num_entries);
+
+/**
+ * \brief Gets the storage usage of a client.
+ *
+ * \param[in]  client_id      Identifier of the assets' owner (client)
+ * \param[out] p_num_objects  Pointer to the location to store the number of
+ *                            objects owned by the client
+ * \param[out] p_size         Pointer to the location to store the sum of the
+ *                            sizes of the client's objects
+ *
+ * \note The usage is counted from the object table the first time it is
+ *       queried, and then maintained as the table is updated.
+ */
+void ps_object_table_get_usage(int32_t client_id, size_t *p_num_objects,
+                               size_t *p_size);
+
+/**
+ * \brief Gets the number of objects that can still be created.
+ *
+ * \return Returns the number of objects that can still be created
+ */
+size_t ps_object_table_num_free_objects(void);
+
 /**
  * \brief Deletes the table entry for the provided UID and client ID pair.
  *
@@ -126,10 +175,36 @@ psa_status_t ps_object_table_delete_object(psa_storage_uid_t uid,
 /**
  * \brief Deletes old object table from the persistent area.
  *
+ * \note The old object table header is kept in the persistent area until it is
+ *       replaced by the next table update.
+ *
  * \return Returns error code as specified in \ref psa_status_t
  */
 psa_status_t ps_object_table_delete_old_table(void);
 
+/**
+ * \brief Releases the file of an object which has been replaced or deleted in
+ *        the object table.
+ *
+ * \param[in] fid  File ID of the old object
+ *
+ * \note With PS_WRITE_BACK, the file is only removed once the update which
+ *       released it is committed.
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+psa_status_t ps_object_table_release_fid(uint32_t fid);
+
+/**
+ * \brief Writes the object table to the file system if it has updates which
+ *        are not committed yet.
+ *
+ * \note Only has an effect when PS_WRITE_BACK is enabled.
+ *
+ * \return Returns error code as specified in \ref psa_status_t
+ */
+psa_status_t ps_object_table_flush(void);
+
 #ifdef __cplusplus
 }
 #endif
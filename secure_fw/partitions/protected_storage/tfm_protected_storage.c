@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019-2020, Arm Limited. All rights reserved.
+ * Copyright (c) 2019-2022, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -64,6 +64,43 @@ psa_status_t tfm_ps_set(int32_t client_id,
     return ps_object_create(uid, client_id, create_flags, data_length);
 }
 
+psa_status_t tfm_ps_create(int32_t client_id,
+                           psa_storage_uid_t uid,
+                           uint32_t capacity,
+                           psa_storage_create_flags_t create_flags)
+{
+    /* Check that the UID is valid */
+    if (uid == TFM_PS_INVALID_UID) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    /* Check that the create_flags does not contain any unsupported flags. An
+     * empty write once asset could never be written, so that flag is not
+     * supported either.
+     */
+    if (create_flags & ~(PSA_STORAGE_FLAG_NO_CONFIDENTIALITY |
+                         PSA_STORAGE_FLAG_NO_REPLAY_PROTECTION)) {
+        return PSA_ERROR_NOT_SUPPORTED;
+    }
+
+    /* Reserve the object in the object system */
+    return ps_object_reserve(uid, client_id, create_flags, capacity);
+}
+
+psa_status_t tfm_ps_set_extended(int32_t client_id,
+                                 psa_storage_uid_t uid,
+                                 uint32_t data_offset,
+                                 uint32_t data_length)
+{
+    /* Check that the UID is valid */
+    if (uid == TFM_PS_INVALID_UID) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
+    /* Write the data range in the object system */
+    return ps_object_write(uid, client_id, data_offset, data_length);
+}
+
 psa_status_t tfm_ps_get(int32_t client_id,
                         psa_storage_uid_t uid,
                         uint32_t data_offset,
@@ -115,14 +152,37 @@ psa_status_t tfm_ps_remove(int32_t client_id, psa_storage_uid_t uid)
     return err;
 }
 
+psa_status_t tfm_ps_flush(void)
+{
+    /* Commit the object table updates batched in write-back mode */
+    return ps_system_flush();
+}
+
+psa_status_t tfm_ps_list(int32_t client_id, psa_storage_uid_t after_uid,
+                         size_t num_entries, size_t *p_num_entries)
+{
+    /* List the client's objects from the object table */
+    return ps_object_list(client_id, after_uid, num_entries, p_num_entries);
+}
+
+psa_status_t tfm_ps_get_capacity(int32_t client_id,
+                                 struct psa_storage_capacity_t *p_capacity)
+{
+    /* The usage is maintained in the object table */
+    return ps_object_get_capacity(client_id, p_capacity);
+}
+
 uint32_t tfm_ps_get_support(void)
 {
     /*
      * This function returns a bitmask with flags set for all of the optional
      * features supported by the PS service implementation.
      *
-     * PS service does not support the optional extended PSA PS API yet.
+     * The optional extended PSA PS API is only supported in the IPC model.
      */
-
+#ifdef TFM_PSA_API
+    return PSA_STORAGE_SUPPORT_SET_EXTENDED;
+#else
     return 0;
+#endif
 }
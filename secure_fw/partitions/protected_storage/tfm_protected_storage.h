@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019-2020, Arm Limited. All rights reserved.
+ * Copyright (c) 2019-2022, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -8,6 +8,7 @@
 #ifndef __TFM_PROTECTED_STORAGE_H__
 #define __TFM_PROTECTED_STORAGE_H__
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include "psa/protected_storage.h"
@@ -56,7 +57,8 @@ psa_status_t tfm_ps_init(void);
  *                                          is not valid
  * \retval PSA_ERROR_INSUFFICIENT_STORAGE   The operation failed because there
  *                                          was insufficient space on the
- *                                          storage medium
+ *                                          storage medium, or the client's
+ *                                          quota would be exceeded
  * \retval PSA_ERROR_STORAGE_FAILURE        The operation failed because the
  *                                          physical storage has failed (fatal
  *                                          error)
@@ -67,6 +69,85 @@ psa_status_t tfm_ps_set(int32_t client_id,
                         psa_storage_uid_t uid,
                         uint32_t data_length,
                         psa_storage_create_flags_t create_flags);
+
+/**
+ * \brief Reserves storage for a new asset without writing any data.
+ *
+ * \param[in] client_id     Identifier of the asset's owner (client)
+ * \param[in] uid           Unique identifier for the data
+ * \param[in] capacity      The maximum size in bytes of the data that can be
+ *                          written to the asset with tfm_ps_set_extended()
+ * \param[in] create_flags  The flags indicating the properties of the data
+ *
+ * \return A status indicating the success/failure of the operation as specified
+ *         in \ref psa_status_t
+ *
+ * \retval PSA_SUCCESS                      The operation completed successfully
+ * \retval PSA_ERROR_ALREADY_EXISTS         The operation failed because the
+ *                                          provided uid value already exists
+ * \retval PSA_ERROR_INVALID_ARGUMENT       The operation failed because
+ *                                          `capacity` is larger than the
+ *                                          maximum asset size
+ * \retval PSA_ERROR_NOT_SUPPORTED          The operation failed because one or
+ *                                          more of the flags provided in
+ *                                          `create_flags` is not supported or
+ *                                          is not valid
+ * \retval PSA_ERROR_INSUFFICIENT_STORAGE   The operation failed because there
+ *                                          was insufficient space on the
+ *                                          storage medium, or the client's
+ *                                          quota would be exceeded
+ * \retval PSA_ERROR_STORAGE_FAILURE        The operation failed because the
+ *                                          physical storage has failed (fatal
+ *                                          error)
+ * \retval PSA_ERROR_GENERIC_ERROR          The operation failed because of an
+ *                                          unspecified internal failure.
+ */
+psa_status_t tfm_ps_create(int32_t client_id,
+                           psa_storage_uid_t uid,
+                           uint32_t capacity,
+                           psa_storage_create_flags_t create_flags);
+
+/**
+ * \brief Writes part of the data of an existing asset.
+ *
+ * Writes `data_length` bytes at `data_offset` bytes from the beginning of the
+ * data, leaving the rest of the data unchanged. The write can extend the data,
+ * up to the capacity of the asset, but must not leave a gap after the current
+ * end of the data.
+ *
+ * \param[in] client_id    Identifier of the asset's owner (client)
+ * \param[in] uid          Unique identifier for the data
+ * \param[in] data_offset  The offset within the data at which to write
+ * \param[in] data_length  The size in bytes of the data to write
+ *
+ * \return A status indicating the success/failure of the operation as specified
+ *         in \ref psa_status_t
+ *
+ * \retval PSA_SUCCESS                    The operation completed successfully
+ * \retval PSA_ERROR_DOES_NOT_EXIST       The operation failed because the
+ *                                        provided uid value was not found in
+ *                                        the storage
+ * \retval PSA_ERROR_NOT_PERMITTED        The operation failed because the
+ *                                        provided uid value was created with
+ *                                        PSA_STORAGE_FLAG_WRITE_ONCE
+ * \retval PSA_ERROR_INVALID_ARGUMENT     The operation failed because
+ *                                        `data_offset` is larger than the
+ *                                        current size of the data, or the write
+ *                                        would exceed the capacity of the asset
+ * \retval PSA_ERROR_STORAGE_FAILURE      The operation failed because the
+ *                                        physical storage has failed (fatal
+ *                                        error)
+ * \retval PSA_ERROR_GENERIC_ERROR        The operation failed because of an
+ *                                        unspecified internal failure
+ * \retval PSA_ERROR_INVALID_SIGNATURE    The operation failed because the data
+ *                                        associated with the UID failed
+ *                                        authentication
+ */
+psa_status_t tfm_ps_set_extended(int32_t client_id,
+                                 psa_storage_uid_t uid,
+                                 uint32_t data_offset,
+                                 uint32_t data_length);
+
 /**
  * \brief Gets the asset data for the provided uid.
  *
@@ -164,6 +245,58 @@ psa_status_t tfm_ps_get_info(int32_t client_id, psa_storage_uid_t uid,
  */
 psa_status_t tfm_ps_remove(int32_t client_id, psa_storage_uid_t uid);
 
+/**
+ * \brief Makes all the completed updates persistent.
+ *
+ * \return A status indicating the success/failure of the operation as specified
+ *         in \ref psa_status_t
+ *
+ * \retval PSA_SUCCESS                    The operation completed successfully
+ * \retval PSA_ERROR_STORAGE_FAILURE      The operation failed because the
+ *                                        physical storage has failed (fatal
+ *                                        error)
+ * \retval PSA_ERROR_GENERIC_ERROR        The operation failed because of an
+ *                                        unspecified internal failure
+ */
+psa_status_t tfm_ps_flush(void);
+
+/**
+ * \brief Lists the client's uids greater than after_uid, in ascending order.
+ *        The uid, size and flags of each listed uid are written to the
+ *        client's output buffer.
+ *
+ * \param[in]  client_id      Identifier of the assets' owner (client)
+ * \param[in]  after_uid      The uid after which to start listing
+ * \param[in]  num_entries    Maximum number of uids to list
+ * \param[out] p_num_entries  On success, this will contain the number of
+ *                            listed uids
+ *
+ * \return A status indicating the success/failure of the operation as specified
+ *         in \ref psa_status_t
+ *
+ * \retval PSA_SUCCESS                    The operation completed successfully
+ */
+psa_status_t tfm_ps_list(int32_t client_id, psa_storage_uid_t after_uid,
+                         size_t num_entries, size_t *p_num_entries);
+
+/**
+ * \brief Retrieves the storage usage of the client and the free storage.
+ *
+ * \param[in]  client_id   Identifier of the assets' owner (client)
+ * \param[out] p_capacity  A pointer to a `psa_storage_capacity_t` struct that
+ *                         will be populated with the usage and free storage
+ *
+ * \return A status indicating the success/failure of the operation as specified
+ *         in \ref psa_status_t
+ *
+ * \retval PSA_SUCCESS                    The operation completed successfully
+ * \retval PSA_ERROR_STORAGE_FAILURE      The operation failed because the
+ *                                        physical storage has failed (fatal
+ *                                        error)
+ */
+psa_status_t tfm_ps_get_capacity(int32_t client_id,
+                                 struct psa_storage_capacity_t *p_capacity);
+
 /**
  * \brief Gets a bitmask with flags set for all of the optional features
  *        supported by the implementation.
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019-2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2019-2022, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -272,6 +272,65 @@ static psa_status_t tfm_ps_set_ipc(void)
     return tfm_ps_set(client_id, uid, msg.in_size[1], create_flags);
 }
 
+static psa_status_t tfm_ps_create_ipc(void)
+{
+    psa_storage_uid_t uid;
+    size_t capacity;
+    psa_storage_create_flags_t create_flags;
+    size_t num = 0;
+
+    if (msg.in_size[0] != sizeof(psa_storage_uid_t) ||
+        msg.in_size[1] != sizeof(size_t) ||
+        msg.in_size[2] != sizeof(psa_storage_create_flags_t)) {
+        /* The size of one of the arguments is incorrect */
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    num = psa_read(msg.handle, 0, &uid, msg.in_size[0]);
+    if (num != msg.in_size[0]) {
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    num = psa_read(msg.handle, 1, &capacity, msg.in_size[1]);
+    if (num != msg.in_size[1]) {
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    num = psa_read(msg.handle, 2, &create_flags, msg.in_size[2]);
+    if (num != msg.in_size[2]) {
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    return tfm_ps_create(msg.client_id, uid, capacity, create_flags);
+}
+
+static psa_status_t tfm_ps_set_extended_ipc(void)
+{
+    psa_storage_uid_t uid;
+    size_t data_offset;
+    size_t num = 0;
+
+    if (msg.in_size[0] != sizeof(psa_storage_uid_t) ||
+        msg.in_size[2] != sizeof(size_t)) {
+        /* The size of one of the arguments is incorrect */
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    num = psa_read(msg.handle, 0, &uid, msg.in_size[0]);
+    if (num != msg.in_size[0]) {
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    num = psa_read(msg.handle, 2, &data_offset, msg.in_size[2]);
+    if (num != msg.in_size[2]) {
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    /* The data to write is read from in_vec[1] by the object system */
+    return tfm_ps_set_extended(msg.client_id, uid, data_offset,
+                               msg.in_size[1]);
+}
+
 static psa_status_t tfm_ps_get_ipc(void)
 {
     psa_storage_uid_t uid;
@@ -360,6 +419,51 @@ static psa_status_t tfm_ps_get_support_ipc(void)
     return PSA_SUCCESS;
 }
 
+static psa_status_t tfm_ps_flush_ipc(void)
+{
+    return tfm_ps_flush();
+}
+
+static psa_status_t tfm_ps_list_ipc(void)
+{
+    psa_storage_uid_t after_uid;
+    size_t num = 0;
+    size_t num_entries;
+
+    if (msg.in_size[0] != sizeof(psa_storage_uid_t)) {
+        /* The size of one of the arguments is incorrect */
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    num = psa_read(msg.handle, 0, &after_uid, msg.in_size[0]);
+    if (num != msg.in_size[0]) {
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    /* The entries are written to out_vec[0] by the object system */
+    return tfm_ps_list(msg.client_id, after_uid,
+                       msg.out_size[0] / sizeof(struct psa_storage_uid_info_t),
+                       &num_entries);
+}
+
+static psa_status_t tfm_ps_get_capacity_ipc(void)
+{
+    struct psa_storage_capacity_t capacity;
+    psa_status_t status;
+
+    if (msg.out_size[0] != sizeof(struct psa_storage_capacity_t)) {
+        /* The size of the argument is incorrect */
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    status = tfm_ps_get_capacity(msg.client_id, &capacity);
+
+    if (status == PSA_SUCCESS) {
+        psa_write(msg.handle, 0, &capacity, msg.out_size[0]);
+    }
+    return status;
+}
+
 static void ps_signal_handle(psa_signal_t signal)
 {
     psa_status_t status;
@@ -386,6 +490,26 @@ static void ps_signal_handle(psa_signal_t signal)
         status = tfm_ps_get_support_ipc();
         psa_reply(msg.handle, status);
         break;
+    case TFM_PS_CREATE:
+        status = tfm_ps_create_ipc();
+        psa_reply(msg.handle, status);
+        break;
+    case TFM_PS_SET_EXTENDED:
+        status = tfm_ps_set_extended_ipc();
+        psa_reply(msg.handle, status);
+        break;
+    case TFM_PS_FLUSH:
+        status = tfm_ps_flush_ipc();
+        psa_reply(msg.handle, status);
+        break;
+    case TFM_PS_LIST:
+        status = tfm_ps_list_ipc();
+        psa_reply(msg.handle, status);
+        break;
+    case TFM_PS_GET_CAPACITY:
+        status = tfm_ps_get_capacity_ipc();
+        psa_reply(msg.handle, status);
+        break;
     default:
         psa_panic();
     }
@@ -429,6 +553,7 @@ psa_status_t ps_req_mngr_read_asset_data(uint8_t *out_data, uint32_t size)
     }
 #else /* TFM_PSA_API */
     (void)tfm_memcpy(out_data, p_data, size);
+    p_data = (uint8_t *)p_data + size;
 #endif
     return PSA_SUCCESS;
 }
@@ -439,5 +564,6 @@ void ps_req_mngr_write_asset_data(const uint8_t *in_data, uint32_t size)
     psa_write(msg.handle, 0, in_data, size);
 #else /* TFM_PSA_API */
     (void)tfm_memcpy(p_data, in_data, size);
+    p_data = (uint8_t *)p_data + size;
 #endif
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019-2020, Arm Limited. All rights reserved.
+ * Copyright (c) 2019-2022, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -102,6 +102,8 @@ psa_status_t tfm_ps_get_support_req(psa_invec *in_vec, size_t in_len,
  * \brief Takes an input buffer containing asset data and writes
  *        its contents to the client iovec
  *
+ * \note Successive calls write consecutive parts of the client iovec.
+ *
  * \param[in]  in_data Pointer to the buffer data will read from.
  * \param[in]  size    The amount of data to read.
  *
@@ -113,6 +115,8 @@ void ps_req_mngr_write_asset_data(const uint8_t *in_data,
 /**
  * \brief Writes the asset data of a client iovec onto an output buffer
  *
+ * \note Successive calls read consecutive parts of the client iovec.
+ *
  * \param[out] out_data  Pointer to the buffer data will be written to.
  * \param[in]  size      The amount of data to write.
  *
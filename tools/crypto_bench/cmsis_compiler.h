@@ -0,0 +1,19 @@
+/*
+ * Copyright (c) 2022, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef __CMSIS_COMPILER_H__
+#define __CMSIS_COMPILER_H__
+
+/* Minimal subset of the CMSIS compiler abstraction required to build the
+ * allocator of the Crypto service for the host.
+ */
+
+#ifndef __STATIC_INLINE
+#define __STATIC_INLINE  static inline
+#endif
+
+#endif /* __CMSIS_COMPILER_H__ */
@@ -0,0 +1,362 @@
+/*
+ * Copyright (c) 2022, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/**
+ * \file  crypto_bench.c
+ *
+ * \brief Throughput benchmark of the PSA Crypto API. Each case measures one
+ *        single-part operation, repeated for a minimum time, for each buffer
+ *        size of the sweep. Only the PSA Crypto API is used, so the same cases
+ *        run on the host build of Mbed Crypto and through the TF-M Crypto
+ *        service.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "crypto_bench.h"
+#include "psa/crypto.h"
+
+/* Room left in the output buffer for an IV or a tag */
+#define BENCH_OUTPUT_OVERHEAD   64u
+
+/* Number of nanoseconds in a second and in a millisecond */
+#define BENCH_NS_PER_S          1000000000u
+#define BENCH_NS_PER_MS         1000000u
+
+struct bench_case_t;
+
+/**
+ * \brief Operation measured by a benchmark case.
+ *
+ * \param[in] bc   Benchmark case
+ * \param[in] size Size of the buffer processed, for the cases which process
+ *                 a buffer
+ *
+ * \return Status of the operation
+ */
+typedef psa_status_t (*bench_op_t)(const struct bench_case_t *bc, size_t size);
+
+/**
+ * \brief Benchmark case.
+ */
+struct bench_case_t {
+    const char *category;    /**< Category of the operation */
+    const char *name;        /**< Name of the algorithm */
+    psa_algorithm_t alg;     /**< Algorithm */
+    psa_key_type_t key_type; /**< Type of the key, or 0 if none is needed */
+    size_t key_bits;         /**< Size of the key in bits */
+    psa_key_usage_t usage;   /**< Usage flags of the key */
+    bench_op_t op;           /**< Operation measured */
+    int sized;               /**< Non-zero if the operation processes a
+                              *   buffer of each size of the sweep, zero if it
+                              *   is measured once
+                              */
+};
+
+/* Key material of the symmetric keys, of which the first key_bits / 8 bytes
+ * are used.
+ */
+static const uint8_t bench_key_data[32] = {
+    0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe,
+    0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81,
+    0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7,
+    0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4,
+};
+
+static const uint8_t bench_nonce[16] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+};
+
+static uint8_t bench_input[CRYPTO_BENCH_MAX_SIZE];
+static uint8_t bench_output[CRYPTO_BENCH_MAX_SIZE + BENCH_OUTPUT_OVERHEAD];
+static uint8_t bench_hash[PSA_HASH_MAX_SIZE];
+static uint8_t bench_signature[PSA_SIGNATURE_MAX_SIZE];
+static size_t bench_signature_len;
+static uint8_t bench_peer_key[PSA_EXPORT_PUBLIC_KEY_MAX_SIZE];
+static size_t bench_peer_key_len;
+static psa_key_id_t bench_key;
+
+static psa_status_t op_hash(const struct bench_case_t *bc, size_t size)
+{
+    size_t len;
+
+    return psa_hash_compute(bc->alg, bench_input, size, bench_output,
+                            sizeof(bench_output), &len);
+}
+
+static psa_status_t op_mac(const struct bench_case_t *bc, size_t size)
+{
+    size_t len;
+
+    return psa_mac_compute(bench_key, bc->alg, bench_input, size, bench_output,
+                           sizeof(bench_output), &len);
+}
+
+static psa_status_t op_cipher(const struct bench_case_t *bc, size_t size)
+{
+    size_t len;
+
+    return psa_cipher_encrypt(bench_key, bc->alg, bench_input, size,
+                              bench_output, sizeof(bench_output), &len);
+}
+
+static psa_status_t op_aead(const struct bench_case_t *bc, size_t size)
+{
+    size_t len;
+
+    return psa_aead_encrypt(bench_key, bc->alg, bench_nonce,
+                            PSA_AEAD_NONCE_LENGTH(bc->key_type, bc->alg),
+                            NULL, 0, bench_input, size, bench_output,
+                            sizeof(bench_output), &len);
+}
+
+static psa_status_t op_sign_hash(const struct bench_case_t *bc, size_t size)
+{
+    (void)size;
+
+    return psa_sign_hash(bench_key, bc->alg, bench_hash,
+                         PSA_HASH_LENGTH(PSA_ALG_SIGN_GET_HASH(bc->alg)),
+                         bench_signature, sizeof(bench_signature),
+                         &bench_signature_len);
+}
+
+static psa_status_t op_verify_hash(const struct bench_case_t *bc, size_t size)
+{
+    (void)size;
+
+    return psa_verify_hash(bench_key, bc->alg, bench_hash,
+                           PSA_HASH_LENGTH(PSA_ALG_SIGN_GET_HASH(bc->alg)),
+                           bench_signature, bench_signature_len);
+}
+
+static psa_status_t op_key_agreement(const struct bench_case_t *bc,
+                                     size_t size)
+{
+    size_t len;
+
+    (void)size;
+
+    return psa_raw_key_agreement(bc->alg, bench_key, bench_peer_key,
+                                 bench_peer_key_len, bench_output,
+                                 sizeof(bench_output), &len);
+}
+
+#define ECC_P256_KEY_PAIR PSA_KEY_TYPE_ECC_KEY_PAIR(PSA_ECC_FAMILY_SECP_R1)
+#define SIGN_VERIFY_HASH  (PSA_KEY_USAGE_SIGN_HASH | PSA_KEY_USAGE_VERIFY_HASH)
+
+static const struct bench_case_t bench_cases[] = {
+    {"hash", "SHA-256", PSA_ALG_SHA_256, 0, 0, 0, op_hash, 1},
+    {"hash", "SHA-384", PSA_ALG_SHA_384, 0, 0, 0, op_hash, 1},
+    {"mac", "HMAC-SHA-256", PSA_ALG_HMAC(PSA_ALG_SHA_256), PSA_KEY_TYPE_HMAC,
+     256, PSA_KEY_USAGE_SIGN_MESSAGE, op_mac, 1},
+    {"mac", "CMAC-AES-128", PSA_ALG_CMAC, PSA_KEY_TYPE_AES, 128,
+     PSA_KEY_USAGE_SIGN_MESSAGE, op_mac, 1},
+    {"cipher", "AES-128-CBC", PSA_ALG_CBC_NO_PADDING, PSA_KEY_TYPE_AES, 128,
+     PSA_KEY_USAGE_ENCRYPT, op_cipher, 1},
+    {"cipher", "AES-128-CTR", PSA_ALG_CTR, PSA_KEY_TYPE_AES, 128,
+     PSA_KEY_USAGE_ENCRYPT, op_cipher, 1},
+    {"aead", "AES-128-GCM", PSA_ALG_GCM, PSA_KEY_TYPE_AES, 128,
+     PSA_KEY_USAGE_ENCRYPT, op_aead, 1},
+    {"aead", "AES-128-CCM", PSA_ALG_CCM, PSA_KEY_TYPE_AES, 128,
+     PSA_KEY_USAGE_ENCRYPT, op_aead, 1},
+    {"aead", "ChaCha20-Poly1305", PSA_ALG_CHACHA20_POLY1305,
+     PSA_KEY_TYPE_CHACHA20, 256, PSA_KEY_USAGE_ENCRYPT, op_aead, 1},
+    {"sign", "ECDSA-P256-SHA-256", PSA_ALG_ECDSA(PSA_ALG_SHA_256),
+     ECC_P256_KEY_PAIR, 256, SIGN_VERIFY_HASH, op_sign_hash, 0},
+    {"verify", "ECDSA-P256-SHA-256", PSA_ALG_ECDSA(PSA_ALG_SHA_256),
+     ECC_P256_KEY_PAIR, 256, SIGN_VERIFY_HASH, op_verify_hash, 0},
+    {"key_agreement", "ECDH-P256", PSA_ALG_ECDH, ECC_P256_KEY_PAIR, 256,
+     PSA_KEY_USAGE_DERIVE, op_key_agreement, 0},
+    {"sign", "RSA-2048-PKCS1v15-SHA-256",
+     PSA_ALG_RSA_PKCS1V15_SIGN(PSA_ALG_SHA_256), PSA_KEY_TYPE_RSA_KEY_PAIR,
+     2048, SIGN_VERIFY_HASH, op_sign_hash, 0},
+    {"verify", "RSA-2048-PKCS1v15-SHA-256",
+     PSA_ALG_RSA_PKCS1V15_SIGN(PSA_ALG_SHA_256), PSA_KEY_TYPE_RSA_KEY_PAIR,
+     2048, SIGN_VERIFY_HASH, op_verify_hash, 0},
+};
+
+#define BENCH_NUM_CASES (sizeof(bench_cases) / sizeof(bench_cases[0]))
+
+/**
+ * \brief Creates the key of a case, and the signature or the public key of the
+ *        peer that its operation needs. Symmetric keys are imported and
+ *        asymmetric keys are generated.
+ */
+static psa_status_t bench_setup(const struct bench_case_t *bc)
+{
+    psa_key_attributes_t attributes = PSA_KEY_ATTRIBUTES_INIT;
+    psa_key_id_t peer = PSA_KEY_ID_NULL;
+    psa_status_t status;
+
+    bench_key = PSA_KEY_ID_NULL;
+    if (bc->key_type == 0) {
+        return PSA_SUCCESS;
+    }
+
+    psa_set_key_type(&attributes, bc->key_type);
+    psa_set_key_bits(&attributes, bc->key_bits);
+    psa_set_key_usage_flags(&attributes, bc->usage);
+    psa_set_key_algorithm(&attributes, bc->alg);
+
+    if (PSA_KEY_TYPE_IS_ASYMMETRIC(bc->key_type)) {
+        status = psa_generate_key(&attributes, &bench_key);
+    } else {
+        status = psa_import_key(&attributes, bench_key_data,
+                                PSA_BITS_TO_BYTES(bc->key_bits), &bench_key);
+    }
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    if (bc->op == op_verify_hash) {
+        status = op_sign_hash(bc, 0);
+    } else if (bc->op == op_key_agreement) {
+        status = psa_generate_key(&attributes, &peer);
+        if (status == PSA_SUCCESS) {
+            status = psa_export_public_key(peer, bench_peer_key,
+                                           sizeof(bench_peer_key),
+                                           &bench_peer_key_len);
+            (void)psa_destroy_key(peer);
+        }
+    }
+
+    if (status != PSA_SUCCESS) {
+        (void)psa_destroy_key(bench_key);
+        bench_key = PSA_KEY_ID_NULL;
+    }
+
+    return status;
+}
+
+/**
+ * \brief Repeats the operation of a case for at least min_time_ms, after a
+ *        first run which is not measured.
+ */
+static psa_status_t bench_measure(const struct bench_case_t *bc, size_t size,
+                                  uint32_t min_time_ms, uint64_t *iterations,
+                                  uint64_t *elapsed_ns)
+{
+    uint64_t min_ns = (uint64_t)min_time_ms * BENCH_NS_PER_MS;
+    uint64_t start, now, count = 0;
+    psa_status_t status;
+
+    status = bc->op(bc, size);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    start = crypto_bench_time_ns();
+    do {
+        status = bc->op(bc, size);
+        if (status != PSA_SUCCESS) {
+            return status;
+        }
+        count++;
+        now = crypto_bench_time_ns();
+    } while ((now - start) < min_ns);
+
+    *iterations = count;
+    *elapsed_ns = (now > start) ? (now - start) : 1;
+
+    return PSA_SUCCESS;
+}
+
+static void bench_print(const struct bench_case_t *bc, size_t size,
+                        uint32_t cpu_mhz, uint64_t iterations,
+                        uint64_t elapsed_ns)
+{
+    uint64_t ops_per_s = (iterations * BENCH_NS_PER_S) / elapsed_ns;
+    uint64_t centi_cycles;
+
+    printf("%s,%s,%zu,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",",
+           bc->category, bc->name, size, iterations, elapsed_ns / iterations,
+           ops_per_s, ops_per_s * size);
+
+    if (cpu_mhz == 0) {
+        printf(",\n");
+        return;
+    }
+
+    /* Cycles per operation, and per byte with two decimals */
+    printf("%" PRIu64 ",", (elapsed_ns * cpu_mhz) / (iterations * 1000u));
+    if (size == 0) {
+        printf("\n");
+        return;
+    }
+    centi_cycles = (elapsed_ns * cpu_mhz * 100u) / (iterations * 1000u * size);
+    printf("%" PRIu64 ".%02" PRIu64 "\n", centi_cycles / 100u,
+           centi_cycles % 100u);
+}
+
+int crypto_bench_run(const struct crypto_bench_params_t *params)
+{
+    const struct bench_case_t *bc;
+    uint64_t iterations, elapsed_ns;
+    psa_status_t status;
+    size_t i, size;
+    int ret = 0;
+
+    for (i = 0; i < sizeof(bench_input); i++) {
+        bench_input[i] = (uint8_t)i;
+    }
+    for (i = 0; i < sizeof(bench_hash); i++) {
+        bench_hash[i] = (uint8_t)(0xA5u ^ i);
+    }
+
+    printf("category,algorithm,size,iterations,ns_per_op,ops_per_s,"
+           "bytes_per_s,cycles_per_op,cycles_per_byte\n");
+
+    for (i = 0; i < BENCH_NUM_CASES; i++) {
+        bc = &bench_cases[i];
+        if (((params->category != NULL) &&
+             (strcmp(params->category, bc->category) != 0)) ||
+            ((params->algorithm != NULL) &&
+             (strstr(bc->name, params->algorithm) == NULL))) {
+            continue;
+        }
+
+        status = bench_setup(bc);
+        if (status == PSA_ERROR_NOT_SUPPORTED) {
+            printf("# %s,%s: not supported\n", bc->category, bc->name);
+            continue;
+        } else if (status != PSA_SUCCESS) {
+            printf("# %s,%s: setup failed (%d)\n", bc->category, bc->name,
+                   (int)status);
+            ret = 1;
+            continue;
+        }
+
+        for (size = CRYPTO_BENCH_MIN_SIZE; ; size *= 4) {
+            status = bench_measure(bc, bc->sized ? size : 0,
+                                   params->min_time_ms, &iterations,
+                                   &elapsed_ns);
+            if (status == PSA_ERROR_NOT_SUPPORTED) {
+                printf("# %s,%s: not supported\n", bc->category, bc->name);
+                break;
+            } else if (status != PSA_SUCCESS) {
+                printf("# %s,%s,%zu: failed (%d)\n", bc->category, bc->name,
+                       bc->sized ? size : 0, (int)status);
+                ret = 1;
+                break;
+            }
+
+            bench_print(bc, bc->sized ? size : 0, params->cpu_mhz, iterations,
+                        elapsed_ns);
+
+            if (!bc->sized || ((size * 4) > params->max_size)) {
+                break;
+            }
+        }
+
+        (void)psa_destroy_key(bench_key);
+    }
+
+    return ret;
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2022, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef __CRYPTO_BENCH_H__
+#define __CRYPTO_BENCH_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Smallest and largest buffer sizes of the sweep. Each size is four times the
+ * previous one.
+ */
+#define CRYPTO_BENCH_MIN_SIZE   16u
+#define CRYPTO_BENCH_MAX_SIZE   16384u
+
+/**
+ * \brief Parameters of a run of the benchmark.
+ */
+struct crypto_bench_params_t {
+    const char *category;  /**< Category of the cases to run, or NULL for all
+                            *   of them
+                            */
+    const char *algorithm; /**< Text contained in the algorithm name of the
+                            *   cases to run, or NULL for all of them
+                            */
+    size_t max_size;       /**< Largest buffer size of the sweep, at most
+                            *   CRYPTO_BENCH_MAX_SIZE
+                            */
+    uint32_t min_time_ms;  /**< Time for which each measurement is repeated */
+    uint32_t cpu_mhz;      /**< CPU frequency used to report cycles per byte,
+                            *   or 0 to leave them out
+                            */
+};
+
+/**
+ * \brief Runs the benchmark cases selected by the parameters through the PSA
+ *        Crypto API, and prints one CSV line per case and buffer size.
+ *
+ * \note  psa_crypto_init() must have been called.
+ *
+ * \param[in] params Parameters of the run
+ *
+ * \return 0 if every selected case that is supported by the crypto
+ *         configuration ran successfully, 1 otherwise
+ */
+int crypto_bench_run(const struct crypto_bench_params_t *params);
+
+/**
+ * \brief Returns the current time in nanoseconds. It is provided by the
+ *        platform the benchmark runs on.
+ */
+uint64_t crypto_bench_time_ns(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CRYPTO_BENCH_H__ */
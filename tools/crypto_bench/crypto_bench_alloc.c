@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) 2022, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/**
+ * \file  crypto_bench_alloc.c
+ *
+ * \brief Host use and checks of the size class allocator of the Crypto
+ *        service.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mbedtls/platform.h"
+#include "tfm_crypto_api.h"
+#include "crypto_bench_alloc.h"
+
+/* Heap of the allocator check, with its first-fit part */
+#define ALLOC_CHECK_HEAP_SIZE   (0x4000u)
+#define ALLOC_CHECK_FIRST_FIT   (0x2000u)
+
+/* Size of the allocations larger than the largest class */
+#define ALLOC_CHECK_LARGE       (6000u)
+
+/* Sizes between which the class switching workload alternates */
+#define ALLOC_CHECK_SMALL_SIZE  (40u)
+#define ALLOC_CHECK_BIG_SIZE    (1500u)
+#define ALLOC_CHECK_ROUNDS      (4u)
+
+#define ALLOC_CHECK_MAX_PTRS    (ALLOC_CHECK_HEAP_SIZE / 16u)
+
+static uint8_t check_heap[ALLOC_CHECK_HEAP_SIZE];
+static uint8_t *check_ptrs[ALLOC_CHECK_MAX_PTRS];
+
+/* Invalid releases made by the check, which are counted instead of stopping
+ * the benchmark
+ */
+static bool check_traps_expected;
+static uint32_t check_traps;
+
+#define ALLOC_CHECK(cond)                                                   \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            fprintf(stderr, "alloc-check: line %d: %s\n", __LINE__, #cond); \
+            return 1;                                                       \
+        }                                                                   \
+    } while (0)
+
+int crypto_bench_alloc_init(uint8_t *buf, size_t size, size_t first_fit_size)
+{
+    if (tfm_crypto_engine_alloc_init(buf, size, first_fit_size) !=
+        PSA_SUCCESS) {
+        return -1;
+    }
+
+    return (mbedtls_platform_set_calloc_free(tfm_crypto_engine_calloc,
+                                             tfm_crypto_engine_free) == 0) ?
+           0 : -1;
+}
+
+void crypto_bench_alloc_trap(void)
+{
+    if (!check_traps_expected) {
+        fprintf(stderr, "The heap of Mbed Crypto is corrupted\n");
+        abort();
+    }
+
+    check_traps++;
+}
+
+void crypto_bench_alloc_report(void)
+{
+    struct tfm_crypto_engine_alloc_stats_t stats;
+    struct tfm_crypto_engine_alloc_class_stats_t cls;
+    uint32_t i;
+
+    if (tfm_crypto_engine_alloc_get_stats(&stats) != PSA_SUCCESS) {
+        return;
+    }
+
+    printf("# heap: size %zu, peak in use %zu, unused %zu, free in classes "
+           "%zu, allocations %u, failed %u\n", stats.heap_size,
+           stats.peak_in_use, stats.unused, stats.free_in_classes,
+           (unsigned)stats.num_allocs, (unsigned)stats.num_failed);
+    printf("# heap: first-fit size %zu, in use %zu, allocations %u\n",
+           stats.first_fit_size, stats.first_fit_in_use,
+           (unsigned)stats.num_first_fit_allocs);
+
+    for (i = 0; i < stats.num_classes; i++) {
+        if ((tfm_crypto_engine_alloc_get_class_stats(i, &cls) ==
+             PSA_SUCCESS) && (cls.num_blocks != 0)) {
+            printf("# heap: class %zu, blocks %u, peak in use %u\n",
+                   cls.block_size, (unsigned)cls.num_blocks,
+                   (unsigned)cls.max_in_use);
+        }
+    }
+}
+
+static int check_zeroed(const uint8_t *p, size_t len)
+{
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        if (p[i] != 0) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * \brief Allocates blocks of a size until the heap is full, fills each one
+ *        with its own pattern, then checks the patterns and frees them.
+ *
+ * \return Returns the number of blocks allocated, or 0 if a check failed.
+ */
+static uint32_t check_fill_heap(size_t len)
+{
+    struct tfm_crypto_engine_alloc_stats_t stats;
+    uint32_t num = 0;
+    uint32_t i;
+    size_t j;
+
+    while (num < ALLOC_CHECK_MAX_PTRS) {
+        check_ptrs[num] = tfm_crypto_engine_calloc(1, len);
+        if (check_ptrs[num] == NULL) {
+            break;
+        }
+        if ((check_ptrs[num] < check_heap) ||
+            (check_ptrs[num] + len > check_heap + sizeof(check_heap)) ||
+            !check_zeroed(check_ptrs[num], len)) {
+            return 0;
+        }
+        memset(check_ptrs[num], (int)(num + 1), len);
+        num++;
+    }
+
+    for (i = 0; i < num; i++) {
+        for (j = 0; j < len; j++) {
+            if (check_ptrs[i][j] != (uint8_t)(i + 1)) {
+                return 0;
+            }
+        }
+        tfm_crypto_engine_free(check_ptrs[i]);
+    }
+
+    if ((tfm_crypto_engine_alloc_get_stats(&stats) != PSA_SUCCESS) ||
+        (stats.in_use != 0) || (stats.requested != 0)) {
+        return 0;
+    }
+
+    return num;
+}
+
+int crypto_bench_alloc_check(void)
+{
+    struct tfm_crypto_engine_alloc_stats_t stats;
+    struct tfm_crypto_engine_alloc_stats_t before;
+    uint32_t num_small[ALLOC_CHECK_ROUNDS];
+    uint32_t num_big[ALLOC_CHECK_ROUNDS];
+    uint8_t *large;
+    uint8_t *other;
+    uint32_t round;
+
+    ALLOC_CHECK(tfm_crypto_engine_alloc_init(check_heap, sizeof(check_heap),
+                                             ALLOC_CHECK_FIRST_FIT) ==
+                PSA_SUCCESS);
+
+    /* An allocation larger than the largest class is served by the
+     * first-fit heap, and its space can be reused once it is freed.
+     */
+    large = tfm_crypto_engine_calloc(1, ALLOC_CHECK_LARGE);
+    ALLOC_CHECK(large != NULL);
+    ALLOC_CHECK(check_zeroed(large, ALLOC_CHECK_LARGE));
+    memset(large, 0x5A, ALLOC_CHECK_LARGE);
+    ALLOC_CHECK(tfm_crypto_engine_calloc(1, ALLOC_CHECK_LARGE) == NULL);
+
+    other = tfm_crypto_engine_calloc(1, 64);
+    ALLOC_CHECK(other != NULL);
+    ALLOC_CHECK((other + 64 <= large) || (other >= large + ALLOC_CHECK_LARGE));
+
+    ALLOC_CHECK(tfm_crypto_engine_alloc_get_stats(&stats) == PSA_SUCCESS);
+    ALLOC_CHECK(stats.num_first_fit_allocs == 1);
+    ALLOC_CHECK(stats.first_fit_in_use >= ALLOC_CHECK_LARGE);
+
+    tfm_crypto_engine_free(large);
+    tfm_crypto_engine_free(other);
+    large = tfm_crypto_engine_calloc(1, ALLOC_CHECK_LARGE);
+    ALLOC_CHECK(large != NULL);
+    ALLOC_CHECK(check_zeroed(large, ALLOC_CHECK_LARGE));
+    tfm_crypto_engine_free(large);
+
+    /* Releases of a pointer into an allocation, of a pointer outside of the
+     * heap and double frees are trapped, and leave the heap unchanged.
+     */
+    large = tfm_crypto_engine_calloc(1, ALLOC_CHECK_LARGE);
+    other = tfm_crypto_engine_calloc(1, 64);
+    ALLOC_CHECK((large != NULL) && (other != NULL));
+    ALLOC_CHECK(tfm_crypto_engine_alloc_get_stats(&before) == PSA_SUCCESS);
+
+    check_traps_expected = true;
+    tfm_crypto_engine_free(large + 64);
+    tfm_crypto_engine_free(other + 8);
+    tfm_crypto_engine_free(&stats);
+    check_traps_expected = false;
+    ALLOC_CHECK(check_traps == 3);
+    ALLOC_CHECK(tfm_crypto_engine_alloc_get_stats(&stats) == PSA_SUCCESS);
+    ALLOC_CHECK((stats.in_use == before.in_use) &&
+                (stats.requested == before.requested));
+
+    tfm_crypto_engine_free(large);
+    tfm_crypto_engine_free(other);
+    check_traps_expected = true;
+    tfm_crypto_engine_free(large);
+    tfm_crypto_engine_free(other);
+    check_traps_expected = false;
+    ALLOC_CHECK(check_traps == 5);
+    ALLOC_CHECK(tfm_crypto_engine_alloc_get_stats(&stats) == PSA_SUCCESS);
+    ALLOC_CHECK((stats.in_use == 0) && (stats.requested == 0));
+
+    /* Allocations beyond the whole heap fail */
+    ALLOC_CHECK(tfm_crypto_engine_calloc(1, ALLOC_CHECK_HEAP_SIZE) == NULL);
+
+    /* The small allocations carve the whole heap into small blocks. The big
+     * ones, for which no class has a block left, must still be served by the
+     * first-fit heap, round after round.
+     */
+    for (round = 0; round < ALLOC_CHECK_ROUNDS; round++) {
+        num_small[round] = check_fill_heap(ALLOC_CHECK_SMALL_SIZE);
+        num_big[round] = check_fill_heap(ALLOC_CHECK_BIG_SIZE);
+
+        ALLOC_CHECK(num_small[round] != 0);
+        ALLOC_CHECK(num_big[round] >= (ALLOC_CHECK_FIRST_FIT /
+                                       (ALLOC_CHECK_BIG_SIZE + 16u)));
+        ALLOC_CHECK(num_small[round] == num_small[0]);
+        ALLOC_CHECK(num_big[round] == num_big[0]);
+    }
+
+    ALLOC_CHECK(tfm_crypto_engine_alloc_get_stats(&stats) == PSA_SUCCESS);
+    ALLOC_CHECK(stats.unused < 24u);
+
+    /* A chunk size of 0 in a corrupted header is trapped by the walk of the
+     * first-fit heap, which would not end otherwise. The size is the second
+     * word of the header which precedes the allocation.
+     */
+    large = tfm_crypto_engine_calloc(1, ALLOC_CHECK_LARGE);
+    ALLOC_CHECK(large != NULL);
+    ((uint32_t *)large)[-3] = 0;
+    check_traps_expected = true;
+    ALLOC_CHECK(tfm_crypto_engine_calloc(1, ALLOC_CHECK_LARGE) == NULL);
+    check_traps_expected = false;
+    ALLOC_CHECK(check_traps == 6);
+
+    printf("alloc-check: %u allocations of %u bytes and %u of %u bytes "
+           "per round, all passed\n", (unsigned)num_small[0],
+           (unsigned)ALLOC_CHECK_SMALL_SIZE, (unsigned)num_big[0],
+           (unsigned)ALLOC_CHECK_BIG_SIZE);
+
+    return 0;
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2022, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/**
+ * \file  crypto_bench_alloc.h
+ *
+ * \brief Host use of the size class allocator of the Crypto service, built
+ *        with CRYPTO_ENGINE_SIZE_CLASS_ALLOC.
+ */
+
+#ifndef __CRYPTO_BENCH_ALLOC_H__
+#define __CRYPTO_BENCH_ALLOC_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Serves the allocations of Mbed Crypto from the size class allocator
+ *        on a buffer, as the Crypto service does.
+ *
+ * \param[in] buf             Buffer holding the heap
+ * \param[in] size            Size of the buffer in bytes
+ * \param[in] first_fit_size  Size of the first-fit heap at the end of the
+ *                            buffer
+ *
+ * \return Returns 0 on success, or -1 on error.
+ */
+int crypto_bench_alloc_init(uint8_t *buf, size_t size, size_t first_fit_size);
+
+/**
+ * \brief Called by the allocator on a release of a pointer which is not an
+ *        allocation in use, or on a corrupted header, instead of stopping
+ *        the service. It aborts the benchmark, unless the check expects it.
+ */
+void crypto_bench_alloc_trap(void);
+
+/**
+ * \brief Prints the statistics of the heap, as comment lines of the output.
+ */
+void crypto_bench_alloc_report(void);
+
+/**
+ * \brief Checks the size class allocator on a heap of its own: allocations
+ *        larger than the largest class, invalid releases and corrupted
+ *        headers, and a workload which moves from small to large sizes once
+ *        the small ones have taken the whole heap. The allocator is left
+ *        uninitialised.
+ *
+ * \return Returns 0 if all the checks pass, or 1 otherwise.
+ */
+int crypto_bench_alloc_check(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CRYPTO_BENCH_ALLOC_H__ */
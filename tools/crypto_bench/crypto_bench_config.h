@@ -0,0 +1,22 @@
+/*
+ * Copyright (c) 2022, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Mbed Crypto configuration appended to the configuration under test in the
+ * host build of the benchmark. The algorithms and their options are kept, and
+ * only the integration with the SPM and with the ITS service is removed, as
+ * the library is called directly.
+ */
+
+#ifndef __CRYPTO_BENCH_CONFIG_H__
+#define __CRYPTO_BENCH_CONFIG_H__
+
+#undef MBEDTLS_PSA_CRYPTO_SPM
+#undef MBEDTLS_PSA_CRYPTO_STORAGE_C
+#undef MBEDTLS_PSA_CRYPTO_KEY_ID_ENCODES_OWNER
+
+#endif /* __CRYPTO_BENCH_CONFIG_H__ */
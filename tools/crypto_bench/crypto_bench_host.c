@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2022, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/**
+ * \file  crypto_bench_host.c
+ *
+ * \brief Host front end of the crypto benchmark. Mbed Crypto is built with the
+ *        configuration under test and allocates from a static heap of
+ *        CRYPTO_ENGINE_BUF_SIZE bytes, as in the Crypto service. The heap is
+ *        managed by the size class allocator of the service if
+ *        TFM_CRYPTO_ENGINE_SIZE_CLASS_ALLOC is defined. The NV seed is read
+ *        from the host random source, see crypto_bench_nv_seed.c.
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mbedtls/build_info.h"
+#ifdef MBEDTLS_MEMORY_BUFFER_ALLOC_C
+#include "mbedtls/memory_buffer_alloc.h"
+#endif
+#include "psa/crypto.h"
+#include "crypto_bench.h"
+#ifdef TFM_CRYPTO_ENGINE_SIZE_CLASS_ALLOC
+#include "crypto_bench_alloc.h"
+#endif
+
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C) || \
+    defined(TFM_CRYPTO_ENGINE_SIZE_CLASS_ALLOC)
+static unsigned char bench_heap[CRYPTO_ENGINE_BUF_SIZE];
+#endif
+
+uint64_t crypto_bench_time_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64_t)ts.tv_sec * 1000000000u) + (uint64_t)ts.tv_nsec;
+}
+
+static void usage(const char *prog)
+{
+    printf("Usage: %s [options]\n"
+           "  -c <category>   Run the cases of one category: hash, mac,\n"
+           "                  cipher, aead, sign, verify or key_agreement\n"
+           "  -a <algorithm>  Run the cases whose algorithm name contains\n"
+           "                  the text, e.g. SHA-256 or P256\n"
+           "  -s <size>       Largest buffer size (default %u)\n"
+           "  -t <ms>         Time of each measurement (default 200)\n"
+           "  -f <MHz>        CPU frequency, to report cycles\n"
+#ifdef TFM_CRYPTO_ENGINE_SIZE_CLASS_ALLOC
+           "  -m              Check the size class allocator and exit\n"
+#endif
+           "  -h              Print this help\n",
+           prog, CRYPTO_BENCH_MAX_SIZE);
+}
+
+int main(int argc, char *argv[])
+{
+    struct crypto_bench_params_t params = {
+        .category = NULL,
+        .algorithm = NULL,
+        .max_size = CRYPTO_BENCH_MAX_SIZE,
+        .min_time_ms = 200,
+        .cpu_mhz = 0,
+    };
+    psa_status_t status;
+    int opt;
+    int ret;
+
+    while ((opt = getopt(argc, argv, "c:a:s:t:f:mh")) != -1) {
+        switch (opt) {
+        case 'c': params.category = optarg; break;
+        case 'a': params.algorithm = optarg; break;
+        case 's': params.max_size = strtoul(optarg, NULL, 0); break;
+        case 't': params.min_time_ms = strtoul(optarg, NULL, 0); break;
+        case 'f': params.cpu_mhz = strtoul(optarg, NULL, 0); break;
+#ifdef TFM_CRYPTO_ENGINE_SIZE_CLASS_ALLOC
+        case 'm': return crypto_bench_alloc_check();
+#endif
+        case 'h':
+            usage(argv[0]);
+            return 0;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if ((params.max_size < CRYPTO_BENCH_MIN_SIZE) ||
+        (params.max_size > CRYPTO_BENCH_MAX_SIZE)) {
+        fprintf(stderr, "The largest size must be between %u and %u\n",
+                CRYPTO_BENCH_MIN_SIZE, CRYPTO_BENCH_MAX_SIZE);
+        return 2;
+    }
+
+#if defined(TFM_CRYPTO_ENGINE_SIZE_CLASS_ALLOC)
+    if (crypto_bench_alloc_init(bench_heap, sizeof(bench_heap),
+                                CRYPTO_ENGINE_FIRST_FIT_SIZE) != 0) {
+        fprintf(stderr, "The size class allocator cannot be initialised\n");
+        return 1;
+    }
+#elif defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C)
+    mbedtls_memory_buffer_alloc_init(bench_heap, sizeof(bench_heap));
+#endif
+
+    status = psa_crypto_init();
+    if (status != PSA_SUCCESS) {
+        fprintf(stderr, "psa_crypto_init failed (%d)\n", (int)status);
+        return 1;
+    }
+
+    ret = crypto_bench_run(&params);
+
+#ifdef TFM_CRYPTO_ENGINE_SIZE_CLASS_ALLOC
+    crypto_bench_alloc_report();
+#endif
+
+    return ret;
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2022, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/**
+ * \file  crypto_bench_nv_seed.c
+ *
+ * \brief NV seed of the host builds of Mbed Crypto, read from the host random
+ *        source. Updates of the seed are dropped.
+ */
+
+#include <stdio.h>
+
+#include "tfm_plat_crypto_nv_seed.h"
+
+int tfm_plat_crypto_nv_seed_read(unsigned char *buf, size_t buf_len)
+{
+    FILE *f = fopen("/dev/urandom", "rb");
+    size_t len = 0;
+
+    if (f != NULL) {
+        len = fread(buf, 1, buf_len, f);
+        fclose(f);
+    }
+
+    return (len == buf_len) ? TFM_CRYPTO_NV_SEED_SUCCESS :
+                              TFM_CRYPTO_NV_SEED_FAILED;
+}
+
+int tfm_plat_crypto_nv_seed_write(const unsigned char *buf, size_t buf_len)
+{
+    (void)buf;
+    (void)buf_len;
+
+    return TFM_CRYPTO_NV_SEED_SUCCESS;
+}
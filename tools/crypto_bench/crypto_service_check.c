@@ -0,0 +1,303 @@
+/*
+ * Copyright (c) 2022, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/**
+ * \file  crypto_service_check.c
+ *
+ * \brief Host check of the key management and MAC modules of the Crypto
+ *        service. The modules are built as in the service, against an Mbed
+ *        Crypto build which encodes the owner in the key ids, and their
+ *        handlers are called with the IOVECs of the library model, from a
+ *        single caller. The check covers the HMAC setup states kept with
+ *        TFM_CRYPTO_MAC_KEY_CACHE_SIZE when the id of a released key is
+ *        given to another key.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "tfm_mbedcrypto_include.h"
+#include "mbedtls/md.h"
+#ifdef MBEDTLS_MEMORY_BUFFER_ALLOC_C
+#include "mbedtls/memory_buffer_alloc.h"
+#endif
+#include "tfm_crypto_api.h"
+#include "tfm_crypto_defs.h"
+
+#ifndef TFM_CRYPTO_MAC_KEY_CACHE_SIZE
+#define TFM_CRYPTO_MAC_KEY_CACHE_SIZE (0)
+#endif
+
+/* Partition id of the caller of all the requests */
+#define SERVICE_CHECK_CALLER_ID  (-1)
+
+#define SERVICE_CHECK_ALG        PSA_ALG_HMAC(PSA_ALG_SHA_256)
+#define SERVICE_CHECK_MAC_SIZE   PSA_HASH_LENGTH(PSA_ALG_SHA_256)
+
+#define SERVICE_CHECK(cond)                                                   \
+    do {                                                                      \
+        if (!(cond)) {                                                        \
+            fprintf(stderr, "service-check: line %d: %s\n", __LINE__, #cond); \
+            return 1;                                                         \
+        }                                                                     \
+    } while (0)
+
+#ifdef MBEDTLS_MEMORY_BUFFER_ALLOC_C
+static unsigned char check_heap[CRYPTO_ENGINE_BUF_SIZE];
+#endif
+
+static const uint8_t key_a[32] = {
+    0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+    0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+    0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+    0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+};
+
+static const uint8_t key_b[32] = {
+    0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22,
+    0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22,
+    0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22,
+    0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22,
+};
+
+/* Shorter than the others, so that its attributes differ */
+static const uint8_t key_c[16] = {
+    0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x33,
+    0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x33,
+};
+
+static const uint8_t message[] = "The same message under each key";
+
+psa_status_t tfm_crypto_get_caller_id(int32_t *id)
+{
+    *id = SERVICE_CHECK_CALLER_ID;
+
+    return PSA_SUCCESS;
+}
+
+static void check_key_attributes(struct psa_client_key_attributes_s *attr)
+{
+    struct psa_client_key_attributes_s init = PSA_CLIENT_KEY_ATTRIBUTES_INIT;
+
+    *attr = init;
+    attr->type = PSA_KEY_TYPE_HMAC;
+    attr->lifetime = PSA_KEY_LIFETIME_VOLATILE;
+    attr->usage = PSA_KEY_USAGE_SIGN_MESSAGE | PSA_KEY_USAGE_VERIFY_MESSAGE;
+    attr->alg = SERVICE_CHECK_ALG;
+}
+
+static psa_status_t check_import_key(const uint8_t *key, size_t key_len,
+                                     psa_key_id_t *key_id)
+{
+    struct tfm_crypto_pack_iovec iov = {.srv_id = TFM_CRYPTO_IMPORT_KEY_SID};
+    struct psa_client_key_attributes_s attr;
+
+    check_key_attributes(&attr);
+
+    psa_invec in_vec[] = {
+        {.base = &iov, .len = sizeof(iov)},
+        {.base = &attr, .len = sizeof(attr)},
+        {.base = key, .len = key_len},
+    };
+    psa_outvec out_vec[] = {
+        {.base = key_id, .len = sizeof(*key_id)},
+    };
+
+    return tfm_crypto_import_key(in_vec, 3, out_vec, 1);
+}
+
+/* Creates a key through the library, without going through the key
+ * management module, so that the cache is not told about it
+ */
+static psa_status_t check_import_key_directly(const uint8_t *key,
+                                              size_t key_len,
+                                              psa_key_id_t *key_id)
+{
+    struct psa_client_key_attributes_s attr;
+    psa_key_attributes_t key_attributes = PSA_KEY_ATTRIBUTES_INIT;
+    mbedtls_svc_key_id_t encoded_key;
+    psa_status_t status;
+
+    check_key_attributes(&attr);
+
+    status = tfm_crypto_key_attributes_from_client(&attr,
+                                                   SERVICE_CHECK_CALLER_ID,
+                                                   &key_attributes);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    status = psa_import_key(&key_attributes, key, key_len, &encoded_key);
+    *key_id = MBEDTLS_SVC_KEY_ID_GET_KEY_ID(encoded_key);
+
+    return status;
+}
+
+static psa_status_t check_key_request(uint32_t sid, psa_key_id_t key_id)
+{
+    struct tfm_crypto_pack_iovec iov = {.srv_id = sid, .key_id = key_id};
+    psa_invec in_vec[] = {
+        {.base = &iov, .len = sizeof(iov)},
+    };
+
+    switch (sid) {
+    case TFM_CRYPTO_CLOSE_KEY_SID:
+        return tfm_crypto_close_key(in_vec, 1, NULL, 0);
+    case TFM_CRYPTO_DESTROY_KEY_SID:
+        return tfm_crypto_destroy_key(in_vec, 1, NULL, 0);
+    default:
+        return PSA_ERROR_NOT_SUPPORTED;
+    }
+}
+
+static psa_status_t check_mac_compute(psa_key_id_t key_id, uint8_t *mac,
+                                      size_t *mac_len)
+{
+    struct tfm_crypto_pack_iovec iov = {
+        .srv_id = TFM_CRYPTO_MAC_COMPUTE_SID,
+        .key_id = key_id,
+        .alg = SERVICE_CHECK_ALG,
+    };
+    psa_invec in_vec[] = {
+        {.base = &iov, .len = sizeof(iov)},
+        {.base = message, .len = sizeof(message)},
+    };
+    psa_outvec out_vec[] = {
+        {.base = mac, .len = SERVICE_CHECK_MAC_SIZE},
+    };
+    psa_status_t status;
+
+    status = tfm_crypto_mac_compute(in_vec, 2, out_vec, 1);
+    *mac_len = out_vec[0].len;
+
+    return status;
+}
+
+static psa_status_t check_mac_verify(psa_key_id_t key_id, const uint8_t *mac)
+{
+    struct tfm_crypto_pack_iovec iov = {
+        .srv_id = TFM_CRYPTO_MAC_VERIFY_SID,
+        .key_id = key_id,
+        .alg = SERVICE_CHECK_ALG,
+    };
+    psa_invec in_vec[] = {
+        {.base = &iov, .len = sizeof(iov)},
+        {.base = message, .len = sizeof(message)},
+        {.base = mac, .len = SERVICE_CHECK_MAC_SIZE},
+    };
+
+    return tfm_crypto_mac_verify(in_vec, 3, NULL, 0);
+}
+
+static int check_reference_mac(const uint8_t *key, size_t key_len,
+                               uint8_t *mac)
+{
+    return mbedtls_md_hmac(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256),
+                           key, key_len, message, sizeof(message), mac);
+}
+
+/* Computes and verifies the MAC twice through the service, the second time
+ * from the saved setup state if the cache is enabled, and compares it with the
+ * MAC under the given key material.
+ */
+static int check_key_mac(psa_key_id_t key_id, const uint8_t *key,
+                         size_t key_len)
+{
+    uint8_t expected[SERVICE_CHECK_MAC_SIZE];
+    uint8_t mac[SERVICE_CHECK_MAC_SIZE];
+    size_t mac_len;
+    int i;
+
+    SERVICE_CHECK(check_reference_mac(key, key_len, expected) == 0);
+
+    for (i = 0; i < 2; i++) {
+        SERVICE_CHECK(check_mac_compute(key_id, mac, &mac_len) == PSA_SUCCESS);
+        SERVICE_CHECK(mac_len == sizeof(mac));
+        SERVICE_CHECK(memcmp(mac, expected, sizeof(mac)) == 0);
+        SERVICE_CHECK(check_mac_verify(key_id, expected) == PSA_SUCCESS);
+    }
+
+    return 0;
+}
+
+/* A key imported after a key is released gets its id back. Its MAC must be
+ * computed under its own material, and the released key must not be usable.
+ */
+static int check_id_reuse(uint32_t release_sid)
+{
+    uint8_t mac_a[SERVICE_CHECK_MAC_SIZE];
+    uint8_t mac[SERVICE_CHECK_MAC_SIZE];
+    psa_key_id_t id_a;
+    psa_key_id_t id_b;
+    size_t mac_len;
+
+    SERVICE_CHECK(check_import_key(key_a, sizeof(key_a), &id_a) ==
+                  PSA_SUCCESS);
+    SERVICE_CHECK(check_key_mac(id_a, key_a, sizeof(key_a)) == 0);
+    SERVICE_CHECK(check_reference_mac(key_a, sizeof(key_a), mac_a) == 0);
+
+    SERVICE_CHECK(check_key_request(release_sid, id_a) == PSA_SUCCESS);
+    SERVICE_CHECK(check_mac_compute(id_a, mac, &mac_len) != PSA_SUCCESS);
+
+    SERVICE_CHECK(check_import_key(key_b, sizeof(key_b), &id_b) ==
+                  PSA_SUCCESS);
+    SERVICE_CHECK(id_b == id_a);
+    SERVICE_CHECK(check_key_mac(id_b, key_b, sizeof(key_b)) == 0);
+    SERVICE_CHECK(check_mac_verify(id_b, mac_a) ==
+                  PSA_ERROR_INVALID_SIGNATURE);
+
+    SERVICE_CHECK(check_key_request(TFM_CRYPTO_DESTROY_KEY_SID, id_b) ==
+                  PSA_SUCCESS);
+
+    return 0;
+}
+
+/* The key is released and its id taken by another key through the library,
+ * so the cache is not told about either. The attributes of the new key differ
+ * from those of the saved state, which must not be used.
+ */
+static int check_id_reuse_unseen(void)
+{
+    mbedtls_svc_key_id_t encoded_key;
+    psa_key_id_t id_a;
+    psa_key_id_t id_c;
+
+    SERVICE_CHECK(check_import_key(key_a, sizeof(key_a), &id_a) ==
+                  PSA_SUCCESS);
+    SERVICE_CHECK(check_key_mac(id_a, key_a, sizeof(key_a)) == 0);
+
+    encoded_key = mbedtls_svc_key_id_make(SERVICE_CHECK_CALLER_ID, id_a);
+    SERVICE_CHECK(psa_close_key(encoded_key) == PSA_SUCCESS);
+
+    SERVICE_CHECK(check_import_key_directly(key_c, sizeof(key_c), &id_c) ==
+                  PSA_SUCCESS);
+    SERVICE_CHECK(id_c == id_a);
+    SERVICE_CHECK(check_key_mac(id_c, key_c, sizeof(key_c)) == 0);
+
+    SERVICE_CHECK(check_key_request(TFM_CRYPTO_DESTROY_KEY_SID, id_c) ==
+                  PSA_SUCCESS);
+
+    return 0;
+}
+
+int main(void)
+{
+#ifdef MBEDTLS_MEMORY_BUFFER_ALLOC_C
+    mbedtls_memory_buffer_alloc_init(check_heap, sizeof(check_heap));
+#endif
+
+    SERVICE_CHECK(psa_crypto_init() == PSA_SUCCESS);
+
+    SERVICE_CHECK(check_id_reuse(TFM_CRYPTO_CLOSE_KEY_SID) == 0);
+    SERVICE_CHECK(check_id_reuse(TFM_CRYPTO_DESTROY_KEY_SID) == 0);
+    SERVICE_CHECK(check_id_reuse_unseen() == 0);
+
+    printf("service-check: MAC key cache of %u entries, all passed\n",
+           (unsigned)TFM_CRYPTO_MAC_KEY_CACHE_SIZE);
+
+    return 0;
+}
@@ -0,0 +1,20 @@
+/*
+ * Copyright (c) 2022, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Mbed Crypto configuration appended to the configuration under test in the
+ * host build of the service check. The integration with the SPM and the owner
+ * encoded in the key ids are kept, as the modules of the Crypto service are
+ * built against it, and only the integration with the ITS service is removed.
+ */
+
+#ifndef __CRYPTO_SERVICE_CHECK_CONFIG_H__
+#define __CRYPTO_SERVICE_CHECK_CONFIG_H__
+
+#undef MBEDTLS_PSA_CRYPTO_STORAGE_C
+
+#endif /* __CRYPTO_SERVICE_CHECK_CONFIG_H__ */
@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) 2022, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef __CMSIS_COMPILER_H__
+#define __CMSIS_COMPILER_H__
+
+/* Minimal subset of the CMSIS compiler abstraction required to build the
+ * storage services for the host.
+ */
+
+#ifndef __STATIC_INLINE
+#define __STATIC_INLINE  static inline
+#endif
+
+#ifndef __WEAK
+#define __WEAK           __attribute__((weak))
+#endif
+
+#ifndef __PACKED_STRUCT
+#define __PACKED_STRUCT  struct __attribute__((packed))
+#endif
+
+#endif /* __CMSIS_COMPILER_H__ */
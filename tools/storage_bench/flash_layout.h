@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2022, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef __FLASH_LAYOUT_H__
+#define __FLASH_LAYOUT_H__
+
+/* Flash layout of the host storage benchmark. ITS and PS share the simulated
+ * flash device, and the location and size of their areas are chosen at
+ * runtime. Only the program unit is required at compile time, as it selects
+ * the flash interface implementation (NOR or NAND) and the filesystem
+ * alignment. When an area is emulated in RAM, its size is also set at compile
+ * time.
+ */
+
+#ifndef STORAGE_BENCH_PROGRAM_UNIT
+#define STORAGE_BENCH_PROGRAM_UNIT    (0x4)
+#endif
+
+/* Size of the NAND write buffers, which must hold a whole filesystem block */
+#ifndef STORAGE_BENCH_MAX_BLOCK_SIZE
+#define STORAGE_BENCH_MAX_BLOCK_SIZE  (0x10000)
+#endif
+
+/* Protected Storage (PS) Service definitions */
+#define TFM_HAL_PS_FLASH_DRIVER       Driver_FLASH_SIM
+#define TFM_HAL_PS_PROGRAM_UNIT       STORAGE_BENCH_PROGRAM_UNIT
+#define PS_FLASH_NAND_BUF_SIZE        STORAGE_BENCH_MAX_BLOCK_SIZE
+/* Size of the PS area when it is emulated in RAM (PS_RAM_FS) */
+#ifndef PS_RAM_FS_SIZE
+#define PS_RAM_FS_SIZE                (0x10000)
+#endif
+
+/* Internal Trusted Storage (ITS) Service definitions */
+#define TFM_HAL_ITS_FLASH_DRIVER      Driver_FLASH_SIM
+#define TFM_HAL_ITS_PROGRAM_UNIT      STORAGE_BENCH_PROGRAM_UNIT
+#define ITS_FLASH_NAND_BUF_SIZE       STORAGE_BENCH_MAX_BLOCK_SIZE
+/* Size of the ITS area when it is emulated in RAM (ITS_RAM_FS) */
+#ifndef ITS_RAM_FS_SIZE
+#define ITS_RAM_FS_SIZE               (0x4000)
+#endif
+
+#endif /* __FLASH_LAYOUT_H__ */
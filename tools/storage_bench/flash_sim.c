@@ -0,0 +1,406 @@
+/*
+ * Copyright (c) 2022, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "flash_sim.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Driver version */
+#define ARM_FLASH_DRV_VERSION      ARM_DRIVER_VERSION_MAJOR_MINOR(1, 0)
+
+/**
+ * \struct flash_sim_dev_t
+ *
+ * \brief State of the simulated flash device.
+ */
+struct flash_sim_dev_t {
+    struct flash_sim_cfg_t cfg;     /**< Device configuration */
+    struct _ARM_FLASH_INFO info;    /**< CMSIS flash information, set at
+                                     *   runtime from the configuration
+                                     */
+    uint8_t *mem;                   /**< Device content */
+    uint8_t *unit_programmed;       /**< Per program unit, non-zero if the unit
+                                     *   has been programmed since the last
+                                     *   erase
+                                     */
+    uint32_t *erase_count;          /**< Per sector erase count */
+    uint8_t *sector_torn;           /**< Per sector, non-zero if a program or
+                                     *   erase was interrupted
+                                     */
+    uint32_t power_loss_countdown;  /**< Operations until the power loss plus
+                                     *   one, or zero if none is scheduled
+                                     */
+    bool powered_off;               /**< True after a power loss */
+    uint32_t failure_countdown;     /**< Operations until the failure plus
+                                     *   one, or zero if none is scheduled
+                                     */
+    struct flash_sim_stats_t stats; /**< Operation counters */
+};
+
+static struct flash_sim_dev_t sim_dev;
+
+/* Flash Status */
+static ARM_FLASH_STATUS FlashStatus = {0, 0, 0};
+
+/* Driver Version */
+static const ARM_DRIVER_VERSION DriverVersion = {
+    ARM_FLASH_API_VERSION,
+    ARM_FLASH_DRV_VERSION
+};
+
+/* Driver Capabilities */
+static const ARM_FLASH_CAPABILITIES DriverCapabilities = {
+    0, /* event_ready */
+    0, /* data_width = 0:8-bit, 1:16-bit, 2:32-bit */
+    1  /* erase_chip */
+};
+
+static uint32_t flash_sim_size(void)
+{
+    return sim_dev.cfg.sector_size * sim_dev.cfg.sector_count;
+}
+
+/**
+ * \brief Checks whether the operation about to start is interrupted by a
+ *        scheduled power loss.
+ *
+ * \return Returns true if the operation must be interrupted.
+ */
+static bool flash_sim_power_loss_now(void)
+{
+    if (sim_dev.power_loss_countdown == 0) {
+        return false;
+    }
+
+    if (--sim_dev.power_loss_countdown == 0) {
+        sim_dev.powered_off = true;
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * \brief Checks whether the operation about to start fails because of a
+ *        scheduled failure.
+ *
+ * \return Returns true if the operation must fail.
+ */
+static bool flash_sim_failure_now(void)
+{
+    if (sim_dev.failure_countdown == 0) {
+        return false;
+    }
+
+    return (--sim_dev.failure_countdown == 0);
+}
+
+static void flash_sim_erase_sector(uint32_t sector, uint32_t size)
+{
+    uint32_t units_per_sector = sim_dev.cfg.sector_size
+                                / sim_dev.cfg.program_unit;
+
+    memset(sim_dev.mem + (sector * sim_dev.cfg.sector_size),
+           sim_dev.cfg.erased_value, size);
+    memset(sim_dev.unit_programmed + (sector * units_per_sector), 0,
+           size / sim_dev.cfg.program_unit);
+
+    sim_dev.erase_count[sector]++;
+    sim_dev.stats.erase_ops++;
+    sim_dev.stats.time_ns += (uint64_t)sim_dev.cfg.erase_us_per_sector * 1000;
+}
+
+int flash_sim_create(const struct flash_sim_cfg_t *cfg)
+{
+    uint32_t size;
+
+    if ((cfg->sector_size == 0) || (cfg->sector_count == 0) ||
+        (cfg->program_unit == 0) ||
+        (cfg->sector_size % cfg->program_unit != 0)) {
+        return -1;
+    }
+
+    flash_sim_destroy();
+
+    sim_dev.cfg = *cfg;
+    size = flash_sim_size();
+
+    sim_dev.mem = malloc(size);
+    sim_dev.unit_programmed = calloc(size / cfg->program_unit, 1);
+    sim_dev.erase_count = calloc(cfg->sector_count, sizeof(uint32_t));
+    sim_dev.sector_torn = calloc(cfg->sector_count, 1);
+    if ((sim_dev.mem == NULL) || (sim_dev.unit_programmed == NULL) ||
+        (sim_dev.erase_count == NULL) || (sim_dev.sector_torn == NULL)) {
+        flash_sim_destroy();
+        return -1;
+    }
+
+    memset(sim_dev.mem, cfg->erased_value, size);
+
+    sim_dev.info.sector_info = NULL; /* Uniform sector layout */
+    sim_dev.info.sector_count = cfg->sector_count;
+    sim_dev.info.sector_size = cfg->sector_size;
+    sim_dev.info.page_size = cfg->program_unit;
+    sim_dev.info.program_unit = cfg->program_unit;
+    sim_dev.info.erased_value = cfg->erased_value;
+
+    return 0;
+}
+
+void flash_sim_destroy(void)
+{
+    free(sim_dev.mem);
+    free(sim_dev.unit_programmed);
+    free(sim_dev.erase_count);
+    free(sim_dev.sector_torn);
+    memset(&sim_dev, 0, sizeof(sim_dev));
+}
+
+void flash_sim_get_stats(struct flash_sim_stats_t *stats)
+{
+    *stats = sim_dev.stats;
+}
+
+void flash_sim_reset_stats(void)
+{
+    memset(&sim_dev.stats, 0, sizeof(sim_dev.stats));
+}
+
+uint32_t flash_sim_get_erase_count(uint32_t sector)
+{
+    if (sector >= sim_dev.cfg.sector_count) {
+        return 0;
+    }
+
+    return sim_dev.erase_count[sector];
+}
+
+void flash_sim_schedule_power_loss(uint32_t num_ops)
+{
+    sim_dev.power_loss_countdown = (num_ops == 0) ? 0 : num_ops + 1;
+}
+
+void flash_sim_schedule_failure(uint32_t num_ops)
+{
+    sim_dev.failure_countdown = num_ops + 1;
+}
+
+bool flash_sim_is_powered_off(void)
+{
+    return sim_dev.powered_off;
+}
+
+void flash_sim_power_cycle(void)
+{
+    sim_dev.powered_off = false;
+    sim_dev.power_loss_countdown = 0;
+}
+
+/*
+ * CMSIS flash interface
+ */
+
+static ARM_DRIVER_VERSION ARM_Flash_GetVersion(void)
+{
+    return DriverVersion;
+}
+
+static ARM_FLASH_CAPABILITIES ARM_Flash_GetCapabilities(void)
+{
+    return DriverCapabilities;
+}
+
+static int32_t ARM_Flash_Initialize(ARM_Flash_SignalEvent_t cb_event)
+{
+    (void)cb_event;
+
+    if (sim_dev.mem == NULL) {
+        return ARM_DRIVER_ERROR;
+    }
+
+    return ARM_DRIVER_OK;
+}
+
+static int32_t ARM_Flash_Uninitialize(void)
+{
+    /* Nothing to be done */
+    return ARM_DRIVER_OK;
+}
+
+static int32_t ARM_Flash_PowerControl(ARM_POWER_STATE state)
+{
+    switch (state) {
+    case ARM_POWER_FULL:
+        /* Nothing to be done */
+        return ARM_DRIVER_OK;
+    case ARM_POWER_OFF:
+    case ARM_POWER_LOW:
+    default:
+        return ARM_DRIVER_ERROR_UNSUPPORTED;
+    }
+}
+
+static int32_t ARM_Flash_ReadData(uint32_t addr, void *data, uint32_t cnt)
+{
+    uint32_t sector;
+
+    if (sim_dev.powered_off) {
+        return ARM_DRIVER_ERROR;
+    }
+
+    if ((addr > flash_sim_size()) || (cnt > flash_sim_size() - addr)) {
+        return ARM_DRIVER_ERROR_PARAMETER;
+    }
+
+    /* Reading data whose update was interrupted is detected, if the device
+     * supports it.
+     */
+    if (sim_dev.cfg.detect_torn_writes) {
+        for (sector = addr / sim_dev.cfg.sector_size;
+             (cnt > 0) && (sector <= (addr + cnt - 1) / sim_dev.cfg.sector_size);
+             sector++) {
+            if (sim_dev.sector_torn[sector]) {
+                return ARM_DRIVER_ERROR;
+            }
+        }
+    }
+
+    memcpy(data, sim_dev.mem + addr, cnt);
+
+    sim_dev.stats.read_ops++;
+    sim_dev.stats.read_bytes += cnt;
+    sim_dev.stats.time_ns += (uint64_t)cnt * sim_dev.cfg.read_ns_per_byte;
+
+    return (int32_t)cnt;
+}
+
+static int32_t ARM_Flash_ProgramData(uint32_t addr, const void *data,
+                                     uint32_t cnt)
+{
+    uint32_t unit = sim_dev.cfg.program_unit;
+    uint32_t num_units;
+    uint32_t i;
+    const uint8_t *src = data;
+    uint8_t *dst;
+
+    if (sim_dev.powered_off) {
+        return ARM_DRIVER_ERROR;
+    }
+
+    /* Check flash memory boundaries and alignment with minimal write size */
+    if ((addr > flash_sim_size()) || (cnt > flash_sim_size() - addr) ||
+        (addr % unit != 0) || (cnt % unit != 0)) {
+        return ARM_DRIVER_ERROR_PARAMETER;
+    }
+
+    num_units = cnt / unit;
+
+    /* Each program unit can only be programmed once after it is erased,
+     * unless the device can reprogram bits.
+     */
+    for (i = 0; i < num_units && !sim_dev.cfg.reprogram; i++) {
+        if (sim_dev.unit_programmed[(addr / unit) + i]) {
+            return ARM_DRIVER_ERROR;
+        }
+    }
+
+    if (flash_sim_failure_now()) {
+        return ARM_DRIVER_ERROR;
+    }
+
+    if (flash_sim_power_loss_now()) {
+        /* Only the first half of the data reaches the flash */
+        num_units /= 2;
+        sim_dev.sector_torn[addr / sim_dev.cfg.sector_size] = 1;
+    }
+
+    /* Programming only moves bits away from their erased value */
+    dst = sim_dev.mem + addr;
+    for (i = 0; i < num_units * unit; i++) {
+        dst[i] = (sim_dev.cfg.erased_value == 0xFF) ? (dst[i] & src[i]) :
+                                                       (dst[i] | src[i]);
+    }
+    memset(sim_dev.unit_programmed + (addr / unit), 1, num_units);
+
+    sim_dev.stats.program_ops++;
+    sim_dev.stats.program_bytes += (uint64_t)num_units * unit;
+    sim_dev.stats.time_ns += (uint64_t)num_units
+                             * sim_dev.cfg.program_ns_per_unit;
+
+    return sim_dev.powered_off ? ARM_DRIVER_ERROR : (int32_t)cnt;
+}
+
+static int32_t ARM_Flash_EraseSector(uint32_t addr)
+{
+    uint32_t sector;
+
+    if (sim_dev.powered_off) {
+        return ARM_DRIVER_ERROR;
+    }
+
+    if ((addr >= flash_sim_size()) || (addr % sim_dev.cfg.sector_size != 0)) {
+        return ARM_DRIVER_ERROR_PARAMETER;
+    }
+
+    sector = addr / sim_dev.cfg.sector_size;
+
+    if (flash_sim_failure_now()) {
+        return ARM_DRIVER_ERROR;
+    }
+
+    if (flash_sim_power_loss_now()) {
+        /* Only the first half of the sector is erased */
+        flash_sim_erase_sector(sector, sim_dev.cfg.sector_size / 2);
+        sim_dev.sector_torn[sector] = 1;
+        return ARM_DRIVER_ERROR;
+    }
+
+    flash_sim_erase_sector(sector, sim_dev.cfg.sector_size);
+    sim_dev.sector_torn[sector] = 0;
+
+    return ARM_DRIVER_OK;
+}
+
+static int32_t ARM_Flash_EraseChip(void)
+{
+    uint32_t sector;
+    int32_t err;
+
+    for (sector = 0; sector < sim_dev.cfg.sector_count; sector++) {
+        err = ARM_Flash_EraseSector(sector * sim_dev.cfg.sector_size);
+        if (err != ARM_DRIVER_OK) {
+            return err;
+        }
+    }
+
+    return ARM_DRIVER_OK;
+}
+
+static ARM_FLASH_STATUS ARM_Flash_GetStatus(void)
+{
+    return FlashStatus;
+}
+
+static ARM_FLASH_INFO * ARM_Flash_GetInfo(void)
+{
+    return &sim_dev.info;
+}
+
+ARM_DRIVER_FLASH Driver_FLASH_SIM = {
+    ARM_Flash_GetVersion,
+    ARM_Flash_GetCapabilities,
+    ARM_Flash_Initialize,
+    ARM_Flash_Uninitialize,
+    ARM_Flash_PowerControl,
+    ARM_Flash_ReadData,
+    ARM_Flash_ProgramData,
+    ARM_Flash_EraseSector,
+    ARM_Flash_EraseChip,
+    ARM_Flash_GetStatus,
+    ARM_Flash_GetInfo
+};
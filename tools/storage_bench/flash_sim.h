@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2022, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/**
+ * \file  flash_sim.h
+ *
+ * \brief Simulated flash device for running the storage services on a host.
+ *        The device is exposed through the CMSIS flash interface, so the ITS
+ *        NOR and NAND flash interface implementations can be used on top of it
+ *        unmodified.
+ */
+
+#ifndef __FLASH_SIM_H__
+#define __FLASH_SIM_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "Driver_Flash.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \struct flash_sim_cfg_t
+ *
+ * \brief Geometry and cost model of the simulated flash device.
+ */
+struct flash_sim_cfg_t {
+    uint32_t sector_size;         /**< Size of the erase unit in bytes */
+    uint32_t sector_count;        /**< Number of erase units */
+    uint32_t program_unit;        /**< Size of the program unit in bytes */
+    uint8_t erased_value;         /**< Value of a byte after erase */
+    bool reprogram;               /**< If true, a program unit can be
+                                   *   programmed again without an erase, which
+                                   *   only changes the bits still at their
+                                   *   erased value, as on NOR flash without
+                                   *   ECC. Otherwise each program unit can only
+                                   *   be programmed once after it is erased
+                                   */
+    bool detect_torn_writes;      /**< If true, reading a sector whose program
+                                   *   or erase was interrupted by a power loss
+                                   *   fails until the sector is erased, as
+                                   *   required by the ITS NAND interface
+                                   */
+    uint32_t read_ns_per_byte;    /**< Simulated read time per byte */
+    uint32_t program_ns_per_unit; /**< Simulated program time per program
+                                   *   unit
+                                   */
+    uint32_t erase_us_per_sector; /**< Simulated erase time per sector */
+};
+
+/**
+ * \struct flash_sim_stats_t
+ *
+ * \brief Accumulated operation counters of the simulated flash device.
+ */
+struct flash_sim_stats_t {
+    uint64_t read_ops;      /**< Number of read operations */
+    uint64_t read_bytes;    /**< Number of bytes read */
+    uint64_t program_ops;   /**< Number of program operations */
+    uint64_t program_bytes; /**< Number of bytes programmed */
+    uint64_t erase_ops;     /**< Number of sectors erased */
+    uint64_t time_ns;       /**< Simulated time spent in flash operations */
+};
+
+/**
+ * \brief The simulated flash device.
+ */
+extern ARM_DRIVER_FLASH Driver_FLASH_SIM;
+
+/**
+ * \brief Creates the simulated flash device. All sectors start erased.
+ *
+ * \param[in] cfg  Device geometry and cost model
+ *
+ * \return Returns 0 on success, or -1 if the configuration is invalid or the
+ *         memory cannot be allocated.
+ */
+int flash_sim_create(const struct flash_sim_cfg_t *cfg);
+
+/**
+ * \brief Destroys the simulated flash device and frees its memory.
+ */
+void flash_sim_destroy(void);
+
+/**
+ * \brief Gets the operation counters accumulated since the last call to
+ *        flash_sim_reset_stats().
+ *
+ * \param[out] stats  Operation counters
+ */
+void flash_sim_get_stats(struct flash_sim_stats_t *stats);
+
+/**
+ * \brief Resets the operation counters. The per-sector erase counts are not
+ *        reset.
+ */
+void flash_sim_reset_stats(void);
+
+/**
+ * \brief Gets the number of times a sector has been erased since the device
+ *        was created.
+ *
+ * \param[in] sector  Sector index
+ *
+ * \return Returns the erase count of the sector.
+ */
+uint32_t flash_sim_get_erase_count(uint32_t sector);
+
+/**
+ * \brief Schedules a power loss during a future program or erase operation.
+ *
+ * \details The operation that is interrupted only completes partially: half
+ *          of its program units are programmed, or half of the sector is
+ *          erased. After that, all operations fail until
+ *          flash_sim_power_cycle() is called.
+ *
+ * \param[in] num_ops  Number of program and erase operations to let complete
+ *                     before the power loss. Zero disables a scheduled power
+ *                     loss.
+ */
+void flash_sim_schedule_power_loss(uint32_t num_ops);
+
+/**
+ * \brief Schedules the failure of a future program or erase operation.
+ *
+ * \details The operation that fails returns an error and leaves the flash
+ *          unchanged. The operations after it are not affected.
+ *
+ * \param[in] num_ops  Number of program and erase operations to let complete
+ *                     before the failure
+ */
+void flash_sim_schedule_failure(uint32_t num_ops);
+
+/**
+ * \brief Checks if a scheduled power loss has happened.
+ *
+ * \return Returns true if the device is powered off.
+ */
+bool flash_sim_is_powered_off(void);
+
+/**
+ * \brief Powers the device back on after a power loss. Any scheduled power
+ *        loss is cancelled.
+ */
+void flash_sim_power_cycle(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FLASH_SIM_H__ */
@@ -0,0 +1,17 @@
+/*
+ * Copyright (c) 2022, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef __PSA_MANIFEST_PID_H__
+#define __PSA_MANIFEST_PID_H__
+
+/* Partition IDs of the host storage replay. Only the PS partition ID is used,
+ * to select the PS filesystem in the ITS service. Any value that is not a
+ * valid non-secure client ID can be used.
+ */
+#define TFM_SP_PS    (256)
+
+#endif /* __PSA_MANIFEST_PID_H__ */
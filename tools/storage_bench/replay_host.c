@@ -0,0 +1,459 @@
+/*
+ * Copyright (c) 2022, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "replay_host.h"
+
+#include <string.h>
+
+#include "psa/internal_trusted_storage.h"
+#include "psa_manifest/pid.h"
+#include "tfm_internal_trusted_storage.h"
+#include "tfm_its_req_mngr.h"
+#include "tfm_ps_req_mngr.h"
+#include "nv_counters/ps_nv_counters.h"
+
+#ifdef PS_ENCRYPTION
+#include "crypto/ps_crypto_interface.h"
+#endif
+
+static struct tfm_hal_its_fs_info_t g_its_fs_info;
+static struct tfm_hal_ps_fs_info_t g_ps_fs_info;
+
+/* Client buffers of the current request. Each service call consumes the input
+ * buffer and fills the output buffer from the start.
+ */
+static const uint8_t *g_client_in;
+static uint8_t *g_client_out;
+
+static uint32_t g_nv_counters[3];
+static struct replay_host_stats_t g_stats;
+
+void replay_host_set_fs_info(const struct tfm_hal_its_fs_info_t *its_info,
+                             const struct tfm_hal_ps_fs_info_t *ps_info)
+{
+    g_its_fs_info = *its_info;
+    g_ps_fs_info = *ps_info;
+}
+
+void replay_host_set_client_bufs(const void *in, void *out)
+{
+    g_client_in = in;
+    g_client_out = out;
+}
+
+void replay_host_get_stats(struct replay_host_stats_t *stats)
+{
+    *stats = g_stats;
+}
+
+/* Storage HAL */
+
+enum tfm_hal_status_t
+tfm_hal_its_fs_info(struct tfm_hal_its_fs_info_t *fs_info)
+{
+    *fs_info = g_its_fs_info;
+
+    return TFM_HAL_SUCCESS;
+}
+
+enum tfm_hal_status_t tfm_hal_ps_fs_info(struct tfm_hal_ps_fs_info_t *fs_info)
+{
+    *fs_info = g_ps_fs_info;
+
+    return TFM_HAL_SUCCESS;
+}
+
+/* Request managers */
+
+size_t its_req_mngr_read(uint8_t *buf, size_t num_bytes)
+{
+    memcpy(buf, g_client_in, num_bytes);
+    g_client_in += num_bytes;
+
+    return num_bytes;
+}
+
+void its_req_mngr_write(const uint8_t *buf, size_t num_bytes)
+{
+    memcpy(g_client_out, buf, num_bytes);
+    g_client_out += num_bytes;
+}
+
+psa_status_t ps_req_mngr_read_asset_data(uint8_t *out_data, uint32_t size)
+{
+    memcpy(out_data, g_client_in, size);
+    g_client_in += size;
+
+    return PSA_SUCCESS;
+}
+
+void ps_req_mngr_write_asset_data(const uint8_t *in_data, uint32_t size)
+{
+    memcpy(g_client_out, in_data, size);
+    g_client_out += size;
+}
+
+/* ITS client API used by PS. As in the secure partition environment, PS calls
+ * the ITS service with its own partition ID. The ITS service accesses the PS
+ * buffers through the ITS request manager, so the client buffers of the
+ * current PS request are saved around the call.
+ */
+
+psa_status_t psa_its_set(psa_storage_uid_t uid,
+                         size_t data_length,
+                         const void *p_data,
+                         psa_storage_create_flags_t create_flags)
+{
+    const uint8_t *in = g_client_in;
+    uint8_t *out = g_client_out;
+    psa_status_t status;
+
+    replay_host_set_client_bufs(p_data, NULL);
+    status = tfm_its_set(TFM_SP_PS, uid, data_length, create_flags);
+    replay_host_set_client_bufs(in, out);
+
+    return status;
+}
+
+psa_status_t psa_its_get(psa_storage_uid_t uid,
+                         size_t data_offset,
+                         size_t data_size,
+                         void *p_data,
+                         size_t *p_data_length)
+{
+    const uint8_t *in = g_client_in;
+    uint8_t *out = g_client_out;
+    psa_status_t status;
+
+    replay_host_set_client_bufs(NULL, p_data);
+    status = tfm_its_get(TFM_SP_PS, uid, data_offset, data_size,
+                         p_data_length);
+    replay_host_set_client_bufs(in, out);
+
+    return status;
+}
+
+psa_status_t psa_its_get_info(psa_storage_uid_t uid,
+                              struct psa_storage_info_t *p_info)
+{
+    return tfm_its_get_info(TFM_SP_PS, uid, p_info);
+}
+
+psa_status_t psa_its_remove(psa_storage_uid_t uid)
+{
+    return tfm_its_remove(TFM_SP_PS, uid);
+}
+
+psa_status_t psa_its_create(psa_storage_uid_t uid,
+                            size_t capacity,
+                            psa_storage_create_flags_t create_flags)
+{
+    return tfm_its_create(TFM_SP_PS, uid, capacity, create_flags);
+}
+
+psa_status_t psa_its_set_extended(psa_storage_uid_t uid,
+                                  size_t data_offset,
+                                  size_t data_length,
+                                  const void *p_data)
+{
+    const uint8_t *in = g_client_in;
+    uint8_t *out = g_client_out;
+    psa_status_t status;
+
+    replay_host_set_client_bufs(p_data, NULL);
+    status = tfm_its_set_extended(TFM_SP_PS, uid, data_offset, data_length);
+    replay_host_set_client_bufs(in, out);
+
+    return status;
+}
+
+psa_status_t psa_its_get_capacity(struct psa_storage_capacity_t *p_capacity)
+{
+    return tfm_its_get_capacity(TFM_SP_PS, p_capacity);
+}
+
+/* NV counters, held in RAM */
+
+psa_status_t ps_read_nv_counter(enum tfm_nv_counter_t counter_id,
+                                uint32_t *val)
+{
+    if (counter_id < TFM_PS_NV_COUNTER_1 || counter_id > TFM_PS_NV_COUNTER_3) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    *val = g_nv_counters[counter_id - TFM_PS_NV_COUNTER_1];
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_increment_nv_counter(enum tfm_nv_counter_t counter_id)
+{
+    if (counter_id < TFM_PS_NV_COUNTER_1 || counter_id > TFM_PS_NV_COUNTER_3) {
+        return PSA_ERROR_GENERIC_ERROR;
+    }
+
+    g_nv_counters[counter_id - TFM_PS_NV_COUNTER_1]++;
+    g_stats.nv_counter_increments++;
+
+    return PSA_SUCCESS;
+}
+
+#ifdef PS_ENCRYPTION
+/* Stand-in for the PS crypto interface. It is NOT cryptographically secure:
+ * it only provides what the PS service relies on, namely that the data is
+ * transformed, that a tag changes with the key, IV, additional data and
+ * ciphertext, and that a modified object fails to authenticate. The object
+ * and object table formats, and so the flash cost of encryption, are the same
+ * as with the crypto service, but the host time does not include the cost of
+ * AES-GCM and SHA-256.
+ */
+
+static uint64_t g_key;
+static uint8_t g_iv[PS_IV_LEN_BYTES];
+static uint64_t g_hash_state;
+
+static uint64_t host_mix(uint64_t state, const uint8_t *data, size_t len)
+{
+    size_t i;
+
+    /* FNV-1a */
+    for (i = 0; i < len; i++) {
+        state ^= data[i];
+        state *= 0x100000001B3ULL;
+    }
+
+    return state;
+}
+
+static uint64_t host_next(uint64_t *state)
+{
+    /* splitmix64 */
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+    return z ^ (z >> 31);
+}
+
+static void host_expand(uint64_t state, uint8_t *out, size_t len)
+{
+    uint64_t word;
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        if ((i % sizeof(word)) == 0) {
+            word = host_next(&state);
+        }
+        out[i] = (uint8_t)(word >> (8 * (i % sizeof(word))));
+    }
+}
+
+static void host_crypt(const uint8_t *iv, const uint8_t *in, uint8_t *out,
+                       size_t len)
+{
+    uint64_t state = host_mix(g_key, iv, PS_IV_LEN_BYTES);
+    uint64_t word;
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        if ((i % sizeof(word)) == 0) {
+            word = host_next(&state);
+        }
+        out[i] = in[i] ^ (uint8_t)(word >> (8 * (i % sizeof(word))));
+    }
+
+    g_stats.crypto_ops++;
+    g_stats.crypto_bytes += len;
+}
+
+static void host_tag(const uint8_t *iv, const uint8_t *add, size_t add_len,
+                     const uint8_t *ciphertext, size_t len, uint8_t *tag)
+{
+    uint64_t state = host_mix(g_key ^ 0xCBF29CE484222325ULL, iv,
+                              PS_IV_LEN_BYTES);
+
+    state = host_mix(state, add, add_len);
+    state = host_mix(state, (const uint8_t *)&add_len, sizeof(add_len));
+    state = host_mix(state, ciphertext, len);
+
+    host_expand(state, tag, PS_TAG_LEN_BYTES);
+}
+
+psa_status_t ps_crypto_init(void)
+{
+    g_key = 0;
+    memset(g_iv, 0, sizeof(g_iv));
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_crypto_setkey(const uint8_t *key_label, size_t key_label_len)
+{
+    g_key = host_mix(0x84222325CBF29CE4ULL, key_label, key_label_len);
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_crypto_destroykey(void)
+{
+    g_key = 0;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_crypto_key_cache_get_stats(
+                                    struct ps_crypto_key_cache_stats_t *stats)
+{
+    /* The host model derives no keys, so it has no key cache */
+    (void)stats;
+
+    return PSA_ERROR_NOT_SUPPORTED;
+}
+
+psa_status_t ps_crypto_encrypt_and_tag(union ps_crypto_t *crypto,
+                                       const uint8_t *add,
+                                       size_t add_len,
+                                       const uint8_t *in,
+                                       size_t in_len,
+                                       uint8_t *out,
+                                       size_t out_size,
+                                       size_t *out_len)
+{
+    if (out_size < in_len) {
+        return PSA_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    host_crypt(crypto->ref.iv, in, out, in_len);
+    host_tag(crypto->ref.iv, add, add_len, out, in_len, crypto->ref.tag);
+    *out_len = in_len;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_crypto_auth_and_decrypt(const union ps_crypto_t *crypto,
+                                        const uint8_t *add,
+                                        size_t add_len,
+                                        uint8_t *in,
+                                        size_t in_len,
+                                        uint8_t *out,
+                                        size_t out_size,
+                                        size_t *out_len)
+{
+    uint8_t tag[PS_TAG_LEN_BYTES];
+
+    if (out_size < in_len) {
+        return PSA_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    host_tag(crypto->ref.iv, add, add_len, in, in_len, tag);
+    if (memcmp(tag, crypto->ref.tag, sizeof(tag)) != 0) {
+        return PSA_ERROR_INVALID_SIGNATURE;
+    }
+
+    host_crypt(crypto->ref.iv, in, out, in_len);
+    *out_len = in_len;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_crypto_generate_auth_tag(union ps_crypto_t *crypto,
+                                         const uint8_t *add,
+                                         uint32_t add_len)
+{
+    host_tag(crypto->ref.iv, add, add_len, NULL, 0, crypto->ref.tag);
+    g_stats.crypto_ops++;
+    g_stats.crypto_bytes += add_len;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_crypto_authenticate(const union ps_crypto_t *crypto,
+                                    const uint8_t *add,
+                                    uint32_t add_len)
+{
+    uint8_t tag[PS_TAG_LEN_BYTES];
+
+    host_tag(crypto->ref.iv, add, add_len, NULL, 0, tag);
+    g_stats.crypto_ops++;
+    g_stats.crypto_bytes += add_len;
+
+    if (memcmp(tag, crypto->ref.tag, sizeof(tag)) != 0) {
+        return PSA_ERROR_INVALID_SIGNATURE;
+    }
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_crypto_hash(const uint8_t *in_1,
+                            size_t in_1_len,
+                            const uint8_t *in_2,
+                            size_t in_2_len,
+                            uint8_t *hash)
+{
+    psa_status_t status;
+
+    status = ps_crypto_hash_start();
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    (void)ps_crypto_hash_update(in_1, in_1_len);
+    (void)ps_crypto_hash_update(in_2, in_2_len);
+
+    return ps_crypto_hash_finish(hash);
+}
+
+psa_status_t ps_crypto_hash_start(void)
+{
+    g_hash_state = 0xCBF29CE484222325ULL;
+    g_stats.crypto_ops++;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_crypto_hash_update(const uint8_t *in, size_t in_len)
+{
+    g_hash_state = host_mix(g_hash_state, in, in_len);
+    g_stats.crypto_bytes += in_len;
+
+    return PSA_SUCCESS;
+}
+
+psa_status_t ps_crypto_hash_finish(uint8_t *hash)
+{
+    host_expand(g_hash_state, hash, PS_HASH_LEN_BYTES);
+
+    return PSA_SUCCESS;
+}
+
+void ps_crypto_hash_abort(void)
+{
+    g_hash_state = 0;
+}
+
+void ps_crypto_set_iv(const union ps_crypto_t *crypto)
+{
+    memcpy(g_iv, crypto->ref.iv, PS_IV_LEN_BYTES);
+}
+
+psa_status_t ps_crypto_get_iv(union ps_crypto_t *crypto)
+{
+    size_t i;
+
+    /* Increment the IV as a little-endian counter */
+    for (i = 0; i < PS_IV_LEN_BYTES; i++) {
+        if (++g_iv[i] != 0) {
+            break;
+        }
+    }
+
+    memcpy(crypto->ref.iv, g_iv, PS_IV_LEN_BYTES);
+
+    return PSA_SUCCESS;
+}
+#endif /* PS_ENCRYPTION */
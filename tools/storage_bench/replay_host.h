@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2022, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/**
+ * \file  replay_host.h
+ *
+ * \brief Host environment of the storage replay. It provides the parts of the
+ *        secure partition environment used by the ITS and PS services: the
+ *        client buffers of the request managers, the ITS client API called by
+ *        PS, the storage HAL, the NV counters and, when PS_ENCRYPTION is
+ *        enabled, the PS crypto interface.
+ */
+
+#ifndef __REPLAY_HOST_H__
+#define __REPLAY_HOST_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tfm_hal_its.h"
+#include "tfm_hal_ps.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \struct replay_host_stats_t
+ *
+ * \brief Counters of the host environment.
+ */
+struct replay_host_stats_t {
+    uint64_t nv_counter_increments; /**< Number of NV counter increments */
+    uint64_t crypto_ops;            /**< Number of AEAD and hash operations */
+    uint64_t crypto_bytes;          /**< Number of bytes encrypted, decrypted,
+                                     *   authenticated or hashed
+                                     */
+};
+
+/**
+ * \brief Sets the flash areas returned by the storage HAL.
+ *
+ * \param[in] its_info  Flash area of the ITS filesystem
+ * \param[in] ps_info   Flash area of the PS filesystem
+ */
+void replay_host_set_fs_info(const struct tfm_hal_its_fs_info_t *its_info,
+                             const struct tfm_hal_ps_fs_info_t *ps_info);
+
+/**
+ * \brief Sets the client buffers of the next request, which the services
+ *        access through their request managers.
+ *
+ * \param[in]  in   Client input buffer, or NULL
+ * \param[out] out  Client output buffer, or NULL
+ */
+void replay_host_set_client_bufs(const void *in, void *out);
+
+/**
+ * \brief Gets the counters accumulated since the start of the replay.
+ *
+ * \param[out] stats  Counters
+ */
+void replay_host_get_stats(struct replay_host_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __REPLAY_HOST_H__ */
@@ -0,0 +1,989 @@
+/*
+ * Copyright (c) 2022, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/**
+ * \file  storage_bench.c
+ *
+ * \brief Host benchmark for the ITS flash filesystem, as used by both the ITS
+ *        and PS services. The filesystem runs unmodified on top of the flash
+ *        simulator, which accounts for the cost of each flash operation and
+ *        the wear of each sector, and which can inject power losses to check
+ *        that every update is atomic.
+ */
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "flash_sim.h"
+#include "flash/its_flash.h"
+#include "flash_fs/its_flash_fs.h"
+#include "flash_fs/its_flash_fs_mblock.h"
+#include "psa/storage_common.h"
+
+/* Client ID used for the files that store assets */
+#define BENCH_ASSET_CLIENT_ID   1
+
+/* Client ID used for the files that emulate the PS object table */
+#define BENCH_TABLE_CLIENT_ID   0
+
+/* Size of the header and of each entry of the emulated PS object table. This
+ * matches the object table of the PS service with encryption enabled.
+ */
+#define BENCH_TABLE_HEADER_SIZE 32
+#define BENCH_TABLE_ENTRY_SIZE  32
+
+/* Size of each record written by the append workload */
+#define BENCH_RECORD_SIZE       32
+
+/* Number of files written by each transaction of the txn workload. A file
+ * that is replaced with a different size takes two transaction entries.
+ */
+#define BENCH_TXN_NUM_FILES     ITS_UTILS_MAX(ITS_TRANSACTION_MAX_FILES / 2, 1)
+
+/* Number of files used as logs by the append workload */
+#define BENCH_NUM_LOGS          2
+
+/**
+ * \brief Expected state of an asset.
+ */
+struct bench_asset_t {
+    bool exists;      /**< True if the asset exists */
+    uint32_t gen;     /**< Generation of the asset data pattern */
+    uint32_t size;    /**< Current size of the asset data */
+    uint32_t max_size; /**< Capacity of the asset */
+};
+
+/**
+ * \brief Filesystem instance under benchmark.
+ */
+struct bench_store_t {
+    const char *name;                  /**< Name of the store */
+    its_flash_fs_ctx_t ctx;            /**< Filesystem context */
+    struct its_flash_fs_config_t cfg;  /**< Filesystem configuration */
+    const struct its_flash_fs_ops_t *ops; /**< Flash interface */
+    uint32_t first_sector;             /**< First sector of the flash area */
+    uint32_t num_sectors;              /**< Number of sectors of the area */
+    uint32_t num_assets;               /**< Number of asset UIDs in use */
+    uint32_t max_asset_size;           /**< Maximum asset size */
+    bool object_table;                 /**< True to emulate the PS object
+                                        *   table, which is rewritten on every
+                                        *   asset update
+                                        */
+    uint32_t table_idx;                /**< Current object table file */
+    uint32_t table_gen;                /**< Object table data generation */
+    struct bench_asset_t *assets;      /**< Expected state of each asset */
+};
+
+/**
+ * \brief Benchmark parameters.
+ */
+struct bench_params_t {
+    const char *workload;
+    uint32_t num_ops;
+    uint32_t seed;
+    uint32_t sector_size;
+    uint32_t sectors_per_block;
+    uint32_t its_num_blocks;
+    uint32_t ps_num_blocks;
+    uint32_t its_num_assets;
+    uint32_t its_max_asset_size;
+    uint32_t ps_num_assets;
+    uint32_t ps_max_asset_size;
+    uint32_t power_loss_trials;
+    bool wear_map;
+    bool no_metadata_shadow;
+    struct flash_sim_cfg_t sim;
+};
+
+typedef psa_status_t (*bench_op_t)(struct bench_store_t *store);
+
+/**
+ * \brief Workload description.
+ */
+struct bench_workload_t {
+    const char *name;        /**< Name used on the command line */
+    bool ps;                 /**< True to run on the PS store */
+    bool populate;           /**< True to write all assets before the run */
+    bench_op_t op;           /**< Operation run for each iteration */
+    const char *desc;        /**< Description */
+};
+
+static uint8_t g_buf[ITS_UTILS_MAX(STORAGE_BENCH_MAX_BLOCK_SIZE, 0x1000)];
+static uint8_t g_ref[sizeof(g_buf)];
+static uint32_t g_next_gen = 1;
+static uint64_t g_rand_state;
+
+static struct bench_store_t g_its = {
+    .name = "ITS",
+    .ops = &ITS_FLASH_OPS,
+};
+
+static struct bench_store_t g_ps = {
+    .name = "PS",
+    .ops = &PS_FLASH_OPS,
+    .object_table = true,
+};
+
+static uint32_t bench_rand(void)
+{
+    /* xorshift64* */
+    g_rand_state ^= g_rand_state >> 12;
+    g_rand_state ^= g_rand_state << 25;
+    g_rand_state ^= g_rand_state >> 27;
+
+    return (uint32_t)((g_rand_state * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+static uint32_t bench_rand_range(uint32_t min, uint32_t max)
+{
+    return min + (bench_rand() % (max - min + 1));
+}
+
+static uint8_t bench_pattern(uint32_t uid, uint32_t gen, uint32_t idx)
+{
+    uint32_t x = (uid * 0x9E3779B1U) ^ (gen * 0x85EBCA77U) ^ (idx * 0xC2B2AE3DU);
+
+    x ^= x >> 15;
+    x *= 0x2C1B3C6DU;
+    x ^= x >> 12;
+
+    return (uint8_t)x;
+}
+
+static void bench_fill(uint8_t *buf, uint32_t uid, uint32_t gen,
+                       uint32_t offset, uint32_t size)
+{
+    uint32_t i;
+
+    for (i = 0; i < size; i++) {
+        buf[i] = bench_pattern(uid, gen, offset + i);
+    }
+}
+
+static void bench_get_fid(uint32_t client_id, uint32_t uid, uint8_t *fid)
+{
+    /* Same layout as the file IDs of the ITS service: client ID then UID */
+    memset(fid, 0, ITS_FILE_ID_SIZE);
+    memcpy(fid, &client_id, sizeof(client_id));
+    memcpy(fid + sizeof(client_id), &uid, sizeof(uid));
+}
+
+static uint32_t bench_table_size(const struct bench_store_t *store)
+{
+    return BENCH_TABLE_HEADER_SIZE + store->num_assets * BENCH_TABLE_ENTRY_SIZE;
+}
+
+static psa_status_t bench_store_mount(struct bench_store_t *store)
+{
+    psa_status_t status;
+
+    memset(&store->ctx, 0, sizeof(store->ctx));
+
+    status = its_flash_fs_init_ctx(&store->ctx, &store->cfg, store->ops);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    return its_flash_fs_prepare(&store->ctx);
+}
+
+static psa_status_t bench_store_init(struct bench_store_t *store,
+                                     const struct bench_params_t *params,
+                                     uint32_t first_sector,
+                                     uint32_t num_blocks,
+                                     uint32_t num_assets,
+                                     uint32_t max_asset_size,
+                                     const void *flash_dev)
+{
+    psa_status_t status;
+    uint32_t max_file_size = max_asset_size;
+
+    if (store->object_table) {
+        max_file_size = ITS_UTILS_MAX(max_file_size,
+                                      BENCH_TABLE_HEADER_SIZE +
+                                      num_assets * BENCH_TABLE_ENTRY_SIZE);
+    }
+
+    store->first_sector = first_sector;
+    store->num_sectors = num_blocks * params->sectors_per_block;
+    store->num_assets = num_assets;
+    store->max_asset_size = max_asset_size;
+
+    store->cfg.flash_dev = flash_dev;
+    store->cfg.flash_area_addr = first_sector * params->sector_size;
+    store->cfg.sector_size = params->sector_size;
+    store->cfg.block_size = params->sector_size * params->sectors_per_block;
+    store->cfg.num_blocks = num_blocks;
+    /* As in the service configuration, the filesystem alignment is 1 for the
+     * NAND flash interface, which buffers whole blocks.
+     */
+    store->cfg.program_unit = (store == &g_its) ? ITS_FLASH_ALIGNMENT :
+                                                  PS_FLASH_ALIGNMENT;
+    store->cfg.max_file_size = ITS_UTILS_ALIGN(max_file_size,
+                                               ITS_FLASH_MAX_ALIGNMENT);
+    /* Each asset UID, the two copies of the object table and the spare files
+     * used to replace existing files. A transaction keeps the files that it
+     * replaces until it is committed, so it needs one spare file per file.
+     */
+    store->cfg.max_num_files = num_assets + (store->object_table ? 2 : 0) +
+                               BENCH_TXN_NUM_FILES;
+    store->cfg.erase_val = params->sim.erased_value;
+
+    store->assets = calloc(num_assets, sizeof(*store->assets));
+    if (!store->assets) {
+        return PSA_ERROR_INSUFFICIENT_MEMORY;
+    }
+
+#ifdef ITS_VALIDATE_METADATA_FROM_FLASH
+    if (!params->no_metadata_shadow) {
+        store->cfg.metadata_shadow_size = ITS_FLASH_FS_METADATA_SIZE(
+                                                   num_blocks,
+                                                   store->cfg.max_num_files);
+        store->cfg.metadata_shadow = malloc(store->cfg.metadata_shadow_size);
+        if (!store->cfg.metadata_shadow) {
+            return PSA_ERROR_INSUFFICIENT_MEMORY;
+        }
+    }
+#endif
+
+    /* Same sequence as the service initialisation: an area that does not
+     * hold a valid filesystem is wiped first.
+     */
+    status = bench_store_mount(store);
+    if (status != PSA_SUCCESS) {
+        status = its_flash_fs_wipe_all(&store->ctx);
+        if (status != PSA_SUCCESS) {
+            return status;
+        }
+
+        status = its_flash_fs_prepare(&store->ctx);
+    }
+
+    return status;
+}
+
+#if (STORAGE_BENCH_PROGRAM_UNIT > 16)
+static struct its_flash_nand_stats_t *bench_nand_stats(
+                                                  struct bench_store_t *store)
+{
+    return &((struct its_flash_nand_dev_t *)store->cfg.flash_dev)->stats;
+}
+#endif
+
+static psa_status_t bench_write_table(struct bench_store_t *store)
+{
+    uint8_t fid[ITS_FILE_ID_SIZE];
+    uint32_t size = bench_table_size(store);
+    uint32_t gen = g_next_gen++;
+    uint32_t idx = store->table_idx ^ 1;
+    psa_status_t status;
+
+    /* The PS object table is written to the file that does not hold the
+     * current table and then the old table is deleted.
+     */
+    bench_fill(g_buf, 0, gen, 0, size);
+    bench_get_fid(BENCH_TABLE_CLIENT_ID, idx + 1, fid);
+    status = its_flash_fs_file_write(&store->ctx, fid,
+                                     ITS_FLASH_FS_FLAG_CREATE |
+                                     ITS_FLASH_FS_FLAG_TRUNCATE,
+                                     size, size, 0, g_buf);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    bench_get_fid(BENCH_TABLE_CLIENT_ID, store->table_idx + 1, fid);
+    status = its_flash_fs_file_delete(&store->ctx, fid);
+    if (status != PSA_SUCCESS && status != PSA_ERROR_DOES_NOT_EXIST) {
+        return status;
+    }
+
+    store->table_idx = idx;
+    store->table_gen = gen;
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Writes a whole asset, as psa_its_set() does.
+ */
+static psa_status_t bench_set(struct bench_store_t *store, uint32_t uid,
+                              uint32_t size)
+{
+    uint8_t fid[ITS_FILE_ID_SIZE];
+    struct bench_asset_t *asset = &store->assets[uid];
+    uint32_t gen = g_next_gen++;
+    psa_status_t status;
+
+    asset->exists = true;
+    asset->gen = gen;
+    asset->size = size;
+    asset->max_size = size;
+
+    bench_fill(g_buf, uid, gen, 0, size);
+    bench_get_fid(BENCH_ASSET_CLIENT_ID, uid + 1, fid);
+    status = its_flash_fs_file_write(&store->ctx, fid,
+                                     ITS_FLASH_FS_FLAG_CREATE |
+                                     ITS_FLASH_FS_FLAG_TRUNCATE,
+                                     size, size, 0, g_buf);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    if (store->object_table) {
+        return bench_write_table(store);
+    }
+
+    return PSA_SUCCESS;
+}
+
+static psa_status_t bench_remove(struct bench_store_t *store, uint32_t uid)
+{
+    uint8_t fid[ITS_FILE_ID_SIZE];
+    psa_status_t status;
+
+    store->assets[uid].exists = false;
+
+    bench_get_fid(BENCH_ASSET_CLIENT_ID, uid + 1, fid);
+    status = its_flash_fs_file_delete(&store->ctx, fid);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    if (store->object_table) {
+        return bench_write_table(store);
+    }
+
+    return PSA_SUCCESS;
+}
+
+/**
+ * \brief Checks that a file holds the expected data.
+ */
+static psa_status_t bench_check(struct bench_store_t *store,
+                                uint32_t client_id, uint32_t uid,
+                                uint32_t gen, uint32_t size)
+{
+    uint8_t fid[ITS_FILE_ID_SIZE];
+    struct its_file_info_t info;
+    psa_status_t status;
+
+    bench_get_fid(client_id, uid + 1, fid);
+    status = its_flash_fs_file_get_info(&store->ctx, fid, &info);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    if (info.size_current != size) {
+        return PSA_ERROR_DATA_CORRUPT;
+    }
+
+    status = its_flash_fs_file_read(&store->ctx, fid, size, 0, g_buf);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    bench_fill(g_ref, uid, gen, 0, size);
+    if (memcmp(g_buf, g_ref, size) != 0) {
+        return PSA_ERROR_DATA_CORRUPT;
+    }
+
+    return PSA_SUCCESS;
+}
+
+static psa_status_t bench_check_asset(struct bench_store_t *store,
+                                      uint32_t uid,
+                                      const struct bench_asset_t *asset)
+{
+    uint8_t fid[ITS_FILE_ID_SIZE];
+    psa_status_t status;
+
+    if (!asset->exists) {
+        bench_get_fid(BENCH_ASSET_CLIENT_ID, uid + 1, fid);
+        status = its_flash_fs_file_exist(&store->ctx, fid);
+        return (status == PSA_ERROR_DOES_NOT_EXIST) ? PSA_SUCCESS :
+                                                      PSA_ERROR_DATA_CORRUPT;
+    }
+
+    return bench_check(store, BENCH_ASSET_CLIENT_ID, uid, asset->gen,
+                       asset->size);
+}
+
+static uint32_t bench_rand_size(const struct bench_store_t *store)
+{
+    return bench_rand_range(1, store->max_asset_size);
+}
+
+static psa_status_t bench_op_set(struct bench_store_t *store)
+{
+    return bench_set(store, bench_rand() % store->num_assets,
+                     bench_rand_size(store));
+}
+
+static psa_status_t bench_op_get(struct bench_store_t *store)
+{
+    uint32_t uid = bench_rand() % store->num_assets;
+
+    return bench_check_asset(store, uid, &store->assets[uid]);
+}
+
+static psa_status_t bench_op_churn(struct bench_store_t *store)
+{
+    uint32_t uid = bench_rand() % store->num_assets;
+
+    if (store->assets[uid].exists) {
+        return bench_remove(store, uid);
+    }
+
+    return bench_set(store, uid, bench_rand_size(store));
+}
+
+/**
+ * \brief Appends a record to a log, as psa_its_set_extended() does. A full
+ *        log is instead truncated, as psa_its_create() does, with the
+ *        capacity of the largest asset.
+ */
+static psa_status_t bench_op_append(struct bench_store_t *store)
+{
+    uint8_t fid[ITS_FILE_ID_SIZE];
+    uint32_t uid = bench_rand() % ITS_UTILS_MIN(BENCH_NUM_LOGS,
+                                                store->num_assets);
+    struct bench_asset_t *asset = &store->assets[uid];
+    uint32_t size = ITS_UTILS_MIN(BENCH_RECORD_SIZE, store->max_asset_size);
+
+    bench_get_fid(BENCH_ASSET_CLIENT_ID, uid + 1, fid);
+
+    if (!asset->exists || asset->size + size > asset->max_size) {
+        asset->exists = true;
+        asset->gen = g_next_gen++;
+        asset->size = 0;
+        asset->max_size = store->max_asset_size;
+
+        return its_flash_fs_file_write(&store->ctx, fid,
+                                       ITS_FLASH_FS_FLAG_CREATE |
+                                       ITS_FLASH_FS_FLAG_TRUNCATE,
+                                       asset->max_size, 0, 0, NULL);
+    }
+
+    bench_fill(g_buf, uid, asset->gen, asset->size, size);
+    asset->size += size;
+
+    return its_flash_fs_file_write(&store->ctx, fid, 0, asset->max_size,
+                                   size, asset->size - size, g_buf);
+}
+
+/**
+ * \brief Writes several assets atomically in one transaction.
+ */
+static psa_status_t bench_op_txn(struct bench_store_t *store)
+{
+    uint8_t fid[ITS_FILE_ID_SIZE];
+    struct bench_asset_t new_assets[BENCH_TXN_NUM_FILES];
+    uint32_t uids[BENCH_TXN_NUM_FILES];
+    uint32_t num_files = ITS_UTILS_MIN(BENCH_TXN_NUM_FILES, store->num_assets);
+    uint32_t size;
+    uint32_t i;
+    uint32_t j;
+    psa_status_t status;
+
+    status = its_flash_fs_txn_begin(&store->ctx);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    for (i = 0; i < num_files; i++) {
+        /* Pick distinct UIDs */
+        do {
+            uids[i] = bench_rand() % store->num_assets;
+            for (j = 0; j < i && uids[j] != uids[i]; j++) {
+            }
+        } while (j < i);
+
+        size = bench_rand_size(store);
+        new_assets[i].exists = true;
+        new_assets[i].gen = g_next_gen++;
+        new_assets[i].size = size;
+        new_assets[i].max_size = size;
+
+        bench_fill(g_buf, uids[i], new_assets[i].gen, 0, size);
+        bench_get_fid(BENCH_ASSET_CLIENT_ID, uids[i] + 1, fid);
+        status = its_flash_fs_file_write(&store->ctx, fid,
+                                         ITS_FLASH_FS_FLAG_CREATE |
+                                         ITS_FLASH_FS_FLAG_TRUNCATE,
+                                         size, size, 0, g_buf);
+        if (status != PSA_SUCCESS) {
+            (void)its_flash_fs_txn_abort(&store->ctx);
+            return status;
+        }
+    }
+
+    for (i = 0; i < num_files; i++) {
+        store->assets[uids[i]] = new_assets[i];
+    }
+
+    return its_flash_fs_txn_commit(&store->ctx);
+}
+
+static psa_status_t bench_op_mixed(struct bench_store_t *store)
+{
+    uint32_t r = bench_rand() % 100;
+
+    /* 60% reads, 30% writes, 10% removes */
+    if (r < 60) {
+        return bench_op_get(store);
+    } else if (r < 90) {
+        return bench_op_set(store);
+    }
+
+    return bench_op_churn(store);
+}
+
+static const struct bench_workload_t g_workloads[] = {
+    {"its-set",    false, false, bench_op_set,
+     "ITS: write a random asset with a random size"},
+    {"its-get",    false, true,  bench_op_get,
+     "ITS: read and verify a random asset"},
+    {"its-churn",  false, false, bench_op_churn,
+     "ITS: alternately create and remove random assets"},
+    {"its-append", false, false, bench_op_append,
+     "ITS: append records to a small number of logs"},
+    {"its-txn",    false, false, bench_op_txn,
+     "ITS: write several assets in one transaction"},
+    {"its-mixed",  false, true,  bench_op_mixed,
+     "ITS: 60% get, 30% set, 10% remove"},
+    {"ps-set",     true,  false, bench_op_set,
+     "PS: write a random object and rewrite the object table"},
+    {"ps-get",     true,  true,  bench_op_get,
+     "PS: read and verify a random object"},
+    {"ps-mixed",   true,  true,  bench_op_mixed,
+     "PS: 60% get, 30% set, 10% remove"},
+};
+
+#define BENCH_NUM_WORKLOADS (sizeof(g_workloads) / sizeof(g_workloads[0]))
+
+static uint64_t bench_host_time_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void bench_print_wear(const struct bench_store_t *store, bool wear_map)
+{
+    uint32_t i;
+    uint32_t count;
+    uint32_t min = UINT32_MAX;
+    uint32_t max = 0;
+    double sum = 0;
+    double sum_sq = 0;
+    double mean;
+
+    for (i = 0; i < store->num_sectors; i++) {
+        count = flash_sim_get_erase_count(store->first_sector + i);
+        min = ITS_UTILS_MIN(min, count);
+        max = ITS_UTILS_MAX(max, count);
+        sum += count;
+        sum_sq += (double)count * count;
+    }
+
+    mean = sum / store->num_sectors;
+
+    printf("  %s wear: erases/sector min %" PRIu32 " mean %.1f max %" PRIu32
+           " stddev %.1f\n", store->name, min, mean, max,
+           sqrt(ITS_UTILS_MAX(sum_sq / store->num_sectors - mean * mean, 0)));
+
+    if (wear_map) {
+        for (i = 0; i < store->num_sectors; i++) {
+            printf("%s%6" PRIu32, (i % 8) ? " " : "\n    ",
+                   flash_sim_get_erase_count(store->first_sector + i));
+        }
+        printf("\n");
+    }
+}
+
+static int bench_run_workload(const struct bench_workload_t *wl,
+                              const struct bench_params_t *params)
+{
+    struct bench_store_t *store = wl->ps ? &g_ps : &g_its;
+    struct flash_sim_stats_t stats;
+    uint64_t host_ns;
+    uint32_t i;
+    psa_status_t status;
+
+    if (wl->populate) {
+        for (i = 0; i < store->num_assets; i++) {
+            if (!store->assets[i].exists) {
+                status = bench_set(store, i, bench_rand_size(store));
+                if (status != PSA_SUCCESS) {
+                    fprintf(stderr, "%s: populate failed: %d\n", wl->name,
+                            (int)status);
+                    return 1;
+                }
+            }
+        }
+    }
+
+    flash_sim_reset_stats();
+#if (STORAGE_BENCH_PROGRAM_UNIT > 16)
+    memset(bench_nand_stats(store), 0, sizeof(struct its_flash_nand_stats_t));
+#endif
+    host_ns = bench_host_time_ns();
+
+    for (i = 0; i < params->num_ops; i++) {
+        status = wl->op(store);
+        if (status != PSA_SUCCESS) {
+            fprintf(stderr, "%s: operation %" PRIu32 " failed: %d\n",
+                    wl->name, i, (int)status);
+            return 1;
+        }
+    }
+
+    host_ns = bench_host_time_ns() - host_ns;
+    flash_sim_get_stats(&stats);
+
+    printf("%s (%s)\n", wl->name, wl->desc);
+    printf("  %" PRIu32 " ops: %.0f ops/s simulated, %.0f ops/s host\n",
+           params->num_ops,
+           stats.time_ns ? params->num_ops * 1e9 / stats.time_ns : 0.0,
+           host_ns ? params->num_ops * 1e9 / host_ns : 0.0);
+    printf("  per op: %.1f reads (%.0f B), %.1f programs (%.0f B), "
+           "%.2f erases\n",
+           (double)stats.read_ops / params->num_ops,
+           (double)stats.read_bytes / params->num_ops,
+           (double)stats.program_ops / params->num_ops,
+           (double)stats.program_bytes / params->num_ops,
+           (double)stats.erase_ops / params->num_ops);
+#if (STORAGE_BENCH_PROGRAM_UNIT > 16)
+    printf("  NAND per op: %.2f block flushes, %.2f pages programmed, "
+           "%.2f pages left erased\n",
+           (double)bench_nand_stats(store)->flushes / params->num_ops,
+           (double)bench_nand_stats(store)->pages_programmed / params->num_ops,
+           (double)bench_nand_stats(store)->pages_skipped / params->num_ops);
+#endif
+    bench_print_wear(store, params->wear_map);
+
+    return 0;
+}
+
+/**
+ * \brief Checks that an asset is in either its old or its new state.
+ *
+ * \return Returns 0 if the asset is in the old state, 1 if it is in the new
+ *         state and -1 otherwise.
+ */
+static int bench_match_asset(struct bench_store_t *store, uint32_t uid,
+                             const struct bench_asset_t *old_asset,
+                             const struct bench_asset_t *new_asset)
+{
+    if (bench_check_asset(store, uid, old_asset) == PSA_SUCCESS) {
+        return 0;
+    }
+
+    if (bench_check_asset(store, uid, new_asset) == PSA_SUCCESS) {
+        return 1;
+    }
+
+    return -1;
+}
+
+/**
+ * \brief Runs random operations on the ITS store and interrupts each of them
+ *        with a power loss. After the power cycle, the filesystem must mount
+ *        and every asset must be in either its old or its new state, and all
+ *        the assets written in one transaction must be in the same state.
+ */
+static int bench_run_power_loss(const struct bench_params_t *params)
+{
+    static const bench_op_t ops[] = {
+        bench_op_set, bench_op_churn, bench_op_append, bench_op_txn,
+    };
+    struct bench_store_t *store = &g_its;
+    struct bench_asset_t *old_assets;
+    struct flash_sim_stats_t stats;
+    uint32_t max_op_cost = 1;
+    uint32_t power_loss_op;
+    uint32_t num_interrupted = 0;
+    uint32_t trial;
+    uint32_t uid;
+    uint32_t op_idx;
+    int state;
+    int txn_state;
+    psa_status_t status;
+
+    old_assets = calloc(store->num_assets, sizeof(*old_assets));
+    if (!old_assets) {
+        return 1;
+    }
+
+    for (trial = 0; trial < params->power_loss_trials; trial++) {
+        memcpy(old_assets, store->assets,
+               store->num_assets * sizeof(*old_assets));
+
+        /* Interrupt the operation at a random point, up to twice the number
+         * of program and erase operations of the most expensive operation seen
+         * so far, so that about half of the operations complete.
+         */
+        op_idx = bench_rand() % (sizeof(ops) / sizeof(ops[0]));
+        power_loss_op = bench_rand_range(1, 2 * max_op_cost);
+        flash_sim_reset_stats();
+        flash_sim_schedule_power_loss(power_loss_op);
+        status = ops[op_idx](store);
+
+        if (!flash_sim_is_powered_off()) {
+            flash_sim_schedule_power_loss(0);
+            if (status != PSA_SUCCESS) {
+                fprintf(stderr, "power-loss: trial %" PRIu32 " failed: %d\n",
+                        trial, (int)status);
+                goto fail;
+            }
+
+            flash_sim_get_stats(&stats);
+            max_op_cost = ITS_UTILS_MAX(max_op_cost, (uint32_t)
+                                        (stats.program_ops + stats.erase_ops));
+            continue;
+        }
+
+        num_interrupted++;
+        max_op_cost = ITS_UTILS_MAX(max_op_cost, power_loss_op);
+
+        /* Each operation updates the model before it updates the flash, so
+         * every asset must be either in its old state or in the state held
+         * by the model. The model is then set to the state found in flash.
+         */
+        /* The write buffers of the NAND flash interface are lost on a power
+         * loss. They are discarded when the filesystem is mounted again.
+         */
+        flash_sim_power_cycle();
+
+        status = bench_store_mount(store);
+        if (status != PSA_SUCCESS) {
+            fprintf(stderr, "power-loss: trial %" PRIu32 ": mount failed: %d\n",
+                    trial, (int)status);
+            goto fail;
+        }
+
+        txn_state = -1;
+        for (uid = 0; uid < store->num_assets; uid++) {
+            if (!memcmp(&old_assets[uid], &store->assets[uid],
+                        sizeof(old_assets[uid]))) {
+                state = (bench_check_asset(store, uid, &old_assets[uid]) ==
+                         PSA_SUCCESS) ? 0 : -1;
+            } else {
+                state = bench_match_asset(store, uid, &old_assets[uid],
+                                          &store->assets[uid]);
+            }
+
+            if (state < 0) {
+                fprintf(stderr, "power-loss: trial %" PRIu32 ": asset %" PRIu32
+                        " is corrupted\n", trial, uid);
+                goto fail;
+            }
+
+            /* All the assets written by a transaction must be in the same
+             * state.
+             */
+            if (ops[op_idx] == bench_op_txn &&
+                memcmp(&old_assets[uid], &store->assets[uid],
+                       sizeof(old_assets[uid]))) {
+                if (txn_state >= 0 && txn_state != state) {
+                    fprintf(stderr, "power-loss: trial %" PRIu32
+                            ": transaction was partially applied\n", trial);
+                    goto fail;
+                }
+                txn_state = state;
+            }
+
+            if (state == 0) {
+                store->assets[uid] = old_assets[uid];
+            }
+        }
+    }
+
+    printf("power-loss: %" PRIu32 " trials, %" PRIu32 " interrupted, "
+           "all recovered\n", params->power_loss_trials, num_interrupted);
+    free(old_assets);
+
+    return 0;
+
+fail:
+    free(old_assets);
+
+    return 1;
+}
+
+static void bench_usage(const char *prog)
+{
+    uint32_t i;
+
+    printf("Usage: %s [options]\n"
+           "  -w <workload>   workload to run, or \"all\" (default)\n"
+           "  -n <ops>        operations per workload (default 1000)\n"
+           "  -s <seed>       random seed (default 1)\n"
+           "  -S <bytes>      flash sector size (default 4096)\n"
+           "  -b <sectors>    sectors per filesystem block (default 1)\n"
+           "  -i <blocks>     ITS area size in blocks (default 4)\n"
+           "  -p <blocks>     PS area size in blocks (default 6)\n"
+           "  -a <assets>     number of ITS assets (default 10)\n"
+           "  -m <bytes>      maximum ITS asset size (default 512)\n"
+           "  -A <assets>     number of PS assets (default 10)\n"
+           "  -M <bytes>      maximum PS asset size (default 1024)\n"
+           "  -r <ns>         read time per byte (default 10)\n"
+           "  -P <ns>         program time per program unit (default 10000)\n"
+           "  -e <us>         erase time per sector (default 20000)\n"
+           "  -l <trials>     run the power loss check instead of the "
+           "workloads\n"
+           "  -W              print the erase count of each sector\n"
+           "  -R              validate the metadata on every read instead of "
+           "keeping a\n"
+           "                  validated copy in RAM\n"
+           "Program unit: %d bytes (%s flash interface)\n"
+           "Workloads:\n", prog, STORAGE_BENCH_PROGRAM_UNIT,
+           (STORAGE_BENCH_PROGRAM_UNIT > 16) ? "NAND" : "NOR");
+
+    for (i = 0; i < BENCH_NUM_WORKLOADS; i++) {
+        printf("  %-12s %s\n", g_workloads[i].name, g_workloads[i].desc);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    struct bench_params_t params = {
+        .workload = "all",
+        .num_ops = 1000,
+        .seed = 1,
+        .sector_size = 4096,
+        .sectors_per_block = 1,
+        .its_num_blocks = 4,
+        .ps_num_blocks = 6,
+        .its_num_assets = 10,
+        .its_max_asset_size = 512,
+        .ps_num_assets = 10,
+        .ps_max_asset_size = 1024,
+        .sim = {
+            .program_unit = STORAGE_BENCH_PROGRAM_UNIT,
+            .erased_value = 0xFF,
+#ifdef ITS_FLASH_NOR_IN_PLACE_WRITE
+            .reprogram = true,
+#endif
+            .detect_torn_writes = (STORAGE_BENCH_PROGRAM_UNIT > 16),
+            .read_ns_per_byte = 10,
+            .program_ns_per_unit = 10000,
+            .erase_us_per_sector = 20000,
+        },
+    };
+    uint32_t i;
+    uint32_t its_sectors;
+    int opt;
+    int ret = 0;
+    bool found = false;
+    psa_status_t status;
+
+    while ((opt = getopt(argc, argv, "w:n:s:S:b:i:p:a:m:A:M:r:P:e:l:WRh")) !=
+           -1) {
+        switch (opt) {
+        case 'w': params.workload = optarg; break;
+        case 'n': params.num_ops = strtoul(optarg, NULL, 0); break;
+        case 's': params.seed = strtoul(optarg, NULL, 0); break;
+        case 'S': params.sector_size = strtoul(optarg, NULL, 0); break;
+        case 'b': params.sectors_per_block = strtoul(optarg, NULL, 0); break;
+        case 'i': params.its_num_blocks = strtoul(optarg, NULL, 0); break;
+        case 'p': params.ps_num_blocks = strtoul(optarg, NULL, 0); break;
+        case 'a': params.its_num_assets = strtoul(optarg, NULL, 0); break;
+        case 'm': params.its_max_asset_size = strtoul(optarg, NULL, 0); break;
+        case 'A': params.ps_num_assets = strtoul(optarg, NULL, 0); break;
+        case 'M': params.ps_max_asset_size = strtoul(optarg, NULL, 0); break;
+        case 'r': params.sim.read_ns_per_byte = strtoul(optarg, NULL, 0); break;
+        case 'P':
+            params.sim.program_ns_per_unit = strtoul(optarg, NULL, 0);
+            break;
+        case 'e':
+            params.sim.erase_us_per_sector = strtoul(optarg, NULL, 0);
+            break;
+        case 'l': params.power_loss_trials = strtoul(optarg, NULL, 0); break;
+        case 'W': params.wear_map = true; break;
+        case 'R': params.no_metadata_shadow = true; break;
+        default:
+            bench_usage(argv[0]);
+            return (opt == 'h') ? 0 : 2;
+        }
+    }
+
+    if (params.num_ops == 0 || params.sectors_per_block == 0 ||
+        params.its_num_assets == 0 || params.ps_num_assets == 0 ||
+        params.its_max_asset_size == 0 || params.ps_max_asset_size == 0 ||
+        params.its_max_asset_size > sizeof(g_buf) ||
+        params.ps_max_asset_size > sizeof(g_buf) ||
+        BENCH_TABLE_HEADER_SIZE +
+        params.ps_num_assets * BENCH_TABLE_ENTRY_SIZE > sizeof(g_buf) ||
+        params.sector_size * params.sectors_per_block >
+        STORAGE_BENCH_MAX_BLOCK_SIZE) {
+        fprintf(stderr, "Invalid parameters\n");
+        return 2;
+    }
+
+    g_rand_state = ((uint64_t)params.seed << 32) | 0x9E3779B9U;
+
+    its_sectors = params.its_num_blocks * params.sectors_per_block;
+    params.sim.sector_size = params.sector_size;
+    params.sim.sector_count = its_sectors +
+                              params.ps_num_blocks * params.sectors_per_block;
+
+    if (flash_sim_create(&params.sim) != 0) {
+        fprintf(stderr, "Cannot create the simulated flash device\n");
+        return 2;
+    }
+
+    status = bench_store_init(&g_its, &params, 0, params.its_num_blocks,
+                              params.its_num_assets,
+                              params.its_max_asset_size, &ITS_FLASH_DEV);
+    if (status == PSA_SUCCESS) {
+        status = bench_store_init(&g_ps, &params, its_sectors,
+                                  params.ps_num_blocks, params.ps_num_assets,
+                                  params.ps_max_asset_size, &PS_FLASH_DEV);
+    }
+    if (status != PSA_SUCCESS) {
+        fprintf(stderr, "Cannot initialise the filesystem: %d\n", (int)status);
+        ret = 2;
+        goto out;
+    }
+
+    if (params.power_loss_trials) {
+        ret = bench_run_power_loss(&params);
+        goto out;
+    }
+
+    for (i = 0; i < BENCH_NUM_WORKLOADS && ret == 0; i++) {
+        if (!strcmp(params.workload, "all") ||
+            !strcmp(params.workload, g_workloads[i].name)) {
+            found = true;
+            ret = bench_run_workload(&g_workloads[i], &params);
+        }
+    }
+
+    if (!found) {
+        fprintf(stderr, "Unknown workload: %s\n", params.workload);
+        ret = 2;
+    }
+
+out:
+    free(g_its.assets);
+    free(g_ps.assets);
+#ifdef ITS_VALIDATE_METADATA_FROM_FLASH
+    free(g_its.cfg.metadata_shadow);
+    free(g_ps.cfg.metadata_shadow);
+#endif
+    flash_sim_destroy();
+
+    return ret;
+}
@@ -0,0 +1,1413 @@
+/*
+ * Copyright (c) 2022, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/**
+ * \file  storage_replay.c
+ *
+ * \brief Replays recorded traces of ITS and PS operations on the host build of
+ *        the ITS and PS services. The services run unmodified on top of the
+ *        flash simulator, or of the RAM filesystem, and each operation is
+ *        measured: its latency in simulated flash time and in host time, the
+ *        flash it programs and erases, and the stack it uses. The data read
+ *        back is checked against a model of the stored assets.
+ */
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <ucontext.h>
+
+#include "flash_sim.h"
+#include "replay_host.h"
+#include "flash/its_flash.h"
+#include "tfm_internal_trusted_storage.h"
+#include "tfm_protected_storage.h"
+
+/* Client ID of the ITS operations. Transactions can only be opened by secure
+ * clients, so the ITS operations are issued by a secure partition.
+ */
+#define REPLAY_ITS_CLIENT_ID    (0x101)
+
+/* Client ID of the PS operations, a non-secure client */
+#define REPLAY_PS_CLIENT_ID     (-1)
+
+/* Maximum length of a trace line */
+#define REPLAY_MAX_LINE         256
+
+/* Maximum data size of an operation */
+#define REPLAY_MAX_DATA_SIZE    (0x10000)
+
+/* Maximum number of entries of a list operation */
+#define REPLAY_MAX_LIST_ENTRIES (REPLAY_MAX_DATA_SIZE / \
+                                 sizeof(struct psa_storage_uid_info_t))
+
+/* Size of the stack the operations run on, and value it is painted with to
+ * find its high-water mark.
+ */
+#define REPLAY_STACK_SIZE       (0x10000)
+#define REPLAY_STACK_PAINT      (0xA5)
+
+enum replay_service_t {
+    REPLAY_ITS = 0,
+    REPLAY_PS,
+    REPLAY_NUM_SERVICES
+};
+
+enum replay_op_t {
+    REPLAY_OP_SET = 0,
+    REPLAY_OP_GET,
+    REPLAY_OP_GET_INFO,
+    REPLAY_OP_REMOVE,
+    REPLAY_OP_CREATE,
+    REPLAY_OP_SET_EXTENDED,
+    REPLAY_OP_TXN_BEGIN,
+    REPLAY_OP_TXN_COMMIT,
+    REPLAY_OP_TXN_ABORT,
+    REPLAY_OP_FLUSH,
+    REPLAY_OP_LIST,
+    REPLAY_OP_CAPACITY,
+    REPLAY_OP_INIT,
+    REPLAY_OP_FAIL,
+    REPLAY_NUM_OPS
+};
+
+/**
+ * \brief Trace operation description.
+ */
+struct replay_op_desc_t {
+    const char *name;    /**< Name used in the traces */
+    uint32_t services;   /**< Bitmap of the services that support it */
+    uint32_t num_args;   /**< Number of required arguments */
+    const char *args;    /**< Description of the arguments */
+};
+
+/**
+ * \brief Operation parsed from a trace line.
+ */
+struct replay_cmd_t {
+    uint32_t line;                 /**< Line number in the trace */
+    enum replay_service_t service; /**< Service */
+    enum replay_op_t op;           /**< Operation */
+    psa_storage_uid_t uid;         /**< UID of the asset */
+    uint32_t size;                 /**< Data size or capacity */
+    uint32_t offset;               /**< Data offset */
+};
+
+/**
+ * \brief Measurements of one replayed operation.
+ */
+struct replay_result_t {
+    psa_status_t status;    /**< Status returned by the service */
+    uint64_t sim_ns;        /**< Simulated flash time */
+    uint64_t host_ns;       /**< Host time */
+    uint64_t logical_bytes; /**< Bytes written by the client */
+    uint64_t program_bytes; /**< Bytes programmed to flash, or changed in the
+                             *   RAM filesystem
+                             */
+    uint64_t erase_bytes;   /**< Bytes erased */
+    uint32_t stack_bytes;   /**< Stack used */
+};
+
+/**
+ * \brief Expected state of an asset.
+ */
+struct replay_asset_t {
+    enum replay_service_t service; /**< Service storing the asset */
+    psa_storage_uid_t uid;         /**< UID of the asset */
+    bool exists;                   /**< True if the asset exists */
+    uint32_t size;                 /**< Current size of the asset data */
+    uint32_t capacity;             /**< Capacity of the asset */
+    uint8_t *data;                 /**< Asset data */
+};
+
+/**
+ * \brief Model of the stored assets.
+ */
+struct replay_model_t {
+    struct replay_asset_t *assets; /**< Assets */
+    uint32_t num_assets;           /**< Number of assets */
+};
+
+/**
+ * \brief Replay parameters.
+ */
+struct replay_params_t {
+    const char *trace;
+    const char *output;
+    uint32_t sector_size;
+    uint32_t sectors_per_block;
+    uint32_t its_num_blocks;
+    uint32_t ps_num_blocks;
+    bool keep_going;
+    struct flash_sim_cfg_t sim;
+};
+
+static const struct replay_op_desc_t g_op_descs[REPLAY_NUM_OPS] = {
+    [REPLAY_OP_SET] = {
+        "set", 0x3, 2, "uid,size",
+    },
+    [REPLAY_OP_GET] = {
+        "get", 0x3, 2, "uid,size[,offset]",
+    },
+    [REPLAY_OP_GET_INFO] = {
+        "get_info", 0x3, 1, "uid",
+    },
+    [REPLAY_OP_REMOVE] = {
+        "remove", 0x3, 1, "uid",
+    },
+    [REPLAY_OP_CREATE] = {
+        "create", 0x3, 2, "uid,capacity",
+    },
+    [REPLAY_OP_SET_EXTENDED] = {
+        "set_extended", 0x3, 3, "uid,size,offset",
+    },
+    [REPLAY_OP_TXN_BEGIN] = {
+        "txn_begin", 0x1, 0, "",
+    },
+    [REPLAY_OP_TXN_COMMIT] = {
+        "txn_commit", 0x1, 0, "",
+    },
+    [REPLAY_OP_TXN_ABORT] = {
+        "txn_abort", 0x1, 0, "",
+    },
+    [REPLAY_OP_FLUSH] = {
+        "flush", 0x2, 0, "",
+    },
+    [REPLAY_OP_LIST] = {
+        "list", 0x3, 2, "after_uid,num_entries",
+    },
+    [REPLAY_OP_CAPACITY] = {
+        "capacity", 0x3, 0, "",
+    },
+    [REPLAY_OP_INIT] = {
+        "init", 0x3, 0, "",
+    },
+    [REPLAY_OP_FAIL] = {
+        "fail", 0x3, 1, "num_ops",
+    },
+};
+
+static const char *const g_service_names[REPLAY_NUM_SERVICES] = {
+    "its", "ps",
+};
+
+static uint8_t g_in_buf[REPLAY_MAX_DATA_SIZE];
+static uint8_t g_out_buf[REPLAY_MAX_DATA_SIZE];
+static uint32_t g_next_gen = 1;
+
+static struct replay_model_t g_model;
+
+/* Copy of the model taken when an ITS transaction is opened, restored if the
+ * transaction is aborted.
+ */
+static struct replay_model_t g_txn_model;
+static bool g_txn_open;
+
+/* True once a change of the open ITS transaction has failed. The transaction
+ * must then reject all the other changes and the commit until it is aborted.
+ */
+static bool g_txn_failed;
+
+/* Operation run on the replay stack */
+static uint8_t g_stack[REPLAY_STACK_SIZE];
+static uint32_t g_stack_high_water = REPLAY_STACK_SIZE;
+static ucontext_t g_main_ctx;
+static ucontext_t g_op_ctx;
+static const struct replay_cmd_t *g_cmd;
+static struct replay_result_t *g_result;
+
+/* Copies of the RAM filesystems, to find the bytes changed by an operation */
+#ifdef ITS_RAM_FS
+static uint8_t g_its_ram_copy[ITS_RAM_FS_SIZE];
+#endif
+#ifdef PS_RAM_FS
+static uint8_t g_ps_ram_copy[PS_RAM_FS_SIZE];
+#endif
+
+static uint64_t replay_time_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void replay_fill(uint8_t *buf, psa_storage_uid_t uid, uint32_t gen,
+                        uint32_t size)
+{
+    uint32_t x = ((uint32_t)uid * 0x9E3779B1U) ^ (gen * 0x85EBCA77U);
+    uint32_t i;
+
+    for (i = 0; i < size; i++) {
+        /* xorshift32 */
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        buf[i] = (uint8_t)x;
+    }
+}
+
+static struct replay_asset_t *replay_model_find(struct replay_model_t *model,
+                                                enum replay_service_t service,
+                                                psa_storage_uid_t uid)
+{
+    struct replay_asset_t *assets;
+    uint32_t i;
+
+    for (i = 0; i < model->num_assets; i++) {
+        if (model->assets[i].service == service &&
+            model->assets[i].uid == uid) {
+            return &model->assets[i];
+        }
+    }
+
+    assets = realloc(model->assets, (model->num_assets + 1) * sizeof(*assets));
+    if (!assets) {
+        return NULL;
+    }
+
+    model->assets = assets;
+    memset(&assets[i], 0, sizeof(assets[i]));
+    assets[i].service = service;
+    assets[i].uid = uid;
+    model->num_assets++;
+
+    return &assets[i];
+}
+
+static bool replay_asset_resize(struct replay_asset_t *asset, uint32_t capacity)
+{
+    uint8_t *data;
+
+    data = realloc(asset->data, capacity ? capacity : 1);
+    if (!data) {
+        return false;
+    }
+
+    if (capacity > asset->capacity) {
+        memset(data + asset->capacity, 0, capacity - asset->capacity);
+    }
+
+    asset->data = data;
+    asset->capacity = capacity;
+
+    return true;
+}
+
+static void replay_model_free(struct replay_model_t *model)
+{
+    uint32_t i;
+
+    for (i = 0; i < model->num_assets; i++) {
+        free(model->assets[i].data);
+    }
+
+    free(model->assets);
+    model->assets = NULL;
+    model->num_assets = 0;
+}
+
+/**
+ * \brief Copies the state of the assets of the given service from one model to
+ *        another. Assets that are not in the source model do not exist.
+ */
+static bool replay_model_copy(struct replay_model_t *dst,
+                              const struct replay_model_t *src,
+                              enum replay_service_t service)
+{
+    struct replay_asset_t *asset;
+    uint32_t i;
+
+    for (i = 0; i < dst->num_assets; i++) {
+        if (dst->assets[i].service == service) {
+            dst->assets[i].exists = false;
+            dst->assets[i].size = 0;
+        }
+    }
+
+    for (i = 0; i < src->num_assets; i++) {
+        if (src->assets[i].service != service) {
+            continue;
+        }
+
+        asset = replay_model_find(dst, service, src->assets[i].uid);
+        if (!asset || !replay_asset_resize(asset, src->assets[i].capacity)) {
+            return false;
+        }
+
+        asset->exists = src->assets[i].exists;
+        asset->size = src->assets[i].size;
+        if (src->assets[i].capacity) {
+            memcpy(asset->data, src->assets[i].data, src->assets[i].capacity);
+        }
+    }
+
+    return true;
+}
+
+static psa_status_t replay_call_service(const struct replay_cmd_t *cmd,
+                                        size_t *out_len,
+                                        struct psa_storage_info_t *info,
+                                        struct psa_storage_capacity_t *capacity)
+{
+    bool its = (cmd->service == REPLAY_ITS);
+    int32_t client_id = its ? REPLAY_ITS_CLIENT_ID : REPLAY_PS_CLIENT_ID;
+
+    switch (cmd->op) {
+    case REPLAY_OP_SET:
+        replay_host_set_client_bufs(g_in_buf, NULL);
+        return its ? tfm_its_set(client_id, cmd->uid, cmd->size,
+                                 PSA_STORAGE_FLAG_NONE) :
+                     tfm_ps_set(client_id, cmd->uid, cmd->size,
+                                PSA_STORAGE_FLAG_NONE);
+    case REPLAY_OP_GET:
+        replay_host_set_client_bufs(NULL, g_out_buf);
+        return its ? tfm_its_get(client_id, cmd->uid, cmd->offset, cmd->size,
+                                 out_len) :
+                     tfm_ps_get(client_id, cmd->uid, cmd->offset, cmd->size,
+                                out_len);
+    case REPLAY_OP_GET_INFO:
+        return its ? tfm_its_get_info(client_id, cmd->uid, info) :
+                     tfm_ps_get_info(client_id, cmd->uid, info);
+    case REPLAY_OP_REMOVE:
+        return its ? tfm_its_remove(client_id, cmd->uid) :
+                     tfm_ps_remove(client_id, cmd->uid);
+    case REPLAY_OP_CREATE:
+        return its ? tfm_its_create(client_id, cmd->uid, cmd->size,
+                                    PSA_STORAGE_FLAG_NONE) :
+                     tfm_ps_create(client_id, cmd->uid, cmd->size,
+                                   PSA_STORAGE_FLAG_NONE);
+    case REPLAY_OP_SET_EXTENDED:
+        replay_host_set_client_bufs(g_in_buf, NULL);
+        return its ? tfm_its_set_extended(client_id, cmd->uid, cmd->offset,
+                                          cmd->size) :
+                     tfm_ps_set_extended(client_id, cmd->uid, cmd->offset,
+                                         cmd->size);
+    case REPLAY_OP_TXN_BEGIN:
+        return tfm_its_txn_begin(client_id);
+    case REPLAY_OP_TXN_COMMIT:
+        return tfm_its_txn_commit(client_id);
+    case REPLAY_OP_TXN_ABORT:
+        return tfm_its_txn_abort(client_id);
+    case REPLAY_OP_FLUSH:
+        return tfm_ps_flush();
+    case REPLAY_OP_LIST:
+        replay_host_set_client_bufs(NULL, g_out_buf);
+        return its ? tfm_its_list(client_id, cmd->uid, cmd->size, out_len) :
+                     tfm_ps_list(client_id, cmd->uid, cmd->size, out_len);
+    case REPLAY_OP_CAPACITY:
+        return its ? tfm_its_get_capacity(client_id, capacity) :
+                     tfm_ps_get_capacity(client_id, capacity);
+    case REPLAY_OP_INIT:
+        return its ? tfm_its_init() : tfm_ps_init();
+    case REPLAY_OP_FAIL:
+        /* The number of operations is parsed in place of the UID */
+        flash_sim_schedule_failure((uint32_t)cmd->uid);
+        return PSA_SUCCESS;
+    default:
+        return PSA_ERROR_NOT_SUPPORTED;
+    }
+}
+
+/* Output of the operation run on the replay stack */
+static size_t g_out_len;
+static struct psa_storage_info_t g_info;
+static struct psa_storage_capacity_t g_capacity;
+
+static void replay_op_entry(void)
+{
+    uint64_t start = replay_time_ns();
+
+    g_result->status = replay_call_service(g_cmd, &g_out_len, &g_info,
+                                           &g_capacity);
+    g_result->host_ns = replay_time_ns() - start;
+}
+
+/**
+ * \brief Runs the operation on the painted replay stack, and measures the
+ *        stack it uses.
+ */
+static void replay_run_on_stack(void)
+{
+    uint32_t used;
+
+    /* Repaint the part of the stack used by the previous operations. The
+     * whole stack is painted before the first one.
+     */
+    memset(g_stack + sizeof(g_stack) - g_stack_high_water, REPLAY_STACK_PAINT,
+           g_stack_high_water);
+
+    getcontext(&g_op_ctx);
+    g_op_ctx.uc_stack.ss_sp = g_stack;
+    g_op_ctx.uc_stack.ss_size = sizeof(g_stack);
+    g_op_ctx.uc_link = &g_main_ctx;
+    makecontext(&g_op_ctx, replay_op_entry, 0);
+    swapcontext(&g_main_ctx, &g_op_ctx);
+
+    /* The stack grows down, so the high-water mark is the lowest byte that is
+     * not painted.
+     */
+    for (used = sizeof(g_stack); used > 0; used--) {
+        if (g_stack[sizeof(g_stack) - used] != REPLAY_STACK_PAINT) {
+            break;
+        }
+    }
+
+    g_result->stack_bytes = used;
+    g_stack_high_water = used;
+}
+
+#if defined(ITS_RAM_FS) || defined(PS_RAM_FS)
+static uint64_t replay_ram_fs_changes(const uint8_t *ram, uint8_t *copy,
+                                      size_t size)
+{
+    uint64_t changed = 0;
+    size_t i;
+
+    for (i = 0; i < size; i++) {
+        if (ram[i] != copy[i]) {
+            copy[i] = ram[i];
+            changed++;
+        }
+    }
+
+    return changed;
+}
+#endif
+
+/**
+ * \brief Runs one operation and measures it.
+ */
+static void replay_measure(const struct replay_cmd_t *cmd,
+                           const struct replay_params_t *params,
+                           struct replay_result_t *result)
+{
+    struct flash_sim_stats_t before;
+    struct flash_sim_stats_t after;
+
+    memset(result, 0, sizeof(*result));
+    g_cmd = cmd;
+    g_result = result;
+    g_out_len = 0;
+    memset(&g_info, 0, sizeof(g_info));
+    memset(&g_capacity, 0, sizeof(g_capacity));
+
+    flash_sim_get_stats(&before);
+    replay_run_on_stack();
+    flash_sim_get_stats(&after);
+
+    result->sim_ns = after.time_ns - before.time_ns;
+    result->program_bytes = after.program_bytes - before.program_bytes;
+    result->erase_bytes = (after.erase_ops - before.erase_ops) *
+                          params->sector_size;
+#ifdef ITS_RAM_FS
+    result->program_bytes += replay_ram_fs_changes(its_block_data,
+                                                   g_its_ram_copy,
+                                                   ITS_RAM_FS_SIZE);
+#endif
+#ifdef PS_RAM_FS
+    result->program_bytes += replay_ram_fs_changes(ps_block_data,
+                                                   g_ps_ram_copy,
+                                                   PS_RAM_FS_SIZE);
+#endif
+}
+
+/**
+ * \brief Checks the entries returned by a list operation, which are the
+ *        smallest UIDs of the existing assets after the given UID.
+ *
+ * \return Returns 0 if the entries match the model, or -1 otherwise.
+ */
+static int replay_check_list(const struct replay_cmd_t *cmd)
+{
+    const struct psa_storage_uid_info_t *entries =
+                                (const struct psa_storage_uid_info_t *)g_out_buf;
+    const struct replay_asset_t *next;
+    psa_storage_uid_t after_uid = cmd->uid;
+    uint32_t num;
+    uint32_t i;
+
+    for (num = 0; num < cmd->size; num++) {
+        next = NULL;
+        for (i = 0; i < g_model.num_assets; i++) {
+            if (g_model.assets[i].service == cmd->service &&
+                g_model.assets[i].exists &&
+                g_model.assets[i].uid > after_uid &&
+                (!next || g_model.assets[i].uid < next->uid)) {
+                next = &g_model.assets[i];
+            }
+        }
+
+        if (!next) {
+            break;
+        }
+
+        if (num >= g_out_len || entries[num].uid != next->uid ||
+            entries[num].size != next->size) {
+            break;
+        }
+
+        after_uid = next->uid;
+    }
+
+    if (num != g_out_len || (num < cmd->size && next)) {
+        fprintf(stderr, "line %" PRIu32 ": %s list after uid %" PRIu64
+                " returned unexpected entries\n", cmd->line,
+                g_service_names[cmd->service], (uint64_t)cmd->uid);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Checks the storage usage returned by a capacity operation. The ITS
+ *        usage is the sum of the asset capacities, rounded up to the alignment
+ *        of the ITS filesystem, and excludes the changes of an open
+ *        transaction. The PS usage is the sum of the asset sizes.
+ *
+ * \return Returns 0 if the usage matches the model, or -1 otherwise.
+ */
+static int replay_check_capacity(const struct replay_cmd_t *cmd)
+{
+    const struct replay_model_t *model = &g_model;
+    const struct replay_asset_t *asset;
+    size_t num_assets = 0;
+    size_t size = 0;
+    uint32_t i;
+
+    if (cmd->service == REPLAY_ITS && g_txn_open) {
+        model = &g_txn_model;
+    }
+
+    for (i = 0; i < model->num_assets; i++) {
+        asset = &model->assets[i];
+        if (asset->service != cmd->service || !asset->exists) {
+            continue;
+        }
+
+        num_assets++;
+        size += (cmd->service == REPLAY_ITS) ?
+                ITS_UTILS_ALIGN(asset->capacity, ITS_FLASH_ALIGNMENT) :
+                asset->size;
+    }
+
+    if (g_capacity.num_assets != num_assets || g_capacity.size != size) {
+        fprintf(stderr, "line %" PRIu32 ": %s capacity returned %zu assets of "
+                "%zu bytes instead of %zu assets of %zu bytes\n", cmd->line,
+                g_service_names[cmd->service], g_capacity.num_assets,
+                g_capacity.size, num_assets, size);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Checks the result of an operation against the model, which is
+ *        updated if the operation succeeded. A write operation stores the
+ *        client data prepared in g_in_buf.
+ *
+ * \return Returns 0 if the result matches the model, or -1 otherwise.
+ */
+static int replay_check(const struct replay_cmd_t *cmd,
+                        struct replay_result_t *result)
+{
+    struct replay_asset_t *asset = NULL;
+    uint32_t expected;
+    bool txn_change = g_txn_open && (cmd->service == REPLAY_ITS) &&
+                      ((cmd->op <= REPLAY_OP_SET_EXTENDED &&
+                        cmd->op != REPLAY_OP_GET &&
+                        cmd->op != REPLAY_OP_GET_INFO) ||
+                       cmd->op == REPLAY_OP_TXN_COMMIT);
+
+    if (txn_change && g_txn_failed && result->status == PSA_SUCCESS) {
+        fprintf(stderr, "line %" PRIu32 ": its %s succeeded in a failed "
+                "transaction\n", cmd->line, g_op_descs[cmd->op].name);
+        return -1;
+    }
+
+    if (result->status != PSA_SUCCESS) {
+        /* A flash failure while a change is staged or committed leaves the
+         * transaction open until it is aborted.
+         */
+        if (txn_change && result->status == PSA_ERROR_GENERIC_ERROR) {
+            g_txn_failed = true;
+        }
+        return 0;
+    }
+
+    if (cmd->op <= REPLAY_OP_SET_EXTENDED) {
+        asset = replay_model_find(&g_model, cmd->service, cmd->uid);
+        if (!asset) {
+            fprintf(stderr, "Out of memory\n");
+            return -1;
+        }
+    }
+
+    switch (cmd->op) {
+    case REPLAY_OP_SET:
+        if (!replay_asset_resize(asset, cmd->size)) {
+            fprintf(stderr, "Out of memory\n");
+            return -1;
+        }
+        memcpy(asset->data, g_in_buf, cmd->size);
+        asset->exists = true;
+        asset->size = cmd->size;
+        result->logical_bytes = cmd->size;
+        break;
+    case REPLAY_OP_CREATE:
+        if (!asset->exists) {
+            if (!replay_asset_resize(asset, cmd->size)) {
+                fprintf(stderr, "Out of memory\n");
+                return -1;
+            }
+            asset->exists = true;
+            asset->size = 0;
+        }
+        break;
+    case REPLAY_OP_SET_EXTENDED:
+        if (!asset->exists || cmd->offset > asset->size ||
+            cmd->size > asset->capacity - cmd->offset) {
+            fprintf(stderr, "line %" PRIu32 ": %s set_extended of uid %"
+                    PRIu64 " succeeded beyond the asset capacity\n",
+                    cmd->line, g_service_names[cmd->service],
+                    (uint64_t)cmd->uid);
+            return -1;
+        }
+        memcpy(asset->data + cmd->offset, g_in_buf, cmd->size);
+        asset->size = ITS_UTILS_MAX(asset->size, cmd->offset + cmd->size);
+        result->logical_bytes = cmd->size;
+        break;
+    case REPLAY_OP_REMOVE:
+        asset->exists = false;
+        asset->size = 0;
+        break;
+    case REPLAY_OP_GET:
+        expected = (asset->exists && cmd->offset <= asset->size) ?
+                   ITS_UTILS_MIN(cmd->size, asset->size - cmd->offset) : 0;
+        if (!asset->exists || g_out_len != expected ||
+            memcmp(g_out_buf, asset->data + cmd->offset, expected) != 0) {
+            fprintf(stderr, "line %" PRIu32 ": %s get of uid %" PRIu64
+                    " returned unexpected data\n", cmd->line,
+                    g_service_names[cmd->service], (uint64_t)cmd->uid);
+            return -1;
+        }
+        break;
+    case REPLAY_OP_GET_INFO:
+        /* The capacity is only checked for ITS, as PS does not report the
+         * capacity reserved by create.
+         */
+        if (!asset->exists || g_info.size != asset->size ||
+            (cmd->service == REPLAY_ITS && g_info.capacity != asset->capacity)) {
+            fprintf(stderr, "line %" PRIu32 ": %s get_info of uid %" PRIu64
+                    " returned size %zu and capacity %zu instead of %" PRIu32
+                    " and %" PRIu32 "\n", cmd->line,
+                    g_service_names[cmd->service], (uint64_t)cmd->uid,
+                    g_info.size, g_info.capacity, asset->size,
+                    asset->capacity);
+            return -1;
+        }
+        break;
+    case REPLAY_OP_LIST:
+        return replay_check_list(cmd);
+    case REPLAY_OP_CAPACITY:
+        return replay_check_capacity(cmd);
+    case REPLAY_OP_TXN_BEGIN:
+        if (!replay_model_copy(&g_txn_model, &g_model, REPLAY_ITS)) {
+            fprintf(stderr, "Out of memory\n");
+            return -1;
+        }
+        g_txn_open = true;
+        break;
+    case REPLAY_OP_TXN_COMMIT:
+        g_txn_open = false;
+        break;
+    case REPLAY_OP_TXN_ABORT:
+        /* The PS assets are not part of the transaction */
+        if (!replay_model_copy(&g_model, &g_txn_model, REPLAY_ITS)) {
+            fprintf(stderr, "Out of memory\n");
+            return -1;
+        }
+        g_txn_open = false;
+        g_txn_failed = false;
+        break;
+    default:
+        break;
+    }
+
+    return 0;
+}
+
+static int replay_parse_u32(const char *str, uint32_t *val)
+{
+    char *end;
+    unsigned long long v;
+
+    v = strtoull(str, &end, 0);
+    if (end == str || *end != '\0' || v > UINT32_MAX) {
+        return -1;
+    }
+
+    *val = (uint32_t)v;
+
+    return 0;
+}
+
+/**
+ * \brief Parses a trace line of the form "service,op[,uid[,size[,offset]]]".
+ *
+ * \return Returns 1 if an operation was parsed, 0 if the line is empty or a
+ *         comment, and -1 on a syntax error.
+ */
+static int replay_parse_line(char *line, uint32_t line_num,
+                             struct replay_cmd_t *cmd)
+{
+    char *fields[5];
+    uint32_t num_fields = 0;
+    uint32_t vals[3] = {0, 0, 0};
+    char *p = line;
+    char *end;
+    uint32_t i;
+    unsigned long long uid;
+
+    /* Strip the comment and the trailing whitespace */
+    end = strchr(line, '#');
+    if (end) {
+        *end = '\0';
+    }
+    end = line + strlen(line);
+    while (end > line && (end[-1] == ' ' || end[-1] == '\t' ||
+                          end[-1] == '\r' || end[-1] == '\n')) {
+        *--end = '\0';
+    }
+    while (*p == ' ' || *p == '\t') {
+        p++;
+    }
+    if (*p == '\0') {
+        return 0;
+    }
+
+    while (p && num_fields < sizeof(fields) / sizeof(fields[0])) {
+        while (*p == ' ' || *p == '\t') {
+            p++;
+        }
+        fields[num_fields++] = p;
+        p = strchr(p, ',');
+        if (p) {
+            *p++ = '\0';
+        }
+    }
+
+    if (p || num_fields < 2) {
+        goto syntax_error;
+    }
+
+    memset(cmd, 0, sizeof(*cmd));
+    cmd->line = line_num;
+
+    for (i = 0; i < REPLAY_NUM_SERVICES; i++) {
+        if (!strcmp(fields[0], g_service_names[i])) {
+            break;
+        }
+    }
+    if (i == REPLAY_NUM_SERVICES) {
+        goto syntax_error;
+    }
+    cmd->service = (enum replay_service_t)i;
+
+    for (i = 0; i < REPLAY_NUM_OPS; i++) {
+        if (!strcmp(fields[1], g_op_descs[i].name)) {
+            break;
+        }
+    }
+    if (i == REPLAY_NUM_OPS ||
+        !(g_op_descs[i].services & (1U << cmd->service))) {
+        goto syntax_error;
+    }
+    cmd->op = (enum replay_op_t)i;
+
+    /* A get can omit the offset, which defaults to zero */
+    if (num_fields - 2 < g_op_descs[i].num_args ||
+        num_fields - 2 > ITS_UTILS_MAX(g_op_descs[i].num_args,
+                                       (cmd->op == REPLAY_OP_GET) ? 3 : 0)) {
+        goto syntax_error;
+    }
+
+    if (num_fields > 2) {
+        uid = strtoull(fields[2], &end, 0);
+        if (end == fields[2] || *end != '\0') {
+            goto syntax_error;
+        }
+        cmd->uid = uid;
+    }
+
+    for (i = 3; i < num_fields; i++) {
+        if (replay_parse_u32(fields[i], &vals[i - 3]) != 0) {
+            goto syntax_error;
+        }
+    }
+    cmd->size = vals[0];
+    cmd->offset = vals[1];
+
+    if ((cmd->op == REPLAY_OP_SET || cmd->op == REPLAY_OP_GET ||
+         cmd->op == REPLAY_OP_SET_EXTENDED) &&
+        cmd->size > REPLAY_MAX_DATA_SIZE) {
+        fprintf(stderr, "line %" PRIu32 ": size larger than %d\n", line_num,
+                REPLAY_MAX_DATA_SIZE);
+        return -1;
+    }
+
+    if (cmd->op == REPLAY_OP_LIST && cmd->size > REPLAY_MAX_LIST_ENTRIES) {
+        fprintf(stderr, "line %" PRIu32 ": more than %zu entries\n", line_num,
+                REPLAY_MAX_LIST_ENTRIES);
+        return -1;
+    }
+
+    return 1;
+
+syntax_error:
+    fprintf(stderr, "line %" PRIu32 ": invalid operation\n", line_num);
+    return -1;
+}
+
+/**
+ * \brief Reads all the operations of a trace.
+ *
+ * \return Returns the number of operations, or -1 on error.
+ */
+static int64_t replay_read_trace(const char *path, struct replay_cmd_t **cmds)
+{
+    char line[REPLAY_MAX_LINE];
+    struct replay_cmd_t cmd;
+    struct replay_cmd_t *tmp;
+    size_t num_cmds = 0;
+    size_t cap = 0;
+    uint32_t line_num = 0;
+    FILE *f;
+    int ret;
+
+    f = strcmp(path, "-") ? fopen(path, "r") : stdin;
+    if (!f) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return -1;
+    }
+
+    *cmds = NULL;
+
+    while (fgets(line, sizeof(line), f)) {
+        line_num++;
+
+        ret = replay_parse_line(line, line_num, &cmd);
+        if (ret < 0) {
+            goto fail;
+        } else if (ret == 0) {
+            continue;
+        }
+
+        if (num_cmds == cap) {
+            cap = cap ? 2 * cap : 256;
+            tmp = realloc(*cmds, cap * sizeof(**cmds));
+            if (!tmp) {
+                fprintf(stderr, "Out of memory\n");
+                goto fail;
+            }
+            *cmds = tmp;
+        }
+
+        (*cmds)[num_cmds++] = cmd;
+    }
+
+    if (f != stdin) {
+        fclose(f);
+    }
+
+    return (int64_t)num_cmds;
+
+fail:
+    if (f != stdin) {
+        fclose(f);
+    }
+    free(*cmds);
+    *cmds = NULL;
+
+    return -1;
+}
+
+static int replay_cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ * \brief Gets a percentile of sorted values, with the nearest-rank method.
+ */
+static uint64_t replay_percentile(const uint64_t *sorted, size_t num,
+                                  uint32_t pct)
+{
+    size_t rank = (num * pct + 99) / 100;
+
+    return sorted[(rank > 0) ? rank - 1 : 0];
+}
+
+static void replay_print_latency(const uint64_t *sorted, size_t num)
+{
+    printf(" %9.1f %9.1f %9.1f %9.1f",
+           replay_percentile(sorted, num, 50) / 1000.0,
+           replay_percentile(sorted, num, 90) / 1000.0,
+           replay_percentile(sorted, num, 99) / 1000.0,
+           sorted[num - 1] / 1000.0);
+}
+
+/**
+ * \brief Prints the latency percentiles and stack high-water mark of the
+ *        operations of the given service and type, or of all the operations if
+ *        op is REPLAY_NUM_OPS.
+ */
+static void replay_print_row(const struct replay_cmd_t *cmds,
+                             const struct replay_result_t *results,
+                             size_t num_cmds, enum replay_service_t service,
+                             enum replay_op_t op, uint64_t *sim, uint64_t *host)
+{
+    size_t num = 0;
+    uint32_t failed = 0;
+    uint32_t stack = 0;
+    size_t i;
+    char name[32];
+
+    for (i = 0; i < num_cmds; i++) {
+        if (op != REPLAY_NUM_OPS &&
+            (cmds[i].service != service || cmds[i].op != op)) {
+            continue;
+        }
+        sim[num] = results[i].sim_ns;
+        host[num] = results[i].host_ns;
+        stack = ITS_UTILS_MAX(stack, results[i].stack_bytes);
+        failed += (results[i].status != PSA_SUCCESS);
+        num++;
+    }
+
+    if (num == 0) {
+        return;
+    }
+
+    qsort(sim, num, sizeof(*sim), replay_cmp_u64);
+    qsort(host, num, sizeof(*host), replay_cmp_u64);
+
+    if (op == REPLAY_NUM_OPS) {
+        snprintf(name, sizeof(name), "all");
+    } else {
+        snprintf(name, sizeof(name), "%s %s", g_service_names[service],
+                 g_op_descs[op].name);
+    }
+
+    printf("%-17s %7zu %5" PRIu32, name, num, failed);
+    replay_print_latency(sim, num);
+    replay_print_latency(host, num);
+    printf(" %7" PRIu32 "\n", stack);
+}
+
+static void replay_report(const struct replay_cmd_t *cmds,
+                          const struct replay_result_t *results,
+                          size_t num_cmds)
+{
+    struct replay_host_stats_t host_stats;
+    uint64_t logical[REPLAY_NUM_SERVICES] = {0, 0};
+    uint64_t programmed[REPLAY_NUM_SERVICES] = {0, 0};
+    uint64_t erased[REPLAY_NUM_SERVICES] = {0, 0};
+    uint64_t *sim;
+    uint64_t *host;
+    uint32_t service;
+    uint32_t op;
+    size_t i;
+
+    sim = malloc(num_cmds * sizeof(*sim));
+    host = malloc(num_cmds * sizeof(*host));
+    if (!sim || !host) {
+        free(sim);
+        free(host);
+        return;
+    }
+
+    printf("%-17s %7s %5s %39s %39s %7s\n", "", "", "",
+           "simulated flash time (us)", "host time (us)", "stack");
+    printf("%-17s %7s %5s %9s %9s %9s %9s %9s %9s %9s %9s %7s\n",
+           "operation", "count", "fail", "p50", "p90", "p99", "max",
+           "p50", "p90", "p99", "max", "(B)");
+
+    for (service = 0; service < REPLAY_NUM_SERVICES; service++) {
+        for (op = 0; op < REPLAY_NUM_OPS; op++) {
+            replay_print_row(cmds, results, num_cmds, service, op, sim, host);
+        }
+    }
+    replay_print_row(cmds, results, num_cmds, REPLAY_ITS, REPLAY_NUM_OPS, sim,
+                     host);
+
+    free(sim);
+    free(host);
+
+    /* Write amplification of each service. The flash written by PS is written
+     * through ITS, to the PS filesystem, and is accounted to the PS operation
+     * that caused it.
+     */
+    for (i = 0; i < num_cmds; i++) {
+        logical[cmds[i].service] += results[i].logical_bytes;
+        programmed[cmds[i].service] += results[i].program_bytes;
+        erased[cmds[i].service] += results[i].erase_bytes;
+    }
+
+    printf("\n%-8s %14s %14s %14s %12s %12s\n", "service", "logical (B)",
+           "programmed (B)", "erased (B)", "prog/logical",
+           "erase/logical");
+    for (service = 0; service < REPLAY_NUM_SERVICES; service++) {
+        printf("%-8s %14" PRIu64 " %14" PRIu64 " %14" PRIu64,
+               g_service_names[service], logical[service],
+               programmed[service], erased[service]);
+        if (logical[service]) {
+            printf(" %12.2f %12.2f\n",
+                   (double)programmed[service] / logical[service],
+                   (double)erased[service] / logical[service]);
+        } else {
+            printf(" %12s %12s\n", "-", "-");
+        }
+    }
+
+#if defined(ITS_RAM_FS) || defined(PS_RAM_FS)
+    printf("The bytes programmed to a RAM filesystem are the bytes it changed, "
+           "including erases.\n");
+#endif
+
+    replay_host_get_stats(&host_stats);
+    printf("\nNV counter increments: %" PRIu64 "\n",
+           host_stats.nv_counter_increments);
+#ifdef PS_ENCRYPTION
+    printf("PS crypto operations: %" PRIu64 " (%" PRIu64 " bytes), "
+           "not included in the host time as a stand-in is used\n",
+           host_stats.crypto_ops, host_stats.crypto_bytes);
+#endif
+}
+
+static int replay_write_results(const char *path,
+                                const struct replay_cmd_t *cmds,
+                                const struct replay_result_t *results,
+                                size_t num_cmds)
+{
+    FILE *f;
+    size_t i;
+
+    f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return -1;
+    }
+
+    fprintf(f, "line,service,op,uid,size,offset,status,sim_ns,host_ns,"
+            "logical_bytes,program_bytes,erase_bytes,stack_bytes\n");
+
+    for (i = 0; i < num_cmds; i++) {
+        fprintf(f, "%" PRIu32 ",%s,%s,%" PRIu64 ",%" PRIu32 ",%" PRIu32
+                ",%d,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64
+                ",%" PRIu32 "\n", cmds[i].line,
+                g_service_names[cmds[i].service], g_op_descs[cmds[i].op].name,
+                (uint64_t)cmds[i].uid, cmds[i].size, cmds[i].offset,
+                (int)results[i].status, results[i].sim_ns, results[i].host_ns,
+                results[i].logical_bytes, results[i].program_bytes,
+                results[i].erase_bytes, results[i].stack_bytes);
+    }
+
+    fclose(f);
+
+    return 0;
+}
+
+#ifdef PS_ENCRYPTION
+#define REPLAY_PS_ENCRYPTION            "ON"
+#else
+#define REPLAY_PS_ENCRYPTION            "OFF"
+#endif
+#ifdef PS_ROLLBACK_PROTECTION
+#define REPLAY_PS_ROLLBACK_PROTECTION   "ON"
+#else
+#define REPLAY_PS_ROLLBACK_PROTECTION   "OFF"
+#endif
+#ifdef ITS_VALIDATE_METADATA_FROM_FLASH
+#define REPLAY_ITS_VALIDATE_METADATA    "ON"
+#else
+#define REPLAY_ITS_VALIDATE_METADATA    "OFF"
+#endif
+#ifdef PS_WRITE_BACK
+#define REPLAY_PS_WRITE_BACK            "ON"
+#else
+#define REPLAY_PS_WRITE_BACK            "OFF"
+#endif
+#ifdef PS_OBJECT_CACHE
+#define REPLAY_PS_OBJECT_CACHE          "ON"
+#else
+#define REPLAY_PS_OBJECT_CACHE          "OFF"
+#endif
+
+static void replay_print_area(const char *name, bool ram_fs, size_t ram_size,
+                              uint32_t num_blocks,
+                              const struct replay_params_t *params)
+{
+    uint32_t block_size = params->sector_size * params->sectors_per_block;
+
+    if (ram_fs) {
+        printf("%s area: RAM filesystem, %zu blocks of %" PRIu32 " bytes\n",
+               name, ram_size / block_size, block_size);
+    } else {
+        printf("%s area: %s flash, %" PRIu32 " blocks of %" PRIu32 " bytes\n",
+               name, (STORAGE_BENCH_PROGRAM_UNIT > 16) ? "NAND" : "NOR",
+               num_blocks, block_size);
+    }
+}
+
+static void replay_print_config(const struct replay_params_t *params)
+{
+    bool its_ram_fs = false;
+    bool ps_ram_fs = false;
+    size_t its_ram_size = 0;
+    size_t ps_ram_size = 0;
+
+#ifdef ITS_RAM_FS
+    its_ram_fs = true;
+    its_ram_size = ITS_RAM_FS_SIZE;
+#endif
+#ifdef PS_RAM_FS
+    ps_ram_fs = true;
+    ps_ram_size = PS_RAM_FS_SIZE;
+#endif
+
+    printf("PS_ENCRYPTION=%s PS_ROLLBACK_PROTECTION=%s "
+           "ITS_VALIDATE_METADATA_FROM_FLASH=%s\n"
+           "ITS_NUM_ASSETS=%d ITS_MAX_ASSET_SIZE=%d PS_NUM_ASSETS=%d "
+           "PS_MAX_ASSET_SIZE=%d\n"
+           "ITS_METADATA_SHADOW_MAX_BLOCKS=%d PS_WRITE_BACK=%s "
+           "PS_OBJECT_CACHE=%s\n", REPLAY_PS_ENCRYPTION,
+           REPLAY_PS_ROLLBACK_PROTECTION, REPLAY_ITS_VALIDATE_METADATA,
+           ITS_NUM_ASSETS, ITS_MAX_ASSET_SIZE, PS_NUM_ASSETS,
+           PS_MAX_ASSET_SIZE, ITS_METADATA_SHADOW_MAX_BLOCKS,
+           REPLAY_PS_WRITE_BACK, REPLAY_PS_OBJECT_CACHE);
+    replay_print_area("ITS", its_ram_fs, its_ram_size, params->its_num_blocks,
+                      params);
+    replay_print_area("PS", ps_ram_fs, ps_ram_size, params->ps_num_blocks,
+                      params);
+}
+
+static void replay_usage(const char *prog)
+{
+    uint32_t i;
+
+    printf("Usage: %s [options] <trace>\n"
+           "Replays a trace of ITS and PS operations, read from the given file "
+           "or from\n"
+           "the standard input if it is \"-\".\n"
+           "  -o <file>       write the measurements of each operation to a "
+           "CSV file\n"
+           "  -k              keep going when the data read does not match "
+           "the data\n"
+           "                  written\n"
+           "  -S <bytes>      flash sector size (default 4096)\n"
+           "  -b <sectors>    sectors per filesystem block (default 1)\n"
+           "  -i <blocks>     ITS area size in blocks (default 4)\n"
+           "  -p <blocks>     PS area size in blocks (default 16)\n"
+           "  -r <ns>         read time per byte (default 10)\n"
+           "  -P <ns>         program time per program unit (default 10000)\n"
+           "  -e <us>         erase time per sector (default 20000)\n"
+           "Trace lines are \"<service>,<operation>[,<arguments>]\". Lines "
+           "starting with\n"
+           "'#' are comments. Operations:\n", prog);
+
+    for (i = 0; i < REPLAY_NUM_OPS; i++) {
+        printf("  %-3s %-13s %s\n",
+               (g_op_descs[i].services == 0x3) ? "any" :
+               g_service_names[(g_op_descs[i].services == 0x1) ? REPLAY_ITS :
+                                                                 REPLAY_PS],
+               g_op_descs[i].name, g_op_descs[i].args);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    struct replay_params_t params = {
+        .sector_size = 4096,
+        .sectors_per_block = 1,
+        .its_num_blocks = 4,
+        .ps_num_blocks = 16,
+        .sim = {
+            .program_unit = STORAGE_BENCH_PROGRAM_UNIT,
+            .erased_value = 0xFF,
+#ifdef ITS_FLASH_NOR_IN_PLACE_WRITE
+            .reprogram = true,
+#endif
+            .detect_torn_writes = (STORAGE_BENCH_PROGRAM_UNIT > 16),
+            .read_ns_per_byte = 10,
+            .program_ns_per_unit = 10000,
+            .erase_us_per_sector = 20000,
+        },
+    };
+    struct tfm_hal_its_fs_info_t its_info;
+    struct tfm_hal_ps_fs_info_t ps_info;
+    struct replay_cmd_t *trace;
+    struct replay_cmd_t *cmds = NULL;
+    struct replay_result_t *results = NULL;
+    uint32_t its_sectors;
+    uint32_t block_size;
+    uint32_t num_errors = 0;
+    size_t num_cmds;
+    size_t i;
+    int64_t num_trace_cmds;
+    int opt;
+    int ret = 0;
+
+    while ((opt = getopt(argc, argv, "o:kS:b:i:p:r:P:e:h")) != -1) {
+        switch (opt) {
+        case 'o': params.output = optarg; break;
+        case 'k': params.keep_going = true; break;
+        case 'S': params.sector_size = strtoul(optarg, NULL, 0); break;
+        case 'b': params.sectors_per_block = strtoul(optarg, NULL, 0); break;
+        case 'i': params.its_num_blocks = strtoul(optarg, NULL, 0); break;
+        case 'p': params.ps_num_blocks = strtoul(optarg, NULL, 0); break;
+        case 'r': params.sim.read_ns_per_byte = strtoul(optarg, NULL, 0); break;
+        case 'P':
+            params.sim.program_ns_per_unit = strtoul(optarg, NULL, 0);
+            break;
+        case 'e':
+            params.sim.erase_us_per_sector = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            replay_usage(argv[0]);
+            return (opt == 'h') ? 0 : 2;
+        }
+    }
+
+    if (optind != argc - 1) {
+        replay_usage(argv[0]);
+        return 2;
+    }
+    params.trace = argv[optind];
+
+    block_size = params.sector_size * params.sectors_per_block;
+    if (block_size == 0 || block_size > STORAGE_BENCH_MAX_BLOCK_SIZE ||
+        params.its_num_blocks == 0 || params.ps_num_blocks == 0) {
+        fprintf(stderr, "Invalid parameters\n");
+        return 2;
+    }
+
+    num_trace_cmds = replay_read_trace(params.trace, &trace);
+    if (num_trace_cmds < 0) {
+        return 2;
+    }
+
+    /* Both services are initialised before the trace is replayed, as on
+     * boot.
+     */
+    num_cmds = (size_t)num_trace_cmds + 2;
+    cmds = calloc(num_cmds, sizeof(*cmds));
+    results = calloc(num_cmds, sizeof(*results));
+    if (!cmds || !results) {
+        fprintf(stderr, "Out of memory\n");
+        ret = 2;
+        goto out;
+    }
+    cmds[0].service = REPLAY_ITS;
+    cmds[0].op = REPLAY_OP_INIT;
+    cmds[1].service = REPLAY_PS;
+    cmds[1].op = REPLAY_OP_INIT;
+    if (num_trace_cmds > 0) {
+        memcpy(&cmds[2], trace, (size_t)num_trace_cmds * sizeof(*trace));
+    }
+
+    its_sectors = params.its_num_blocks * params.sectors_per_block;
+    params.sim.sector_size = params.sector_size;
+    params.sim.sector_count = its_sectors +
+                              params.ps_num_blocks * params.sectors_per_block;
+
+    if (flash_sim_create(&params.sim) != 0) {
+        fprintf(stderr, "Cannot create the simulated flash device\n");
+        ret = 2;
+        goto out;
+    }
+
+    its_info.flash_area_addr = 0;
+    its_info.flash_area_size = its_sectors * params.sector_size;
+    its_info.sectors_per_block = params.sectors_per_block;
+    ps_info.flash_area_addr = its_sectors * params.sector_size;
+    ps_info.flash_area_size = params.ps_num_blocks * block_size;
+    ps_info.sectors_per_block = params.sectors_per_block;
+#ifdef ITS_RAM_FS
+    its_info.flash_area_size = ITS_RAM_FS_SIZE;
+#endif
+#ifdef PS_RAM_FS
+    ps_info.flash_area_size = PS_RAM_FS_SIZE;
+#endif
+    replay_host_set_fs_info(&its_info, &ps_info);
+
+    replay_print_config(&params);
+    printf("Trace: %s, %" PRId64 " operations\n\n", params.trace,
+           num_trace_cmds);
+
+    for (i = 0; i < num_cmds; i++) {
+        if (cmds[i].op == REPLAY_OP_SET ||
+            cmds[i].op == REPLAY_OP_SET_EXTENDED) {
+            replay_fill(g_in_buf, cmds[i].uid, g_next_gen++, cmds[i].size);
+        }
+
+        replay_measure(&cmds[i], &params, &results[i]);
+
+        if (cmds[i].op == REPLAY_OP_INIT && results[i].status != PSA_SUCCESS) {
+            fprintf(stderr, "line %" PRIu32 ": %s init failed: %d\n",
+                    cmds[i].line, g_service_names[cmds[i].service],
+                    (int)results[i].status);
+            ret = 1;
+            i++;
+            break;
+        }
+
+        if (replay_check(&cmds[i], &results[i]) != 0) {
+            num_errors++;
+            if (!params.keep_going) {
+                i++;
+                break;
+            }
+        }
+    }
+
+    /* Report the operations that were run */
+    num_cmds = i;
+    replay_report(cmds, results, num_cmds);
+
+    if (params.output &&
+        replay_write_results(params.output, cmds, results, num_cmds) != 0) {
+        ret = 2;
+    }
+
+    if (num_errors) {
+        fprintf(stderr, "%" PRIu32 " operations did not match the expected "
+                "result\n", num_errors);
+        ret = 1;
+    }
+
+    flash_sim_destroy();
+
+out:
+    free(trace);
+    free(cmds);
+    free(results);
+    replay_model_free(&g_model);
+    replay_model_free(&g_txn_model);
+
+    return ret;
+}